@@ -1,9 +1,124 @@
 #ifndef REGS_COMMON_H
 #define REGS_COMMON_H
 
+#include <linux/kernel.h>
+#include <linux/stddef.h>
+#include <linux/string.h>
 #include <arch/arch_ids.h>
 #include <dbg.h>
 
+/** Kinds of steps of a register conversion */
+enum regs_conv_op {
+	/** copies a register, zero extends or truncates it if needed */
+	REGS_CONV_COPY,
+	/** copies a register, sign extends it if needed */
+	REGS_CONV_SCOPY,
+	/** sets a register to a constant value */
+	REGS_CONV_CONST,
+};
+
+/** Single step of a register conversion */
+struct regs_conv_step {
+	u_int16_t op;
+	u_int16_t src_offset;
+	u_int16_t src_size;
+	u_int16_t dst_offset;
+	u_int16_t dst_size;
+	unsigned long value;
+};
+
+/** Maximum number of steps of a single conversion */
+#define REGS_CONV_MAX_STEPS 32
+
+/**
+ * Descriptor of a conversion of registers checkpointed on a source
+ * architecture into pt_regs of the current architecture. The
+ * descriptors are built once when the checkpoint component is loaded,
+ * so that the restart only walks the table instead of checking the
+ * architectures and copying each register by hand. A descriptor with
+ * no steps denotes an unsupported source architecture.
+ */
+struct regs_conv {
+	int steps;
+	struct regs_conv_step step[REGS_CONV_MAX_STEPS];
+};
+
+/**
+ * Appends a step to a conversion descriptor.
+ *
+ * @param conv Conversion descriptor being built
+ * @param op Kind of the step
+ * @param src_offset Offset of the source register
+ * @param src_size Size of the source register
+ * @param dst_offset Offset of the target register
+ * @param dst_size Size of the target register
+ * @param value Value of a constant step
+ */
+static inline void regs_conv_add(struct regs_conv* conv, enum regs_conv_op op, size_t src_offset, size_t src_size,
+				 size_t dst_offset, size_t dst_size, unsigned long value) {
+	struct regs_conv_step* step;
+
+	BUG_ON(conv->steps >= REGS_CONV_MAX_STEPS);
+	step = &conv->step[conv->steps++];
+	step->op = op;
+	step->src_offset = src_offset;
+	step->src_size = src_size;
+	step->dst_offset = dst_offset;
+	step->dst_size = dst_size;
+	step->value = value;
+};
+
+/** Adds a step converting a field of the source registers into a field of pt_regs */
+#define regs_conv_field(conv, op, src_type, src_field, dst_field) \
+	regs_conv_add(conv, op, offsetof(src_type, src_field), FIELD_SIZEOF(src_type, src_field), \
+		      offsetof(struct pt_regs, dst_field), FIELD_SIZEOF(struct pt_regs, dst_field), 0)
+
+/** Adds a step setting a field of pt_regs to a constant */
+#define regs_conv_const(conv, dst_field, value) \
+	regs_conv_add(conv, REGS_CONV_CONST, 0, 0, \
+		      offsetof(struct pt_regs, dst_field), FIELD_SIZEOF(struct pt_regs, dst_field), value)
+
+/**
+ * Performs a conversion described by a descriptor.
+ *
+ * @param conv Conversion descriptor
+ * @param src Source registers
+ * @param dst Target registers
+ */
+static inline void regs_conv_apply(const struct regs_conv* conv, const void* src, void* dst) {
+	const struct regs_conv_step* step;
+	const void* from;
+	void* to;
+	u_int64_t value;
+
+	for ( step = conv->step; step < conv->step + conv->steps; step++ ) {
+		from = (const u_int8_t*)src + step->src_offset;
+		to = (u_int8_t*)dst + step->dst_offset;
+
+		if ( step->op == REGS_CONV_COPY && step->src_size == step->dst_size ) {
+			memcpy(to, from, step->dst_size);
+			continue;
+		}
+
+		switch ( step->op ) {
+		case REGS_CONV_CONST:
+			value = step->value;
+			break;
+		case REGS_CONV_SCOPY:
+			value = step->src_size == 4 ? (int64_t)*(const int32_t*)from : *(const int64_t*)from;
+			break;
+		default:
+			value = step->src_size == 4 ? *(const u_int32_t*)from : *(const u_int64_t*)from;
+			break;
+		}
+
+		if ( step->dst_size == 4 )
+			*(u_int32_t*)to = (u_int32_t)value;
+		else
+			*(u_int64_t*)to = value;
+	}
+};
+
 /**
  * Loads value of pt_regs into the current architecture type specific regs. 
  * It can be done directly by copying as both structures are same.
@@ -44,6 +159,12 @@ static inline void load_registers( struct tcmi_regs* tcmi_regs, struct pt_regs*
  */
 extern void* get_target_platform_registers(struct pt_regs* regs, enum arch_ids target_arch);
 
+/**
+ * Builds conversion descriptors for all supported source architectures.
+ * Has to be called before any registers are loaded.
+ */
+extern void regs_conv_init(void);
+
 /**
  * Loads registers from checkpointed registers
  *
@@ -51,40 +51,46 @@ void* get_target_platform_registers(struct pt_regs* regs, enum arch_ids target_a
 	return NULL;
 };
 
-void load_from_platform_registers(void* platform_registers, struct pt_regs* regs, enum arch_ids from_arch, int is_32bit_app) {
-	if ( from_arch == ARCH_CURRENT ) {
-		/** Simple load of compatible registers */
-		load_registers( (struct tcmi_regs*)platform_registers, regs);
-		return;
-	}
-
-	if ( from_arch == ARCH_X86_64) {
-		struct tcmi_x86_64_regs* tcmi_regs = (struct tcmi_x86_64_regs*)platform_registers;
-		regs->orig_ax = tcmi_regs->orig_rax;;
-		regs->ax = tcmi_regs->rax;
-		regs->bx = tcmi_regs->rbx;
-		regs->cx = tcmi_regs->rcx;
-		regs->dx = tcmi_regs->rdx;
-
-		regs->si = tcmi_regs->rsi;
-		regs->di = tcmi_regs->rdi;
-
-		regs->ss = tcmi_regs->ss;
-		regs->cs = tcmi_regs->cs;
-		regs->ip = tcmi_regs->rip;
-		regs->flags = tcmi_regs->eflags;
-		regs->bp = tcmi_regs->rbp;
-		regs->sp = tcmi_regs->rsp;
+/** Conversion descriptors indexed by the source architecture */
+static struct regs_conv regs_load_conv[ARCH_COUNT];
+
+void regs_conv_init(void) {
+	struct regs_conv* conv;
+
+	memset(regs_load_conv, 0, sizeof(regs_load_conv));
+
+	/* Registers of the same architecture are copied as a whole */
+	conv = &regs_load_conv[ARCH_CURRENT];
+	regs_conv_add(conv, REGS_CONV_COPY, 0, sizeof(struct tcmi_regs), 0, sizeof(struct pt_regs), 0);
+
+	conv = &regs_load_conv[ARCH_X86_64];
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, orig_rax, orig_ax);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rax, ax);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rbx, bx);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rcx, cx);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rdx, dx);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rsi, si);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rdi, di);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, ss, ss);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, cs, cs);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rip, ip);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, eflags, flags);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rbp, bp);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_x86_64_regs, rsp, sp);
+	/* TODO: How to restore fs and es? It is not stored on 64 stack.. */
+	regs_conv_const(conv, fs, 0);
+	regs_conv_const(conv, es, 0);
+};
 
-		/* TODO: How to restore fs and es? It is not stored on 64 stack.. */
-		regs->fs = 0;
-		regs->es = 0;
+void load_from_platform_registers(void* platform_registers, struct pt_regs* regs, enum arch_ids from_arch, int is_32bit_app) {
+	BUILD_BUG_ON(sizeof(struct pt_regs) != sizeof(struct tcmi_regs));
 
+	if ( from_arch <= UNKNOWN || from_arch >= ARCH_COUNT || !regs_load_conv[from_arch].steps ) {
+		mdbg(ERR3, "Unsupported source platform: %d", from_arch);
 		return;
 	}
 
-
-	mdbg(ERR3, "Unsupported source platform: %d", from_arch);
+	regs_conv_apply(&regs_load_conv[from_arch], platform_registers, regs);
 };
 
 int is_in_syscall(struct pt_regs* regs) {
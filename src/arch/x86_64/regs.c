@@ -48,54 +48,58 @@ void* get_target_platform_registers(struct pt_regs* regs, enum arch_ids target_a
 	return NULL;
 };
 
-void load_from_platform_registers(void* platform_registers, struct pt_regs* regs, enum arch_ids from_arch, int is_32bit_app) {
-	if ( from_arch == ARCH_CURRENT ) {
-		/** Simple load of equal registers */
-		load_registers( (struct tcmi_regs*)platform_registers, regs);
+/** Conversion descriptors indexed by the source architecture */
+static struct regs_conv regs_load_conv[ARCH_COUNT];
+
+void regs_conv_init(void) {
+	struct regs_conv* conv;
+
+	memset(regs_load_conv, 0, sizeof(regs_load_conv));
+
+	/* Registers of the same architecture are copied as a whole */
+	conv = &regs_load_conv[ARCH_CURRENT];
+	regs_conv_add(conv, REGS_CONV_COPY, 0, sizeof(struct tcmi_regs), 0, sizeof(struct pt_regs), 0);
+
+	conv = &regs_load_conv[ARCH_I386];
+	/* orig_eax is the only signed register, the syscall restart logic relies on its sign */
+	regs_conv_field(conv, REGS_CONV_SCOPY, struct tcmi_i386_regs, orig_eax, orig_ax);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, eax, ax);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, ebx, bx);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, ecx, cx);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, edx, dx);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, esi, si);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, edi, di);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, eip, ip);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, eflags, flags);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, ebp, bp);
+	regs_conv_field(conv, REGS_CONV_COPY, struct tcmi_i386_regs, esp, sp);
+	/* The checkpointed segments are meaningless in the compat mode */
+	regs_conv_const(conv, cs, __USER32_CS);
+	regs_conv_const(conv, ss, __USER32_DS);
+	regs_conv_const(conv, r8, 0);
+	regs_conv_const(conv, r9, 0);
+	regs_conv_const(conv, r10, 0);
+	regs_conv_const(conv, r11, 0);
+	regs_conv_const(conv, r12, 0);
+	regs_conv_const(conv, r13, 0);
+	regs_conv_const(conv, r14, 0);
+	regs_conv_const(conv, r15, 0);
+};
 
-		if ( is_32bit_app ) {
-			regs->cs = __USER32_CS;		
-			regs->ss = __USER32_DS;
-		}
+void load_from_platform_registers(void* platform_registers, struct pt_regs* regs, enum arch_ids from_arch, int is_32bit_app) {
+	BUILD_BUG_ON(sizeof(struct pt_regs) != sizeof(struct tcmi_regs));
 
+	if ( from_arch <= UNKNOWN || from_arch >= ARCH_COUNT || !regs_load_conv[from_arch].steps ) {
+		mdbg(ERR3, "Unsupported source platform: %d", from_arch);
 		return;
 	}
 
-	if ( from_arch == ARCH_I386) {
-		struct tcmi_i386_regs* tcmi_regs = (struct tcmi_i386_regs*)platform_registers;
-		regs->orig_ax = tcmi_regs->orig_eax;;
-		regs->ax = tcmi_regs->eax;
-		regs->bx = tcmi_regs->ebx;
-		regs->cx = tcmi_regs->ecx;
-		regs->dx = tcmi_regs->edx;
-
-		regs->si = tcmi_regs->esi;
-		regs->di = tcmi_regs->edi;
-
-/*		regs->ss = tcmi_regs->xss;
-		regs->cs = tcmi_regs->xcs; */
+	regs_conv_apply(&regs_load_conv[from_arch], platform_registers, regs);
 
+	if ( from_arch == ARCH_CURRENT && is_32bit_app ) {
 		regs->cs = __USER32_CS;		
 		regs->ss = __USER32_DS;
-		regs->ip = tcmi_regs->eip;
-		regs->flags = tcmi_regs->eflags;
-		regs->bp = tcmi_regs->ebp;
-		regs->sp = tcmi_regs->esp;
-
-		regs->r8 = 0;
-		regs->r9 = 0;
-		regs->r10 = 0;
-		regs->r11 = 0;
-		regs->r12 = 0;
-		regs->r13 = 0;
-		regs->r14 = 0;
-		regs->r15 = 0;
-
-		return;
 	}
-
-
-	mdbg(ERR3, "Unsupported source platform: %d", from_arch);
 };
 
 int is_in_syscall(struct pt_regs* regs) {
@@ -53,6 +53,7 @@ struct tcmi_x86_64_regs {
 #define original_ax(regs) ((regs)->orig_ax)
 
 extern void* get_target_platform_registers(struct pt_regs* regs, enum arch_ids target_arch);
+extern void regs_conv_init(void);
 extern void load_from_platform_registers(void* platform_registers, struct pt_regs* regs, enum arch_ids from_arch, int is_32bit_app);
 extern int is_in_syscall(struct pt_regs* regs);
 extern void debug_registers(struct pt_regs* regs);
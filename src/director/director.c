@@ -1,30 +1,45 @@
 #include "director.h"
+#include "npm_cache.h"
+#include "npm_hints.h"
 #include "netlink/comm.h"
 #include "netlink/npm_msg.h"
 #include "netlink/node_connected_msg.h"
 #include "netlink/node_disconnected_msg.h"
 #include "netlink/generic_user_message_recv_msg.h"
 #include "netlink/generic_user_message_send_handler.h"
+#include "netlink/migrate_batch_handler.h"
 #include "netlink/task_exitted_msg.h"
 #include "netlink/task_forked_msg.h"
 #include "netlink/immigration_request_msg.h"
 #include "netlink/immigration_confirmed_msg.h"
 #include "netlink/emigration_failed_msg.h"
 #include "netlink/migrated_home_msg.h"
+#include "netlink/task_migrated_msg.h"
 
 #include <linux/module.h>
 #include <dbg.h>
 
 MODULE_LICENSE("GPL");
 
-int director_npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, 
+int director_npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, struct file* file,
 		char* __user * __user argv, char* __user * __user envp, 
 		int* migman_to_use, int* migrate_home, struct rusage *rusage) {
+	struct npm_hint* hint;
 	int res, decision, decision_value;
 
 	// TODO: If full is not too expensive do full every time? Or perhaps some "learning" for which processes we should do full immediately and for which not?
 
-	res = npm_check(pid, uid, is_guest, name, &decision, &decision_value, rusage);
+	// The director has told us this binary always runs locally, so do not bother asking
+	if ( npm_cache_lookup(file, uid, is_guest) == NPM_CACHE_LOCAL ) {
+		minfo(INFO4, "Npm cache hit [%s]. Not migrating", name);
+		return 0;
+	}
+
+	// With a hint, the first check carries the args and envs the director needs, so it does not have to ask again
+	hint = npm_hint_get(name);
+	res = npm_check(pid, uid, is_guest, name, argv, envp, hint, &decision, &decision_value, rusage);
+	if ( hint )
+		npm_hint_put(hint);
 	minfo(INFO4, "Npm check [%s]. Decision: %d, Res %d", name, decision, res);
 	if ( res )
 		return res;
@@ -56,6 +71,12 @@ int director_npm_check(pid_t pid, uid_t uid, int is_guest, const char* name,
 
 EXPORT_SYMBOL(director_npm_check);
 
+int director_npm_cache_empty(void) {
+	return npm_cache_empty();
+}
+
+EXPORT_SYMBOL(director_npm_cache_empty);
+
 int director_immigration_request(int slot_index, uid_t uid, const char* name, int* accept) {
 	return immigration_request(slot_index, uid, name, accept);
 }
@@ -93,6 +114,12 @@ void director_register_send_generic_user_message_handler(send_generic_user_messa
 
 EXPORT_SYMBOL(director_register_send_generic_user_message_handler);
 
+void director_register_migrate_batch_handler(migrate_batch_handler_t handler) {
+	register_migrate_batch_handler(handler);
+}
+
+EXPORT_SYMBOL(director_register_migrate_batch_handler);
+
 int director_task_exit(pid_t pid, int exit_code, struct rusage *rusage) {
 	return task_exitted(pid, exit_code, rusage);	
 }
@@ -121,6 +148,12 @@ int director_migrated_home(pid_t pid) {
 
 EXPORT_SYMBOL(director_migrated_home);
 
+int director_task_migrated(pid_t pid, int restart, int phase_count, const u64 *durations, const u64 *bytes) {
+	return task_migrated(pid, restart, phase_count, durations, bytes);
+}
+
+EXPORT_SYMBOL(director_task_migrated);
+
 static int __init init_director_module(void) {
 	init_director_comm();
 	return 0;
@@ -128,6 +161,8 @@ static int __init init_director_module(void) {
 
 static void __exit exit_director_module(void) {	
 	destroy_director_comm();
+	npm_cache_flush();
+	npm_hint_flush();
 }
 
 module_init(init_director_module);
@@ -5,6 +5,8 @@
 #include <linux/resource.h>
 #include "handlers.h"
 
+struct file;
+
 /**
  * This is the main entry point that can be used by TCMI when it needs to consult user space director.
  */
@@ -12,11 +14,15 @@
 
 /**
  * Checks, whether the process should be non-preemptively migrated to some other node.
+ * Binaries the director has marked as always local in the npm decision cache are not migrated
+ * without asking the director.
  *
  * @param pid Pid of the process
  * @param uid Effective user ID of the process being executed
  * @param is_guest 1 if the process is guest
  * @param name File name, that is being executed
+ * @param file The binary being executed, opened by the caller, used to look up the npm decision cache. May be NULL
+ *             when director_npm_cache_empty() says there is nothing to look up
  * @param argv Args of execve
  * @param envp Envp of execve
  * @param migman_to_use Output parameter.. slot index of migration manager to be used
@@ -27,7 +33,14 @@
  *         1 on success, when a migration should be performed
  *         error code otherwise. In case of error, output params are not valid!
  */
-int director_npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, char* __user * __user argv, char* __user * __user envp, int* migman_to_use, int* migrate_home, struct rusage *rusage);
+int director_npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, struct file* file, char* __user * __user argv, char* __user * __user envp, int* migman_to_use, int* migrate_home, struct rusage *rusage);
+
+/**
+ * Checks, whether the npm decision cache is empty, so that the caller does not have to open the binary for the lookup.
+ *
+ * @return 1 if there is no cached decision
+ */
+int director_npm_cache_empty(void);
 
 /**
  * Request to immigrate process from core node specified by slot_index to this node.
@@ -121,10 +134,27 @@ int director_emigration_failed(pid_t pid);
  */
 int director_migrated_home(pid_t pid);
 
+/**
+ * Called, when a task has been checkpointed for a migration or restarted after it.
+ * Reports duration and size of each checkpoint/restart phase.
+ * @param pid Local pid of the task
+ * @param restart 1 if the task has been restarted on this node, 0 if it has been checkpointed here
+ * @param phase_count Number of phases in the following arrays
+ * @param durations Duration of each phase in nanoseconds
+ * @param bytes Number of image bytes processed by each phase
+ * @return 0 on success, error code otherwise.
+ */
+int director_task_migrated(pid_t pid, int restart, int phase_count, const u64 *durations, const u64 *bytes);
+
 /**
  * Registers handler for send generic user message command..
  */
 void director_register_send_generic_user_message_handler(send_generic_user_message_handler_t handler);
 
+/**
+ * Registers handler for batch migration command.
+ */
+void director_register_migrate_batch_handler(migrate_batch_handler_t handler);
+
 
 #endif
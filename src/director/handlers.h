@@ -1,6 +1,8 @@
 #ifndef DIRECTOR_HANDLERS_H
 #define DIRECTOR_HANDLERS_H
 
+#include <linux/types.h>
+
 /**
  * Handler of user message transmission requests. 
  * 
@@ -14,4 +16,37 @@
  */
 typedef int (*send_generic_user_message_handler_t)(int is_core_node, int target_slot_index, int user_data_size, char* user_data);
 
+/** Modes of migrations requested in a batch */
+enum director_migration_mode {
+	DIRECTOR_MIGRATION_EMIGRATE_PPM_P = 0, /* Preemptive emigration to a node */
+	DIRECTOR_MIGRATION_HOME_PPM_P = 1, /* Preemptive migration home */
+	DIRECTOR_MIGRATION_HOME_PPM_V = 2, /* Preemptive migration home with an in-memory image */
+};
+
+/** Max number of migrations in a single batch */
+#define DIRECTOR_MIGRATION_BATCH_MAX 256
+
+/** Single migration of a batch, the layout is shared with user space */
+struct director_migration {
+	/** Pid of the migrated task */
+	int32_t pid;
+	/** Slot index of the target node, ignored when migrating home */
+	int32_t slot_index;
+	/** Migration mode (director_migration_mode) */
+	int32_t mode;
+	/** Reserved, must be 0 */
+	int32_t reserved;
+};
+
+/**
+ * Handler of batch migration requests. The migrations are started asynchronously, failures are reported 
+ * the same way as for single migration requests.
+ * 
+ * @param is_core_node 1 if the core node manager shall migrate the tasks, 0 for the detached node manager
+ * @param count Number of migrations
+ * @param migrations Migrations to be performed, the handler must not keep a reference to them
+ * @returns 0 when the migrations were started, EINVAL for a malformed batch, ENOMEM if out of memory
+ */
+typedef int (*migrate_batch_handler_t)(int is_core_node, int count, struct director_migration* migrations);
+
 #endif
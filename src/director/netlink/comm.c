@@ -7,6 +7,11 @@
 #include <dbg.h>
 
 #include "generic_user_message_send_handler.h"
+#include "npm_cache_set_handler.h"
+#include "npm_hint_set_handler.h"
+#include "migrate_batch_handler.h"
+#include "../npm_cache.h"
+#include "../npm_hints.h"
 
 const char* DIRECTOR_CHANNEL_NAME = "DIRECTORCHNL";
 
@@ -33,6 +38,13 @@ static struct nla_policy director_genl_policy[DIRECTOR_ATTR_MAX + 1] = {
 	[DIRECTOR_A_EXIT_CODE] = { .type = NLA_U32 },
 	[DIRECTOR_A_ERRNO] = { .type = NLA_U32 },
 	[DIRECTOR_A_RUSAGE] = { .type = NLA_BINARY, .len = sizeof(struct rusage) },
+	[DIRECTOR_A_RESTART] = { .type = NLA_U32 },
+	[DIRECTOR_A_PHASE_TIMES] = { .type = NLA_BINARY },
+	[DIRECTOR_A_PHASE_BYTES] = { .type = NLA_BINARY },
+	[DIRECTOR_A_CACHE_POLICY] = { .type = NLA_U32 },
+	[DIRECTOR_A_TTL] = { .type = NLA_U32 },
+	[DIRECTOR_A_ARG_MASK] = { .type = NLA_U32 },
+	[DIRECTOR_A_MIGRATIONS] = { .type = NLA_BINARY, .len = DIRECTOR_MIGRATION_BATCH_MAX * sizeof(struct director_migration) },
 };
 
 /**
@@ -79,6 +91,9 @@ static int register_pid_handler(struct sk_buff *skb, struct genl_info *info) {
 
 	user_director_pid = nla_get_u32(attr);
 	minfo(INFO1, "Registered director pid: %u", user_director_pid);
+	/* Decisions cached and hints registered by a previous director are not valid anymore */
+	npm_cache_flush();
+	npm_hint_flush();
 
 
 	return 0;
@@ -100,6 +115,30 @@ static struct genl_ops send_user_message_ops = {
 	.dumpit = NULL,
 };
 
+static struct genl_ops npm_cache_set_ops = {
+        .cmd = DIRECTOR_NPM_CACHE_SET,
+        .flags = GENL_ADMIN_PERM,
+        .policy = director_genl_policy,
+	.doit = handle_npm_cache_set,
+	.dumpit = NULL,
+};
+
+static struct genl_ops npm_hint_set_ops = {
+        .cmd = DIRECTOR_NPM_HINT_SET,
+        .flags = 0,
+        .policy = director_genl_policy,
+	.doit = handle_npm_hint_set,
+	.dumpit = NULL,
+};
+
+static struct genl_ops migrate_batch_ops = {
+        .cmd = DIRECTOR_MIGRATE_BATCH,
+        .flags = GENL_ADMIN_PERM,
+        .policy = director_genl_policy,
+	.doit = handle_migrate_batch,
+	.dumpit = NULL,
+};
+
 static struct genl_ops* check_npm_ops_ref,
 		      * node_connected_ops_ref,
 		      * ack_ops_ref,
@@ -119,6 +158,12 @@ int init_director_comm(void) {
 
 	genl_register_ops(&director_gnl_family, &send_user_message_ops);	
 
+	genl_register_ops(&director_gnl_family, &npm_cache_set_ops);
+
+	genl_register_ops(&director_gnl_family, &npm_hint_set_ops);
+
+	genl_register_ops(&director_gnl_family, &migrate_batch_ops);
+
 	/* Register generic dispatching callback for all other calls */
 	check_npm_ops_ref = genlmsg_register_tx_ops(&director_gnl_family, director_genl_policy, DIRECTOR_NPM_RESPONSE);
 	if ( !check_npm_ops_ref )
@@ -151,6 +196,9 @@ void destroy_director_comm(void) {
 
 	genl_unregister_ops(&director_gnl_family, &register_pid_ops);
 	genl_unregister_ops(&director_gnl_family, &send_user_message_ops);
+	genl_unregister_ops(&director_gnl_family, &npm_cache_set_ops);
+	genl_unregister_ops(&director_gnl_family, &npm_hint_set_ops);
+	genl_unregister_ops(&director_gnl_family, &migrate_batch_ops);
 	genl_unregister_ops(&director_gnl_family, check_npm_ops_ref);
 	genl_unregister_ops(&director_gnl_family, node_connected_ops_ref);
 	genl_unregister_ops(&director_gnl_family, ack_ops_ref);
@@ -0,0 +1,45 @@
+#include "msgs.h"
+#include "genl_ext.h"
+#include "comm.h"
+
+#include <dbg.h>
+
+#include <linux/skbuff.h>
+#include "migrate_batch_handler.h"
+
+/** Handler instance */
+static migrate_batch_handler_t migrate_batch_handler = NULL;
+
+void register_migrate_batch_handler(migrate_batch_handler_t handler) {
+	migrate_batch_handler = handler;
+};
+
+int handle_migrate_batch(struct sk_buff *skb, struct genl_info *info) {
+	struct nlattr* attr;
+	int slot_type, count;
+
+	// No handler registered?
+	if ( !migrate_batch_handler ) {
+		return -EINVAL;
+	}
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_SLOT_TYPE);
+	if ( attr == NULL ) {
+		return -EINVAL;
+	}
+	slot_type = nla_get_u32(attr);
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_MIGRATIONS);
+	if ( attr == NULL ) {
+		return -EINVAL;
+	}
+	if ( nla_len(attr) % sizeof(struct director_migration) ) {
+		return -EINVAL;
+	}
+	count = nla_len(attr) / sizeof(struct director_migration);
+	if ( count == 0 || count > DIRECTOR_MIGRATION_BATCH_MAX ) {
+		return -EINVAL;
+	}
+
+	return migrate_batch_handler(slot_type, count, nla_data(attr));
+};
@@ -0,0 +1,10 @@
+#ifndef MIGRATE_BATCH_HANDLER_H
+#define MIGRATE_BATCH_HANDLER_H
+
+#include "../handlers.h"
+
+void register_migrate_batch_handler(migrate_batch_handler_t handler);
+
+int handle_migrate_batch(struct sk_buff *skb, struct genl_info *info);
+
+#endif
@@ -8,6 +8,9 @@ enum {
   /* User space requests */
   DIRECTOR_REGISTER_PID, /* User helper daemon initially registers itself and its PID to the kernel */
   DIRECTOR_SEND_GENERIC_USER_MESSAGE, /* Informs requests transmission of a generic user message to peer */
+  DIRECTOR_NPM_CACHE_SET, /* Installs a kernel side npm decision cache policy for a binary */
+  DIRECTOR_NPM_HINT_SET, /* Registers args and envs to be passed in the first npm check of a binary */
+  DIRECTOR_MIGRATE_BATCH, /* Requests a batch of preemptive migrations */
   /* Generic ack */
   DIRECTOR_ACK,
 
@@ -23,6 +26,7 @@ enum {
   DIRECTOR_GENERIC_USER_MESSAGE, /* Informs about newly arrived generic user message */
   DIRECTOR_EMIGRATION_FAILED, /* Informs director about failed emigration request (could be npm or ppm, director should know which one based on provided pid) */
   DIRECTOR_MIGRATED_HOME, /* Informs director that a task was migrated home */
+  DIRECTOR_TASK_MIGRATED, /* Informs director about phases of a checkpoint/restart of a migrated task */
 
   /* Responses */
   DIRECTOR_NPM_RESPONSE, /* Response on non-preemptive migration check */
@@ -59,6 +63,14 @@ enum {
   DIRECTOR_A_EXIT_CODE, /* 32 bit length */  
   DIRECTOR_A_ERRNO, /* error code, in case some error occured */
   DIRECTOR_A_RUSAGE,
+  DIRECTOR_A_RESTART, /* 32 bit (1=restart, 0=checkpoint) */
+  DIRECTOR_A_PHASE_TIMES, /* array of 64 bit phase durations in ns (header, files, mm, vmas, regs, signals, conv) */
+  DIRECTOR_A_PHASE_BYTES, /* array of 64 bit image bytes processed by the phases */
+  DIRECTOR_A_CACHE_POLICY, /* 32 bit npm decision cache policy */
+  DIRECTOR_A_TTL, /* 32 bit time to live in seconds, 0 = unlimited */
+  DIRECTOR_A_ARG_MASK, /* 32 bit mask of argv elements, 0xffffffff = all */
+  DIRECTOR_A_DIGEST, /* 32 bit digest of args and envs that were not passed */
+  DIRECTOR_A_MIGRATIONS, /* array of struct director_migration */
 
   __DIRECTOR_ATTR_MAX
 };
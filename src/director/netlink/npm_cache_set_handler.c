@@ -0,0 +1,51 @@
+#include "msgs.h"
+#include "genl_ext.h"
+#include "comm.h"
+
+#include <dbg.h>
+
+#include <linux/skbuff.h>
+#include "npm_cache_set_handler.h"
+#include "../npm_cache.h"
+
+int handle_npm_cache_set(struct sk_buff *skb, struct genl_info *info) {
+	struct nlattr* attr;
+	char* name;
+	uid_t uid;
+	int is_guest = 0;
+	int policy;
+	unsigned int ttl = 0;
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_NAME);
+	if ( attr == NULL ) {
+		return -EINVAL;
+	}
+	name = nla_data(attr);
+	if ( !nla_len(attr) || name[nla_len(attr) - 1] != '\0' ) {
+		return -EINVAL;
+	}
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_UID);
+	if ( attr == NULL ) {
+		return -EINVAL;
+	}
+	uid = nla_get_u32(attr);
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_TASK_TYPE);
+	if ( attr != NULL ) {
+		is_guest = nla_get_u32(attr);
+	}
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_CACHE_POLICY);
+	if ( attr == NULL ) {
+		return -EINVAL;
+	}
+	policy = nla_get_u32(attr);
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_TTL);
+	if ( attr != NULL ) {
+		ttl = nla_get_u32(attr);
+	}
+
+	return npm_cache_set(name, uid, is_guest, policy, ttl);
+};
@@ -0,0 +1,10 @@
+#ifndef NPM_CACHE_SET_HANDLER_H
+#define NPM_CACHE_SET_HANDLER_H
+
+struct sk_buff;
+struct genl_info;
+
+/** Handles request of the user space director to install a npm decision cache policy for a binary */
+int handle_npm_cache_set(struct sk_buff *skb, struct genl_info *info);
+
+#endif
@@ -0,0 +1,59 @@
+#include "msgs.h"
+#include "genl_ext.h"
+#include "comm.h"
+
+#include <dbg.h>
+
+#include <linux/skbuff.h>
+#include "npm_hint_set_handler.h"
+#include "../npm_hints.h"
+
+/** Returns string data of an attribute, or NULL if the attribute is not a string */
+static const char* get_string(struct nlattr* attr) {
+	const char* str = nla_data(attr);
+
+	if ( !nla_len(attr) || str[nla_len(attr) - 1] != '\0' )
+		return NULL;
+
+	return str;
+}
+
+int handle_npm_hint_set(struct sk_buff *skb, struct genl_info *info) {
+	struct nlattr *attr, *iter;
+	const char* suffix;
+	const char* envs[NPM_HINT_MAX_ENVS];
+	int env_count = 0, rem;
+	u32 arg_mask = 0;
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_NAME);
+	if ( attr == NULL || !(suffix = get_string(attr)) ) {
+		return -EINVAL;
+	}
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_ARG_MASK);
+	if ( attr != NULL ) {
+		arg_mask = nla_get_u32(attr);
+	}
+
+	attr = nlmsg_find_attr(info->nlhdr, sizeof(struct genlmsghdr), DIRECTOR_A_ENVS);
+	if ( attr != NULL ) {
+		nla_for_each_nested(iter, attr, rem) {
+			if ( nla_type(iter) != DIRECTOR_A_ENV )
+				continue;
+
+			if ( env_count == NPM_HINT_MAX_ENVS )
+				return -E2BIG;
+
+			if ( !(envs[env_count++] = get_string(iter)) )
+				return -EINVAL;
+		}
+	}
+
+	// A hint selecting nothing is just a request to remove the hint
+	if ( !arg_mask && !env_count ) {
+		npm_hint_remove(suffix);
+		return 0;
+	}
+
+	return npm_hint_set(suffix, arg_mask, env_count, envs);
+};
@@ -0,0 +1,10 @@
+#ifndef NPM_HINT_SET_HANDLER_H
+#define NPM_HINT_SET_HANDLER_H
+
+struct sk_buff;
+struct genl_info;
+
+/** Handles request of the user space director to register a hint of args and envs it needs for npm checks of a binary */
+int handle_npm_hint_set(struct sk_buff *skb, struct genl_info *info);
+
+#endif
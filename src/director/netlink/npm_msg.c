@@ -7,6 +7,12 @@
 
 #include <linux/skbuff.h>
 #include <linux/resource.h>
+#include <linux/binfmts.h>
+#include <linux/jhash.h>
+#include <linux/gfp.h>
+#include <asm/uaccess.h>
+
+#include "../npm_hints.h"
 
 struct npm_check_params {
 	/* In params */
@@ -19,6 +25,8 @@ struct npm_check_params {
 	/* Params only in full mode */
 	char __user * __user * args;
 	char __user * __user * envp;
+	/* Hint selecting args and envs for the first check, if any */
+	struct npm_hint* hint;
 
 	/* Out params */
 	/** User mode helper decision.. one of npm_msg_response enum */
@@ -27,6 +35,131 @@ struct npm_check_params {
 	int decision_value; 
 };
 
+/**
+ * Copies an element of a user space string array into a page sized buffer. Longer strings are truncated.
+ *
+ * @return Length of the string, -ENOENT past the end of the array, other error code on failure
+ */
+static int get_user_string(char __user * __user * array, int index, char* buf) {
+	char __user* str;
+	long len;
+
+	if ( !array || index >= MAX_ARG_STRINGS )
+		return -ENOENT;
+
+	if ( get_user(str, array + index) )
+		return -EFAULT;
+
+	if ( !str )
+		return -ENOENT;
+
+	len = strncpy_from_user(buf, str, PAGE_SIZE - 1);
+	if ( len < 0 )
+		return len;
+
+	buf[len] = '\0';
+	return len;
+}
+
+/** Returns 1 if the environment variable is selected by the hint */
+static int hint_wants_env(struct npm_hint* hint, const char* env) {
+	int i, len;
+
+	for ( i = 0; i < hint->env_count; i++ ) {
+		len = strlen(hint->envs[i]);
+		if ( !strncmp(env, hint->envs[i], len) && env[len] == '=' )
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Puts args and envs selected by the hint into the request. Args keep their positions, so the
+ * args that are not selected and precede a selected one are put as empty strings. All strings
+ * that are not put are hashed into a digest, so that the director can tell executions with the
+ * same selected values apart.
+ *
+ * @return 0 on success, -EMSGSIZE if the strings do not fit into the request
+ */
+static int put_hinted_strings(struct sk_buff *skb, struct npm_check_params* check_params) {
+	struct npm_hint* hint = check_params->hint;
+	struct nlattr* nest_attr;
+	u32 digest = 0;
+	char* buf;
+	int i, len, count = 0, ret = 0;
+
+	buf = (char*)__get_free_page(GFP_KERNEL);
+	if ( !buf )
+		return -ENOMEM;
+
+	nest_attr = nla_nest_start(skb, DIRECTOR_A_ARGS);
+	if ( !nest_attr ) {
+		ret = -EMSGSIZE;
+		goto done;
+	}
+
+	for ( i = 0; (len = get_user_string(check_params->args, i, buf)) >= 0; i++ ) {
+		if ( !npm_hint_wants_arg(hint, i) ) {
+			digest = jhash(buf, len, digest);
+			continue;
+		}
+
+		for ( ; count < i; count++ ) {
+			if ( (ret = nla_put_string(skb, DIRECTOR_A_ARG, "")) )
+				goto done;
+		}
+
+		if ( (ret = nla_put_string(skb, DIRECTOR_A_ARG, buf)) )
+			goto done;
+		count++;
+	}
+	if ( len != -ENOENT ) {
+		ret = len;
+		goto done;
+	}
+
+	if ( (ret = nla_put_u32(skb, DIRECTOR_A_LENGTH, count)) )
+		goto done;
+	nla_nest_end(skb, nest_attr);
+
+	nest_attr = nla_nest_start(skb, DIRECTOR_A_ENVS);
+	if ( !nest_attr ) {
+		ret = -EMSGSIZE;
+		goto done;
+	}
+
+	count = 0;
+	for ( i = 0; (len = get_user_string(check_params->envp, i, buf)) >= 0; i++ ) {
+		if ( !hint_wants_env(hint, buf) ) {
+			digest = jhash(buf, len, digest);
+			continue;
+		}
+
+		if ( (ret = nla_put_string(skb, DIRECTOR_A_ENV, buf)) )
+			goto done;
+		count++;
+	}
+	if ( len != -ENOENT ) {
+		ret = len;
+		goto done;
+	}
+
+	if ( (ret = nla_put_u32(skb, DIRECTOR_A_LENGTH, count)) )
+		goto done;
+	nla_nest_end(skb, nest_attr);
+
+	ret = nla_put_u32(skb, DIRECTOR_A_DIGEST, digest);
+
+done:
+	if ( ret == -EMSGSIZE )
+		minfo(INFO3, "Hinted args of [%s] do not fit into the request", check_params->name);
+	else if ( ret )
+		minfo(ERR1, "Putting of hinted args has failed: %d", ret);
+	free_page((unsigned long)buf);
+	return ret;
+}
+
 /** Creates npm check request */
 static int npm_check_create_request(struct sk_buff *skb, void* params) {
   	int ret = 0;
@@ -58,6 +191,19 @@ static int npm_check_create_request(struct sk_buff *skb, void* params) {
       			goto failure;
 	}
 
+	if (check_params->hint) {
+		unsigned char* mark = skb_tail_pointer(skb);
+
+		ret = put_hinted_strings(skb, check_params);
+		if (ret == -EMSGSIZE) {
+			/* Send the check without hinted strings, director asks for them with a full check */
+			nlmsg_trim(skb, mark);
+			ret = 0;
+		}
+		if (ret != 0)
+			goto failure;
+	}
+
 failure:
 
 	return ret;
@@ -91,7 +237,8 @@ static struct msg_transaction_ops npm_check_msg_ops = {
 	.read_response = npm_check_read_response
 };
 
-int npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, int* decision, int* decision_value, struct rusage *rusage) {
+int npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, char __user * __user * args, char __user* __user* envp,
+		struct npm_hint* hint, int* decision, int* decision_value, struct rusage *rusage) {
 	struct npm_check_params params;
 	int ret;
 
@@ -100,8 +247,9 @@ int npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, int* decisio
 	params.is_guest = is_guest;
 	params.name = name;
 	params.name_length = strlen(name);
-	params.args = NULL;
-	params.envp = NULL;
+	params.args = args;
+	params.envp = envp;
+	params.hint = hint;
 	params.rusage = rusage;
 
 	ret = msg_transaction_do(DIRECTOR_CHECK_NPM, &npm_check_msg_ops, &params, 0);
@@ -206,6 +354,7 @@ int npm_check_full(pid_t pid, uid_t uid, int is_guest, const char* name, char __
 	params.name_length = strlen(name);
 	params.args = args;
 	params.envp = envp;
+	params.hint = NULL;
 	params.rusage = NULL;
 
 	ret = msg_transaction_do(DIRECTOR_CHECK_FULL_NPM, &npm_check_full_msg_ops, &params, 0);
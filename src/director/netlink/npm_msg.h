@@ -4,6 +4,8 @@
 #include <linux/types.h>
 #include <linux/resource.h>
 
+struct npm_hint;
+
 enum npm_msg_response {
 	DO_NOT_MIGRATE, 
 	MIGRATE, // In this case second return params is target migman id
@@ -16,16 +18,22 @@ enum npm_msg_response {
 
 /**
  * Checks, whether the process should be non-preemptively migrated to some other node.
+ * If there is a hint registered for the binary, the selected args and envs are passed as well, together
+ * with a digest of the rest of them.
  *
  * @param pid Pid of the process
  * @param uid Effective user ID of the process being executed
  * @param is_guest 1 if the process is guest
  * @param name File name, that is being executed
+ * @param args Args of execve
+ * @param envp Envp of execve
+ * @param hint Hint describing which args and envs the director needs, or NULL
  * @param decision Output parameter.. element of "npm_msg_response" enum
  * @param decision_value Output param .. if result is to perform migration, this will contain slot of the migration manager to be used
  * @return 0 on success, error code otherwise. In case of error, output params are not valid!
  */
-int npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, int* decision, int* decision_value, struct rusage *rusage);
+int npm_check(pid_t pid, uid_t uid, int is_guest, const char* name, char __user * __user * args, char __user* __user* envp,
+		struct npm_hint* hint, int* decision, int* decision_value, struct rusage *rusage);
 
 /**
  * Checks, whether the process should be non-preemptively migrated to some other node.
@@ -0,0 +1,79 @@
+#include "msgs.h"
+#include "genl_ext.h"
+#include "comm.h"
+
+#include "task_migrated_msg.h"
+
+#include <dbg.h>
+
+#include <linux/skbuff.h>
+
+struct task_migrated_params {
+	/* In params */
+	u32 pid;
+	u32 restart;
+	u32 phase_count;
+	const u64 *durations;
+	const u64 *bytes;
+
+	/* Out params -> NONE */
+
+};
+
+static int task_migrated_create_request(struct sk_buff *skb, void* params) {
+  	int ret = 0;
+  	struct task_migrated_params* task_migrated_params = params;
+
+	ret = nla_put_u32(skb, DIRECTOR_A_PID, task_migrated_params->pid);
+  	if (ret != 0)
+      		goto failure;
+
+	ret = nla_put_u32(skb, DIRECTOR_A_RESTART, task_migrated_params->restart);
+  	if (ret != 0)
+      		goto failure;
+
+	ret = nla_put_u32(skb, DIRECTOR_A_LENGTH, task_migrated_params->phase_count);
+  	if (ret != 0)
+      		goto failure;
+
+	ret = nla_put(skb, DIRECTOR_A_PHASE_TIMES, task_migrated_params->phase_count * sizeof(u64), task_migrated_params->durations);
+  	if (ret != 0)
+      		goto failure;
+
+	ret = nla_put(skb, DIRECTOR_A_PHASE_BYTES, task_migrated_params->phase_count * sizeof(u64), task_migrated_params->bytes);
+  	if (ret != 0)
+      		goto failure;
+
+failure:
+	return ret;
+}
+
+
+static int task_migrated_read_response(struct genl_info* info, void* params) {
+	int ret = 0;
+
+	return ret;
+}
+
+static struct msg_transaction_ops task_migrated_msg_ops = {
+	.create_request = task_migrated_create_request,
+	.read_response = task_migrated_read_response
+};
+
+
+int task_migrated(pid_t pid, int restart, int phase_count, const u64 *durations, const u64 *bytes) {
+	struct task_migrated_params params;
+	int ret;
+
+	params.pid = pid;
+	params.restart = restart;
+	params.phase_count = phase_count;
+	params.durations = durations;
+	params.bytes = bytes;
+
+	ret = msg_transaction_do(DIRECTOR_TASK_MIGRATED, &task_migrated_msg_ops, &params, 1);
+
+	minfo(INFO3, "Task migrated. Pid:  %u  Restart: %d -> Res: %d", pid, restart, ret);
+
+	return ret;
+}
@@ -0,0 +1,18 @@
+#ifndef TASK_MIGRATED_MSG_H
+#define TASK_MIGRATED_MSG_H
+
+#include <linux/types.h>
+
+/**
+ * Called, when a task has been checkpointed for a migration or restarted after it
+ *
+ * @param pid Local pid of the task
+ * @param restart 1 if the task has been restarted on this node, 0 if it has been checkpointed here
+ * @param phase_count Number of phases in the following arrays
+ * @param durations Duration of each phase in nanoseconds
+ * @param bytes Number of image bytes processed by each phase
+ * @return 0 on success, error code otherwise
+ */
+int task_migrated(pid_t pid, int restart, int phase_count, const u64 *durations, const u64 *bytes);
+
+#endif
@@ -0,0 +1,198 @@
+#include "npm_cache.h"
+
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/list.h>
+#include <linux/hash.h>
+#include <linux/jiffies.h>
+#include <linux/namei.h>
+#include <linux/fs.h>
+#include <dbg.h>
+
+#define NPM_CACHE_HASH_BITS 8
+
+/** Identity of an executed binary and the user executing it */
+struct npm_cache_key {
+	unsigned long ino;
+	dev_t dev;
+	struct timespec mtime;
+	uid_t uid;
+	int is_guest;
+};
+
+/** Single cached decision */
+struct npm_cache_entry {
+	struct hlist_node node;
+	struct npm_cache_key key;
+	int policy;
+	/** Expiration time in jiffies, 0 if the entry never expires */
+	unsigned long expires;
+};
+
+static struct hlist_head npm_cache_hash[1 << NPM_CACHE_HASH_BITS];
+/** Number of cached entries, when 0 the lookup does not even build the key */
+static int npm_cache_entries = 0;
+/** Protects the hash table and the entries counter */
+static DEFINE_SPINLOCK(npm_cache_lock);
+
+/** Fills in identity of a binary */
+static void npm_cache_make_key(struct inode* inode, uid_t uid, int is_guest, struct npm_cache_key* key) {
+	key->ino = inode->i_ino;
+	key->dev = inode->i_sb->s_dev;
+	key->mtime = inode->i_mtime;
+	key->uid = uid;
+	key->is_guest = is_guest ? 1 : 0;
+}
+
+/** Resolves an absolute path of a binary into its identity. Returns 0 on success. */
+static int npm_cache_get_key(const char* name, uid_t uid, int is_guest, struct npm_cache_key* key) {
+	struct path path;
+	int err;
+
+	/* A relative name would be resolved against cwd of the director */
+	if ( name[0] != '/' )
+		return -EINVAL;
+
+	if ( (err = kern_path(name, LOOKUP_FOLLOW, &path)) )
+		return err;
+
+	npm_cache_make_key(path.dentry->d_inode, uid, is_guest, key);
+	path_put(&path);
+
+	return 0;
+}
+
+static struct hlist_head* npm_cache_bucket(const struct npm_cache_key* key) {
+	return &npm_cache_hash[hash_long(key->ino ^ key->dev ^ key->uid, NPM_CACHE_HASH_BITS)];
+}
+
+static int npm_cache_key_equal(const struct npm_cache_key* a, const struct npm_cache_key* b) {
+	return a->ino == b->ino && a->dev == b->dev && a->uid == b->uid && a->is_guest == b->is_guest &&
+		timespec_equal(&a->mtime, &b->mtime);
+}
+
+static int npm_cache_expired(const struct npm_cache_entry* entry) {
+	return entry->expires && time_after_eq(jiffies, entry->expires);
+}
+
+/** Removes an entry, has to be called with the lock held */
+static void npm_cache_remove(struct npm_cache_entry* entry) {
+	hlist_del(&entry->node);
+	npm_cache_entries--;
+	kfree(entry);
+}
+
+/** Finds an entry, expired entries are dropped. Has to be called with the lock held */
+static struct npm_cache_entry* npm_cache_find(const struct npm_cache_key* key) {
+	struct npm_cache_entry* entry;
+	struct hlist_node *pos, *tmp;
+
+	hlist_for_each_entry_safe(entry, pos, tmp, npm_cache_bucket(key), node) {
+		if ( npm_cache_expired(entry) ) {
+			npm_cache_remove(entry);
+			continue;
+		}
+		if ( npm_cache_key_equal(&entry->key, key) )
+			return entry;
+	}
+
+	return NULL;
+}
+
+/** Drops all expired entries, has to be called with the lock held */
+static void npm_cache_purge(void) {
+	struct npm_cache_entry* entry;
+	struct hlist_node *pos, *tmp;
+	int i;
+
+	for ( i = 0; i < ARRAY_SIZE(npm_cache_hash); i++ ) {
+		hlist_for_each_entry_safe(entry, pos, tmp, &npm_cache_hash[i], node) {
+			if ( npm_cache_expired(entry) )
+				npm_cache_remove(entry);
+		}
+	}
+}
+
+int npm_cache_set(const char* name, uid_t uid, int is_guest, int policy, unsigned int ttl) {
+	struct npm_cache_key key;
+	struct npm_cache_entry *entry, *new_entry = NULL;
+	int err;
+
+	if ( policy != NPM_CACHE_ASK && policy != NPM_CACHE_LOCAL )
+		return -EINVAL;
+
+	if ( (err = npm_cache_get_key(name, uid, is_guest, &key)) ) {
+		minfo(INFO3, "Cannot resolve npm cache binary [%s]: %d", name, err);
+		return err;
+	}
+
+	if ( policy != NPM_CACHE_ASK ) {
+		new_entry = kmalloc(sizeof(*new_entry), GFP_KERNEL);
+		if ( !new_entry )
+			return -ENOMEM;
+		new_entry->key = key;
+		new_entry->policy = policy;
+		if ( ttl > NPM_CACHE_MAX_TTL )
+			ttl = NPM_CACHE_MAX_TTL;
+		new_entry->expires = ttl ? jiffies + ttl * HZ : 0;
+		/* 0 is reserved for entries that never expire */
+		if ( ttl && !new_entry->expires )
+			new_entry->expires = 1;
+	}
+
+	spin_lock(&npm_cache_lock);
+	if ( (entry = npm_cache_find(&key)) )
+		npm_cache_remove(entry);
+
+	if ( new_entry ) {
+		if ( npm_cache_entries >= NPM_CACHE_MAX_ENTRIES )
+			npm_cache_purge();
+		if ( npm_cache_entries >= NPM_CACHE_MAX_ENTRIES ) {
+			spin_unlock(&npm_cache_lock);
+			kfree(new_entry);
+			return -ENOSPC;
+		}
+		hlist_add_head(&new_entry->node, npm_cache_bucket(&key));
+		npm_cache_entries++;
+	}
+	spin_unlock(&npm_cache_lock);
+
+	minfo(INFO3, "Npm cache [%s] uid %u guest %d. Policy %d, ttl %u", name, uid, is_guest, policy, ttl);
+
+	return 0;
+}
+
+int npm_cache_lookup(struct file* file, uid_t uid, int is_guest) {
+	struct npm_cache_key key;
+	struct npm_cache_entry* entry;
+	int policy = NPM_CACHE_ASK;
+
+	if ( !file || npm_cache_empty() )
+		return NPM_CACHE_ASK;
+
+	npm_cache_make_key(file->f_path.dentry->d_inode, uid, is_guest, &key);
+
+	spin_lock(&npm_cache_lock);
+	if ( (entry = npm_cache_find(&key)) )
+		policy = entry->policy;
+	spin_unlock(&npm_cache_lock);
+
+	return policy;
+}
+
+int npm_cache_empty(void) {
+	return !npm_cache_entries;
+}
+
+void npm_cache_flush(void) {
+	struct npm_cache_entry* entry;
+	struct hlist_node *pos, *tmp;
+	int i;
+
+	spin_lock(&npm_cache_lock);
+	for ( i = 0; i < ARRAY_SIZE(npm_cache_hash); i++ ) {
+		hlist_for_each_entry_safe(entry, pos, tmp, &npm_cache_hash[i], node)
+			npm_cache_remove(entry);
+	}
+	spin_unlock(&npm_cache_lock);
+}
@@ -0,0 +1,61 @@
+#ifndef NPM_CACHE_H
+#define NPM_CACHE_H
+
+#include <linux/types.h>
+
+struct file;
+
+/**
+ * Kernel side cache of non-preemptive migration decisions.
+ *
+ * The user space director can tell the kernel that exec of some binary by some user should never
+ * be migrated, so that the npm check of such an exec does not need a netlink round trip. Entries are
+ * keyed by identity of the binary (inode, device and modification time), the effective uid and whether
+ * the process is a guest, so a modified or replaced binary is asked about again.
+ */
+
+/** Policies the director can install for a binary */
+enum npm_cache_policy {
+	NPM_CACHE_ASK, /* Ask the director on each exec, i.e. remove any cached decision */
+	NPM_CACHE_LOCAL, /* Do not migrate, without asking the director */
+};
+
+/** Maximum number of cached decisions */
+#define NPM_CACHE_MAX_ENTRIES 1024
+
+/** Longest TTL in seconds, longer TTLs are clamped so that the expiry fits into jiffies */
+#define NPM_CACHE_MAX_TTL (7 * 24 * 3600)
+
+/**
+ * Installs a policy for a binary.
+ *
+ * @param name Absolute path to the binary
+ * @param uid Effective user ID the policy applies to
+ * @param is_guest 1 if the policy applies to guests, 0 if to local processes
+ * @param policy Element of "npm_cache_policy" enum
+ * @param ttl Number of seconds the policy is valid for, 0 if it is valid until replaced, at most NPM_CACHE_MAX_TTL
+ * @return 0 on success, error code otherwise
+ */
+int npm_cache_set(const char* name, uid_t uid, int is_guest, int policy, unsigned int ttl);
+
+/**
+ * Looks up a cached decision for an exec.
+ *
+ * @param file The binary being executed
+ * @param uid Effective user ID of the process
+ * @param is_guest 1 if the process is guest
+ * @return Cached policy, NPM_CACHE_ASK if there is none
+ */
+int npm_cache_lookup(struct file* file, uid_t uid, int is_guest);
+
+/**
+ * Checks, whether there is any cached decision. Racy, but a missed entry only costs an upcall.
+ *
+ * @return 1 if the cache is empty
+ */
+int npm_cache_empty(void);
+
+/** Drops all cached decisions */
+void npm_cache_flush(void);
+
+#endif
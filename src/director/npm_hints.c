@@ -0,0 +1,130 @@
+#include "npm_hints.h"
+
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/list.h>
+#include <linux/string.h>
+#include <dbg.h>
+
+static LIST_HEAD(npm_hints);
+static int npm_hint_count = 0;
+/** Protects the list of hints */
+static DEFINE_SPINLOCK(npm_hints_lock);
+
+static void npm_hint_free(struct npm_hint* hint) {
+	int i;
+
+	for ( i = 0; i < hint->env_count; i++ )
+		kfree(hint->envs[i]);
+	kfree(hint->suffix);
+	kfree(hint);
+}
+
+void npm_hint_put(struct npm_hint* hint) {
+	if ( atomic_dec_and_test(&hint->ref_count) )
+		npm_hint_free(hint);
+}
+
+/** Finds a hint with an equal suffix, has to be called with the lock held */
+static struct npm_hint* npm_hint_find(const char* suffix) {
+	struct npm_hint* hint;
+
+	list_for_each_entry(hint, &npm_hints, node) {
+		if ( !strcmp(hint->suffix, suffix) )
+			return hint;
+	}
+
+	return NULL;
+}
+
+/** Unlinks a hint, has to be called with the lock held */
+static void npm_hint_unlink(struct npm_hint* hint) {
+	list_del(&hint->node);
+	npm_hint_count--;
+	npm_hint_put(hint);
+}
+
+int npm_hint_set(const char* suffix, u32 arg_mask, int env_count, const char** envs) {
+	struct npm_hint *hint, *old;
+	int i;
+
+	if ( env_count < 0 || env_count > NPM_HINT_MAX_ENVS )
+		return -EINVAL;
+
+	hint = kzalloc(sizeof(*hint), GFP_KERNEL);
+	if ( !hint )
+		return -ENOMEM;
+	atomic_set(&hint->ref_count, 1);
+	hint->arg_mask = arg_mask;
+	if ( !(hint->suffix = kstrdup(suffix, GFP_KERNEL)) )
+		goto exit0;
+	for ( i = 0; i < env_count; i++ ) {
+		if ( !(hint->envs[i] = kstrdup(envs[i], GFP_KERNEL)) )
+			goto exit0;
+		hint->env_count++;
+	}
+
+	spin_lock(&npm_hints_lock);
+	if ( (old = npm_hint_find(suffix)) )
+		npm_hint_unlink(old);
+	if ( npm_hint_count >= NPM_HINT_MAX ) {
+		spin_unlock(&npm_hints_lock);
+		npm_hint_free(hint);
+		return -ENOSPC;
+	}
+	list_add(&hint->node, &npm_hints);
+	npm_hint_count++;
+	spin_unlock(&npm_hints_lock);
+
+	minfo(INFO3, "Npm hint [%s]. Args 0x%x, envs %d", suffix, arg_mask, env_count);
+
+	return 0;
+
+exit0:
+	npm_hint_free(hint);
+	return -ENOMEM;
+}
+
+void npm_hint_remove(const char* suffix) {
+	struct npm_hint* hint;
+
+	spin_lock(&npm_hints_lock);
+	if ( (hint = npm_hint_find(suffix)) )
+		npm_hint_unlink(hint);
+	spin_unlock(&npm_hints_lock);
+}
+
+struct npm_hint* npm_hint_get(const char* name) {
+	struct npm_hint *hint, *best = NULL;
+	size_t name_length, suffix_length, best_length = 0;
+
+	/* Racy, but a missed hint only costs a second upcall */
+	if ( !npm_hint_count )
+		return NULL;
+
+	name_length = strlen(name);
+	spin_lock(&npm_hints_lock);
+	list_for_each_entry(hint, &npm_hints, node) {
+		suffix_length = strlen(hint->suffix);
+		if ( suffix_length > name_length || (best && suffix_length <= best_length) )
+			continue;
+		if ( strcmp(name + name_length - suffix_length, hint->suffix) )
+			continue;
+		best = hint;
+		best_length = suffix_length;
+	}
+	if ( best )
+		atomic_inc(&best->ref_count);
+	spin_unlock(&npm_hints_lock);
+
+	return best;
+}
+
+void npm_hint_flush(void) {
+	struct npm_hint *hint, *tmp;
+
+	spin_lock(&npm_hints_lock);
+	list_for_each_entry_safe(hint, tmp, &npm_hints, node)
+		npm_hint_unlink(hint);
+	spin_unlock(&npm_hints_lock);
+}
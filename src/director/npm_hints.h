@@ -0,0 +1,75 @@
+#ifndef NPM_HINTS_H
+#define NPM_HINTS_H
+
+#include <linux/types.h>
+#include <asm/atomic.h>
+
+/**
+ * Hints about the execve arguments the user space director needs for its npm decisions.
+ *
+ * Without a hint the director gets only the binary name in the first npm check and asks for
+ * the whole argv and envp with a second upcall, when it needs them. With a hint registered for
+ * the binary, the first check already carries the selected arguments and environment variables,
+ * plus a digest of the rest, so that one upcall is enough.
+ *
+ * Hints are matched against a suffix of the executed path, the longest matching suffix wins.
+ */
+
+/** Maximum number of registered hints */
+#define NPM_HINT_MAX 64
+/** Maximum number of environment keys in a hint */
+#define NPM_HINT_MAX_ENVS 8
+/** Argument mask selecting all arguments */
+#define NPM_HINT_ALL_ARGS 0xffffffffU
+
+struct npm_hint {
+	struct list_head node;
+	atomic_t ref_count;
+	/** Suffix of the path of binaries the hint applies to */
+	char* suffix;
+	/** Bit i set means argv[i] is needed, NPM_HINT_ALL_ARGS selects all of them */
+	u32 arg_mask;
+	/** Number of environment keys */
+	int env_count;
+	/** Keys of needed environment variables */
+	char* envs[NPM_HINT_MAX_ENVS];
+};
+
+/**
+ * Registers a hint, replacing a hint with the same suffix.
+ *
+ * @param suffix Suffix of the path of binaries the hint applies to
+ * @param arg_mask Mask of needed argv elements
+ * @param env_count Number of environment keys
+ * @param envs Keys of needed environment variables
+ * @return 0 on success, error code otherwise
+ */
+int npm_hint_set(const char* suffix, u32 arg_mask, int env_count, const char** envs);
+
+/**
+ * Removes a hint.
+ *
+ * @param suffix Suffix the hint was registered with
+ */
+void npm_hint_remove(const char* suffix);
+
+/**
+ * Finds a hint for a binary.
+ *
+ * @param name Path to the binary being executed
+ * @return Referenced hint that has to be released by npm_hint_put(), NULL if there is none
+ */
+struct npm_hint* npm_hint_get(const char* name);
+
+/** Releases a hint */
+void npm_hint_put(struct npm_hint* hint);
+
+/** Drops all hints */
+void npm_hint_flush(void);
+
+/** Returns 1 if argv[index] is selected by the hint */
+static inline int npm_hint_wants_arg(const struct npm_hint* hint, int index) {
+	return hint->arg_mask == NPM_HINT_ALL_ARGS || (index < 32 && (hint->arg_mask & (1U << index)));
+}
+
+#endif
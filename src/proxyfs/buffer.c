@@ -36,6 +36,56 @@
 #define BUFFER_PRIVATE
 #include "buffer.h"
 
+/** \<\<public\>\> Grow buffer to have the requested free space. The buffer
+ * is at least doubled on each growth and never grows above its maximum size,
+ * so the request may be satisfied only partially. The content is moved to the
+ * start of the new memory, offsets relative to the read pointer stay valid.
+ * @param self - pointer to this buffer instance
+ * @param space - wanted amount of free bytes
+ *
+ * @return amount of free bytes in buffer
+ */
+unsigned circ_buf_reserve(struct circ_buf *self, unsigned space)
+{
+	unsigned count, size, first;
+	void *buf;
+
+	if( circ_buf_free_space(self) >= space || self->size >= self->max_size )
+		return circ_buf_free_space(self);
+
+	count = circ_buf_count(self);
+	for( size = self->size << 1; size < self->max_size && size - count < space; size <<= 1 );
+	if( size > self->max_size )
+		size = self->max_size;
+
+	if( size >= CIRC_BUF_USE_VMALLOC )
+		buf = vmalloc( size );
+	else
+		buf = kmalloc( size, GFP_KERNEL );
+
+	if( buf == NULL ){
+		mdbg(ERR3, "Growing buffer to %u bytes failed", size);
+		return circ_buf_free_space(self);
+	}
+
+	first = circ_buf_get_read_size(self);
+	memcpy( buf, circ_buf_get_read_addr(self), first );
+	memcpy( buf + first, self->buf, count - first );
+
+	if( self->size >= CIRC_BUF_USE_VMALLOC )
+	 	vfree(self->buf);
+	else
+		kfree(self->buf);
+
+	mdbg(INFO3, "Buffer grown from %u to %u bytes (%u used)", self->size, size, count);
+	self->buf = buf;
+	self->size = size;
+	self->read = buf;
+	self->write = buf + count;
+	self->full = 0;
+	return size - count;
+}
+
 /** \<\<public\>\> Write to buffer 
  * @param self - pointer to this buffer instance
  * @param buf - pointer to data, which will be written
@@ -46,6 +96,8 @@
 int circ_buf_write(struct circ_buf *self, const char *buf, unsigned count)
 {
 	unsigned wrs;
+	if( count > circ_buf_free_space(self) )
+		circ_buf_reserve(self, count);
 	wrs = circ_buf_get_write_size(self);
 	if(wrs){
 		if( count < wrs ){
@@ -73,6 +125,8 @@ int circ_buf_write_user(struct circ_buf *self, const char *buf, unsigned count)
 {
 	unsigned wrs;
 	void *ptr;
+	if( count > circ_buf_free_space(self) )
+		circ_buf_reserve(self, count);
 	wrs = circ_buf_get_write_size(self);
 	if(wrs){
 		if( count < wrs ){
@@ -57,6 +57,8 @@ struct circ_buf {
 	int full;
 	/** Memory size */
 	unsigned size;
+	/** Memory size up to which the buffer can grow */
+	unsigned max_size;
 };
 
 /** \<\<public\>\> Initialize buffer structure 
@@ -72,6 +74,9 @@ int circ_buf_write(struct circ_buf *self, const char *buf, unsigned count);
 /** \<\<public\>\> Write to buffer from user space  */
 int circ_buf_write_user(struct circ_buf *self, const char *buf, unsigned count);
 
+/** \<\<public\>\> Grow buffer to have the requested free space */
+unsigned circ_buf_reserve(struct circ_buf *self, unsigned space);
+
 /** \<\<public\>\> Destructively read from buffer */
 int circ_buf_read(struct circ_buf *self, char *buf, unsigned count);
 
@@ -88,12 +93,22 @@ static inline int circ_buf_init(struct circ_buf *self, unsigned size)
 	if( self->buf == NULL ) return -1;
 
 	self->size = size;
+	self->max_size = size;
 	self->read = self->buf;
 	self->write = self->buf;
 	self->full = 0;
 	return 0;
 }
 
+/** \<\<public\>\> Allows the buffer to grow on demand
+ * @param self - pointer to this buffer instance
+ * @param max_size - memory size up to which the buffer can grow, see circ_buf_reserve()
+ */
+static inline void circ_buf_set_max_size(struct circ_buf *self, unsigned max_size)
+{
+	self->max_size = max_size > self->size ? max_size : self->size;
+}
+
 /** \<\<public\>\> Opossite function to circ_buf_init
  * @param self - pointer to this buffer instance
  */
@@ -105,6 +105,7 @@ int proxyfs_client_thread(void *ss)
 	mdbg(INFO3, "Proxy fs client connected succesfully");
 
 	list_add(&self->server->peers, &PROXYFS_TASK(self)->peers );
+	proxyfs_peer_send_params( self->server, 0, READ_BUF_SIZE );
 
 	proxyfs_task_complete( PROXYFS_TASK(self), start_struct ); // After this call *start_struct is invalid
 
@@ -143,9 +143,12 @@ int proxyfs_file_init(struct proxyfs_file_t* self)
 		mdbg(ERR3, "Allocating read buffer for proxy_file failed");
 		goto exit1;
 	}
+	circ_buf_set_max_size( & self->write_buf, WRITE_BUF_MAX_SIZE );
+	circ_buf_set_max_size( & self->read_buf, READ_BUF_MAX_SIZE );
 
 	self->state = 0;
 	self->write_buf_unconfirmed = 0;
+	self->peer_window = 0;
 	self->read_was_requested = 0;
 	self->peer = NULL;
 	return 0;
@@ -196,9 +199,23 @@ void proxyfs_file_set_peer(struct proxyfs_file_t *self, struct proxyfs_peer_t *p
 		mdbg(INFO3, "Switching from peer %p to peer %p", self->peer, peer);		
 	proxyfs_peer_get(peer); // Aquire ref of a new peer
 	proxyfs_peer_put(self->peer); // Release current peer
+	if ( self->peer != peer )
+		self->peer_window = 0; // The window has been announced by the former peer
 	self->peer = peer;
 }
 
+/** \<\<protected\>\> Grows the read buffer once the peer has filled it, so that it is
+ * reserved before a larger window is announced to the peer. The peer never sends more
+ * unconfirmed data than the announced window, so its data always fits.
+ * Must be called with the read buffer locked.
+ * @param self - pointer to this file instance
+ */
+void proxyfs_file_grow_read_buf(struct proxyfs_file_t *self)
+{
+	if( circ_buf_free_space( & self->read_buf ) == 0 )
+		circ_buf_reserve( & self->read_buf, self->read_buf.size );
+}
+
 /** \<\<public\>\> Checks, whether read was requested for this file */
 int proxyfs_file_was_read_requested(struct proxyfs_file_t* self) {
 	return self->read_was_requested;
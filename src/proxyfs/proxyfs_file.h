@@ -34,6 +34,9 @@
 
 #define WRITE_BUF_SIZE (2 << 12)
 #define READ_BUF_SIZE (2 << 12)
+/** Buffers grow on demand up to this size, so that streaming files can use large messages */
+#define WRITE_BUF_MAX_SIZE (256 << 10)
+#define READ_BUF_MAX_SIZE (256 << 10)
 /**
  * @defgroup proxyfs_file_class proxyfs_file class
  * @ingroup proxyfs_module_class
@@ -173,6 +176,8 @@ struct proxyfs_file_t {
 
 	/** Unconfirmed amount of data which was send */
 	size_t write_buf_unconfirmed;
+	/** Max. amount of unconfirmed data the peer accepts for this file, 0 until the peer announces it */
+	size_t peer_window;
 
 	/** Helper variable, telling whether the file was ever requested to read some data. see MSG_READ_REQUEST comment for details */	
 	int read_was_requested;
@@ -189,6 +194,20 @@ struct proxyfs_file_t {
 	struct proxyfs_file_ops *ops;
 };
 
+/** \<\<protected\>\> Grows the read buffer once the peer has filled it */
+void proxyfs_file_grow_read_buf(struct proxyfs_file_t *self);
+
+/** \<\<protected\>\> Returns max. amount of unconfirmed data we accept for this file, the read buffer is reserved to it */
+static inline size_t proxyfs_file_get_read_window(struct proxyfs_file_t *self) {
+	return self->read_buf.size;
+};
+
+/** \<\<protected\>\> Sets max. amount of unconfirmed data the peer accepts for this file, see #MSG_PEER_PARAMS */
+static inline void proxyfs_file_set_peer_window(struct proxyfs_file_t *self, size_t window) {
+	if( window > self->peer_window )
+		self->peer_window = window;
+};
+
 #endif // _PROXYFS_FILE_H_PROTECTED
 #endif //PROXYFS_FILE_PROTECTED
 
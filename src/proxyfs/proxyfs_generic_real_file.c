@@ -109,6 +109,8 @@ static int proxyfs_generic_real_file_read(struct proxyfs_real_file *self)
 	size_t buf_data;
 	loff_t pos;
         
+	// Grow the buffer while the peer does not keep up with the data
+	circ_buf_reserve( & PROXYFS_FILE(self)->write_buf, circ_buf_count( & PROXYFS_FILE(self)->write_buf ) );
 	buf_data = circ_buf_get_write_size( & PROXYFS_FILE(self)->write_buf );
 	mdbg(INFO3, "Trying read file %lu, buffer space is at least %lu", proxyfs_file_get_file_ident(PROXYFS_FILE(self)), (unsigned long)buf_data );
 
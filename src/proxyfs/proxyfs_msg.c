@@ -43,7 +43,7 @@ static struct proxyfs_msg *proxyfs_msg_new_internal(unsigned long msg_num,
 {
 	struct proxyfs_msg *msg;
 
-	if( data_size > MSG_MAX_SIZE - MSG_HDR_SIZE ){
+	if( data_size > MSG_MAX_FRAME_SIZE - MSG_HDR_SIZE ){
 		mdbg(ERR3, "Data too long");
 		return NULL;
 	}
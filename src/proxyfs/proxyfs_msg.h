@@ -76,8 +76,11 @@ struct proxyfs_msg {
 #define MSG_HDR_SIZE (sizeof(struct proxyfs_msg_header))
 /** \<\<public\>\> Magic number, each message starts with it */
 #define MSG_MAGIC 0x1ee7babe
-/** \<\<public\>\> Max. messagge size */
+/** \<\<public\>\> Max. messagge size every peer accepts, larger messages
+ * are sent only to peers that announced it by #MSG_PEER_PARAMS */
 #define MSG_MAX_SIZE (4 << 10)
+/** \<\<public\>\> Max. message size we accept and announce to peers */
+#define MSG_MAX_FRAME_SIZE (256 << 10)
 
 /** \<\<public\>\> msg_num for message which is send when opening file */
 #define MSG_OPEN 	1
@@ -96,6 +99,14 @@ struct proxyfs_msg {
  * won't ever get them..
  */
 #define MSG_READ_REQUEST 7
+/** \<\<public\>\> Peer parameters, each side sends it as the first message after 
+ * the connection is established. data[0] is the max. message size the sender accepts,
+ * data[1] is the max. amount of unconfirmed data the sender accepts for a single file.
+ * Until the message arrives, #MSG_MAX_SIZE and READ_BUF_SIZE are assumed. There is no reply.
+ * The message is sent again with a file identifier once the read buffer of that file has
+ * grown, data[1] is then the window of the file.
+ */
+#define MSG_PEER_PARAMS 8
 
 /** \<\<public\>\> msg_num for message which can be send as reply for #MSG_OPEN */
 #define MSG_OPEN_RESP_OK	101
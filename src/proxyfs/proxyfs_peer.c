@@ -36,6 +36,24 @@
 
 #define USE_VMALLOC ( 4 << 10 )
 
+/** \<\<private\>\> Allocates memory for receiving buffer */
+static void *proxyfs_peer_alloc_recv_buf(size_t size)
+{
+	if( size >= USE_VMALLOC )
+		return vmalloc( size );
+	else
+		return kmalloc( size, GFP_KERNEL );
+}
+
+/** \<\<private\>\> Releases memory of receiving buffer */
+static void proxyfs_peer_free_recv_buf(void *buf, size_t size)
+{
+	if( size >= USE_VMALLOC )
+		vfree(buf);
+	else
+		kfree(buf);
+}
+
 /** \<\<public\>\> Create proxyfs_peer instance
  * @return new proxyfs_peer instance or NULL on error
  */
@@ -64,16 +82,15 @@ exit0:
  */
 int proxyfs_peer_init(struct proxyfs_peer_t *self)
 {
-	if( MSG_MAX_SIZE >= USE_VMALLOC )
-		self->recv_buf = vmalloc( MSG_MAX_SIZE );
-	else
-		self->recv_buf = kmalloc( MSG_MAX_SIZE, GFP_KERNEL );
-
+	self->recv_buf = proxyfs_peer_alloc_recv_buf( MSG_MAX_SIZE );
 	if( self->recv_buf == NULL ){
 		mdbg(ERR3, "Allocating recv_buf failed");
 		return -1;
 	}
 	self->recv_start = 0;
+	self->recv_size = MSG_MAX_SIZE;
+	self->send_max = MSG_MAX_SIZE;
+	self->send_window = PEER_DEFAULT_WINDOW;
 	atomic_set(&self->ref_count, 1);
 	spin_lock_init(&self->enqueue_msg_lock);
 	self->state = PEER_CREATED;
@@ -96,10 +113,7 @@ void proxyfs_peer_put(struct proxyfs_peer_t *self)
 
 	if (atomic_dec_and_test(&self->ref_count)) {		  
 		mdbg(INFO3, "Freeing peer");
-		if( MSG_MAX_SIZE >= USE_VMALLOC )
-			vfree(self->recv_buf);
-		else
-			kfree(self->recv_buf);
+		proxyfs_peer_free_recv_buf(self->recv_buf, self->recv_size);
 		kkc_sock_put(self->sock);
 		
 		self->state = PEER_DISCONNECTED;
@@ -141,13 +155,85 @@ send_n:	if( ! list_empty( & self->msg_queue ) ){
 	}
 }
 
+/** \<\<private\>\> Grows receiving buffer, so that a message of a given size fits in
+ * @param self - pointer to proxyfs_peer_t instance
+ * @param msg_size - size of the message being received
+ *
+ * @return 0 on success
+ */
+static int proxyfs_peer_grow_recv_buf(struct proxyfs_peer_t *self, size_t msg_size)
+{
+	size_t size;
+	void *buf;
+
+	for( size = self->recv_size << 1; size < msg_size; size <<= 1 );
+	if( size > MSG_MAX_FRAME_SIZE )
+		size = MSG_MAX_FRAME_SIZE;
+
+	if( (buf = proxyfs_peer_alloc_recv_buf(size)) == NULL ){
+		mdbg(ERR3, "Growing recv_buf to %lu bytes failed", (unsigned long)size);
+		return -ENOMEM;
+	}
+	memcpy( buf, self->recv_buf, self->recv_start );
+	proxyfs_peer_free_recv_buf(self->recv_buf, self->recv_size);
+
+	mdbg(INFO3, "recv_buf grown from %lu to %lu bytes", (unsigned long)self->recv_size, (unsigned long)size);
+	self->recv_buf = buf;
+	self->recv_size = size;
+	return 0;
+}
+
+/** \<\<public\>\> Announces our parameters to the peer, see #MSG_PEER_PARAMS 
+ * @param self - pointer to proxyfs_peer_t instance
+ * @param file_ident - file the window applies to, 0 for all files
+ * @param window - max. amount of unconfirmed data we accept for a single file, the read
+ * buffer of the file has to be reserved to it already
+ *
+ * @return 0 on success
+ */
+int proxyfs_peer_send_params(struct proxyfs_peer_t *self, unsigned long file_ident, unsigned long window)
+{
+	struct proxyfs_msg *msg;
+	u_int32_t max_size = MSG_MAX_FRAME_SIZE;
+	u_int32_t max_window = window;
+
+	msg = proxyfs_msg_compose_new(MSG_PEER_PARAMS, file_ident, 
+			sizeof(u_int32_t), &max_size, sizeof(u_int32_t), &max_window, 0 );
+	if( msg == NULL )
+		return -ENOMEM;
+
+	proxyfs_peer_send_msg( self, msg );
+	return 0;
+}
+
+/** \<\<public\>\> Sets parameters announced by the peer. Values lower than 
+ * what every peer accepts are ignored.
+ * @param self - pointer to proxyfs_peer_t instance
+ * @param max_size - max. message size the peer accepts
+ * @param window - max. amount of unconfirmed data the peer accepts for a single file
+ */
+void proxyfs_peer_set_params(struct proxyfs_peer_t *self, unsigned long max_size, unsigned long window)
+{
+	if( max_size > MSG_MAX_FRAME_SIZE )
+		max_size = MSG_MAX_FRAME_SIZE;
+	if( max_size > MSG_MAX_SIZE )
+		self->send_max = max_size;
+	if( window > PEER_DEFAULT_WINDOW )
+		self->send_window = window;
+
+	mdbg(INFO2, "Peer %s accepts messages up to %lu bytes, window %lu bytes", 
+			kkc_sock_getpeername2(self->sock), (unsigned long)self->send_max, (unsigned long)self->send_window);
+}
+
 /** \<\<public\>\> Nonblocking recv messages 
  * @param self - pointer to proxyfs_peer_t instance
  *
- * @return 1 when complete message is received
+ * @return 1 when complete message is received, -EPROTO when the peer sent 
+ * a malformed message
  */
 int proxyfs_peer_real_recv(struct proxyfs_peer_t *self)
 {
+	struct proxyfs_msg_header *header = self->recv_buf;
 	int result = 0;
 	int msg_size;
 
@@ -166,8 +252,15 @@ int proxyfs_peer_real_recv(struct proxyfs_peer_t *self)
 			mdbg(ERR3, "recv(%s) returned %d", kkc_sock_getpeername2(self->sock), result);
 	}
 	if( self->recv_start >=  MSG_HDR_SIZE ){
+		if( header->magic != MSG_MAGIC || header->data_size > MSG_MAX_FRAME_SIZE - MSG_HDR_SIZE ){
+			mdbg(ERR3, "Malformed message from %s (data size %lu)", kkc_sock_getpeername2(self->sock), header->data_size);
+			return -EPROTO;
+		}
 		msg_size = proxyfs_msg_get_size( self->recv_buf );
 
+		if( msg_size > self->recv_size && proxyfs_peer_grow_recv_buf(self, msg_size) != 0 )
+			return -ENOMEM;
+
 		if( msg_size == self->recv_start )
 			return 1; // Message is complete
 
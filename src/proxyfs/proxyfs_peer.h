@@ -65,6 +65,13 @@ struct proxyfs_peer_t {
 	void   *recv_buf;
 	/** Receiving offset to rec_buf */
 	size_t recv_start;
+	/** Size of rec_buf, grows up to #MSG_MAX_FRAME_SIZE */
+	size_t recv_size;
+
+	/** Max. message size the peer accepts */
+	size_t send_max;
+	/** Max. amount of unconfirmed data the peer accepts for a single file */
+	size_t send_window;
 
 	/** Queue of messages */ 
 	struct list_head msg_queue;
@@ -83,6 +90,9 @@ struct proxyfs_peer_t {
 	proxyfs_peer_state_t state;
 };
 
+/** Amount of unconfirmed data accepted by peers that do not announce it (their read buffer size) */
+#define PEER_DEFAULT_WINDOW (2 << 12)
+
 /** Cast to struct proxyfs_peer_t * */
 #define PROXYFS_PEER(arg) ((struct proxyfs_peer_t *)arg)
 
@@ -119,6 +129,22 @@ static inline void proxyfs_peer_set_state(struct proxyfs_peer_t *self, proxyfs_p
 	self->state = state;
 };
 
+/** \<\<public\>\> Announces our parameters to the peer */
+int proxyfs_peer_send_params(struct proxyfs_peer_t *self, unsigned long file_ident, unsigned long window);
+
+/** \<\<public\>\> Sets parameters announced by the peer */
+void proxyfs_peer_set_params(struct proxyfs_peer_t *self, unsigned long max_size, unsigned long window);
+
+/** \<\<public\>\> Returns max. data size of a single message sent to the peer */
+static inline size_t proxyfs_peer_get_send_max(struct proxyfs_peer_t *self) {
+	return self->send_max - MSG_HDR_SIZE;
+};
+
+/** \<\<public\>\> Returns max. amount of unconfirmed data the peer accepts for a single file */
+static inline size_t proxyfs_peer_get_send_window(struct proxyfs_peer_t *self) {
+	return self->send_window;
+};
+
 /** \<\<public\>\> Delete received message, and prepare to receiving new one
  * @param self - pointer to proxyfs_peer_t instance 
  * @return Zero on success
@@ -52,7 +52,7 @@ static int proxyfs_pipe_proxy_file_write_user(struct proxyfs_proxy_file_t *self,
 		return -EFAULT;
 
 	down( & self->write_buf_sem );
-	write_size = circ_buf_free_space( & PROXYFS_FILE(self)->write_buf );
+	write_size = circ_buf_reserve( & PROXYFS_FILE(self)->write_buf, sizeof(write_size) + count );
 
 	mdbg(INFO2, "[File %lu] Space in buf: %lu, writting %lu", proxyfs_file_get_file_ident(PROXYFS_FILE(self)), (unsigned long)write_size, (unsigned long)count);
 
@@ -189,7 +189,9 @@ static int proxyfs_pipe_real_file_read(struct proxyfs_real_file *self)
 	if ( poll_result < 1 ) // Are there some date pending?
 		return -EAGAIN;
 
-	total_buffer_size = circ_buf_free_space( &PROXYFS_FILE(self)->write_buf );
+	// Grow the buffer while the peer does not keep up with the data
+	total_buffer_size = circ_buf_reserve( &PROXYFS_FILE(self)->write_buf, 
+			circ_buf_count( &PROXYFS_FILE(self)->write_buf ) );
 	if ( total_buffer_size == 0 ) // We do not have free space in the bufer at the moment
 		return -EAGAIN;
 
@@ -91,6 +91,7 @@ static int proxyfs_proxy_file_write_from_peer(struct proxyfs_file_t *self, const
 	}
 	else
 		lenght = circ_buf_write( & self->read_buf, buf, count );
+	proxyfs_file_grow_read_buf( self );
 	up( & PROXYFS_PROXY_FILE(self)->read_buf_sem );
 
 	mdbg(INFO4, "Waking up sleepers on %lu", proxyfs_file_get_file_ident(self));
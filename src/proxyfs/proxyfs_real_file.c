@@ -262,6 +262,7 @@ static int proxyfs_real_file_write_from_peer(struct proxyfs_file_t *self, const
 	int lenght;
 
 	lenght = circ_buf_write( & self->read_buf, buf, count );
+	proxyfs_file_grow_read_buf( self );
 	
 	return lenght;
 }
@@ -498,6 +498,67 @@ void proxyfs_server_duplicate_all_parent(struct task_struct* parent, struct task
 
 EXPORT_SYMBOL_GPL(proxyfs_server_duplicate_all_parent);
 
+/** \<\<private\>\> Finds an open file with the specified identifier used by the shadow task
+ * @param ident - file identifier
+ * @param *shadow - shadow task using the file
+ * @return the file or NULL if the shadow doesn't use such a file
+ */
+static struct proxyfs_file_t* proxyfs_server_find_shadow_file(unsigned long ident, struct task_struct* shadow)
+{
+	struct proxyfs_file_t *file;
+	struct list_head *l;
+
+	list_for_each( l, &PROXYFS_TASK(self)->files ) {
+		file = list_entry(l, struct proxyfs_file_t, files);
+		if( proxyfs_file_get_file_ident(file) == ident &&
+		    !proxyfs_file_get_status(file, PROXYFS_FILE_CLOSED) &&
+		    proxyfs_real_file_has_shadow(PROXYFS_REAL_FILE(file), shadow) )
+			return file;
+	}
+
+	return NULL;
+}
+
+/**
+ * \<\<public\>\> \<\<exported\>\> Makes files of a child forked some time ago match the current files of its parent.
+ * Duplicates of files closed by the parent since the fork are released and files the child is missing are duplicated.
+ */
+void proxyfs_server_reconcile_parent(struct task_struct* parent, struct task_struct* child)
+{
+	struct proxyfs_file_t *file;
+	struct list_head *l, *nxt;
+	unsigned long ident;
+
+	if ( !self )
+		return;
+
+	if ( task_tgid_vnr(parent) == task_tgid_vnr(child) )
+		return;
+
+	down( & self->files_sem );
+
+	list_for_each_safe( l, nxt, &PROXYFS_TASK(self)->files ) {
+		file = list_entry(l, struct proxyfs_file_t, files);
+		if ( proxyfs_file_get_status(file, PROXYFS_FILE_CLOSED) )
+			continue;
+
+		ident = proxyfs_file_get_file_ident(file);
+		if( proxyfs_real_file_has_shadow(PROXYFS_REAL_FILE(file),child) &&
+		    !proxyfs_server_find_shadow_file(ident, parent) ){
+			mdbg(INFO2, "Releasing file %lu closed by the parent (for task %d)", ident, child->pid);
+			if ( proxyfs_real_file_remove_shadow(PROXYFS_REAL_FILE(file),child) == 1 )
+				proxyfs_file_set_status( file, PROXYFS_FILE_CLOSED );
+		} else if( proxyfs_real_file_has_shadow(PROXYFS_REAL_FILE(file),parent) &&
+			   !proxyfs_server_find_shadow_file(ident, child) ){
+			mdbg(INFO2, "Going to duplicate file %lu (for task %d)", ident, child->pid);
+			proxyfs_server_duplicate_overtaken_file(PROXYFS_REAL_FILE(file), child);
+		}
+	}
+	up( & self->files_sem );
+}
+
+EXPORT_SYMBOL_GPL(proxyfs_server_reconcile_parent);
+
 
 /** \<\<private\>\> Method used for waiting on files, callback for poll structure 
  * @param *file - pointer to file in which wait queue this task will be added
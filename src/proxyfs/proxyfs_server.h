@@ -53,6 +53,11 @@ void proxyfs_server_release_all(void);
  */
 void proxyfs_server_duplicate_all_parent(struct task_struct* parent, struct task_struct* child);
 
+/**
+ * \<\<public\>\> \<\<exported\>\> Makes files of a child forked some time ago match the current files of its parent.
+ */
+void proxyfs_server_reconcile_parent(struct task_struct* parent, struct task_struct* child);
+
 /** \<\<public\>\> Main server thread */
 int proxyfs_server_thread(void *start_struct);
 
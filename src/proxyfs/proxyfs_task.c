@@ -228,7 +228,7 @@ recv_next:	recv_res = proxyfs_peer_real_recv(peer);
 			proxyfs_peer_clear_msg(peer);
 			// Consider adding protection from receiving from only one peer
 			goto recv_next;
-		} else if ( recv_res == -ECONNRESET || recv_res == -ECONNABORTED ) {
+		} else if ( recv_res == -ECONNRESET || recv_res == -ECONNABORTED || recv_res == -EPROTO ) {
 			// TODO: Some nicer general solution for removing (and detecting) lost peers.. but for now we need at least this
 			proxyfs_peer_set_state(peer, PEER_DEAD);
 			mdbg(INFO1, "Peer marked dead");
@@ -284,6 +284,7 @@ void proxyfs_task_handle_dead_peers(struct proxyfs_task *self) {
 void proxyfs_task_handle_msg(struct proxyfs_task *self, struct proxyfs_peer_t *peer)
 {
 	struct proxyfs_file_t *file;
+	size_t window;
 	struct proxyfs_msg *msg = proxyfs_peer_get_msg(peer);
 	if ( !msg ) // Case, when we had incomplete message in the buffer
 		return;
@@ -312,13 +313,25 @@ void proxyfs_task_handle_msg(struct proxyfs_task *self, struct proxyfs_peer_t *p
 			if(( file = proxyfs_task_find_file(self, msg->header.file_ident)) != NULL){
 				mdbg(INFO3, "Peer writes %lu bytes to file %lu", msg->header.data_size, proxyfs_file_get_file_ident(file));
 
+				window = proxyfs_file_get_read_window(file);
 				if( msg->header.data_size >= 0 ){
 					proxyfs_file_write_from_peer( file, (void*)msg->header.data, msg->header.data_size);
 				}
+				// The peer has filled the read buffer, let it use the grown one
+				if( proxyfs_file_get_read_window(file) > window )
+					proxyfs_peer_send_params( peer, proxyfs_file_get_file_ident(file), proxyfs_file_get_read_window(file) );
 				break;
 			}
 			mdbg(ERR3, "WRITE: Unknown file identificator %lu", msg->header.file_ident);
 			break;
+		case MSG_PEER_PARAMS:
+			if( msg->header.data_size < 2*sizeof(u_int32_t) )
+				break;
+			if( msg->header.file_ident == 0 )
+				proxyfs_peer_set_params( peer, msg->header.data[0], msg->header.data[1] );
+			else if(( file = proxyfs_task_find_file(self, msg->header.file_ident)) != NULL && file->peer == peer )
+				proxyfs_file_set_peer_window( file, msg->header.data[1] );
+			break;
 		default:
 			mdbg(INFO3, "Calling task specific msg handler");
 			if( self->ops && self->ops->handle_msg )
@@ -355,7 +368,7 @@ void proxyfs_task_send_buffers(struct proxyfs_task *self)
 int proxyfs_task_send_write_buf(struct proxyfs_task *self, struct proxyfs_file_t *file)
 {
 	struct proxyfs_msg *msg;
-	size_t total_size, data_size, send;
+	size_t total_size, data_size, send, window;
 	void *data_ptr;
 	char* read_buffer = NULL;
 	int res = 0;
@@ -374,12 +387,25 @@ int proxyfs_task_send_write_buf(struct proxyfs_task *self, struct proxyfs_file_t
 	if ( send == 0 )
 		return 0;
 
-	if( send > MSG_MAX_SIZE - MSG_HDR_SIZE ) {
-		send = MSG_MAX_SIZE - MSG_HDR_SIZE;
+	// Peer accepts limited amount of unconfirmed data, the rest is sent after its MSG_WRITE_RESP
+	window = proxyfs_peer_get_send_window(file->peer);
+	if( file->peer_window > window )
+		window = file->peer_window;
+	if( file->write_buf_unconfirmed >= window )
+		return 0;
+	if( send > window - file->write_buf_unconfirmed )
+		send = window - file->write_buf_unconfirmed;
+
+	if( send > proxyfs_peer_get_send_max(file->peer) ) {
+		send = proxyfs_peer_get_send_max(file->peer);
 		res = -EAGAIN;
 	}
 
-	read_buffer = kmalloc(send, GFP_KERNEL);
+	// Large frames need high order allocations, fall back to smaller frames when memory is fragmented
+	while( (read_buffer = kmalloc(send, GFP_KERNEL | __GFP_NOWARN)) == NULL && send > MSG_MAX_SIZE - MSG_HDR_SIZE ) {
+		send >>= 1;
+		res = -EAGAIN;
+	}
 	if ( !read_buffer )
 		goto exit0;
 
@@ -451,6 +477,7 @@ struct proxyfs_peer_t* proxyfs_task_add_to_peers(struct proxyfs_task *self, stru
 
 	peer->sock = peer_sock;
 	list_add( &peer->peers, &self->peers );
+	proxyfs_peer_send_params( peer, 0, READ_BUF_SIZE );
 
 	return peer;
 }
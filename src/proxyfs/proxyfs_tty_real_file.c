@@ -113,6 +113,8 @@ static int proxyfs_tty_real_file_read(struct proxyfs_real_file *self)
 	if ( proxyfs_real_file_poll_read(self) < 1 ) // Are there some date pending?
 		return -EAGAIN;
 
+	// Grow the buffer while the peer does not keep up with the data
+	circ_buf_reserve( & PROXYFS_FILE(self)->write_buf, circ_buf_count( & PROXYFS_FILE(self)->write_buf ) );
 	buf_data = circ_buf_get_write_size( & PROXYFS_FILE(self)->write_buf );
 	mdbg(INFO3, "Trying read file %lu, buffer space is at least %lu", proxyfs_file_get_file_ident(PROXYFS_FILE(self)), (unsigned long)buf_data );
 	circ_buf_dump("Tty real file read", & PROXYFS_FILE(self)->write_buf);
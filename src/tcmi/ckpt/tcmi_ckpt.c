@@ -40,6 +40,7 @@
 
 #include "tcmi_ckpt_openfile.h"
 #include "tcmi_ckpt_vm_area.h"
+#include "tcmi_ckpt_pwrite.h"
 
 #include <arch/arch_ids.h>
 #include <arch/current/regs.h>
@@ -72,6 +73,17 @@ struct tcmi_ckpt* tcmi_ckpt_new(struct file *file)
 	}
 	get_file(file);
 	ckpt->file = file;
+	ckpt->sock = NULL;
+	ckpt->stream_pos = 0;
+	ckpt->compress = 0;
+	ckpt->diff = 0;
+	ckpt->zbatch = NULL;
+	ckpt->dedup = NULL;
+	ckpt->parallel = 0;
+	ckpt->pwrite = NULL;
+	ckpt->readahead = 0;
+	ckpt->version = 1;
+	ckpt->toc = NULL;
 	ckpt->fdcache = NULL;
 	atomic_set(&ckpt->ref_count, 1);
 	mdbg(INFO2, "Created new checkpoint %p", ckpt);
@@ -91,6 +103,51 @@ struct tcmi_ckpt* tcmi_ckpt_new(struct file *file)
 
 }
 
+/** 
+ * \<\<public\>\> Streamed checkpoint constructor.
+ * - allocates a new instance
+ * - reserves an extra reference for the socket
+ * - resets the stream position
+ *
+ * The instance can only be used for creating a checkpoint, the image
+ * is sent directly into the socket (see \link tcmi_ckpt_stream_class
+ * stream class \endlink for the format).
+ *
+ * @param *sock - socket where the checkpoint is to be streamed
+ * @return tcmi_ckpt instance or NULL
+ */
+struct tcmi_ckpt* tcmi_ckpt_new_stream(struct kkc_sock *sock)
+{
+	struct tcmi_ckpt *ckpt;
+
+	if (!(ckpt = TCMI_CKPT(kmalloc(sizeof(struct tcmi_ckpt), 
+				       GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate memory for TCMI ckpt");
+		goto exit0;
+	}
+	ckpt->file = NULL;
+	ckpt->sock = kkc_sock_get(sock);
+	ckpt->stream_pos = 0;
+	ckpt->compress = 0;
+	ckpt->diff = 0;
+	ckpt->zbatch = NULL;
+	ckpt->dedup = NULL;
+	ckpt->parallel = 0;
+	ckpt->pwrite = NULL;
+	ckpt->readahead = 0;
+	ckpt->version = 1;
+	ckpt->toc = NULL;
+	ckpt->fdcache = NULL;
+	atomic_set(&ckpt->ref_count, 1);
+	mdbg(INFO2, "Created new streamed checkpoint %p", ckpt);
+
+	return ckpt;
+
+	/* error handling */
+ exit0:
+	return NULL;
+}
+
 /** 
  * \<\<public\>\> Writes a checkpoint header.
  * The checkpoint header consists of:
@@ -98,6 +155,9 @@ struct tcmi_ckpt* tcmi_ckpt_new(struct file *file)
  * - total VM area count
  * - total file count
  *
+ * Version 2 images are indexed from here on, the header section
+ * starts with the header.
+ *
  * @param *self - this checkpoint instance
  * @param is_npm - Is this a non-preemptive checkpoint (otherwise preemptive is assumed)
  * @return 0 upon success
@@ -106,8 +166,9 @@ int tcmi_ckpt_write_hdr(struct tcmi_ckpt *self, int is_npm)
 {
 	self->hdr.checkpoint_arch = ARCH_CURRENT;
 	self->hdr.is_32bit_application = check_is_application_32bit();
-	self->hdr.magic = TCMI_CKPT_MAGIC;
+	self->hdr.magic = (self->version >= 2 ? TCMI_CKPT_MAGIC_V2 : TCMI_CKPT_MAGIC);
 	self->hdr.is_npm = is_npm;
+	self->hdr.readahead = max_t(int32_t, self->readahead, 0);
 	if ((self->hdr.map_count = tcmi_ckpt_map_count(self)) < 0) {
 		mdbg(ERR3, "Failed counting mmap's");
 		goto exit0;
@@ -124,6 +185,9 @@ int tcmi_ckpt_write_hdr(struct tcmi_ckpt *self, int is_npm)
 	// No need to lock, exclusive access
 	strncpy(self->hdr.comm, current->comm, sizeof(current->comm));
 
+	if (self->version >= 2 && tcmi_ckpt_toc_begin(self) < 0)
+		goto exit0;
+
 	mdbg(INFO3, "Writing header of size: %lu Address: %p First 4 bytes: %8x", (unsigned long)sizeof(self->hdr), &self->hdr, ((uint32_t*)(&self->hdr))[0]);
 	
 	return tcmi_ckpt_write(self, &self->hdr, sizeof(self->hdr));
@@ -133,9 +197,26 @@ int tcmi_ckpt_write_hdr(struct tcmi_ckpt *self, int is_npm)
 	return -EINVAL;
 }
 
+/** 
+ * \<\<public\>\> Writes the table of contents of a version 2 image,
+ * this has to be the very last record of the image. Version 1 images
+ * are left as they are.
+ *
+ * @param *self - this checkpoint instance
+ * @return 0 upon success
+ */
+int tcmi_ckpt_write_toc(struct tcmi_ckpt *self)
+{
+	if (!self->toc)
+		return 0;
+	return tcmi_ckpt_toc_write(self);
+}
+
 /** 
  * \<\<public\>\> Reads the checkpoint header.  
- * The magic number has to match TCMI_CKPT_MAGIC.
+ * The magic number has to match TCMI_CKPT_MAGIC or
+ * TCMI_CKPT_MAGIC_V2. The table of contents of a version 2 image is
+ * read and verified right away.
  *
  * @param *self - this checkpoint instance
  * @return 0 upon success
@@ -148,11 +229,16 @@ int tcmi_ckpt_read_hdr(struct tcmi_ckpt *self)
 		mdbg(ERR3, "Can't read checkpoint header %d", err);
 		goto exit0;
 	}
-	if (self->hdr.magic != TCMI_CKPT_MAGIC) {
+	if (!tcmi_ckpt_check_magic(&self->hdr)) {
 		mdbg(ERR3, "Invalid checkpoint magic: %08x, expected: %08x",
 		     self->hdr.magic, TCMI_CKPT_MAGIC);
 		goto exit0;
 	}
+	self->version = (self->hdr.magic == TCMI_CKPT_MAGIC_V2 ? 2 : 1);
+	if (self->version >= 2 && tcmi_ckpt_toc_read(self) < 0) {
+		mdbg(ERR3, "Invalid table of contents");
+		goto exit0;
+	}
 	mdbg(INFO4, "Read ckpt header - magic: %08x, map_count: %d, files: %d (Header size: %lu)", 
 	     self->hdr.magic, self->hdr.map_count, self->hdr.file_count, (unsigned long)sizeof(self->hdr));
 
@@ -234,6 +320,9 @@ int tcmi_ckpt_read_files(struct tcmi_ckpt *self)
 
 /** 
  * \<\<public\>\> Writes all process memory regions into the checkpoint. 
+ * Large heavy areas of file based checkpoints are only submitted to
+ * the \link tcmi_ckpt_pwrite_class parallel writer \endlink, which
+ * is waited for once all areas have been processed.
  *
  * @param *self - this checkpoint instance
  * @param heavy - if set a full checkpoint of all memory areas
@@ -248,6 +337,10 @@ int tcmi_ckpt_write_vmas(struct tcmi_ckpt *self, int heavy)
 	/* select the checkpoint type*/
 	type = (heavy ? TCMI_CKPT_VM_AREA_HEAVY : TCMI_CKPT_VM_AREA_LIGHT);
 
+	/* the areas are written sequentially if the writer can't be started */
+	if (heavy && !self->sock && self->parallel > 0)
+		tcmi_ckpt_pwrite_begin(self);
+
 	tcmi_ckpt_foreach_vma(vma) {
 		if ( vma_ignore(self, vma) )
 			continue;
@@ -258,11 +351,16 @@ int tcmi_ckpt_write_vmas(struct tcmi_ckpt *self, int heavy)
 		goto exit0;
 		}
 	}
+	/* completion barrier, all reserved pages have been written */
+	if (tcmi_ckpt_pwrite_end(self) < 0)
+		goto exit1;
 
 	return 0;
 
 	/* error handling */
  exit0:
+	tcmi_ckpt_pwrite_end(self);
+ exit1:
 	return -EINVAL;
 }
 
@@ -33,6 +33,7 @@
 
 #include <linux/fs.h>
 #include <linux/file.h>
+#include <linux/fdtable.h>
 #include <linux/mm.h>
 #include <asm/uaccess.h>
 
@@ -42,6 +43,10 @@
 #include <linux/unistd.h> 
 
 #include "tcmi_fdcache.h"
+#include "tcmi_ckpt_profile.h"
+#include "tcmi_ckpt_toc.h"
+
+#include <kkc/kkc_sock.h>
 
 #include <arch/arch_ids.h> 
 #include <dbg.h>
@@ -79,19 +84,59 @@ struct tcmi_ckpt_hdr {
 	int8_t is_32bit_application;
 	/** 1, if this is checkpoint created as a result of non-preemptive migration request (0 otherwise) */
 	int8_t is_npm;
+	/** Number of pages of each heavy or file mapped area to be populated eagerly upon restart (0 = on demand) */
+	int32_t readahead;
 	/** Process executable name */
 	char comm[TASK_COMM_LEN];
 } __attribute__((__packed__));
 
+struct tcmi_ckpt_zbatch;
+struct tcmi_ckpt_dedup;
+struct tcmi_ckpt_pwrite;
+
 /** Compound structure that gathers necessary process information. */
 struct tcmi_ckpt {
 	/** Actual file used create/restore the process checkpoint */
 	struct file *file;
 
+	/** Socket the checkpoint is streamed into, NULL for file based
+	 * checkpoints. Streamed checkpoints are write only. */
+	struct kkc_sock *sock;
+	/** Current position in the streamed image. */
+	loff_t stream_pos;
+
+	/** Heavy areas are stored compressed. */
+	int8_t compress;
+	/** Writable private file mappings are stored as a difference
+	 * against the file. */
+	int8_t diff;
+	/** Buffers for compressed areas, allocated on demand. */
+	struct tcmi_ckpt_zbatch *zbatch;
+	/** Page hashes known to the receiver, NULL when the pages are
+	 * not deduplicated. */
+	struct tcmi_ckpt_dedup *dedup;
+	/** Heavy areas of at least this number of pages are written in
+	 * parallel (file based checkpoints only), 0 disables it. */
+	int32_t parallel;
+	/** Parallel writer, exists only while the areas are being
+	 * written. */
+	struct tcmi_ckpt_pwrite *pwrite;
+	/** Restart readahead window requested for this checkpoint in
+	 * pages, 0 selects the default, negative value disables it. */
+	int32_t readahead;
+	/** Image format version, see TCMI_CKPT_MAGIC and
+	 * TCMI_CKPT_MAGIC_V2. */
+	int32_t version;
+	/** Table of contents of a version 2 image, NULL for version 1. */
+	struct tcmi_ckpt_toc *toc;
+
 	/** File descriptor cache - used when indentifying descriptors
 	 * referencing the same file. */
 	struct tcmi_fdcache *fdcache;
 
+	/** Durations and sizes of the checkpoint/restart phases. */
+	struct tcmi_ckpt_profile profile;
+
 	/** Checkpoint header */
 	struct tcmi_ckpt_hdr hdr;
 
@@ -104,15 +149,36 @@ struct tcmi_ckpt {
 
 /** a magic number for the header  */
 #define TCMI_CKPT_MAGIC 0xdeadbeef
+/** a magic number for the header of an indexed (version 2) image */
+#define TCMI_CKPT_MAGIC_V2 0xdeadbe02
 
 /** \<\<public\>\> Checkpoint constructor. */
 extern struct tcmi_ckpt* tcmi_ckpt_new(struct file *file);
+/** \<\<public\>\> Streamed checkpoint constructor. */
+extern struct tcmi_ckpt* tcmi_ckpt_new_stream(struct kkc_sock *sock);
+
+/** \<\<public\>\> Releases buffers for compressed areas. */
+extern void tcmi_ckpt_zbatch_free(struct tcmi_ckpt_zbatch *self);
+
+/** \<\<public\>\> Releases page hashes. */
+extern void tcmi_ckpt_dedup_put(struct tcmi_ckpt_dedup *self);
+/** \<\<public\>\> Writes a page, possibly as a reference. */
+extern int tcmi_ckpt_dedup_write_page(struct tcmi_ckpt *ckpt, unsigned long addr, 
+				      void *kaddr);
+
+/** \<\<public\>\> Writes a data frame into the streamed image. */
+extern int tcmi_ckpt_stream_write(struct tcmi_ckpt *self, void *data, int count);
+/** \<\<public\>\> Creates a hole in the streamed image. */
+extern loff_t tcmi_ckpt_stream_skip(struct tcmi_ckpt *self, loff_t count);
 
 /** \<\<public\>\> Writes a checkpoint header. */
 extern int tcmi_ckpt_write_hdr(struct tcmi_ckpt *self, int is_npm);
 /** \<\<public\>\> Reads a checkpoint header. */
 extern int tcmi_ckpt_read_hdr(struct tcmi_ckpt *self);
 
+/** \<\<public\>\> Writes the table of contents of a version 2 image. */
+extern int tcmi_ckpt_write_toc(struct tcmi_ckpt *self);
+
 /** \<\<public\>\> Writes open files into the checkpoint. */
 extern int tcmi_ckpt_write_files(struct tcmi_ckpt *self);
 /** \<\<public\>\> Reads open files from the checkpoint. */
@@ -135,14 +201,17 @@ extern int tcmi_ckpt_read_regs(struct tcmi_ckpt *self, struct pt_regs *regs);
 
 /**
  * \<\<public\>\> Performs a quick check if the specified buffer
- * contains a valid magic number of the checkpoint file.
+ * contains a valid magic number of the checkpoint file. Both image
+ * versions are accepted.
  *
  * @param *buf - buffer containing the magic number
  * @return true when valid.
  */
 static inline int tcmi_ckpt_check_magic(void *buf)
 {
-	return ((struct tcmi_ckpt_hdr*)buf)->magic == TCMI_CKPT_MAGIC;
+	int32_t magic = ((struct tcmi_ckpt_hdr*)buf)->magic;
+
+	return magic == TCMI_CKPT_MAGIC || magic == TCMI_CKPT_MAGIC_V2;
 }
 
 /** 
@@ -169,8 +238,14 @@ static inline void tcmi_ckpt_put(struct tcmi_ckpt *self)
 {
 	if (self && atomic_dec_and_test(&self->ref_count)) {
 		mdbg(INFO4, "Destroying TCMI ckpt, %p", self);
-		fput(self->file);
+		if (self->file)
+			fput(self->file);
+		if (self->sock)
+			kkc_sock_put(self->sock);
+		tcmi_ckpt_zbatch_free(self->zbatch);
+		tcmi_ckpt_dedup_put(self->dedup);
 		tcmi_fdcache_put(self->fdcache);
+		tcmi_ckpt_toc_free(self->toc);
 		kfree(self);
 	}
 }
@@ -218,9 +293,31 @@ static inline int tcmi_ckpt_read_write(struct tcmi_ckpt *self,
  */
 static inline int tcmi_ckpt_write(struct tcmi_ckpt *self, void *data, int count)
 {
+	if (self->toc)
+		tcmi_ckpt_toc_update(self->toc, data, count);
+	if (self->sock)
+		return tcmi_ckpt_stream_write(self, data, count);
 	return tcmi_ckpt_read_write(self, data, count, (vfs_method_t*)vfs_write);
 }
 
+/**
+ * \<\<public\>\> Writes a page of the checkpointed process. When
+ * the pages are deduplicated, the page is written as a reference to
+ * a page the receiver already has, if possible.
+ *
+ * @param *self - this checkpoint instance
+ * @param addr - virtual address of the page in the process
+ * @param *kaddr - kernel address of the page data
+ * @return 0 upon success
+ */
+static inline int tcmi_ckpt_write_page(struct tcmi_ckpt *self, unsigned long addr, 
+				       void *kaddr)
+{
+	if (self->dedup)
+		return tcmi_ckpt_dedup_write_page(self, addr, kaddr);
+	return tcmi_ckpt_write(self, kaddr, PAGE_SIZE);
+}
+
 /**
  * \<\<public\>\> Reads a specified number of bytes from a checkpoint
  * file. 
@@ -233,13 +330,65 @@ static inline int tcmi_ckpt_write(struct tcmi_ckpt *self, void *data, int count)
 static inline int tcmi_ckpt_read(struct tcmi_ckpt *self, void *data, int count)
 {
 	mdbg(INFO3, "CKPT read to %p, count %d bytes", data, count);
+	if (self->sock) {
+		mdbg(ERR3, "Streamed checkpoint can't be read back");
+		return -EINVAL;
+	}
 	return tcmi_ckpt_read_write(self, data, count, (vfs_method_t*)vfs_read);
 }
 
 
+/**
+ * \<\<public\>\> Current position in the checkpoint image.
+ *
+ * @param *self - this checkpoint instance
+ * @return current position
+ */
+static inline loff_t tcmi_ckpt_pos(struct tcmi_ckpt *self)
+{
+	return self->sock ? self->stream_pos : self->file->f_pos;
+}
+
+/**
+ * \<\<public\>\> Starts profiling the checkpoint or restart phases.
+ *
+ * @param *self - this checkpoint instance
+ * @param restart - set when the checkpoint is being restarted
+ */
+static inline void tcmi_ckpt_profile_begin(struct tcmi_ckpt *self, int restart)
+{
+	tcmi_ckpt_profile_start(&self->profile, restart, tcmi_ckpt_pos(self));
+}
+
+/**
+ * \<\<public\>\> Accounts the time and image bytes since the
+ * previous phase to the specified phase.
+ *
+ * @param *self - this checkpoint instance
+ * @param phase - phase that has just finished
+ */
+static inline void tcmi_ckpt_phase(struct tcmi_ckpt *self, enum tcmi_ckpt_phase phase)
+{
+	tcmi_ckpt_profile_phase(&self->profile, phase, tcmi_ckpt_pos(self));
+}
+
+/**
+ * \<\<public\>\> Marks the beginning of a section in an image being
+ * written. Only version 2 images are indexed.
+ *
+ * @param *self - this checkpoint instance
+ * @param type - section that follows
+ */
+static inline void tcmi_ckpt_section(struct tcmi_ckpt *self, enum tcmi_ckpt_section_type type)
+{
+	if (self->toc)
+		tcmi_ckpt_toc_section(self, type);
+}
+
 /**
  * \<\<public\>\> Seeks in the checkpoint file based on specified
- * offset.
+ * offset. A streamed checkpoint can only move forward, the skipped
+ * area is sent as a hole.
  * 
  * @param *self - this checkpoint instance
  * @param *offset - relative offset
@@ -250,6 +399,13 @@ static inline int tcmi_ckpt_read(struct tcmi_ckpt *self, void *data, int count)
  */
 static inline loff_t tcmi_ckpt_seek(struct tcmi_ckpt *self, loff_t offset, int origin)
 {
+	if (self->sock) {
+		if (origin == 0)
+			offset -= self->stream_pos;
+		if (origin == 2 || offset < 0)
+			return -ESPIPE;
+		return tcmi_ckpt_stream_skip(self, offset);
+	}
 	return vfs_llseek(self->file, offset, origin);
 }
 
@@ -294,7 +450,7 @@ static inline unsigned long tcmi_ckpt_do_mmap(struct tcmi_ckpt *self, unsigned l
  */
 static inline loff_t tcmi_ckpt_page_align(struct tcmi_ckpt *self)
 {
-	return vfs_llseek(self->file, (self->file->f_pos + PAGE_SIZE - 1) & PAGE_MASK, 0);
+	return tcmi_ckpt_seek(self, (tcmi_ckpt_pos(self) + PAGE_SIZE - 1) & PAGE_MASK, 0);
 }
 
 
@@ -346,14 +502,20 @@ static int tcmi_ckpt_map_count(struct tcmi_ckpt *self);
 static int tcmi_ckpt_file_count(struct tcmi_ckpt *self);
 
 /**
- * Initializes filedescriptor cache for a given file count
+ * Initializes filedescriptor cache for the file count stored in the
+ * header. The hash table is sized by the descriptor table of the
+ * current process.
  * 
  * @param *self - this checkpoint instance
- * @param count - maximum number of files that it will retain.
  */
 static inline int tcmi_ckpt_fdcache_init(struct tcmi_ckpt *self)
 {
-	self->fdcache = tcmi_fdcache_new(self->hdr.file_count);
+	int max_fds;
+
+	rcu_read_lock();
+	max_fds = files_fdtable(current->files)->max_fds;
+	rcu_read_unlock();
+	self->fdcache = tcmi_fdcache_new(self->hdr.file_count, max_fds);
 	return self->fdcache ? 0 : -ENOMEM;
 }
 
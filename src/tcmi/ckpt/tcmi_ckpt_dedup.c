@@ -0,0 +1,216 @@
+/**
+ * @file tcmi_ckpt_dedup.c - a helper class that deduplicates pages of
+ *                           a streamed checkpoint
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/module.h>
+#include <linux/vmalloc.h>
+
+#include "tcmi_ckpt_stream.h"
+#include "tcmi_ckpt_vm_area.h"
+
+#define TCMI_CKPT_DEDUP_PRIVATE
+#include "tcmi_ckpt_dedup.h"
+
+/**
+ * Maximum number of pages scanned for deduplication. Off by default,
+ * the pages are hashed synchronously before the migration and a
+ * deduplicated image is not compressed.
+ */
+static int dedup_pages = 0;
+module_param(dedup_pages, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(dedup_pages, "Pages scanned for deduplication of streamed checkpoints, 0 disables (default 0)");
+
+/**
+ * \<\<public\>\> Scans pages of the current process and calculates
+ * their hashes. Only pages that would be written into a heavy
+ * checkpoint are scanned - shared areas are not supported by the
+ * checkpoint at all and writable private file mappings are scanned
+ * for pages diverged from the file only.
+ *
+ * @return new instance or NULL when there is nothing to deduplicate
+ */
+struct tcmi_ckpt_dedup* tcmi_ckpt_dedup_new(void)
+{
+	struct tcmi_ckpt_dedup *self;
+	struct vm_area_struct *vma;
+	struct shash_desc *desc;
+	u_int32_t max = dedup_pages > 0 ? dedup_pages : 0;
+
+	if (!max)
+		goto exit0;
+	if (!(self = kmalloc(sizeof(*self), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate memory for deduplication");
+		goto exit0;
+	}
+	self->count = 0;
+	self->known = NULL;
+	self->session = 0;
+	self->cursor = 0;
+	atomic_set(&self->ref_count, 1);
+	self->addrs = vmalloc(max * sizeof(unsigned long));
+	self->hashes = vmalloc(max * sizeof(struct tcmi_ckpt_page_hash));
+	if (!self->addrs || !self->hashes) {
+		mdbg(ERR3, "Can't allocate page hashes");
+		goto exit1;
+	}
+	if (!(desc = tcmi_ckpt_page_hasher_new()))
+		goto exit1;
+
+	for (vma = current->mm->mmap; vma && self->count < max; vma = vma->vm_next) {
+		if (vma->vm_flags & (VM_IO | VM_SHARED | VM_RESERVED))
+			continue;
+		if (tcmi_ckpt_dedup_scan_vma(self, desc, vma, max) < 0)
+			goto exit2;
+	}
+	tcmi_ckpt_page_hasher_free(desc);
+
+	mdbg(INFO3, "Scanned %u pages for deduplication", self->count);
+	if (!self->count)
+		goto exit1;
+	return self;
+
+	/* error handling */
+ exit2:
+	tcmi_ckpt_page_hasher_free(desc);
+ exit1:
+	tcmi_ckpt_dedup_put(self);
+ exit0:
+	return NULL;
+}
+
+/**
+ * \<\<public\>\> Releases the instance.
+ *
+ * @param *self - pointer to this instance
+ */
+void tcmi_ckpt_dedup_put(struct tcmi_ckpt_dedup *self)
+{
+	if (self && atomic_dec_and_test(&self->ref_count)) {
+		mdbg(INFO4, "Destroying deduplication %p", self);
+		vfree(self->addrs);
+		vfree(self->hashes);
+		vfree(self->known);
+		kfree(self);
+	}
+}
+
+/**
+ * \<\<public\>\> Sets the session the destination has created for
+ * the scanned pages. The instance takes over the bitmap.
+ *
+ * @param *self - this instance
+ * @param session - session ID
+ * @param *known - vmalloc'ed bitmap of pages held by the destination
+ */
+void tcmi_ckpt_dedup_set_session(struct tcmi_ckpt_dedup *self, u_int32_t session, 
+				 u_int8_t *known)
+{
+	vfree(self->known);
+	self->known = known;
+	self->session = session;
+}
+
+/**
+ * \<\<public\>\> Writes a page into the streamed checkpoint. Scanned
+ * pages held by the destination are sent as a reference, other
+ * scanned pages along with their hash. Pages that have not been
+ * scanned are written as regular data.
+ *
+ * @param *ckpt - streamed checkpoint
+ * @param addr - address of the page
+ * @param *kaddr - page data
+ * @return 0 upon success
+ */
+int tcmi_ckpt_dedup_write_page(struct tcmi_ckpt *ckpt, unsigned long addr, void *kaddr)
+{
+	struct tcmi_ckpt_dedup *self = ckpt->dedup;
+	u_int32_t i;
+
+	while (self->cursor < self->count && self->addrs[self->cursor] < addr)
+		self->cursor++;
+	if (self->cursor == self->count || self->addrs[self->cursor] != addr)
+		return tcmi_ckpt_write(ckpt, kaddr, PAGE_SIZE);
+
+	i = self->cursor++;
+	if (self->known && tcmi_ckpt_pagecache_bit(self->known, i))
+		return tcmi_ckpt_stream_page_ref(ckpt, i);
+	return tcmi_ckpt_stream_page(ckpt, &self->hashes[i], kaddr);
+}
+
+/** @addtogroup tcmi_ckpt_dedup_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Scans pages of a single memory area.
+ *
+ * @param *self - this instance
+ * @param *desc - hash calculator
+ * @param *vma - memory area to be scanned
+ * @param max - maximum number of scanned pages
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_dedup_scan_vma(struct tcmi_ckpt_dedup *self, struct shash_desc *desc,
+				    struct vm_area_struct *vma, u_int32_t max)
+{
+	unsigned long addr;
+	int diverged_only = vma->vm_file && (vma->vm_flags & VM_WRITE);
+	int err;
+
+	for (addr = vma->vm_start; addr < vma->vm_end && self->count < max; 
+	     addr += PAGE_SIZE) {
+		struct page *page;
+		struct vm_area_struct *page_vma;
+		void *kaddr;
+
+		if (diverged_only && !tcmi_ckpt_vm_area_page_diverged(vma, addr))
+			continue;
+		if (get_user_pages(current, current->mm, addr, 1, 0, 1,
+				   &page, &page_vma) <= 0)
+			continue;
+		kaddr = tcmi_ckpt_vm_area_kmap(page);
+		err = tcmi_ckpt_page_hash(desc, kaddr, &self->hashes[self->count]);
+		tcmi_ckpt_vm_area_kunmap(page);
+		page_cache_release(page);
+		if (err < 0) {
+			mdbg(ERR3, "Failed to hash page at %08lx: %d", addr, err);
+			return err;
+		}
+		self->addrs[self->count++] = addr;
+	}
+	return 0;
+}
+
+/**
+ * @}
+ */
+
+EXPORT_SYMBOL_GPL(tcmi_ckpt_dedup_new);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_dedup_put);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_dedup_set_session);
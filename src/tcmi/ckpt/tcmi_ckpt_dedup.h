@@ -0,0 +1,149 @@
+/**
+ * @file tcmi_ckpt_dedup.h - a helper class that deduplicates pages of
+ *                           a streamed checkpoint
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_DEDUP_H
+#define _TCMI_CKPT_DEDUP_H
+
+#include <asm/atomic.h>
+
+#include "tcmi_ckpt.h"
+#include "tcmi_ckpt_pagecache.h"
+
+/** @defgroup tcmi_ckpt_dedup_class tcmi_ckpt_dedup class
+ *
+ * @ingroup tcmi_ckpt_class
+ *
+ * This class is used by the sender of a streamed checkpoint to avoid
+ * sending pages the destination node already holds in its \link
+ * tcmi_ckpt_pagecache_class page cache \endlink.
+ *
+ * Before the checkpoint is created:
+ * - the pages of the current process are scanned and their hashes
+ * calculated (up to 'dedup_pages' pages, module parameter, 0
+ * disables deduplication)
+ * - the hashes are sent to the destination, which replies with a
+ * session ID and a bitmap of pages it holds
+ *
+ * While the checkpoint is being streamed, each page written is
+ * checked against the scanned pages. Pages held by the destination
+ * are sent as a reference into the session. Other scanned pages are
+ * sent along with their hash, so that the destination can cache
+ * them. Pages are written in ascending order of addresses, so a
+ * single cursor is sufficient for the lookup.
+ *
+ * @{
+ */
+
+/** Compound structure describing scanned pages */
+struct tcmi_ckpt_dedup {
+	/** number of scanned pages */
+	u_int32_t count;
+	/** addresses of the scanned pages, ascending */
+	unsigned long *addrs;
+	/** hashes of the scanned pages */
+	struct tcmi_ckpt_page_hash *hashes;
+	/** bitmap of pages held by the destination, NULL if unknown */
+	u_int8_t *known;
+	/** session ID at the destination, 0 if none */
+	u_int32_t session;
+	/** lookup cursor of the checkpoint writer */
+	u_int32_t cursor;
+	/** instance reference counter. */
+	atomic_t ref_count;
+};
+
+/** \<\<public\>\> Scans pages of the current process. */
+extern struct tcmi_ckpt_dedup* tcmi_ckpt_dedup_new(void);
+/** \<\<public\>\> Releases the instance. */
+extern void tcmi_ckpt_dedup_put(struct tcmi_ckpt_dedup *self);
+/** \<\<public\>\> Sets the destination session. */
+extern void tcmi_ckpt_dedup_set_session(struct tcmi_ckpt_dedup *self, u_int32_t session, 
+					u_int8_t *known);
+
+/** 
+ * \<\<public\>\> Instance accessor, increments the reference counter.
+ *
+ * @param *self - pointer to this instance
+ * @return tcmi_ckpt_dedup instance
+ */
+static inline struct tcmi_ckpt_dedup* tcmi_ckpt_dedup_get(struct tcmi_ckpt_dedup *self)
+{
+	if (self) {
+		atomic_inc(&self->ref_count);
+	}
+	return self;
+}
+
+/**
+ * \<\<public\>\> Number of scanned pages.
+ *
+ * @param *self - this instance
+ * @return page count
+ */
+static inline u_int32_t tcmi_ckpt_dedup_count(struct tcmi_ckpt_dedup *self)
+{
+	return self->count;
+}
+
+/**
+ * \<\<public\>\> Hashes of the scanned pages.
+ *
+ * @param *self - this instance
+ * @return array of tcmi_ckpt_dedup_count() hashes
+ */
+static inline struct tcmi_ckpt_page_hash* tcmi_ckpt_dedup_hashes(struct tcmi_ckpt_dedup *self)
+{
+	return self->hashes;
+}
+
+/**
+ * \<\<public\>\> Destination session ID.
+ *
+ * @param *self - this instance
+ * @return session ID or 0
+ */
+static inline u_int32_t tcmi_ckpt_dedup_session(struct tcmi_ckpt_dedup *self)
+{
+	return self->session;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CKPT_DEDUP_PRIVATE
+
+/** Scans pages of a single memory area. */
+static int tcmi_ckpt_dedup_scan_vma(struct tcmi_ckpt_dedup *self, struct shash_desc *desc,
+				    struct vm_area_struct *vma, u_int32_t max);
+
+#endif /* TCMI_CKPT_DEDUP_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_DEDUP_H */
+
@@ -52,6 +52,9 @@
  * - othewise we delegate the work to write_newfd method that
  * stores the full file information in about the file.
  *
+ * The lookup is done first, so that the pathname of a duplicate
+ * descriptor is never resolved.
+ *
  * @param *ckpt - checkpoint instance, that we are writing into
  * @param fd - file descriptor of associated with the file object
  * @param *file - file whose information is be written
@@ -0,0 +1,430 @@
+/**
+ * @file tcmi_ckpt_pagecache.c - content addressed cache of pages received
+ *                               in streamed checkpoints
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
+#include <linux/jiffies.h>
+
+#include <dbg.h>
+
+#define TCMI_CKPT_PAGECACHE_PRIVATE
+#include "tcmi_ckpt_pagecache.h"
+
+/** Maximum number of cached pages */
+static int pagecache_pages = 8192;
+module_param(pagecache_pages, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(pagecache_pages, "Pages cached for deduplication of received checkpoints, 0 disables (default 8192)");
+
+/** Hash table of cached pages */
+static struct hlist_head tcmi_ckpt_pagecache_table[1 << TCMI_CKPT_PAGECACHE_HASH_BITS];
+/** Cached pages, most recently used first */
+static LIST_HEAD(tcmi_ckpt_pagecache_lru);
+/** Number of cached pages */
+static int tcmi_ckpt_pagecache_count;
+/** Sessions not claimed by a stream yet */
+static LIST_HEAD(tcmi_ckpt_pagecache_sessions);
+/** Last assigned session ID */
+static u_int32_t tcmi_ckpt_pagecache_last_id;
+/** Last assigned owner */
+static u_int64_t tcmi_ckpt_pagecache_last_owner;
+/** Serializes access to all of the above */
+static DEFINE_MUTEX(tcmi_ckpt_pagecache_lock);
+
+/**
+ * \<\<public\>\> Initializes the cache.
+ *
+ * @return 0 upon success
+ */
+int tcmi_ckpt_pagecache_init(void)
+{
+	int i;
+
+	for (i = 0; i < (1 << TCMI_CKPT_PAGECACHE_HASH_BITS); i++)
+		INIT_HLIST_HEAD(&tcmi_ckpt_pagecache_table[i]);
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Releases all cached pages and sessions.
+ */
+void tcmi_ckpt_pagecache_exit(void)
+{
+	mutex_lock(&tcmi_ckpt_pagecache_lock);
+	tcmi_ckpt_pagecache_reap_sessions(1);
+	tcmi_ckpt_pagecache_shrink(0);
+	mutex_unlock(&tcmi_ckpt_pagecache_lock);
+}
+
+/**
+ * \<\<public\>\> Allocates a new owner of pages and sessions.
+ *
+ * @return owner, never 0
+ */
+u_int64_t tcmi_ckpt_pagecache_owner_new(void)
+{
+	u_int64_t owner;
+
+	mutex_lock(&tcmi_ckpt_pagecache_lock);
+	owner = ++tcmi_ckpt_pagecache_last_owner;
+	mutex_unlock(&tcmi_ckpt_pagecache_lock);
+	return owner;
+}
+
+/**
+ * \<\<public\>\> Releases all pages and sessions of an owner. Called
+ * when the peer is gone, its pages would only take the place of the
+ * pages of other peers.
+ *
+ * @param owner - owner to forget
+ */
+void tcmi_ckpt_pagecache_forget(u_int64_t owner)
+{
+	struct tcmi_ckpt_pagecache_session *session, *tmp_session;
+	struct tcmi_ckpt_pagecache_entry *entry, *tmp;
+
+	mutex_lock(&tcmi_ckpt_pagecache_lock);
+	list_for_each_entry_safe(session, tmp_session, &tcmi_ckpt_pagecache_sessions, node) {
+		if (session->owner != owner)
+			continue;
+		list_del(&session->node);
+		tcmi_ckpt_pagecache_session_free(session);
+	}
+	list_for_each_entry_safe(entry, tmp, &tcmi_ckpt_pagecache_lru, lru) {
+		if (entry->owner == owner)
+			tcmi_ckpt_pagecache_release(entry);
+	}
+	mutex_unlock(&tcmi_ckpt_pagecache_lock);
+}
+
+/**
+ * \<\<public\>\> Inserts a page into the cache. The hash announced by
+ * the sender is verified, so that a peer can't poison its own cache
+ * entries. A page that is already present just becomes the most
+ * recently used one. Failure to cache a page is not fatal for the
+ * checkpoint being received.
+ *
+ * @param *desc - hash calculator
+ * @param owner - owner of the page, 0 doesn't cache the page at all
+ * @param *hash - hash announced by the sender
+ * @param *data - page data
+ * @return 0 upon success
+ */
+int tcmi_ckpt_pagecache_insert(struct shash_desc *desc, u_int64_t owner,
+			       struct tcmi_ckpt_page_hash *hash, void *data)
+{
+	struct tcmi_ckpt_pagecache_entry *entry;
+	struct tcmi_ckpt_page_hash real;
+	int capacity = pagecache_pages;
+
+	if (capacity <= 0 || !owner)
+		return 0;
+	if (tcmi_ckpt_page_hash(desc, data, &real) < 0 || 
+	    memcmp(&real, hash, sizeof(real))) {
+		mdbg(ERR3, "Page hash mismatch, page not cached");
+		return -EINVAL;
+	}
+
+	mutex_lock(&tcmi_ckpt_pagecache_lock);
+	if ((entry = tcmi_ckpt_pagecache_find(owner, hash))) {
+		list_move(&entry->lru, &tcmi_ckpt_pagecache_lru);
+		mutex_unlock(&tcmi_ckpt_pagecache_lock);
+		return 0;
+	}
+	if (!(entry = kmalloc(sizeof(*entry), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate page cache entry");
+		goto exit0;
+	}
+	if (!(entry->page = alloc_page(GFP_KERNEL | __GFP_NOWARN))) {
+		mdbg(ERR3, "Can't allocate page for the page cache");
+		goto exit1;
+	}
+	memcpy(page_address(entry->page), data, PAGE_SIZE);
+	entry->owner = owner;
+	entry->hash = *hash;
+	hlist_add_head(&entry->hnode, 
+		       &tcmi_ckpt_pagecache_table[tcmi_ckpt_pagecache_bucket(hash)]);
+	list_add(&entry->lru, &tcmi_ckpt_pagecache_lru);
+	tcmi_ckpt_pagecache_count++;
+	tcmi_ckpt_pagecache_shrink(capacity);
+	mutex_unlock(&tcmi_ckpt_pagecache_lock);
+	return 0;
+
+	/* error handling */
+ exit1:
+	kfree(entry);
+ exit0:
+	mutex_unlock(&tcmi_ckpt_pagecache_lock);
+	return -ENOMEM;
+}
+
+/**
+ * \<\<public\>\> Creates a session for a list of hashes. Each page
+ * of the owner found in the cache is pinned by the session and marked
+ * in the present bitmap. The session is registered among the
+ * unclaimed sessions, expired sessions are released.
+ *
+ * @param owner - owner of the session
+ * @param *hashes - page hashes announced by the sender
+ * @param count - number of hashes
+ * @param *present - output bitmap of found pages,
+ * tcmi_ckpt_pagecache_bitmap_size(count) bytes
+ * @return new session or NULL
+ */
+struct tcmi_ckpt_pagecache_session* 
+tcmi_ckpt_pagecache_session_new(u_int64_t owner, struct tcmi_ckpt_page_hash *hashes, 
+				u_int32_t count, u_int8_t *present)
+{
+	struct tcmi_ckpt_pagecache_session *session;
+	struct tcmi_ckpt_pagecache_entry *entry;
+	u_int32_t i, found = 0;
+
+	if (!count || !owner)
+		goto exit0;
+	if (!(session = kmalloc(sizeof(*session), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate page cache session");
+		goto exit0;
+	}
+	if (!(session->pages = vmalloc(count * sizeof(struct page*)))) {
+		mdbg(ERR3, "Can't allocate pages of page cache session");
+		goto exit1;
+	}
+	session->count = count;
+	session->owner = owner;
+	session->created = jiffies;
+	memset(present, 0, tcmi_ckpt_pagecache_bitmap_size(count));
+
+	mutex_lock(&tcmi_ckpt_pagecache_lock);
+	tcmi_ckpt_pagecache_reap_sessions(0);
+	for (i = 0; i < count; i++) {
+		session->pages[i] = NULL;
+		if (!(entry = tcmi_ckpt_pagecache_find(owner, &hashes[i])))
+			continue;
+		get_page(entry->page);
+		session->pages[i] = entry->page;
+		list_move(&entry->lru, &tcmi_ckpt_pagecache_lru);
+		present[i >> 3] |= 1 << (i & 7);
+		found++;
+	}
+	if (!++tcmi_ckpt_pagecache_last_id)
+		++tcmi_ckpt_pagecache_last_id;
+	session->id = tcmi_ckpt_pagecache_last_id;
+	list_add_tail(&session->node, &tcmi_ckpt_pagecache_sessions);
+	mutex_unlock(&tcmi_ckpt_pagecache_lock);
+
+	mdbg(INFO3, "Page cache session %u: %u of %u pages found", 
+	     session->id, found, count);
+	return session;
+
+	/* error handling */
+ exit1:
+	kfree(session);
+ exit0:
+	return NULL;
+}
+
+/**
+ * \<\<public\>\> Takes a session over from the list of unclaimed
+ * sessions. The caller becomes responsible for releasing it. Sessions
+ * of other owners are never handed out.
+ *
+ * @param id - session ID
+ * @param owner - owner claiming the session
+ * @return session or NULL if it doesn't exist (or has expired)
+ */
+struct tcmi_ckpt_pagecache_session* tcmi_ckpt_pagecache_session_claim(u_int32_t id,
+								      u_int64_t owner)
+{
+	struct tcmi_ckpt_pagecache_session *session;
+
+	mutex_lock(&tcmi_ckpt_pagecache_lock);
+	list_for_each_entry(session, &tcmi_ckpt_pagecache_sessions, node) {
+		if (session->id == id && session->owner == owner) {
+			list_del_init(&session->node);
+			mutex_unlock(&tcmi_ckpt_pagecache_lock);
+			return session;
+		}
+	}
+	mutex_unlock(&tcmi_ckpt_pagecache_lock);
+	mdbg(ERR3, "Page cache session %u not found", id);
+	return NULL;
+}
+
+/**
+ * \<\<public\>\> Releases a claimed session along with the pinned pages.
+ *
+ * @param *self - this session
+ */
+void tcmi_ckpt_pagecache_session_free(struct tcmi_ckpt_pagecache_session *self)
+{
+	u_int32_t i;
+
+	if (!self)
+		return;
+	for (i = 0; i < self->count; i++) {
+		if (self->pages[i])
+			put_page(self->pages[i]);
+	}
+	vfree(self->pages);
+	kfree(self);
+}
+
+/**
+ * \<\<public\>\> Allocates a page hash calculator.
+ *
+ * @return hash calculator or NULL
+ */
+struct shash_desc* tcmi_ckpt_page_hasher_new(void)
+{
+	struct crypto_shash *tfm;
+	struct shash_desc *desc;
+
+	tfm = crypto_alloc_shash("sha1", 0, 0);
+	if (IS_ERR(tfm)) {
+		mdbg(ERR3, "Can't allocate SHA-1 transformation: %ld", PTR_ERR(tfm));
+		goto exit0;
+	}
+	if (!(desc = kmalloc(sizeof(*desc) + crypto_shash_descsize(tfm), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate SHA-1 descriptor");
+		goto exit1;
+	}
+	desc->tfm = tfm;
+	desc->flags = 0;
+	return desc;
+
+	/* error handling */
+ exit1:
+	crypto_free_shash(tfm);
+ exit0:
+	return NULL;
+}
+
+/**
+ * \<\<public\>\> Releases a page hash calculator.
+ *
+ * @param *desc - hash calculator
+ */
+void tcmi_ckpt_page_hasher_free(struct shash_desc *desc)
+{
+	if (!desc)
+		return;
+	crypto_free_shash(desc->tfm);
+	kfree(desc);
+}
+
+/** @addtogroup tcmi_ckpt_pagecache_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Finds a page in the cache. Has to be called with
+ * the cache lock held.
+ *
+ * @param owner - owner of the page
+ * @param *hash - page hash
+ * @return cache entry or NULL
+ */
+static struct tcmi_ckpt_pagecache_entry* tcmi_ckpt_pagecache_find(u_int64_t owner, 
+								  struct tcmi_ckpt_page_hash *hash)
+{
+	struct tcmi_ckpt_pagecache_entry *entry;
+	struct hlist_node *pos;
+
+	hlist_for_each_entry(entry, pos, 
+			     &tcmi_ckpt_pagecache_table[tcmi_ckpt_pagecache_bucket(hash)], hnode) {
+		if (entry->owner == owner && !memcmp(&entry->hash, hash, sizeof(*hash)))
+			return entry;
+	}
+	return NULL;
+}
+
+/**
+ * \<\<private\>\> Evicts least recently used pages over the
+ * capacity. Pages pinned by sessions are released by the sessions
+ * later. Has to be called with the cache lock held.
+ *
+ * @param capacity - number of pages that may stay in the cache
+ */
+static void tcmi_ckpt_pagecache_shrink(int capacity)
+{
+	struct tcmi_ckpt_pagecache_entry *entry;
+
+	while (tcmi_ckpt_pagecache_count > capacity) {
+		entry = list_entry(tcmi_ckpt_pagecache_lru.prev, 
+				   struct tcmi_ckpt_pagecache_entry, lru);
+		tcmi_ckpt_pagecache_release(entry);
+	}
+}
+
+/**
+ * \<\<private\>\> Releases a single cached page. A page pinned by a
+ * session stays in memory until the session is released. Has to be
+ * called with the cache lock held.
+ *
+ * @param *entry - cache entry to release
+ */
+static void tcmi_ckpt_pagecache_release(struct tcmi_ckpt_pagecache_entry *entry)
+{
+	list_del(&entry->lru);
+	hlist_del(&entry->hnode);
+	put_page(entry->page);
+	kfree(entry);
+	tcmi_ckpt_pagecache_count--;
+}
+
+/**
+ * \<\<private\>\> Releases expired unclaimed sessions. Has to be
+ * called with the cache lock held.
+ *
+ * @param all - release all sessions regardless of their age
+ */
+static void tcmi_ckpt_pagecache_reap_sessions(int all)
+{
+	struct tcmi_ckpt_pagecache_session *session, *tmp;
+
+	list_for_each_entry_safe(session, tmp, &tcmi_ckpt_pagecache_sessions, node) {
+		if (!all && time_before(jiffies, session->created + 
+					TCMI_CKPT_PAGECACHE_SESSION_TIMEOUT))
+			continue;
+		mdbg(INFO3, "Page cache session %u expired", session->id);
+		list_del(&session->node);
+		tcmi_ckpt_pagecache_session_free(session);
+	}
+}
+
+/**
+ * @}
+ */
+
+EXPORT_SYMBOL_GPL(tcmi_ckpt_pagecache_owner_new);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_pagecache_forget);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_pagecache_session_new);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_pagecache_session_free);
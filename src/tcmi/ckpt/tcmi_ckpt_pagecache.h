@@ -0,0 +1,219 @@
+/**
+ * @file tcmi_ckpt_pagecache.h - content addressed cache of pages received
+ *                               in streamed checkpoints
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_PAGECACHE_H
+#define _TCMI_CKPT_PAGECACHE_H
+
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <crypto/hash.h>
+#include <crypto/sha.h>
+
+/** @defgroup tcmi_ckpt_pagecache_class tcmi_ckpt_pagecache class
+ *
+ * @ingroup tcmi_ckpt_class
+ *
+ * This is a \<\<singleton\>\> that keeps copies of pages received in
+ * streamed checkpoints, keyed by a strong hash (SHA-1) of their
+ * content. Migrated processes are often instances of the same
+ * binary, so their images share many identical pages. A node that
+ * already holds a page doesn't need to receive it again.
+ *
+ * The cache is bounded, the least recently used pages are evicted
+ * once the capacity is reached. The capacity is set by the
+ * 'pagecache_pages' module parameter, 0 disables the cache.
+ *
+ * Before a checkpoint is streamed, the sender asks for the hashes of
+ * its pages. A session is created that pins the pages found in the
+ * cache and assigns them the index of their hash. The streamed image
+ * then refers to these pages by the session ID and the index. Pinned
+ * pages are not affected by eviction. Sessions that are never claimed
+ * by a stream (e.g. the sender has failed) expire.
+ *
+ * Pages and sessions belong to an owner - the migration manager of
+ * the peer that has sent them. A peer is offered only its own pages
+ * and can claim only its own sessions, so that it can learn neither
+ * the content nor the presence of pages received from another
+ * node. Owners are identified by numbers that are never reused.
+ *
+ * @{
+ */
+
+/** Size of a page hash */
+#define TCMI_CKPT_PAGE_HASH_SIZE SHA1_DIGEST_SIZE
+
+/** Content hash of a single page */
+struct tcmi_ckpt_page_hash {
+	u_int8_t data[TCMI_CKPT_PAGE_HASH_SIZE];
+} __attribute__((__packed__));
+
+/** Pages of the cache pinned for a single streamed checkpoint */
+struct tcmi_ckpt_pagecache_session {
+	/** node in the list of unclaimed sessions */
+	struct list_head node;
+	/** session ID, never 0 */
+	u_int32_t id;
+	/** owner of the session */
+	u_int64_t owner;
+	/** time of creation in jiffies */
+	unsigned long created;
+	/** number of hashes the session was created for */
+	u_int32_t count;
+	/** pinned pages, NULL for hashes not found */
+	struct page **pages;
+};
+
+/** Unclaimed sessions expire after 60 seconds */
+#define TCMI_CKPT_PAGECACHE_SESSION_TIMEOUT (60*HZ)
+
+/** \<\<public\>\> Initializes the cache. */
+extern int tcmi_ckpt_pagecache_init(void);
+/** \<\<public\>\> Releases all cached pages and sessions. */
+extern void tcmi_ckpt_pagecache_exit(void);
+
+/** \<\<public\>\> Allocates a new owner of pages and sessions. */
+extern u_int64_t tcmi_ckpt_pagecache_owner_new(void);
+/** \<\<public\>\> Releases all pages and sessions of an owner. */
+extern void tcmi_ckpt_pagecache_forget(u_int64_t owner);
+
+/** \<\<public\>\> Inserts a page into the cache. */
+extern int tcmi_ckpt_pagecache_insert(struct shash_desc *desc, u_int64_t owner,
+				      struct tcmi_ckpt_page_hash *hash, void *data);
+
+/** \<\<public\>\> Creates a session for a list of hashes. */
+extern struct tcmi_ckpt_pagecache_session* 
+tcmi_ckpt_pagecache_session_new(u_int64_t owner, struct tcmi_ckpt_page_hash *hashes, 
+				u_int32_t count, u_int8_t *present);
+/** \<\<public\>\> Takes a session over from the list of unclaimed sessions. */
+extern struct tcmi_ckpt_pagecache_session* tcmi_ckpt_pagecache_session_claim(u_int32_t id,
+									     u_int64_t owner);
+/** \<\<public\>\> Releases a claimed session. */
+extern void tcmi_ckpt_pagecache_session_free(struct tcmi_ckpt_pagecache_session *self);
+
+/** \<\<public\>\> Allocates a page hash calculator. */
+extern struct shash_desc* tcmi_ckpt_page_hasher_new(void);
+/** \<\<public\>\> Releases a page hash calculator. */
+extern void tcmi_ckpt_page_hasher_free(struct shash_desc *desc);
+
+/**
+ * \<\<public\>\> Calculates a hash of a page.
+ *
+ * @param *desc - hash calculator
+ * @param *data - page data
+ * @param *hash - output hash
+ * @return 0 upon success
+ */
+static inline int tcmi_ckpt_page_hash(struct shash_desc *desc, void *data, 
+				      struct tcmi_ckpt_page_hash *hash)
+{
+	return crypto_shash_digest(desc, data, PAGE_SIZE, hash->data);
+}
+
+/**
+ * \<\<public\>\> Session ID accessor.
+ *
+ * @param *self - this session
+ * @return session ID
+ */
+static inline u_int32_t tcmi_ckpt_pagecache_session_id(struct tcmi_ckpt_pagecache_session *self)
+{
+	return self->id;
+}
+
+/**
+ * \<\<public\>\> Returns a pinned page of the session.
+ *
+ * @param *self - this session
+ * @param index - index of the page hash
+ * @return page or NULL
+ */
+static inline struct page* tcmi_ckpt_pagecache_session_page(struct tcmi_ckpt_pagecache_session *self,
+							    u_int32_t index)
+{
+	return index < self->count ? self->pages[index] : NULL;
+}
+
+/** Tests a bit in a bitmap transferred over the network. */
+#define tcmi_ckpt_pagecache_bit(bitmap, i) ((bitmap)[(i) >> 3] & (1 << ((i) & 7)))
+
+/** Size of a bitmap transferred over the network. */
+#define tcmi_ckpt_pagecache_bitmap_size(count) (((count) + 7) >> 3)
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CKPT_PAGECACHE_PRIVATE
+
+/** Single cached page */
+struct tcmi_ckpt_pagecache_entry {
+	/** node in the hash table */
+	struct hlist_node hnode;
+	/** node in the LRU list, most recently used first */
+	struct list_head lru;
+	/** owner of the page */
+	u_int64_t owner;
+	/** content hash */
+	struct tcmi_ckpt_page_hash hash;
+	/** the page itself */
+	struct page *page;
+};
+
+/** Number of bits of the hash table index */
+#define TCMI_CKPT_PAGECACHE_HASH_BITS 12
+
+/** Finds a page in the cache. */
+static struct tcmi_ckpt_pagecache_entry* tcmi_ckpt_pagecache_find(u_int64_t owner, 
+								  struct tcmi_ckpt_page_hash *hash);
+
+/** Releases a single cached page. */
+static void tcmi_ckpt_pagecache_release(struct tcmi_ckpt_pagecache_entry *entry);
+
+/** Evicts least recently used pages over the capacity. */
+static void tcmi_ckpt_pagecache_shrink(int capacity);
+
+/** Releases expired unclaimed sessions. */
+static void tcmi_ckpt_pagecache_reap_sessions(int all);
+
+/**
+ * \<\<private\>\> Hash table bucket of a page hash. The hash is
+ * uniformly distributed, so its leading bytes are used directly.
+ *
+ * @param *hash - page hash
+ * @return bucket index
+ */
+static inline u_int32_t tcmi_ckpt_pagecache_bucket(struct tcmi_ckpt_page_hash *hash)
+{
+	return *(u_int32_t*)hash->data & ((1 << TCMI_CKPT_PAGECACHE_HASH_BITS) - 1);
+}
+
+#endif /* TCMI_CKPT_PAGECACHE_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_PAGECACHE_H */
+
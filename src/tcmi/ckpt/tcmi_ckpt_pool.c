@@ -0,0 +1,143 @@
+/**
+ * @file tcmi_ckpt_pool.c - a pool of kernel workers that process checkpoint
+ *                          data in parallel
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/module.h>
+#include <linux/cpumask.h>
+
+#include <dbg.h>
+
+#define TCMI_CKPT_POOL_PRIVATE
+#include "tcmi_ckpt_pool.h"
+
+/**
+ * \<\<public\>\> Starts the worker threads. A per CPU workqueue is
+ * used, jobs are then explicitly distributed among the CPUs.
+ *
+ * @return 0 upon success
+ */
+int tcmi_ckpt_pool_init(void)
+{
+	if (!(tcmi_ckpt_pool_wq = create_workqueue("tcmi_ckptd"))) {
+		mdbg(ERR3, "Can't create checkpoint worker threads");
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Stops the worker threads. There can't be any
+ * pending job as each submitter waits for its batch.
+ */
+void tcmi_ckpt_pool_exit(void)
+{
+	destroy_workqueue(tcmi_ckpt_pool_wq);
+}
+
+/**
+ * \<\<public\>\> Initializes a new batch of jobs. The pending counter
+ * starts at 1, this reference is owned by the submitter and dropped
+ * in tcmi_ckpt_pool_wait(). Thus the batch can't complete while jobs
+ * are still being submitted.
+ *
+ * @param *batch - batch to be initialized
+ */
+void tcmi_ckpt_pool_begin(struct tcmi_ckpt_pool_batch *batch)
+{
+	atomic_set(&batch->pending, 1);
+	atomic_set(&batch->result, 0);
+	init_completion(&batch->done);
+	batch->cpu = -1;
+}
+
+/**
+ * \<\<public\>\> Submits a job into the batch. The job is queued to
+ * the next online CPU.
+ *
+ * @param *batch - batch the job belongs to
+ * @param *job - job to be submitted, must stay valid until the batch is
+ * finished
+ * @param *fn - method to be executed by the worker
+ */
+void tcmi_ckpt_pool_submit(struct tcmi_ckpt_pool_batch *batch,
+			   struct tcmi_ckpt_pool_job *job,
+			   tcmi_ckpt_pool_fn_t *fn)
+{
+	job->fn = fn;
+	job->batch = batch;
+	INIT_WORK(&job->work, tcmi_ckpt_pool_work);
+
+	batch->cpu = cpumask_next(batch->cpu, cpu_online_mask);
+	if (batch->cpu >= nr_cpu_ids)
+		batch->cpu = cpumask_first(cpu_online_mask);
+
+	atomic_inc(&batch->pending);
+	queue_work_on(batch->cpu, tcmi_ckpt_pool_wq, &job->work);
+}
+
+/**
+ * \<\<public\>\> Waits for all jobs of the batch.
+ *
+ * @param *batch - batch to wait for
+ * @return 0 if all jobs succeeded, otherwise the first reported error
+ */
+int tcmi_ckpt_pool_wait(struct tcmi_ckpt_pool_batch *batch)
+{
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+	wait_for_completion(&batch->done);
+	return atomic_read(&batch->result);
+}
+
+/** @addtogroup tcmi_ckpt_pool_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Executes a single job in the worker thread and
+ * completes the batch when it was the last one.
+ *
+ * @param *work - work item embedded in the job
+ */
+static void tcmi_ckpt_pool_work(struct work_struct *work)
+{
+	struct tcmi_ckpt_pool_job *job =
+		container_of(work, struct tcmi_ckpt_pool_job, work);
+	struct tcmi_ckpt_pool_batch *batch = job->batch;
+	int err;
+
+	if ((err = job->fn(job)) < 0)
+		atomic_cmpxchg(&batch->result, 0, err);
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,111 @@
+/**
+ * @file tcmi_ckpt_pool.h - a pool of kernel workers that process checkpoint
+ *                          data in parallel
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_POOL_H
+#define _TCMI_CKPT_POOL_H
+
+#include <linux/workqueue.h>
+#include <linux/completion.h>
+#include <asm/atomic.h>
+
+/** @defgroup tcmi_ckpt_pool_class tcmi_ckpt_pool class
+ *
+ * @ingroup tcmi_ckpt_class
+ *
+ * This is a \<\<singleton\>\> that manages a pool of kernel workers
+ * (one per online CPU) used by the checkpoint to offload CPU
+ * intensive work (e.g. page compression) from the checkpointed
+ * process.
+ *
+ * The work is submitted in batches. The submitter initializes a
+ * batch, submits any number of jobs and then waits for all of them to
+ * finish. Jobs are spread over the CPUs in a round robin fashion, so
+ * that a single checkpoint uses all of them. The jobs must not access
+ * the address space of the checkpointed process, they run in the
+ * context of the worker threads.
+ *
+ * @{
+ */
+
+/** Tracks the jobs of a single batch. */
+struct tcmi_ckpt_pool_batch {
+	/** number of unfinished jobs + 1 for the submitter */
+	atomic_t pending;
+	/** signalled once the last job has finished */
+	struct completion done;
+	/** first error reported by a job */
+	atomic_t result;
+	/** CPU that receives the next job */
+	int cpu;
+};
+
+struct tcmi_ckpt_pool_job;
+/** Job method, returns 0 upon success. */
+typedef int tcmi_ckpt_pool_fn_t(struct tcmi_ckpt_pool_job *job);
+
+/** Single unit of work, typically embedded in the job data. */
+struct tcmi_ckpt_pool_job {
+	/** work item queued to the workers */
+	struct work_struct work;
+	/** method to be executed */
+	tcmi_ckpt_pool_fn_t *fn;
+	/** batch the job belongs to */
+	struct tcmi_ckpt_pool_batch *batch;
+};
+
+/** \<\<public\>\> Starts the worker threads. */
+extern int tcmi_ckpt_pool_init(void);
+/** \<\<public\>\> Stops the worker threads. */
+extern void tcmi_ckpt_pool_exit(void);
+
+/** \<\<public\>\> Initializes a new batch of jobs. */
+extern void tcmi_ckpt_pool_begin(struct tcmi_ckpt_pool_batch *batch);
+/** \<\<public\>\> Submits a job into the batch. */
+extern void tcmi_ckpt_pool_submit(struct tcmi_ckpt_pool_batch *batch,
+				  struct tcmi_ckpt_pool_job *job,
+				  tcmi_ckpt_pool_fn_t *fn);
+/** \<\<public\>\> Waits for all jobs of the batch. */
+extern int tcmi_ckpt_pool_wait(struct tcmi_ckpt_pool_batch *batch);
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CKPT_POOL_PRIVATE
+
+/** Executes a single job in the worker thread. */
+static void tcmi_ckpt_pool_work(struct work_struct *work);
+
+/** Workqueue with one worker thread per CPU. */
+static struct workqueue_struct *tcmi_ckpt_pool_wq;
+
+#endif /* TCMI_CKPT_POOL_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_POOL_H */
+
@@ -0,0 +1,150 @@
+/**
+ * @file tcmi_ckpt_profile.h - a helper class that measures duration and size
+ *                             of the checkpoint and restart phases
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_PROFILE_H
+#define _TCMI_CKPT_PROFILE_H
+
+#include <linux/types.h>
+#include <linux/sched.h>
+#include <linux/smp.h>
+#include <linux/string.h>
+
+/** @defgroup tcmi_ckpt_profile_class tcmi_ckpt_profile class 
+ *
+ * @ingroup tcmi_ckpt_class
+ *
+ * This is a helper class used by the checkpoint to record how long
+ * each phase of checkpointing or restarting a process took and how
+ * many bytes of the image it has produced or consumed. The phases
+ * follow the order in which the image is written:
+ * - header - checkpoint header and resource limits
+ * - files - open file table
+ * - mm - memory descriptor
+ * - vmas - memory areas including their pages, on restart this is
+ * the time spent mapping the image
+ * - regs - processor registers, TLS and fs struct
+ * - signals - signal handlers and pending signals
+ * - conv - conversion of the registers of the process and its threads
+ * into the registers of the current architecture, restart only. The
+ * time is not accounted to the regs phase.
+ *
+ * The profile of the last checkpoint/restart is kept by the \link
+ * tcmi_task_class TCMI task \endlink, that reports it via ctlfs and
+ * to the director.
+ *
+ * As the fdcache, the profile is accessed from a single thread of
+ * execution and needs no locking.
+ *
+ * @{
+ */
+
+/** Profiled phases */
+enum tcmi_ckpt_phase {
+	TCMI_CKPT_PHASE_HDR,
+	TCMI_CKPT_PHASE_FILES,
+	TCMI_CKPT_PHASE_MM,
+	TCMI_CKPT_PHASE_VMAS,
+	TCMI_CKPT_PHASE_REGS,
+	TCMI_CKPT_PHASE_SIGS,
+	TCMI_CKPT_PHASE_CONV,
+	TCMI_CKPT_PHASE_COUNT
+};
+
+/** Compound structure describing phases of a single checkpoint or restart. */
+struct tcmi_ckpt_profile {
+	/** set for a restart profile, clear for a checkpoint */
+	int restart;
+	/** duration of each phase in nanoseconds */
+	u_int64_t time[TCMI_CKPT_PHASE_COUNT];
+	/** number of image bytes processed by each phase */
+	u_int64_t bytes[TCMI_CKPT_PHASE_COUNT];
+
+	/** time when the current phase has started */
+	u_int64_t mark_time;
+	/** image position when the current phase has started */
+	loff_t mark_pos;
+};
+
+/**
+ * \<\<public\>\> Starts profiling, all previous measurements are
+ * discarded.
+ *
+ * @param *self - this profile instance
+ * @param restart - set when profiling a restart
+ * @param pos - current position in the image
+ */
+static inline void tcmi_ckpt_profile_start(struct tcmi_ckpt_profile *self, int restart,
+					   loff_t pos)
+{
+	memset(self, 0, sizeof(*self));
+	self->restart = restart;
+	self->mark_time = cpu_clock(smp_processor_id());
+	self->mark_pos = pos;
+}
+
+/**
+ * \<\<public\>\> Accounts everything since the end of the previous
+ * phase to the specified phase. A phase may be accounted several
+ * times, the measurements are summed up.
+ *
+ * @param *self - this profile instance
+ * @param phase - phase that has just finished
+ * @param pos - current position in the image
+ */
+static inline void tcmi_ckpt_profile_phase(struct tcmi_ckpt_profile *self, 
+					   enum tcmi_ckpt_phase phase, loff_t pos)
+{
+	u_int64_t now = cpu_clock(smp_processor_id());
+
+	self->time[phase] += now - self->mark_time;
+	self->bytes[phase] += pos - self->mark_pos;
+	self->mark_time = now;
+	self->mark_pos = pos;
+}
+
+/**
+ * \<\<public\>\> Total number of image bytes processed by all phases.
+ *
+ * @param *self - this profile instance
+ * @return number of bytes
+ */
+static inline u_int64_t tcmi_ckpt_profile_bytes(struct tcmi_ckpt_profile *self)
+{
+	u_int64_t bytes = 0;
+	int i;
+
+	for (i = 0; i < TCMI_CKPT_PHASE_COUNT; i++)
+		bytes += self->bytes[i];
+	return bytes;
+}
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_PROFILE_H */
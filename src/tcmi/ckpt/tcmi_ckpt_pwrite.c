@@ -0,0 +1,190 @@
+/**
+ * @file tcmi_ckpt_pwrite.c - a helper class that writes large memory
+ *                            areas in parallel
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <asm/cacheflush.h>
+
+#include "tcmi_ckpt_vm_area.h"
+
+#define TCMI_CKPT_PWRITE_PRIVATE
+#include "tcmi_ckpt_pwrite.h"
+
+/**
+ * \<\<public\>\> Starts a parallel writer of the checkpoint. Only
+ * file based checkpoints can be written in parallel, as the image
+ * has to be seekable.
+ *
+ * @param *ckpt - checkpoint instance
+ * @return 0 upon success
+ */
+int tcmi_ckpt_pwrite_begin(struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_pwrite *self;
+
+	if (ckpt->sock)
+		return -ESPIPE;
+	if (!(self = kmalloc(sizeof(*self), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate parallel writer");
+		return -ENOMEM;
+	}
+	INIT_LIST_HEAD(&self->list);
+	tcmi_ckpt_pool_begin(&self->jobs);
+	ckpt->pwrite = self;
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Submits pages of an area for writing. The current
+ * position of the checkpoint has to be page aligned. Pages are pinned
+ * in context of the checkpointed process, while the actual writing is
+ * left to the workers. The position is advanced behind the area,
+ * i.e. the whole area is reserved in the image.
+ *
+ * @param *ckpt - checkpoint instance
+ * @param *vma - VM area to be written
+ * @return 0 upon success
+ */
+int tcmi_ckpt_pwrite_area(struct tcmi_ckpt *ckpt, struct vm_area_struct *vma)
+{
+	struct tcmi_ckpt_pwrite *self = ckpt->pwrite;
+	struct tcmi_ckpt_pwrite_job *chunk = NULL;
+	struct vm_area_struct *page_vma;
+	struct page *page;
+	unsigned long addr;
+	loff_t pos = tcmi_ckpt_pos(ckpt);
+
+	for (addr = vma->vm_start; addr < vma->vm_end; addr += PAGE_SIZE) {
+		if (!chunk) {
+			if (!(chunk = vmalloc(sizeof(*chunk)))) {
+				mdbg(ERR3, "Can't allocate parallel write job");
+				goto exit0;
+			}
+			chunk->file = ckpt->file;
+			chunk->pos = pos + (addr - vma->vm_start);
+			chunk->count = 0;
+			list_add(&chunk->node, &self->list);
+		}
+		if (get_user_pages(current, current->mm, addr, 1, 0, 1,
+				   &page, &page_vma) <= 0)
+			page = NULL;
+		else
+			flush_cache_page(page_vma, addr, page_to_pfn(page));
+		chunk->pages[chunk->count++] = page;
+		if (chunk->count == TCMI_CKPT_PWRITE_PAGES) {
+			tcmi_ckpt_pool_submit(&self->jobs, &chunk->job, tcmi_ckpt_pwrite_chunk);
+			chunk = NULL;
+		}
+	}
+	if (chunk)
+		tcmi_ckpt_pool_submit(&self->jobs, &chunk->job, tcmi_ckpt_pwrite_chunk);
+
+	tcmi_ckpt_seek(ckpt, pos + (vma->vm_end - vma->vm_start), 0);
+	return 0;
+
+	/* error handling */
+ exit0:
+	return -ENOMEM;
+}
+
+/**
+ * \<\<public\>\> Waits for all submitted pages and releases the
+ * writer. Has to be called whenever the writer has been started, also
+ * when the checkpoint fails, as the workers still use the pinned
+ * pages.
+ *
+ * @param *ckpt - checkpoint instance
+ * @return 0 if all pages have been written
+ */
+int tcmi_ckpt_pwrite_end(struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_pwrite *self = ckpt->pwrite;
+	struct tcmi_ckpt_pwrite_job *chunk, *tmp;
+	int err;
+
+	if (!self)
+		return 0;
+	if ((err = tcmi_ckpt_pool_wait(&self->jobs)) < 0)
+		mdbg(ERR3, "Error writing areas in parallel: %d", err);
+	list_for_each_entry_safe(chunk, tmp, &self->list, node) {
+		list_del(&chunk->node);
+		vfree(chunk);
+	}
+	kfree(self);
+	ckpt->pwrite = NULL;
+	return err;
+}
+
+/** @addtogroup tcmi_ckpt_pwrite_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Writes a single chunk of pages at its reserved
+ * offset and releases the pinned pages. Untouched pages are left as
+ * holes in the image.
+ *
+ * @param *job - pool job embedded in the chunk
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_pwrite_chunk(struct tcmi_ckpt_pool_job *job)
+{
+	struct tcmi_ckpt_pwrite_job *self =
+		container_of(job, struct tcmi_ckpt_pwrite_job, job);
+	mm_segment_t old_fs;
+	loff_t pos;
+	void *kaddr;
+	int i, err = 0;
+
+	old_fs = get_fs();
+	set_fs(get_ds());
+	for (i = 0; i < self->count; i++) {
+		if (!self->pages[i])
+			continue;
+		if (!err) {
+			pos = self->pos + i * PAGE_SIZE;
+			kaddr = tcmi_ckpt_vm_area_kmap(self->pages[i]);
+			/* The cast to a user pointer is valid due to the set_fs() */
+			if (vfs_write(self->file, (void __user *)kaddr, PAGE_SIZE, &pos) != PAGE_SIZE) {
+				mdbg(ERR3, "Error writing page at offset %08llx", 
+				     (unsigned long long)self->pos + i * PAGE_SIZE);
+				err = -EIO;
+			}
+			tcmi_ckpt_vm_area_kunmap(self->pages[i]);
+		}
+		page_cache_release(self->pages[i]);
+	}
+	set_fs(old_fs);
+	return err;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,122 @@
+/**
+ * @file tcmi_ckpt_pwrite.h - a helper class that writes large memory
+ *                            areas in parallel
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_PWRITE_H
+#define _TCMI_CKPT_PWRITE_H
+
+#include <linux/list.h>
+#include <linux/mm.h>
+
+#include "tcmi_ckpt.h"
+#include "tcmi_ckpt_pool.h"
+
+/** @defgroup tcmi_ckpt_pwrite_class tcmi_ckpt_pwrite class
+ *
+ * @ingroup tcmi_ckpt_vm_area_class
+ *
+ * This is a helper class used by the \link tcmi_ckpt_vm_area_class
+ * VM area \endlink to write large memory areas of file based
+ * checkpoints in parallel. The layout of the image is the same as of
+ * the heavy checkpoint, so the restart doesn't notice any difference.
+ *
+ * As the size of a heavy area is known upfront, the checkpointed
+ * process only writes the area header, reserves the page aligned
+ * range for the pages in the image and moves on to the next area. The
+ * pages are pinned and handed over in chunks of
+ * TCMI_CKPT_PWRITE_PAGES to the \link tcmi_ckpt_pool_class worker
+ * pool \endlink, which writes them at their reserved offsets. The
+ * workers never touch the address space of the process, they work
+ * with the pinned pages only.
+ *
+ * All areas of a checkpoint share a single batch of jobs, the writer
+ * waits for all of them just once, when all areas have been
+ * submitted.
+ *
+ * @{
+ */
+
+/** Number of pages written by a single job. */
+#define TCMI_CKPT_PWRITE_PAGES 1024
+
+/** Single chunk of pages written by a worker. */
+struct tcmi_ckpt_pwrite_job {
+	/** pool job */
+	struct tcmi_ckpt_pool_job job;
+	/** node in the list of jobs of the writer */
+	struct list_head node;
+	/** checkpoint file */
+	struct file *file;
+	/** reserved offset of the first page in the image */
+	loff_t pos;
+	/** number of pages in the chunk */
+	int count;
+	/** pinned pages, NULL for untouched pages (holes) */
+	struct page *pages[TCMI_CKPT_PWRITE_PAGES];
+};
+
+/** Parallel writer of a single checkpoint. */
+struct tcmi_ckpt_pwrite {
+	/** batch shared by all jobs of the checkpoint */
+	struct tcmi_ckpt_pool_batch jobs;
+	/** all submitted jobs, released once the batch is finished */
+	struct list_head list;
+};
+
+/** \<\<public\>\> Starts a parallel writer of the checkpoint. */
+extern int tcmi_ckpt_pwrite_begin(struct tcmi_ckpt *ckpt);
+/** \<\<public\>\> Submits pages of an area for writing. */
+extern int tcmi_ckpt_pwrite_area(struct tcmi_ckpt *ckpt, struct vm_area_struct *vma);
+/** \<\<public\>\> Waits for all submitted pages and releases the writer. */
+extern int tcmi_ckpt_pwrite_end(struct tcmi_ckpt *ckpt);
+
+/**
+ * \<\<public\>\> Checks whether an area is to be written in parallel.
+ *
+ * @param *ckpt - checkpoint instance
+ * @param *vma - VM area to be written
+ * @return 1 if the parallel writer is to be used
+ */
+static inline int tcmi_ckpt_pwrite_wanted(struct tcmi_ckpt *ckpt, struct vm_area_struct *vma)
+{
+	return ckpt->pwrite && 
+		((vma->vm_end - vma->vm_start) >> PAGE_SHIFT) >= ckpt->parallel;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CKPT_PWRITE_PRIVATE
+
+/** Writes a single chunk of pages, runs in the worker. */
+static int tcmi_ckpt_pwrite_chunk(struct tcmi_ckpt_pool_job *job);
+
+#endif /* TCMI_CKPT_PWRITE_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_PWRITE_H */
@@ -80,7 +80,9 @@ static inline int tcmi_ckpt_regs_write(struct tcmi_ckpt *ckpt, struct pt_regs *r
 
 /** 
  * Reads a process registers from the checkpoint file and sets
- * them for the current process.
+ * them for the current process. The registers are converted by the
+ * table prepared for the checkpoint architecture, the time spent
+ * converting is accounted to the conversion phase of the profile.
  *
  * @param *ckpt - checkpoint file where the area is to be stored
  * @param *regs - registers of the current process
@@ -108,7 +110,10 @@ static inline int tcmi_ckpt_regs_read(struct tcmi_ckpt *ckpt, struct pt_regs *re
 		goto exit1;
 	}
 
+	/* account the conversion separately so that its cost is visible */
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_REGS);
 	load_from_platform_registers(platform_regs, regs, ckpt->hdr.checkpoint_arch, ckpt->hdr.is_32bit_application);
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_CONV);
 	platform_start_thread(regs, instruction_pointer(regs), stack_pointer(regs), ckpt->hdr.checkpoint_arch, ckpt->hdr.is_32bit_application);
 
 	mdbg(INFO4, "Read process registers:");
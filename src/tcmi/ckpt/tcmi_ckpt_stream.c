@@ -0,0 +1,550 @@
+/**
+ * @file tcmi_ckpt_stream.c - a helper class that transfers a checkpoint
+ *                            image over a KKC socket
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/module.h>
+#include <linux/mm.h>
+#include <linux/shmem_fs.h>
+#include <crypto/hash.h>
+
+#include "tcmi_ckpt.h"
+
+#define TCMI_CKPT_STREAM_PRIVATE
+#include "tcmi_ckpt_stream.h"
+
+/**
+ * \<\<public\>\> Writes a data frame into the streamed image. The
+ * frame header is followed by the data itself.
+ *
+ * @param *self - this checkpoint instance
+ * @param *data - data to be written
+ * @param count - number of bytes to be written
+ * @return 0 upon successful write of count bytes
+ */
+int tcmi_ckpt_stream_write(struct tcmi_ckpt *self, void *data, int count)
+{
+	int err;
+
+	if (count <= 0)
+		return 0;
+	if ((err = tcmi_ckpt_stream_send_frame(self->sock, count)) < 0)
+		goto exit0;
+	if ((err = kkc_sock_send(self->sock, data, count, KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to stream %d bytes of the image: %d", count, err);
+		goto exit0;
+	}
+	self->stream_pos += count;
+	return 0;
+
+	/* error handling */
+ exit0:
+	return -EINVAL;
+}
+
+/**
+ * \<\<public\>\> Creates a hole in the streamed image. Nothing but
+ * the frame header is sent, the receiver just advances its position.
+ *
+ * @param *self - this checkpoint instance
+ * @param count - size of the hole in bytes
+ * @return new position in the image or error (< 0)
+ */
+loff_t tcmi_ckpt_stream_skip(struct tcmi_ckpt *self, loff_t count)
+{
+	int32_t chunk;
+	int err;
+
+	while (count > 0) {
+		chunk = min_t(loff_t, count, TCMI_CKPT_STREAM_MAX_HOLE);
+		if ((err = tcmi_ckpt_stream_send_frame(self->sock, -chunk)) < 0)
+			return err;
+		self->stream_pos += chunk;
+		count -= chunk;
+	}
+	return self->stream_pos;
+}
+
+/**
+ * \<\<public\>\> Announces the page cache session the image refers
+ * to. Has to precede any page reference in the stream.
+ *
+ * @param *self - this checkpoint instance
+ * @param id - session ID assigned by the receiver
+ * @return 0 upon success
+ */
+int tcmi_ckpt_stream_session(struct tcmi_ckpt *self, u_int32_t id)
+{
+	int err;
+
+	if ((err = tcmi_ckpt_stream_send_frame(self->sock, TCMI_CKPT_STREAM_SESSION)) < 0)
+		return err;
+	if ((err = kkc_sock_send(self->sock, &id, sizeof(id), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send page cache session ID: %d", err);
+		return err;
+	}
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Writes a page along with its hash. The receiver
+ * stores the page at the current position and caches it for future
+ * migrations.
+ *
+ * @param *self - this checkpoint instance
+ * @param *hash - hash of the page
+ * @param *data - page data
+ * @return 0 upon success
+ */
+int tcmi_ckpt_stream_page(struct tcmi_ckpt *self, struct tcmi_ckpt_page_hash *hash,
+			  void *data)
+{
+	int err;
+
+	if ((err = tcmi_ckpt_stream_send_frame(self->sock, TCMI_CKPT_STREAM_PAGE)) < 0)
+		return err;
+	if ((err = kkc_sock_send(self->sock, hash, sizeof(*hash), KKC_SOCK_BLOCK)) < 0 ||
+	    (err = kkc_sock_send(self->sock, data, PAGE_SIZE, KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to stream hashed page: %d", err);
+		return err;
+	}
+	self->stream_pos += PAGE_SIZE;
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Writes a reference to a page pinned by the
+ * session. The receiver takes the page from its cache, no page data
+ * are sent.
+ *
+ * @param *self - this checkpoint instance
+ * @param index - index of the page hash in the session
+ * @return 0 upon success
+ */
+int tcmi_ckpt_stream_page_ref(struct tcmi_ckpt *self, u_int32_t index)
+{
+	int err;
+
+	if ((err = tcmi_ckpt_stream_send_frame(self->sock, TCMI_CKPT_STREAM_PAGE_REF)) < 0)
+		return err;
+	if ((err = kkc_sock_send(self->sock, &index, sizeof(index), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to stream page reference: %d", err);
+		return err;
+	}
+	self->stream_pos += PAGE_SIZE;
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Terminates the streamed image. Has to be called
+ * exactly once per streamed checkpoint, also when the checkpoint has
+ * failed, so that the receiver doesn't wait for more data.
+ *
+ * @param *self - this checkpoint instance
+ * @param aborted - when set, the receiver is told to discard the image
+ * @return 0 upon success
+ */
+int tcmi_ckpt_stream_end(struct tcmi_ckpt *self, int aborted)
+{
+	mdbg(INFO3, "Terminating streamed image at %lld, aborted: %d",
+	     (long long)self->stream_pos, aborted);
+	return tcmi_ckpt_stream_send_frame(self->sock, aborted ? TCMI_CKPT_STREAM_ABORT : 0);
+}
+
+/**
+ * \<\<public\>\> Streams an existing image file (typically an
+ * in-memory image created by tcmi_ckptcom_checkpoint_ppm_mem()) from
+ * its current position to its end. The image is sent page by page,
+ * zero pages are turned into holes, so that the receiver doesn't
+ * allocate memory for them. The stream is always terminated.
+ *
+ * The caller is responsible for holding the send lock of the socket
+ * as the image must not interleave with other messages.
+ *
+ * @param *sock - socket where the image is to be streamed
+ * @param *file - file with the image
+ * @return 0 upon success
+ */
+int tcmi_ckpt_stream_send_file(struct kkc_sock *sock, struct file *file)
+{
+	unsigned long page;
+	int32_t hole = 0;
+	int count;
+	int err;
+	mm_segment_t old_fs;
+
+	if (!(page = __get_free_page(GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate page for the image data");
+		err = -ENOMEM;
+		goto exit0;
+	}
+
+	for (;;) {
+		old_fs = get_fs();
+		set_fs(get_ds());
+		/* The cast to a user pointer is valid due to the set_fs() */
+		count = vfs_read(file, (void __user *)page, PAGE_SIZE, &file->f_pos);
+		set_fs(old_fs);
+		if (count < 0) {
+			mdbg(ERR3, "Failed to read the image: %d", count);
+			err = count;
+			goto exit1;
+		}
+		if (count == 0)
+			break;
+		if (tcmi_ckpt_stream_zero((void*)page, count)) {
+			if (hole > TCMI_CKPT_STREAM_MAX_HOLE - count) {
+				if ((err = tcmi_ckpt_stream_send_frame(sock, -hole)) < 0)
+					goto exit1;
+				hole = 0;
+			}
+			hole += count;
+			continue;
+		}
+		if (hole && (err = tcmi_ckpt_stream_send_frame(sock, -hole)) < 0)
+			goto exit1;
+		hole = 0;
+		if ((err = tcmi_ckpt_stream_send_frame(sock, count)) < 0)
+			goto exit1;
+		if ((err = kkc_sock_send(sock, (void*)page, count, KKC_SOCK_BLOCK)) < 0) {
+			mdbg(ERR3, "Failed to stream %d bytes of the image: %d", count, err);
+			goto exit1;
+		}
+	}
+	if (hole && (err = tcmi_ckpt_stream_send_frame(sock, -hole)) < 0)
+		goto exit1;
+	mdbg(INFO3, "Streamed image file of size %lld", (long long)file->f_pos);
+	free_page(page);
+
+	return tcmi_ckpt_stream_send_frame(sock, 0);
+
+	/* error handling */
+ exit1:
+	free_page(page);
+ exit0:
+	tcmi_ckpt_stream_send_frame(sock, TCMI_CKPT_STREAM_ABORT);
+	return err;
+}
+
+/**
+ * \<\<public\>\> Receives a streamed image into an in-memory
+ * file. The file is not linked anywhere in the filesystem, it lives
+ * as long as somebody holds a reference (e.g. a memory mapping of the
+ * restarted process).
+ *
+ * Holes are reproduced by seeking in the file, so that untouched
+ * pages don't take any memory. If the image ends with a hole, a
+ * single zero byte is written at its end to extend the file size.
+ *
+ * Hashed pages are spooled and inserted into the \link
+ * tcmi_ckpt_pagecache_class page cache \endlink, page references are
+ * resolved against the session announced by the sender. Both are
+ * limited to the pages of the owner - the peer the image comes from.
+ *
+ * @param *sock - socket the image is being received from
+ * @param owner - page cache owner of the sender, 0 disables the page cache
+ * @return file with the image or an error pointer
+ */
+struct file* tcmi_ckpt_stream_recv(struct kkc_sock *sock, u_int64_t owner)
+{
+	struct tcmi_ckpt_stream_frame frame;
+	struct tcmi_ckpt_pagecache_session *session = NULL;
+	struct shash_desc *desc = NULL;
+	struct file *file;
+	unsigned long page;
+	u_int32_t id;
+	int in_hole = 0;
+	int err;
+	mm_segment_t old_fs;
+	char zero = 0;
+
+	file = shmem_file_setup("tcmi-ckpt", 0, VM_NORESERVE);
+	if (IS_ERR(file)) {
+		mdbg(ERR3, "Can't create in-memory file for the image: %ld", PTR_ERR(file));
+		goto exit0;
+	}
+	if (!(page = __get_free_page(GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate page for the image data");
+		err = -ENOMEM;
+		goto exit1;
+	}
+
+	for (;;) {
+		if ((err = kkc_sock_recv(sock, &frame, sizeof(frame), KKC_SOCK_BLOCK)) < 0) {
+			mdbg(ERR3, "Failed to receive image frame: %d", err);
+			goto exit2;
+		}
+		if (frame.length == 0)
+			break;
+		if (frame.length == TCMI_CKPT_STREAM_ABORT) {
+			mdbg(ERR3, "Image transfer aborted by the sender");
+			err = -ENOEXEC;
+			goto exit2;
+		}
+		if (frame.length == TCMI_CKPT_STREAM_SESSION) {
+			if ((err = kkc_sock_recv(sock, &id, sizeof(id), KKC_SOCK_BLOCK)) < 0) {
+				mdbg(ERR3, "Failed to receive page cache session ID: %d", err);
+				goto exit2;
+			}
+			if (session)
+				tcmi_ckpt_pagecache_session_free(session);
+			session = owner ? tcmi_ckpt_pagecache_session_claim(id, owner) : NULL;
+			continue;
+		}
+		if (frame.length == TCMI_CKPT_STREAM_PAGE) {
+			if ((err = tcmi_ckpt_stream_recv_page(sock, file, (void*)page,
+							      owner, &desc)) < 0)
+				goto exit2;
+			in_hole = 0;
+			continue;
+		}
+		if (frame.length == TCMI_CKPT_STREAM_PAGE_REF) {
+			if ((err = tcmi_ckpt_stream_recv_page_ref(sock, file, session)) < 0)
+				goto exit2;
+			in_hole = 0;
+			continue;
+		}
+		if (frame.length < -TCMI_CKPT_STREAM_MAX_HOLE) {
+			mdbg(ERR3, "Unknown image frame %x", frame.length);
+			err = -EINVAL;
+			goto exit2;
+		}
+		if (frame.length < 0) {
+			vfs_llseek(file, -(loff_t)frame.length, 1);
+			in_hole = 1;
+			continue;
+		}
+		if ((err = tcmi_ckpt_stream_recv_data(sock, file, (void*)page,
+						      frame.length)) < 0)
+			goto exit2;
+		in_hole = 0;
+	}
+
+	if (in_hole) {
+		vfs_llseek(file, -1, 1);
+		old_fs = get_fs();
+		set_fs(get_ds());
+		err = vfs_write(file, (void __user *)&zero, 1, &file->f_pos);
+		set_fs(old_fs);
+		if (err != 1) {
+			mdbg(ERR3, "Can't extend the image file");
+			err = -EIO;
+			goto exit2;
+		}
+	}
+	mdbg(INFO3, "Received streamed image of size %lld", (long long)file->f_pos);
+	vfs_llseek(file, 0, 0);
+
+	tcmi_ckpt_pagecache_session_free(session);
+	tcmi_ckpt_page_hasher_free(desc);
+	free_page(page);
+	return file;
+
+	/* error handling */
+ exit2:
+	tcmi_ckpt_pagecache_session_free(session);
+	tcmi_ckpt_page_hasher_free(desc);
+	free_page(page);
+ exit1:
+	fput(file);
+	return ERR_PTR(err);
+ exit0:
+	return file;
+}
+
+/** @addtogroup tcmi_ckpt_stream_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Sends a single frame header.
+ *
+ * @param *sock - socket the image is being sent to
+ * @param length - length of the frame (see frame description)
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_stream_send_frame(struct kkc_sock *sock, int32_t length)
+{
+	struct tcmi_ckpt_stream_frame frame;
+	int err;
+
+	frame.length = length;
+	if ((err = kkc_sock_send(sock, &frame, sizeof(frame), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send image frame header: %d", err);
+		return err;
+	}
+	return 0;
+}
+
+/**
+ * \<\<private\>\> Checks whether a buffer contains only zeros.
+ *
+ * @param *buf - buffer to be checked
+ * @param length - number of bytes in the buffer
+ * @return 1 if all bytes are zero
+ */
+static int tcmi_ckpt_stream_zero(void *buf, int length)
+{
+	unsigned long *word = buf;
+	char *byte;
+
+	for (; length >= sizeof(*word); length -= sizeof(*word))
+		if (*word++)
+			return 0;
+	for (byte = (char*)word; length > 0; length--)
+		if (*byte++)
+			return 0;
+	return 1;
+}
+
+/**
+ * \<\<private\>\> Receives a data frame into the spool file. The data
+ * are received in page sized chunks.
+ *
+ * @param *sock - socket the image is being received from
+ * @param *file - spool file
+ * @param *buf - page sized buffer
+ * @param length - number of bytes in the frame
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_stream_recv_data(struct kkc_sock *sock, struct file *file,
+				      void *buf, int32_t length)
+{
+	int chunk;
+	int err;
+
+	while (length > 0) {
+		chunk = min_t(int32_t, length, PAGE_SIZE);
+		if ((err = kkc_sock_recv(sock, buf, chunk, KKC_SOCK_BLOCK)) < 0) {
+			mdbg(ERR3, "Failed to receive image data: %d", err);
+			return err;
+		}
+		if ((err = tcmi_ckpt_stream_spool(file, buf, chunk)) < 0)
+			return err;
+		length -= chunk;
+	}
+	return 0;
+}
+
+/**
+ * \<\<private\>\> Writes data into the spool file at its current
+ * position.
+ *
+ * @param *file - spool file
+ * @param *buf - data to be written
+ * @param length - number of bytes to be written
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_stream_spool(struct file *file, void *buf, int length)
+{
+	int err;
+	mm_segment_t old_fs;
+
+	old_fs = get_fs();
+	set_fs(get_ds());
+	/* The cast to a user pointer is valid due to the set_fs() */
+	err = vfs_write(file, (void __user *)buf, length, &file->f_pos);
+	set_fs(old_fs);
+	if (err != length) {
+		mdbg(ERR3, "Failed to spool image data: %d", err);
+		return -EIO;
+	}
+	return 0;
+}
+
+/**
+ * \<\<private\>\> Receives a page along with its hash. The page is
+ * spooled and offered to the page cache. A page that can't be cached
+ * (e.g. hash mismatch) is still part of the image, so it is not
+ * treated as an error.
+ *
+ * @param *sock - socket the image is being received from
+ * @param *file - spool file
+ * @param *buf - page sized buffer
+ * @param owner - page cache owner of the sender, 0 doesn't cache the page
+ * @param **desc - hashing context, allocated upon first use
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_stream_recv_page(struct kkc_sock *sock, struct file *file,
+				      void *buf, u_int64_t owner, struct shash_desc **desc)
+{
+	struct tcmi_ckpt_page_hash hash;
+	int err;
+
+	if ((err = kkc_sock_recv(sock, &hash, sizeof(hash), KKC_SOCK_BLOCK)) < 0 ||
+	    (err = kkc_sock_recv(sock, buf, PAGE_SIZE, KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive hashed page: %d", err);
+		return err;
+	}
+	if ((err = tcmi_ckpt_stream_spool(file, buf, PAGE_SIZE)) < 0)
+		return err;
+	if (!owner)
+		return 0;
+	if (!*desc)
+		*desc = tcmi_ckpt_page_hasher_new();
+	if (*desc)
+		tcmi_ckpt_pagecache_insert(*desc, owner, &hash, buf);
+	return 0;
+}
+
+/**
+ * \<\<private\>\> Receives a page reference and spools the page
+ * pinned by the session.
+ *
+ * @param *sock - socket the image is being received from
+ * @param *file - spool file
+ * @param *session - session announced by the sender
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_stream_recv_page_ref(struct kkc_sock *sock, struct file *file,
+					  struct tcmi_ckpt_pagecache_session *session)
+{
+	struct page *page;
+	u_int32_t index;
+	int err;
+
+	if ((err = kkc_sock_recv(sock, &index, sizeof(index), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive page reference: %d", err);
+		return err;
+	}
+	if (!session || !(page = tcmi_ckpt_pagecache_session_page(session, index))) {
+		mdbg(ERR3, "Referenced page %u is not available", index);
+		return -ENOENT;
+	}
+	return tcmi_ckpt_stream_spool(file, page_address(page), PAGE_SIZE);
+}
+
+/**
+ * @}
+ */
+
+EXPORT_SYMBOL_GPL(tcmi_ckpt_stream_send_file);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_stream_recv);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_stream_session);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_stream_page);
+EXPORT_SYMBOL_GPL(tcmi_ckpt_stream_page_ref);
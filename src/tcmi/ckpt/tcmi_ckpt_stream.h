@@ -0,0 +1,141 @@
+/**
+ * @file tcmi_ckpt_stream.h - a helper class that transfers a checkpoint
+ *                            image over a KKC socket
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_STREAM_H
+#define _TCMI_CKPT_STREAM_H
+
+#include <linux/fs.h>
+#include <linux/file.h>
+
+#include <kkc/kkc_sock.h>
+
+#include "tcmi_ckpt.h"
+#include "tcmi_ckpt_pagecache.h"
+
+/** @defgroup tcmi_ckpt_stream_class tcmi_ckpt_stream class
+ *
+ * @ingroup tcmi_ckpt_class
+ *
+ * This is a helper \<\<singleton\>\> class used by the \link
+ * tcmi_ckpt_class checkpoint \endlink when the image is not written
+ * into a file, but streamed directly into a KKC socket (typically
+ * the socket of the migration manager).
+ *
+ * The image is sent as a sequence of frames. Each frame starts with
+ * a signed length:
+ * - length > 0 - the frame carries 'length' bytes of image data
+ * - length < 0 - a hole, the receiver just advances its position by
+ * '-length' bytes (untouched pages, page alignment)
+ * - length == 0 - end of the image
+ * - TCMI_CKPT_STREAM_ABORT - the sender has failed, the image is invalid
+ *
+ * Lengths below -TCMI_CKPT_STREAM_MAX_HOLE are reserved for frames
+ * used by the \link tcmi_ckpt_dedup_class page deduplication
+ * \endlink:
+ * - TCMI_CKPT_STREAM_SESSION - followed by a 32bit ID of the \link
+ * tcmi_ckpt_pagecache_class page cache \endlink session the image
+ * refers to
+ * - TCMI_CKPT_STREAM_PAGE - followed by a page hash and a page of
+ * data, the receiver caches the page
+ * - TCMI_CKPT_STREAM_PAGE_REF - followed by a 32bit index of a page
+ * pinned by the session, the receiver takes the page from its cache
+ *
+ * The receiving side spools the frames into an unlinked in-memory
+ * (shmem) file at the very same offsets as a file based checkpoint
+ * would have. The resulting file can be thus restarted by the regular
+ * binfmt handler and its pages mapped directly without touching
+ * any network filesystem.
+ *
+ * @{
+ */
+
+/** Describes a single frame of the streamed image */
+struct tcmi_ckpt_stream_frame {
+	/** data length, hole size (negative) or end/abort marker */
+	int32_t length;
+} __attribute__((__packed__));
+
+/** Marks an aborted image transfer */
+#define TCMI_CKPT_STREAM_ABORT ((int32_t)0x80000000)
+/** Announces the page cache session */
+#define TCMI_CKPT_STREAM_SESSION ((int32_t)0x80000001)
+/** Page along with its hash */
+#define TCMI_CKPT_STREAM_PAGE ((int32_t)0x80000002)
+/** Reference to a page pinned by the session */
+#define TCMI_CKPT_STREAM_PAGE_REF ((int32_t)0x80000003)
+
+/** Largest hole that is announced by a single frame */
+#define TCMI_CKPT_STREAM_MAX_HOLE (1 << 30)
+
+/** \<\<public\>\> Announces the page cache session. */
+extern int tcmi_ckpt_stream_session(struct tcmi_ckpt *self, u_int32_t id);
+/** \<\<public\>\> Writes a page along with its hash. */
+extern int tcmi_ckpt_stream_page(struct tcmi_ckpt *self, struct tcmi_ckpt_page_hash *hash,
+				 void *data);
+/** \<\<public\>\> Writes a reference to a page pinned by the session. */
+extern int tcmi_ckpt_stream_page_ref(struct tcmi_ckpt *self, u_int32_t index);
+
+/** \<\<public\>\> Terminates the streamed image. */
+extern int tcmi_ckpt_stream_end(struct tcmi_ckpt *self, int aborted);
+
+/** \<\<public\>\> Streams an existing image file. */
+extern int tcmi_ckpt_stream_send_file(struct kkc_sock *sock, struct file *file);
+/** \<\<public\>\> Receives a streamed image into an in-memory file. */
+extern struct file* tcmi_ckpt_stream_recv(struct kkc_sock *sock, u_int64_t owner);
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CKPT_STREAM_PRIVATE
+
+/** Sends a single frame header. */
+static int tcmi_ckpt_stream_send_frame(struct kkc_sock *sock, int32_t length);
+
+/** Checks whether a buffer contains only zeros. */
+static int tcmi_ckpt_stream_zero(void *buf, int length);
+
+/** Receives a data frame into the spool file. */
+static int tcmi_ckpt_stream_recv_data(struct kkc_sock *sock, struct file *file,
+				      void *buf, int32_t length);
+
+/** Writes data into the spool file. */
+static int tcmi_ckpt_stream_spool(struct file *file, void *buf, int length);
+
+/** Receives a page along with its hash into the spool file. */
+static int tcmi_ckpt_stream_recv_page(struct kkc_sock *sock, struct file *file,
+				      void *buf, u_int64_t owner, struct shash_desc **desc);
+
+/** Receives a page reference and spools the referenced page. */
+static int tcmi_ckpt_stream_recv_page_ref(struct kkc_sock *sock, struct file *file,
+					  struct tcmi_ckpt_pagecache_session *session);
+
+#endif /* TCMI_CKPT_STREAM_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_STREAM_H */
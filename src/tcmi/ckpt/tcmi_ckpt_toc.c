@@ -0,0 +1,303 @@
+/**
+ * @file tcmi_ckpt_toc.c - table of contents of a version 2 checkpoint
+ *                         image
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/fs.h>
+#include <linux/slab.h>
+#include <linux/binfmts.h>
+
+#define TCMI_CKPT_TOC_PRIVATE
+#include "tcmi_ckpt_toc.h"
+
+#include "tcmi_ckpt.h"
+
+/**
+ * \<\<public\>\> Starts indexing of an image being written. The
+ * header section starts at the current position.
+ *
+ * @param *ckpt - checkpoint instance, its header is about to be written
+ * @return 0 upon success
+ */
+int tcmi_ckpt_toc_begin(struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_toc *self;
+
+	if (!(self = kzalloc(sizeof(*self), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate table of contents");
+		return -ENOMEM;
+	}
+	self->current = -1;
+	ckpt->toc = self;
+	tcmi_ckpt_toc_section(ckpt, TCMI_CKPT_SECTION_HDR);
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Starts a new section of the image being written at
+ * the current position. The previous section (if any) ends here.
+ *
+ * @param *ckpt - checkpoint instance
+ * @param type - section that follows
+ */
+void tcmi_ckpt_toc_section(struct tcmi_ckpt *ckpt, enum tcmi_ckpt_section_type type)
+{
+	struct tcmi_ckpt_toc *self = ckpt->toc;
+	struct tcmi_ckpt_section *section = &self->sections[type];
+
+	tcmi_ckpt_toc_close(ckpt);
+	section->type = type;
+	section->flags = TCMI_CKPT_SECTION_PRESENT;
+	if (type != TCMI_CKPT_SECTION_VMAS)
+		section->flags |= TCMI_CKPT_SECTION_CRC;
+	section->offset = tcmi_ckpt_pos(ckpt);
+	section->size = 0;
+	section->crc = 0;
+	self->current = type;
+}
+
+/**
+ * \<\<public\>\> Closes the last section and writes the table of
+ * contents. Only present sections are listed.
+ *
+ * @param *ckpt - checkpoint instance
+ * @return 0 upon success
+ */
+int tcmi_ckpt_toc_write(struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_toc *self = ckpt->toc;
+	struct tcmi_ckpt_toc_tail tail = {
+		.count = 0,
+		.crc = 0,
+		.magic = TCMI_CKPT_TOC_MAGIC,
+	};
+	int i;
+
+	tcmi_ckpt_toc_close(ckpt);
+	for (i = 0; i < TCMI_CKPT_SECTION_COUNT; i++) {
+		struct tcmi_ckpt_section *section = &self->sections[i];
+
+		if (!(section->flags & TCMI_CKPT_SECTION_PRESENT))
+			continue;
+		if (tcmi_ckpt_write(ckpt, section, sizeof(*section)) < 0)
+			goto exit0;
+		tail.crc = crc32_le(tail.crc, (void*)section, sizeof(*section));
+		tail.count++;
+	}
+	if (tcmi_ckpt_write(ckpt, &tail, sizeof(tail)) < 0)
+		goto exit0;
+	mdbg(INFO4, "Written table of contents with %u sections", tail.count);
+	return 0;
+
+	/* error handling */
+ exit0:
+	mdbg(ERR3, "Can't write table of contents");
+	return -EIO;
+}
+
+/**
+ * \<\<public\>\> Reads the table of contents from the end of the
+ * image and verifies checksums of all sections that carry one. The
+ * file position is not affected.
+ *
+ * @param *ckpt - checkpoint instance, its header has been read
+ * @return 0 upon success
+ */
+int tcmi_ckpt_toc_read(struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_toc *self;
+	struct tcmi_ckpt_toc_tail tail;
+	struct tcmi_ckpt_section *entries;
+	loff_t size, pos;
+	u_int32_t i;
+	int err = -EINVAL;
+
+	if (!(self = kzalloc(sizeof(*self), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate table of contents");
+		err = -ENOMEM;
+		goto exit0;
+	}
+	self->current = -1;
+
+	size = i_size_read(ckpt->file->f_dentry->d_inode);
+	if (size < (loff_t)sizeof(tail) ||
+	    tcmi_ckpt_toc_pread(ckpt, &tail, sizeof(tail), size - sizeof(tail)) < 0) {
+		mdbg(ERR3, "Can't read table of contents tail");
+		goto exit1;
+	}
+	if (tail.magic != TCMI_CKPT_TOC_MAGIC || tail.count > TCMI_CKPT_TOC_MAX_ENTRIES) {
+		mdbg(ERR3, "Invalid table of contents magic: %08x, entries: %u",
+		     tail.magic, tail.count);
+		goto exit1;
+	}
+	pos = size - sizeof(tail) - tail.count * sizeof(*entries);
+	if (pos < 0 || !(entries = kmalloc(tail.count * sizeof(*entries), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't load %u table of contents entries", tail.count);
+		goto exit1;
+	}
+	if (tcmi_ckpt_toc_pread(ckpt, entries, tail.count * sizeof(*entries), pos) < 0 ||
+	    crc32_le(0, (void*)entries, tail.count * sizeof(*entries)) != tail.crc) {
+		mdbg(ERR3, "Corrupted table of contents");
+		goto exit2;
+	}
+	/* sections must not overlap the table itself */
+	size = pos;
+	for (i = 0; i < tail.count; i++) {
+		struct tcmi_ckpt_section *section = &entries[i];
+
+		if (section->type >= TCMI_CKPT_SECTION_COUNT) {
+			mdbg(INFO3, "Skipping unknown section %u", section->type);
+			continue;
+		}
+		if (section->offset > size || section->size > size - section->offset) {
+			mdbg(ERR3, "Section %u out of image bounds", section->type);
+			err = -EINVAL;
+			goto exit2;
+		}
+		if ((err = tcmi_ckpt_toc_verify(ckpt, section)) < 0)
+			goto exit2;
+		self->sections[section->type] = *section;
+	}
+	kfree(entries);
+	ckpt->toc = self;
+	mdbg(INFO3, "Read table of contents with %u sections", tail.count);
+	return 0;
+
+	/* error handling */
+ exit2:
+	kfree(entries);
+ exit1:
+	kfree(self);
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<public\>\> Moves to the beginning of a section, so that it
+ * doesn't matter whether the previous section has been read
+ * completely. Version 1 images have no table of contents and are
+ * always read in order, the position is left untouched.
+ *
+ * @param *ckpt - checkpoint instance
+ * @param type - section to be read next
+ * @return 0 upon success
+ */
+int tcmi_ckpt_toc_seek(struct tcmi_ckpt *ckpt, enum tcmi_ckpt_section_type type)
+{
+	struct tcmi_ckpt_section *section;
+	loff_t res;
+
+	if (!ckpt->toc)
+		return 0;
+	section = &ckpt->toc->sections[type];
+	if (!(section->flags & TCMI_CKPT_SECTION_PRESENT)) {
+		mdbg(ERR3, "Section %d missing in the image", type);
+		return -ENOENT;
+	}
+	if ((res = tcmi_ckpt_seek(ckpt, section->offset, 0)) < 0)
+		return res;
+	return 0;
+}
+
+/** @addtogroup tcmi_ckpt_toc_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Closes the section being written, its size is
+ * given by the current position.
+ *
+ * @param *ckpt - checkpoint instance
+ */
+static void tcmi_ckpt_toc_close(struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_toc *self = ckpt->toc;
+	struct tcmi_ckpt_section *section;
+
+	if (self->current < 0)
+		return;
+	section = &self->sections[self->current];
+	section->size = tcmi_ckpt_pos(ckpt) - section->offset;
+	self->current = -1;
+}
+
+/**
+ * \<\<private\>\> Reads a range of the image without moving the
+ * file position.
+ *
+ * @param *ckpt - checkpoint instance
+ * @param *buf - destination buffer
+ * @param count - number of bytes to be read
+ * @param pos - offset in the image
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_toc_pread(struct tcmi_ckpt *ckpt, void *buf, int count, loff_t pos)
+{
+	return kernel_read(ckpt->file, pos, buf, count) == count ? 0 : -EIO;
+}
+
+/**
+ * \<\<private\>\> Verifies the checksum of a section. The section
+ * is read in page sized chunks.
+ *
+ * @param *ckpt - checkpoint instance
+ * @param *section - section to be verified
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_toc_verify(struct tcmi_ckpt *ckpt, struct tcmi_ckpt_section *section)
+{
+	void *buf;
+	loff_t pos = section->offset;
+	loff_t end = section->offset + section->size;
+	u32 crc = 0;
+	int err = 0;
+
+	if (!(section->flags & TCMI_CKPT_SECTION_CRC))
+		return 0;
+	if (!(buf = (void*)__get_free_page(GFP_KERNEL)))
+		return -ENOMEM;
+	while (pos < end) {
+		int count = min_t(loff_t, end - pos, PAGE_SIZE);
+
+		if ((err = tcmi_ckpt_toc_pread(ckpt, buf, count, pos)) < 0)
+			break;
+		crc = crc32_le(crc, buf, count);
+		pos += count;
+	}
+	free_page((unsigned long)buf);
+	if (!err && crc != section->crc) {
+		mdbg(ERR3, "Section %u checksum mismatch: %08x, expected: %08x",
+		     section->type, crc, section->crc);
+		err = -EINVAL;
+	}
+	return err;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,189 @@
+/**
+ * @file tcmi_ckpt_toc.h - table of contents of a version 2 checkpoint
+ *                         image
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_TOC_H
+#define _TCMI_CKPT_TOC_H
+
+#include <linux/types.h>
+#include <linux/slab.h>
+#include <linux/crc32.h>
+
+/** @defgroup tcmi_ckpt_toc_class tcmi_ckpt_toc class
+ *
+ * @ingroup tcmi_ckpt_class
+ *
+ * This is a helper class used by the \link tcmi_ckpt_class checkpoint
+ * \endlink to index a version 2 image. The sections of the image are
+ * the same as of version 1 and follow in the very same order:
+ * - header - checkpoint header and resource limits
+ * - files - open file table
+ * - mm - memory descriptor
+ * - vmas - memory areas including their pages (PPM only)
+ * - regs - processor registers, TLS and fs struct
+ * - signals - signal handlers and pending signals
+ * - npm params - arguments of the non-preemptive exec (NPM only)
+ *
+ * A version 2 image is identified by TCMI_CKPT_MAGIC_V2 in the
+ * header and ends with a table of contents that describes offset,
+ * size and CRC32 of each present section. Since a streamed image
+ * can't go back to patch its header, the table trails the image and
+ * is located by the image size:
+ *
+ * \verbatim
+ * | hdr | ... sections ... | section entries | tail |
+ * \endverbatim
+ *
+ * The tail carries the number of entries that precede it. Readers
+ * skip entries of unknown section types, so new sections can be
+ * added without bumping the version.
+ *
+ * Checksums are accumulated while the data is written. The pages of
+ * the vmas section are not checksummed, they may be written out of
+ * order by the \link tcmi_ckpt_pwrite_class parallel writer \endlink,
+ * sent as holes or references to deduplicated pages, and they are
+ * mapped lazily on restart anyway. The remaining sections are small
+ * and are verified before the restart touches the process.
+ *
+ * @{
+ */
+
+/** Sections of a checkpoint image */
+enum tcmi_ckpt_section_type {
+	TCMI_CKPT_SECTION_HDR,
+	TCMI_CKPT_SECTION_FILES,
+	TCMI_CKPT_SECTION_MM,
+	TCMI_CKPT_SECTION_VMAS,
+	TCMI_CKPT_SECTION_REGS,
+	TCMI_CKPT_SECTION_SIGS,
+	TCMI_CKPT_SECTION_NPM_PARAMS,
+	TCMI_CKPT_SECTION_COUNT
+};
+
+/** The section has been written into the image */
+#define TCMI_CKPT_SECTION_PRESENT 0x1
+/** The crc of the section is valid */
+#define TCMI_CKPT_SECTION_CRC     0x2
+
+/** Describes a single section of the image */
+struct tcmi_ckpt_section {
+	/** section type, see tcmi_ckpt_section_type */
+	u_int32_t type;
+	/** section flags */
+	u_int32_t flags;
+	/** offset of the section in the image */
+	u_int64_t offset;
+	/** size of the section in bytes */
+	u_int64_t size;
+	/** CRC32 of the section data (if TCMI_CKPT_SECTION_CRC is set) */
+	u_int32_t crc;
+} __attribute__((__packed__));
+
+/** Terminates the table of contents, the very last bytes of the image */
+struct tcmi_ckpt_toc_tail {
+	/** number of section entries preceding the tail */
+	u_int32_t count;
+	/** CRC32 of the section entries */
+	u_int32_t crc;
+	/** identifies the tail */
+	int32_t magic;
+} __attribute__((__packed__));
+
+/** a magic number of the table of contents tail */
+#define TCMI_CKPT_TOC_MAGIC 0x70c0beef
+
+/** Upper bound of entries accepted by the reader */
+#define TCMI_CKPT_TOC_MAX_ENTRIES 64
+
+/** Table of contents of a single image. */
+struct tcmi_ckpt_toc {
+	/** known sections indexed by their type */
+	struct tcmi_ckpt_section sections[TCMI_CKPT_SECTION_COUNT];
+	/** section being written, -1 if none */
+	int current;
+};
+
+struct tcmi_ckpt;
+
+/** \<\<public\>\> Starts indexing of an image being written. */
+extern int tcmi_ckpt_toc_begin(struct tcmi_ckpt *ckpt);
+/** \<\<public\>\> Starts a new section of the image being written. */
+extern void tcmi_ckpt_toc_section(struct tcmi_ckpt *ckpt, enum tcmi_ckpt_section_type type);
+/** \<\<public\>\> Writes the table of contents at the end of the image. */
+extern int tcmi_ckpt_toc_write(struct tcmi_ckpt *ckpt);
+/** \<\<public\>\> Reads and verifies the table of contents of an image. */
+extern int tcmi_ckpt_toc_read(struct tcmi_ckpt *ckpt);
+/** \<\<public\>\> Moves to the beginning of a section. */
+extern int tcmi_ckpt_toc_seek(struct tcmi_ckpt *ckpt, enum tcmi_ckpt_section_type type);
+
+/**
+ * \<\<public\>\> Accounts data written into the current section.
+ *
+ * @param *self - this table of contents
+ * @param *data - data being written
+ * @param count - number of bytes
+ */
+static inline void tcmi_ckpt_toc_update(struct tcmi_ckpt_toc *self, void *data, int count)
+{
+	struct tcmi_ckpt_section *section;
+
+	if (self->current < 0)
+		return;
+	section = &self->sections[self->current];
+	if (section->flags & TCMI_CKPT_SECTION_CRC)
+		section->crc = crc32_le(section->crc, data, count);
+}
+
+/**
+ * \<\<public\>\> Releases the table of contents.
+ *
+ * @param *self - this table of contents
+ */
+static inline void tcmi_ckpt_toc_free(struct tcmi_ckpt_toc *self)
+{
+	kfree(self);
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CKPT_TOC_PRIVATE
+
+/** Closes the section being written. */
+static void tcmi_ckpt_toc_close(struct tcmi_ckpt *ckpt);
+
+/** Reads a range of the image without moving the file position. */
+static int tcmi_ckpt_toc_pread(struct tcmi_ckpt *ckpt, void *buf, int count, loff_t pos);
+
+/** Verifies the checksum of a section. */
+static int tcmi_ckpt_toc_verify(struct tcmi_ckpt *ckpt, struct tcmi_ckpt_section *section);
+
+#endif /* TCMI_CKPT_TOC_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_TOC_H */
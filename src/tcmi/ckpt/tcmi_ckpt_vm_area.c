@@ -33,16 +33,24 @@
 #include <asm/highmem.h>
 #endif
 #include <asm/cacheflush.h>
+#include <linux/pagemap.h>
 
 #define TCMI_CKPT_VM_AREA_PRIVATE
 #include "tcmi_ckpt_vm_area.h"
+#include "tcmi_ckpt_zbatch.h"
+#include "tcmi_ckpt_pwrite.h"
 
 /**
  * \<\<public\>\> Writes a specified memory area into the checkpoint
  * file.  Checks for the requested type - when the light version is
  * required, it will do so only if the area is non-writable and maps a
  * file.  The actual work is then delegated to the light or heavy
- * version of this method.
+ * version of this method. Writable private file mappings are stored
+ * as a difference against the file when enabled by the checkpoint,
+ * regardless of the requested type. The heavy version is replaced by
+ * the compressed one when the checkpoint has compression enabled and
+ * the compression buffers are available, unless the area is large
+ * enough to be written by the parallel writer.
  *
  * @param *ckpt - checkpoint file where the area is to be stored
  * @param *vma - the actual VM area that is being processed
@@ -62,6 +70,12 @@ int tcmi_ckpt_vm_area_write(struct tcmi_ckpt *ckpt, struct vm_area_struct *vma,
 	if (type == TCMI_CKPT_VM_AREA_LIGHT && 
 	    !(vma->vm_flags & VM_WRITE) && vma->vm_file)
 		err = tcmi_ckpt_vm_area_write_l(ckpt, vma, &hdr);
+	else if (ckpt->diff && vma->vm_file && (vma->vm_flags & VM_WRITE) &&
+		 !(vma->vm_flags & VM_SHARED) && tcmi_ckpt_zbatch(ckpt))
+		err = tcmi_ckpt_vm_area_write_d(ckpt, vma, &hdr);
+	else if (ckpt->compress && !tcmi_ckpt_pwrite_wanted(ckpt, vma) &&
+		 tcmi_ckpt_zbatch(ckpt))
+		err = tcmi_ckpt_vm_area_write_z(ckpt, vma, &hdr);
 	else
 		err = tcmi_ckpt_vm_area_write_h(ckpt, vma, &hdr);
 	return err;
@@ -71,8 +85,8 @@ int tcmi_ckpt_vm_area_write(struct tcmi_ckpt *ckpt, struct vm_area_struct *vma,
 /**
  * \<\<public\>\> Reads a memory area from the checkpoint file. Reads
  * the VM area header and checks for the requested type. The actual
- * work is then delegated to the light or heavy version of this
- * method.
+ * work is then delegated to the light, heavy, compressed or
+ * differential version of this method.
  *
  * @param *ckpt - checkpoint file where the area is stored
  * @return 0 upon success.
@@ -93,6 +107,10 @@ int tcmi_ckpt_vm_area_read(struct tcmi_ckpt *ckpt)
 		err = tcmi_ckpt_vm_area_read_l(ckpt, &hdr);
 	else if (hdr.type == TCMI_CKPT_VM_AREA_HEAVY)
 		err = tcmi_ckpt_vm_area_read_h(ckpt, &hdr);
+	else if (hdr.type == TCMI_CKPT_VM_AREA_COMPRESSED)
+		err = tcmi_ckpt_vm_area_read_z(ckpt, &hdr);
+	else if (hdr.type == TCMI_CKPT_VM_AREA_DIFF)
+		err = tcmi_ckpt_vm_area_read_d(ckpt, &hdr);
 	else {
 		mdbg(ERR3, "Unrecognized header type %x", hdr.type);
 		goto exit0;
@@ -175,6 +193,10 @@ static int tcmi_ckpt_vm_area_write_l(struct tcmi_ckpt *ckpt,
  * otherwise we wouldn't be able to mmap pages from the file upon
  * restoring the checkpoint.
  *
+ * Large areas of file based checkpoints are handed over to the \link
+ * tcmi_ckpt_pwrite_class parallel writer \endlink, the range for the
+ * pages is just reserved in the image.
+ *
  * Following algorithm dumps the pages, the idea comes from a regular
  * core dump handler (e.g. in fs/binfmt_elf.c)
  *
@@ -211,6 +233,9 @@ static int tcmi_ckpt_vm_area_write_h(struct tcmi_ckpt *ckpt,
 	}
 	/* align the current file position to page size boundary */
 	tcmi_ckpt_page_align(ckpt);
+	/* large areas are only reserved, the pages are written by the workers */
+	if (tcmi_ckpt_pwrite_wanted(ckpt, vma))
+		return tcmi_ckpt_pwrite_area(ckpt, vma);
 	for (addr = vma->vm_start; addr < vma->vm_end; addr += PAGE_SIZE) {
 		struct page *page;
 		struct vm_area_struct *vma;
@@ -231,7 +256,7 @@ static int tcmi_ckpt_vm_area_write_h(struct tcmi_ckpt *ckpt,
 		flush_cache_page(vma, addr,  page_to_pfn(page));  /* TODO: check this fix is correct */
 		kaddr = tcmi_ckpt_vm_area_kmap(page);
 		/* write the page into the checkpoint */
-		if (tcmi_ckpt_write(ckpt, kaddr, PAGE_SIZE) < 0) {
+		if (tcmi_ckpt_write_page(ckpt, addr, kaddr) < 0) {
 			mdbg(ERR3, "Error writing page at %08lx", addr);
 			goto exit0;
 		}
@@ -244,7 +269,166 @@ static int tcmi_ckpt_vm_area_write_h(struct tcmi_ckpt *ckpt,
 	return -EINVAL;
 }
 
+/**
+ * \<\<private\>\> Writes a specified memory area into the checkpoint
+ * file - compressed version. It fills out the rest of the header and
+ * writes it into the checkpoint file followed by the pages. No page
+ * alignment is needed, the pages are never mapped from the checkpoint.
+ *
+ * @param *ckpt - checkpoint file where the area is to be stored
+ * @param *vma - the actual VM area that is being processed
+ * @param *hdr - partially filled VM area header
+ * @return 0 upon success.
+ */
+static int tcmi_ckpt_vm_area_write_z(struct tcmi_ckpt *ckpt, 
+				     struct vm_area_struct *vma, 
+				     struct tcmi_ckpt_vm_area_hdr *hdr)
+{
+	/* finish the header */
+	hdr->type = TCMI_CKPT_VM_AREA_COMPRESSED;
+	hdr->pathname_size = 0;
+	/* write the header into the checkpoint */
+	if (tcmi_ckpt_write(ckpt, hdr, sizeof(*hdr)) < 0) {
+		mdbg(ERR3, "Error writing VM area header chunk");
+		goto exit0;
+	}
+	return tcmi_ckpt_vm_area_write_pages(ckpt, vma, 0);
 
+	/* error handling */
+ exit0:
+	return -EINVAL;
+}
+
+/**
+ * \<\<private\>\> Writes a specified memory area into the checkpoint
+ * file - differential version. Used for private file mappings that
+ * are writable, e.g. data segments of binaries. Most of their pages
+ * typically still match the file, only the pages modified by the
+ * process have been replaced by anonymous copies (COW).
+ *
+ * The header and the pathname are stored the same way as in the light
+ * version, followed by the diverged pages only. Pages that still map
+ * the file (or have never been touched) are left out.
+ *
+ * @param *ckpt - checkpoint file where the area is to be stored
+ * @param *vma - the actual VM area that is being processed
+ * @param *hdr - partially filled VM area header
+ * @return 0 upon success.
+ */
+static int tcmi_ckpt_vm_area_write_d(struct tcmi_ckpt *ckpt, 
+				     struct vm_area_struct *vma, 
+				     struct tcmi_ckpt_vm_area_hdr *hdr)
+{
+	/* page for the filepathname */
+	unsigned long page;
+	char *pathname;
+
+	/* finish the header */
+	hdr->type = TCMI_CKPT_VM_AREA_DIFF;
+
+	/* resolve the path name. */
+	if (!(page = __get_free_page(GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate page for file pathname!");
+		goto exit0;
+	}
+	if (IS_ERR(pathname = d_path(&vma->vm_file->f_path, 
+				     (char*)page, PAGE_SIZE))) {
+		mdbg(ERR3, "Can't resolve pathname for '%s'", 
+		     vma->vm_file->f_dentry->d_name.name);
+		goto exit1;
+	}
+	hdr->pathname_size = strlen(pathname) + 1;
+	/* write the header and the pathname into the checkpoint */
+	if (tcmi_ckpt_write(ckpt, hdr, sizeof(*hdr)) < 0) {
+		mdbg(ERR3, "Error writing VM_area header chunk");
+		goto exit1;
+	}
+	if (tcmi_ckpt_write(ckpt, pathname, hdr->pathname_size) < 0) {
+		mdbg(ERR3, "Error writing pathname chunk");
+		goto exit1;
+	}
+	free_page(page);
+
+	return tcmi_ckpt_vm_area_write_pages(ckpt, vma, 1);
+
+	/* error handling */
+ exit1:
+	free_page(page);
+ exit0:
+	return -EINVAL;
+}
+
+/**
+ * \<\<private\>\> Writes pages of a memory area in the compressed
+ * format.
+ *
+ * Pages are gathered the same way as in the heavy version, but instead
+ * of being written one by one, they are copied into chunks of the
+ * compression batch. Whenever the batch is full, it is compressed by
+ * the worker pool and written out. Untouched pages are not stored at
+ * all, they are just left out from the chunk present bitmap. The
+ * pages are terminated by an empty batch.
+ *
+ * @param *ckpt - checkpoint file where the area is to be stored
+ * @param *vma - the actual VM area that is being processed
+ * @param diverged_only - store only pages that diverged from the
+ * mapped file
+ * @return 0 upon success.
+ */
+static int tcmi_ckpt_vm_area_write_pages(struct tcmi_ckpt *ckpt, 
+					 struct vm_area_struct *vma,
+					 int diverged_only)
+{
+	struct tcmi_ckpt_zbatch *batch = tcmi_ckpt_zbatch(ckpt);
+	struct tcmi_ckpt_zchunk *chunk = NULL;
+	unsigned long addr, chunk_start;
+	int idx, count = 0;
+
+	for (addr = vma->vm_start; addr < vma->vm_end; addr += PAGE_SIZE) {
+		struct page *page;
+		struct vm_area_struct *page_vma;
+		void *kaddr;
+
+		idx = ((addr - vma->vm_start) >> PAGE_SHIFT) % TCMI_CKPT_ZCHUNK_PAGES;
+		if (idx == 0)
+			chunk = NULL;
+		if (diverged_only && !tcmi_ckpt_vm_area_page_diverged(vma, addr))
+			continue;
+		if (get_user_pages(current, current->mm, addr, 1, 0, 1,
+				   &page, &page_vma) <= 0) {
+			mdbg(INFO4, "Skipping untouched page at %08lx", addr);
+			continue;
+		}
+		chunk_start = addr - idx * PAGE_SIZE;
+		if (!chunk && !(chunk = tcmi_ckpt_zbatch_add(batch, chunk_start))) {
+			/* batch is full, flush it and start over */
+			if (tcmi_ckpt_zbatch_write(batch, ckpt) < 0) {
+				mdbg(ERR3, "Error writing pages of %08lx", vma->vm_start);
+				page_cache_release(page);
+				goto exit0;
+			}
+			chunk = tcmi_ckpt_zbatch_add(batch, chunk_start);
+		}
+		flush_cache_page(page_vma, addr, page_to_pfn(page));
+		kaddr = tcmi_ckpt_vm_area_kmap(page);
+		tcmi_ckpt_zchunk_add_page(chunk, idx, kaddr);
+		tcmi_ckpt_vm_area_kunmap(page);
+		page_cache_release(page);
+		count++;
+	}
+	if (tcmi_ckpt_zbatch_write(batch, ckpt) < 0 || 
+	    tcmi_ckpt_zbatch_write_end(ckpt) < 0) {
+		mdbg(ERR3, "Error writing pages of %08lx", vma->vm_start);
+		goto exit0;
+	}
+	mdbg(INFO4, "Stored %d pages of %08lx (diverged only: %d)", 
+	     count, vma->vm_start, diverged_only);
+	return 0;
+
+	/* error handling */
+ exit0:
+	return -EINVAL;
+}
 
 /** 
  * \<\<private\>\> Reads a memory area from the checkpoint file -
@@ -252,6 +436,9 @@ static int tcmi_ckpt_vm_area_write_h(struct tcmi_ckpt *ckpt,
  * into the area.
  * - opens the file 
  * - performs the memory mapping, 
+ * - populates the beginning of the mapping when the checkpoint header
+ * requests it, each fault would be a round trip to the file server
+ * otherwise (see tcmi_ckpt_vm_area_populate()),
  * - releases the file - the memory mapping retains its own reference.
  *
  * @param *ckpt - checkpoint file where the area is to be stored
@@ -268,6 +455,7 @@ static int tcmi_ckpt_vm_area_read_l(struct tcmi_ckpt *ckpt,
 	struct file *file; /* file object for the vm_file */
 	unsigned long mmap_flags;
 	unsigned long addr;
+	loff_t pos, size;
 
 	/* finish the header */
 	hdr->type = TCMI_CKPT_VM_AREA_LIGHT;
@@ -300,6 +488,16 @@ static int tcmi_ckpt_vm_area_read_l(struct tcmi_ckpt *ckpt,
 		mdbg(ERR3, "Error mapping file '%s' at: %lx", pathname, addr);
 		goto exit2;
 	}
+	/* pages past the end of the file can't be populated */
+	pos = (loff_t)hdr->vm_pgoff << PAGE_SHIFT;
+	size = PAGE_ALIGN(i_size_read(file->f_path.dentry->d_inode));
+	if (ckpt->hdr.readahead > 0 && size > pos) {
+		size = min_t(loff_t, size - pos, hdr->vm_end - addr);
+		tcmi_ckpt_vm_area_populate(file, addr,
+					   min_t(unsigned long, size,
+						 (unsigned long)ckpt->hdr.readahead << PAGE_SHIFT),
+					   pos);
+	}
 
 	/* or shall we perform filp_close??? */
 	fput(file);
@@ -328,7 +526,8 @@ static int tcmi_ckpt_vm_area_read_l(struct tcmi_ckpt *ckpt,
  * There is special case that needs to be handled - if the area
  * grows down which indicates a stack region stack setup
  * work is delegated to tcmi_ckpt_vm_area_stack_fixup().
- *
+ * - populates the beginning of the area when the checkpoint header
+ * requests it (see tcmi_ckpt_vm_area_populate()).
  *
  * @param *ckpt - checkpoint file where the area is to be stored
  * @param *hdr - VM area header
@@ -340,6 +539,7 @@ static int tcmi_ckpt_vm_area_read_h(struct tcmi_ckpt *ckpt,
 	unsigned long mmap_flags;
 	unsigned long addr;
 	unsigned long length;
+	loff_t pos;
 
 	tcmi_ckpt_page_align(ckpt);
 
@@ -367,6 +567,8 @@ static int tcmi_ckpt_vm_area_read_h(struct tcmi_ckpt *ckpt,
 
 	/* convert the VM flags to MMAP flags */
 	mmap_flags = tcmi_ckpt_vm_area_to_mmap_flags(hdr->vm_flags);
+	/* the mapping advances the position, remember where the area starts */
+	pos = ckpt->file->f_pos;
 	/* prot flags are just the lower bits extracted from vm_flags - see mman.h, mm.h */
 	addr = tcmi_ckpt_do_mmap(ckpt, hdr->vm_start, hdr->vm_end - hdr->vm_start,
 				 hdr->vm_flags & (PROT_READ | PROT_EXEC| PROT_WRITE),	
@@ -377,6 +579,11 @@ static int tcmi_ckpt_vm_area_read_h(struct tcmi_ckpt *ckpt,
 	}
 	mdbg(INFO4, "Mapped checkpoint at: %08lx, VM_flags = %16llx, mmap flags = %08lx", 
 	     addr, (unsigned long long)hdr->vm_flags, mmap_flags);
+	if (ckpt->hdr.readahead > 0)
+		tcmi_ckpt_vm_area_populate(ckpt->file, addr,
+					   min_t(unsigned long, hdr->vm_end - addr,
+						 (unsigned long)ckpt->hdr.readahead << PAGE_SHIFT),
+					   pos);
 	return 0;
 
 	/* error handling */
@@ -384,6 +591,214 @@ static int tcmi_ckpt_vm_area_read_h(struct tcmi_ckpt *ckpt,
 	return -EINVAL;
 }
 
+/** 
+ * \<\<private\>\> Reads a memory area from the checkpoint file -
+ * compressed version.
+ * - creates an anonymous mapping covering the whole area, including
+ * the VM_GROWSDOWN flag - no stack fixup is needed
+ * - restores the stored pages into the mapping, untouched pages are
+ * left unpopulated
+ *
+ * @param *ckpt - checkpoint file where the area is to be stored
+ * @param *hdr - VM area header
+ * @return 0 upon success.
+ */
+static int tcmi_ckpt_vm_area_read_z(struct tcmi_ckpt *ckpt, 
+				    struct tcmi_ckpt_vm_area_hdr *hdr)
+{
+	unsigned long mmap_flags;
+	unsigned long addr;
+
+	/* convert the VM flags to MMAP flags */
+	mmap_flags = tcmi_ckpt_vm_area_to_mmap_flags(hdr->vm_flags);
+	/* prot flags are just the lower bits extracted from vm_flags - see mman.h, mm.h */
+	down_write(&current->mm->mmap_sem);
+	addr = do_mmap(NULL, hdr->vm_start, hdr->vm_end - hdr->vm_start,
+		       hdr->vm_flags & (PROT_READ | PROT_EXEC| PROT_WRITE),	
+		       mmap_flags, 0);
+	up_write(&current->mm->mmap_sem);
+	if (addr != hdr->vm_start) {
+		mdbg(ERR3, "Error creating an anonymous mapping at: %08lx (hdr->vm_start: %16llx", 
+		     addr, (unsigned long long)hdr->vm_start);
+		goto exit0;
+	}
+	if (tcmi_ckpt_vm_area_read_pages(ckpt, hdr) < 0)
+		goto exit0;
+
+	mdbg(INFO4, "Restored compressed area at: %16llx, VM_flags = %16llx, mmap flags = %08lx", 
+	     (unsigned long long)hdr->vm_start, (unsigned long long)hdr->vm_flags, mmap_flags);
+	return 0;
+
+	/* error handling */
+ exit0:
+	return -EINVAL;
+}
+
+/** 
+ * \<\<private\>\> Reads a memory area from the checkpoint file -
+ * differential version.
+ * - maps the file the same way as the light version does
+ * - overlays the mapping with the pages stored in the checkpoint,
+ * these become private (COW) copies again
+ *
+ * Pages that are not stored in the checkpoint are read from the file
+ * upon first access. If the file has been modified in the meantime,
+ * the process sees the modification - the very same applies to
+ * private file mappings that haven't been migrated.
+ *
+ * @param *ckpt - checkpoint file where the area is to be stored
+ * @param *hdr - VM area header
+ * @return 0 upon success.
+ */
+static int tcmi_ckpt_vm_area_read_d(struct tcmi_ckpt *ckpt, 
+				    struct tcmi_ckpt_vm_area_hdr *hdr)
+{
+	/* page for the filepathname */
+	unsigned long page;
+	char *pathname = NULL;
+	struct file *file; /* file object for the vm_file */
+	unsigned long mmap_flags;
+	unsigned long addr;
+
+	if (!(page = __get_free_page(GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate page for file pathname!");
+		goto exit0;
+	}
+	pathname = (char*) page;
+	if (hdr->pathname_size > PAGE_SIZE ||
+	    tcmi_ckpt_read(ckpt, pathname, hdr->pathname_size) < 0) {
+		mdbg(ERR3, "Error reading pathname");
+		goto exit1;
+	}
+	pathname[PAGE_SIZE - 1] = '\0';
+	/* convert the VM flags to MMAP flags */
+	mmap_flags = tcmi_ckpt_vm_area_to_mmap_flags(hdr->vm_flags);
+
+	file = filp_open(pathname, O_RDONLY, 0); 
+	if (IS_ERR(file)) {
+		mdbg(ERR3, "Error opening file '%s'", pathname);
+		goto exit1;
+	}
+	/* prot flags are just the lower bits extracted from vm_flags - see mman.h, mm.h */
+	down_write(&current->mm->mmap_sem);
+	addr = do_mmap_pgoff(file, hdr->vm_start, hdr->vm_end - hdr->vm_start,
+			     hdr->vm_flags & (PROT_READ | PROT_EXEC| PROT_WRITE),	
+			     mmap_flags, hdr->vm_pgoff);
+	up_write(&current->mm->mmap_sem);
+	if (addr != hdr->vm_start) {
+		mdbg(ERR3, "Error mapping file '%s' at: %lx", pathname, addr);
+		goto exit2;
+	}
+	fput(file);
+
+	if (tcmi_ckpt_vm_area_read_pages(ckpt, hdr) < 0) {
+		mdbg(ERR3, "Error restoring diverged pages of '%s'", pathname);
+		goto exit1;
+	}
+	free_page(page);
+
+	mdbg(INFO4, "Mapped differential area at: 08%lx, VM_flags = %08llx, mmap flags = %08lx", 
+	     addr, (unsigned long long)hdr->vm_flags, mmap_flags);
+	return 0;
+
+	/* error handling */
+ exit2:
+	fput(file);
+ exit1:
+	free_page(page);
+ exit0:
+	return -EINVAL;
+}
+
+/** 
+ * \<\<private\>\> Restores pages stored in the compressed format
+ * into an already mapped area. The batches are decompressed in
+ * parallel, the present pages of each chunk are then copied into the
+ * area.
+ *
+ * @param *ckpt - checkpoint file where the area is to be stored
+ * @param *hdr - VM area header
+ * @return 0 upon success.
+ */
+static int tcmi_ckpt_vm_area_read_pages(struct tcmi_ckpt *ckpt, 
+					struct tcmi_ckpt_vm_area_hdr *hdr)
+{
+	struct tcmi_ckpt_zbatch *batch;
+	struct tcmi_ckpt_zchunk *chunk;
+	unsigned long addr;
+	int count, i, idx, n;
+
+	if (!(batch = tcmi_ckpt_zbatch(ckpt))) {
+		mdbg(ERR3, "Can't allocate decompression buffers");
+		goto exit0;
+	}
+	while ((count = tcmi_ckpt_zbatch_read(batch, ckpt)) > 0) {
+		for (i = 0; i < count; i++) {
+			chunk = &batch->chunks[i];
+			for (idx = 0, n = 0; idx < TCMI_CKPT_ZCHUNK_PAGES; idx++) {
+				if (!(chunk->hdr.present & (1 << idx)))
+					continue;
+				addr = chunk->hdr.start + idx * PAGE_SIZE;
+				if (addr < hdr->vm_start || addr >= hdr->vm_end) {
+					mdbg(ERR3, "Stored page at %08lx out of area", addr);
+					goto exit0;
+				}
+				if (tcmi_ckpt_vm_area_copy_page(addr, (unsigned long)chunk->raw + 
+								n++ * PAGE_SIZE) < 0) {
+					mdbg(ERR3, "Failed to copy page to %08lx", addr);
+					goto exit0;
+				}
+			}
+		}
+	}
+	if (count < 0) {
+		mdbg(ERR3, "Error reading pages of %16llx", 
+		     (unsigned long long)hdr->vm_start);
+		goto exit0;
+	}
+	return 0;
+
+	/* error handling */
+ exit0:
+	return -EINVAL;
+}
+
+/**
+ * \<\<private\>\> Populates a part of an area that has just been
+ * mapped from a file - the checkpoint file or the file of a light
+ * area, so that the restarted process doesn't take a page fault (and
+ * a round trip to the file server) for each page. Reads are first
+ * issued in chunks of the readahead window of the file, then all
+ * pages are faulted in at once.  Files without readpage support
+ * (in-memory images of streamed checkpoints) are just populated.
+ * Failures are not fatal, the remaining pages are faulted in on
+ * demand.
+ *
+ * @param *file - file the area has been mapped from
+ * @param addr - start of the range to be populated
+ * @param len - length of the range
+ * @param pos - offset of the range in the file
+ */
+static void tcmi_ckpt_vm_area_populate(struct file *file, unsigned long addr,
+				       unsigned long len, loff_t pos)
+{
+	struct address_space *mapping = file->f_mapping;
+	pgoff_t index = pos >> PAGE_SHIFT;
+	pgoff_t end = index + (len >> PAGE_SHIFT);
+	unsigned long chunk = max_t(unsigned long, file->f_ra.ra_pages, 1);
+	int count;
+
+	if (mapping->a_ops->readpage) {
+		for (; index < end; index += chunk)
+			page_cache_sync_readahead(mapping, &file->f_ra, file, index,
+						  min_t(unsigned long, chunk, end - index));
+	}
+	down_read(&current->mm->mmap_sem);
+	count = get_user_pages(current, current->mm, addr, len >> PAGE_SHIFT,
+			       0, 0, NULL, NULL);
+	up_read(&current->mm->mmap_sem);
+	mdbg(INFO4, "Populated %d of %lu pages at %08lx", count, len >> PAGE_SHIFT, addr);
+}
 
 /**
  * \<\<private\>\> This method is responsible for fixing a the stack
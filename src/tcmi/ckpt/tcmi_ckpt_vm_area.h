@@ -34,6 +34,7 @@
 #include <linux/mm.h>
 #include <linux/mman.h>
 #include <linux/hardirq.h>
+#include <linux/highmem.h>
 
 #include "tcmi_ckpt.h"
 
@@ -53,6 +54,16 @@
  * size dramatically. Also, when restoring such checkpoint parts,
  * there is a big chance that the file is already mapped in memory.
  * This typically happens with shared libraries and executable code.
+ * - compressed checkpoint mode - a variant of the heavy mode used
+ * when the checkpoint has compression enabled. Pages are compressed
+ * in chunks by the \link tcmi_ckpt_zbatch_class compression batch
+ * \endlink and restored into an anonymous mapping, as the image
+ * can't be mapped directly.
+ * - differential checkpoint mode - used for writable private file
+ * mappings (e.g. data segments). The pathname is stored as in the
+ * light mode, followed only by the pages that have diverged from the
+ * file (anonymous COW copies). Upon restart, the file is mapped and
+ * the stored pages are copied over it.
  *
  * @{
  */
@@ -60,7 +71,9 @@
 /** Describes the type of the vm area we store, see above. */
 typedef enum {
 	TCMI_CKPT_VM_AREA_LIGHT,
-	TCMI_CKPT_VM_AREA_HEAVY
+	TCMI_CKPT_VM_AREA_HEAVY,
+	TCMI_CKPT_VM_AREA_COMPRESSED,
+	TCMI_CKPT_VM_AREA_DIFF
 } tcmi_ckpt_vm_area_t;
 
 /** Compound structure describes a particular memory region. Very
@@ -78,7 +91,7 @@ struct tcmi_ckpt_vm_area_hdr {
 	/** type of the area */
 	tcmi_ckpt_vm_area_t type;
 	/** pathname size in bytes, including trailing zero - for
-	 * light version only */
+	 * light and differential version only */
 	u_int32_t pathname_size;
 }  __attribute__((__packed__));
 
@@ -91,6 +104,91 @@ extern int tcmi_ckpt_vm_area_write(struct tcmi_ckpt *ckpt,
 /**\<\<public\>\>  Reads a memory area from the checkpoint file. */
 extern int tcmi_ckpt_vm_area_read(struct tcmi_ckpt *ckpt);
 
+/**
+ * \<\<public\>\> This is really stupid, but linux kernel doesn't
+ * export kmap/kunmap, so we had to duplicate the highmemory check..
+ *
+ * @param *page - page that is to be mapped into the linear address space
+ * @return linear address of the page
+ */
+static inline void* tcmi_ckpt_vm_area_kmap(struct page *page)
+{
+        might_sleep();
+
+	#if defined(__i386__)
+		if (!PageHighMem(page))
+			return page_address(page);
+		return kmap_high(page);
+	#else
+		return page_address(page);
+	#endif
+}
+
+
+/**
+ * \<\<public\>\> Same problem is before..  We had to duplicate the
+ * highmemory check..
+ *
+ * @param *page - page that is to be unmapped
+ */
+static inline void tcmi_ckpt_vm_area_kunmap(struct page *page)
+{
+	if (in_interrupt())
+                BUG();
+
+	#if defined(__i386__)
+		if (!PageHighMem(page))
+			return;
+		kunmap_high(page);
+	#endif
+}
+
+/**
+ * \<\<public\>\> Checks whether a page of a private file mapping
+ * has diverged from the file. This is the case when the page table
+ * entry maps an anonymous page (COW copy) or the page has been
+ * swapped out - only anonymous pages are swapped. Page cache pages
+ * and entries not populated at all still match the file.
+ *
+ * The page tables are walked directly, so that the pages still
+ * matching the file are not faulted in.
+ *
+ * @param *vma - private file mapping the page belongs to
+ * @param addr - address of the page
+ * @return 1 when the page has diverged
+ */
+static inline int tcmi_ckpt_vm_area_page_diverged(struct vm_area_struct *vma,
+						  unsigned long addr)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *ptep, pte;
+	spinlock_t *ptl;
+	int diverged;
+
+	pgd = pgd_offset(mm, addr);
+	if (pgd_none(*pgd) || unlikely(pgd_bad(*pgd)))
+		return 0;
+	pud = pud_offset(pgd, addr);
+	if (pud_none(*pud) || unlikely(pud_bad(*pud)))
+		return 0;
+	pmd = pmd_offset(pud, addr);
+	if (pmd_none(*pmd) || unlikely(pmd_bad(*pmd)))
+		return 0;
+
+	ptep = pte_offset_map_lock(mm, pmd, addr, &ptl);
+	pte = *ptep;
+	if (pte_present(pte))
+		diverged = PageAnon(pte_page(pte));
+	else
+		diverged = !pte_none(pte) && !pte_file(pte);
+	pte_unmap_unlock(ptep, ptl);
+
+	return diverged;
+}
+
 /********************** PRIVATE METHODS AND DATA ******************************/
 #ifdef TCMI_CKPT_VM_AREA_PRIVATE
 
@@ -102,6 +200,18 @@ static int tcmi_ckpt_vm_area_read_l(struct tcmi_ckpt *ckpt,
 static int tcmi_ckpt_vm_area_read_h(struct tcmi_ckpt *ckpt, 
 				    struct tcmi_ckpt_vm_area_hdr *hdr);
 
+/** Reads a memory area from the checkpoint file - compressed version. */
+static int tcmi_ckpt_vm_area_read_z(struct tcmi_ckpt *ckpt, 
+				    struct tcmi_ckpt_vm_area_hdr *hdr);
+
+/** Reads a memory area from the checkpoint file - differential version. */
+static int tcmi_ckpt_vm_area_read_d(struct tcmi_ckpt *ckpt, 
+				    struct tcmi_ckpt_vm_area_hdr *hdr);
+
+/** Restores pages stored in the compressed format into a mapped area. */
+static int tcmi_ckpt_vm_area_read_pages(struct tcmi_ckpt *ckpt, 
+					struct tcmi_ckpt_vm_area_hdr *hdr);
+
 /** Writes a specified memory area into the checkpoint file - light
  * version. */
 static int tcmi_ckpt_vm_area_write_l(struct tcmi_ckpt *ckpt, 
@@ -114,6 +224,23 @@ static int tcmi_ckpt_vm_area_write_h(struct tcmi_ckpt *ckpt,
 				     struct vm_area_struct *vma, 
 				     struct tcmi_ckpt_vm_area_hdr *hdr);
 
+/** Writes a specified memory area into the checkpoint file -
+ * compressed version. */
+static int tcmi_ckpt_vm_area_write_z(struct tcmi_ckpt *ckpt, 
+				     struct vm_area_struct *vma, 
+				     struct tcmi_ckpt_vm_area_hdr *hdr);
+
+/** Writes a specified memory area into the checkpoint file -
+ * differential version. */
+static int tcmi_ckpt_vm_area_write_d(struct tcmi_ckpt *ckpt, 
+				     struct vm_area_struct *vma, 
+				     struct tcmi_ckpt_vm_area_hdr *hdr);
+
+/** Writes pages of a memory area in the compressed format. */
+static int tcmi_ckpt_vm_area_write_pages(struct tcmi_ckpt *ckpt, 
+					 struct vm_area_struct *vma,
+					 int diverged_only);
+
 /** 
  * \<\private\>\> Converts the VM area flags to mmap flags.
  *
@@ -142,45 +269,6 @@ static inline unsigned long tcmi_ckpt_vm_area_to_mmap_flags(unsigned long vm_fla
 }
 
 
-/**
- * \<\private\>\> This is really stupid, but linux kernel doesn't
- * export kmap/kunmap, so we had to duplicate the highmemory check..
- *
- * @param *page - page that is to be mapped into the linear address space
- * @return linear address of the page
- */
-static inline void* tcmi_ckpt_vm_area_kmap(struct page *page)
-{
-        might_sleep();
-
-	#if defined(__i386__)
-		if (!PageHighMem(page))
-			return page_address(page);
-		return kmap_high(page);
-	#else
-		return page_address(page);
-	#endif
-}
-
-
-/**
- * \<\private\>\> Same problem is before..  We had to duplicate the
- * highmemory check..
- *
- * @param *page - page that is to be unmapped
- */
-static inline void tcmi_ckpt_vm_area_kunmap(struct page *page)
-{
-	if (in_interrupt())
-                BUG();
-
-	#if defined(__i386__)
-		if (!PageHighMem(page))
-			return;
-		kunmap_high(page);
-	#endif
-}
-
 /**
  * \<\<private\>\> Helper method that provides a safe mechanism of
  * copying a page from kernel into the address space of a process that
@@ -259,6 +347,7 @@ static inline int tcmi_ckpt_vm_area_copy_page(unsigned long dst_addr, unsigned l
 	kaddr = tcmi_ckpt_vm_area_kmap(dst_page);
 	memcpy(kaddr, (void*)src_addr, PAGE_SIZE);
 	tcmi_ckpt_vm_area_kunmap(dst_page);
+	page_cache_release(dst_page);
 	return 0;
 	
 	/* error handling */
@@ -271,6 +360,10 @@ static inline int tcmi_ckpt_vm_area_copy_page(unsigned long dst_addr, unsigned l
 static int tcmi_ckpt_vm_area_stack_fixup(struct tcmi_ckpt *ckpt, 
 					 struct tcmi_ckpt_vm_area_hdr *hdr);
 
+/** Populates a part of an area mapped from a file. */
+static void tcmi_ckpt_vm_area_populate(struct file *file, unsigned long addr,
+				       unsigned long len, loff_t pos);
+
 #endif /* TCMI_CKPT_VM_AREA_PRIVATE */
 
 /**
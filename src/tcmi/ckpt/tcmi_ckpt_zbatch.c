@@ -0,0 +1,323 @@
+/**
+ * @file tcmi_ckpt_zbatch.c - a helper class that (de)compresses batches
+ *                            of process pages
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/vmalloc.h>
+
+#define TCMI_CKPT_ZBATCH_PRIVATE
+#include "tcmi_ckpt_zbatch.h"
+
+/**
+ * \<\<public\>\> Batch constructor. Buffers of all chunks are
+ * allocated at once as a single virtually contiguous area.
+ *
+ * @return new batch or NULL
+ */
+struct tcmi_ckpt_zbatch* tcmi_ckpt_zbatch_new(void)
+{
+	struct tcmi_ckpt_zbatch *batch;
+	void *mem;
+	int i;
+
+	if (!(batch = kmalloc(sizeof(*batch), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate memory for compression batch");
+		goto exit0;
+	}
+	batch->mem = vmalloc(TCMI_CKPT_ZBATCH_CHUNKS * (TCMI_CKPT_ZCHUNK_SIZE + 
+							TCMI_CKPT_ZCHUNK_ZSIZE +
+							LZO1X_1_MEM_COMPRESS));
+	if (!batch->mem) {
+		mdbg(ERR3, "Can't allocate compression buffers");
+		goto exit1;
+	}
+	for (i = 0, mem = batch->mem; i < TCMI_CKPT_ZBATCH_CHUNKS; i++) {
+		batch->chunks[i].raw = mem;
+		mem += TCMI_CKPT_ZCHUNK_SIZE;
+		batch->chunks[i].z = mem;
+		mem += TCMI_CKPT_ZCHUNK_ZSIZE;
+		batch->chunks[i].wrkmem = mem;
+		mem += LZO1X_1_MEM_COMPRESS;
+	}
+	batch->count = 0;
+	return batch;
+
+	/* error handling */
+ exit1:
+	kfree(batch);
+ exit0:
+	return NULL;
+}
+
+/**
+ * \<\<public\>\> Releases the batch.
+ *
+ * @param *self - this batch
+ */
+void tcmi_ckpt_zbatch_free(struct tcmi_ckpt_zbatch *self)
+{
+	if (!self)
+		return;
+	vfree(self->mem);
+	kfree(self);
+}
+
+/**
+ * \<\<public\>\> Compresses all chunks of the batch in parallel and
+ * writes the batch into the checkpoint. When the checkpoint has
+ * compression disabled, all chunks are stored raw. The batch is empty
+ * afterwards.
+ *
+ * @param *self - this batch
+ * @param *ckpt - checkpoint the batch is written into
+ * @return 0 upon success
+ */
+int tcmi_ckpt_zbatch_write(struct tcmi_ckpt_zbatch *self, struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_zchunk *chunk;
+	int32_t count = self->count;
+	int i;
+
+	if (!count)
+		return 0;
+
+	tcmi_ckpt_pool_begin(&self->jobs);
+	for (i = 0; i < count; i++) {
+		chunk = &self->chunks[i];
+		if (ckpt->compress)
+			tcmi_ckpt_pool_submit(&self->jobs, &chunk->job,
+					      tcmi_ckpt_zbatch_compress);
+		else {
+			chunk->hdr.flags |= TCMI_CKPT_ZCHUNK_RAW;
+			chunk->hdr.length = tcmi_ckpt_zchunk_pages(chunk) * PAGE_SIZE;
+		}
+	}
+	if (tcmi_ckpt_pool_wait(&self->jobs) < 0) {
+		mdbg(ERR3, "Error compressing chunks");
+		goto exit0;
+	}
+
+	if (tcmi_ckpt_write(ckpt, &count, sizeof(count)) < 0) {
+		mdbg(ERR3, "Error writing chunk count");
+		goto exit0;
+	}
+	for (i = 0; i < count; i++) {
+		if (tcmi_ckpt_write(ckpt, &self->chunks[i].hdr, 
+				    sizeof(struct tcmi_ckpt_zchunk_hdr)) < 0) {
+			mdbg(ERR3, "Error writing chunk index");
+			goto exit0;
+		}
+	}
+	for (i = 0; i < count; i++) {
+		chunk = &self->chunks[i];
+		if (ckpt->dedup && (chunk->hdr.flags & TCMI_CKPT_ZCHUNK_RAW)) {
+			if (tcmi_ckpt_zbatch_write_pages(chunk, ckpt) < 0)
+				goto exit0;
+			continue;
+		}
+		if (tcmi_ckpt_write(ckpt, (chunk->hdr.flags & TCMI_CKPT_ZCHUNK_RAW) ? 
+				    chunk->raw : chunk->z, chunk->hdr.length) < 0) {
+			mdbg(ERR3, "Error writing chunk at %08llx", 
+			     (unsigned long long)chunk->hdr.start);
+			goto exit0;
+		}
+	}
+	self->count = 0;
+	return 0;
+
+	/* error handling */
+ exit0:
+	self->count = 0;
+	return -EINVAL;
+}
+
+/**
+ * \<\<public\>\> Terminates the compressed area by an empty batch.
+ *
+ * @param *ckpt - checkpoint the area is written into
+ * @return 0 upon success
+ */
+int tcmi_ckpt_zbatch_write_end(struct tcmi_ckpt *ckpt)
+{
+	int32_t count = 0;
+	return tcmi_ckpt_write(ckpt, &count, sizeof(count));
+}
+
+/**
+ * \<\<public\>\> Reads a batch from the checkpoint and decompresses
+ * its chunks in parallel. The index is validated, so that corrupted
+ * image can't overflow the chunk buffers.
+ *
+ * @param *self - this batch
+ * @param *ckpt - checkpoint the batch is read from
+ * @return number of chunks read (0 at the end of the area) or error (< 0)
+ */
+int tcmi_ckpt_zbatch_read(struct tcmi_ckpt_zbatch *self, struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_zchunk *chunk;
+	int32_t count;
+	u_int32_t raw_len;
+	int i;
+
+	self->count = 0;
+	if (tcmi_ckpt_read(ckpt, &count, sizeof(count)) < 0) {
+		mdbg(ERR3, "Error reading chunk count");
+		goto exit0;
+	}
+	if (count < 0 || count > TCMI_CKPT_ZBATCH_CHUNKS) {
+		mdbg(ERR3, "Invalid chunk count %d", count);
+		goto exit0;
+	}
+	for (i = 0; i < count; i++) {
+		chunk = &self->chunks[i];
+		if (tcmi_ckpt_read(ckpt, &chunk->hdr, sizeof(chunk->hdr)) < 0) {
+			mdbg(ERR3, "Error reading chunk index");
+			goto exit0;
+		}
+		raw_len = tcmi_ckpt_zchunk_pages(chunk) * PAGE_SIZE;
+		if ((chunk->hdr.flags & TCMI_CKPT_ZCHUNK_RAW) ? 
+		    chunk->hdr.length != raw_len : 
+		    chunk->hdr.length > TCMI_CKPT_ZCHUNK_ZSIZE) {
+			mdbg(ERR3, "Invalid chunk length %u", chunk->hdr.length);
+			goto exit0;
+		}
+	}
+	for (i = 0; i < count; i++) {
+		chunk = &self->chunks[i];
+		if (tcmi_ckpt_read(ckpt, (chunk->hdr.flags & TCMI_CKPT_ZCHUNK_RAW) ? 
+				   chunk->raw : chunk->z, chunk->hdr.length) < 0) {
+			mdbg(ERR3, "Error reading chunk at %08llx", 
+			     (unsigned long long)chunk->hdr.start);
+			goto exit0;
+		}
+	}
+
+	tcmi_ckpt_pool_begin(&self->jobs);
+	for (i = 0; i < count; i++) {
+		if (!(self->chunks[i].hdr.flags & TCMI_CKPT_ZCHUNK_RAW))
+			tcmi_ckpt_pool_submit(&self->jobs, &self->chunks[i].job,
+					      tcmi_ckpt_zbatch_decompress);
+	}
+	if (tcmi_ckpt_pool_wait(&self->jobs) < 0) {
+		mdbg(ERR3, "Error decompressing chunks");
+		goto exit0;
+	}
+	self->count = count;
+	return count;
+
+	/* error handling */
+ exit0:
+	return -EINVAL;
+}
+
+/** @addtogroup tcmi_ckpt_zbatch_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Writes the pages of a raw chunk one by one, so
+ * that pages known to the receiver are sent as references only.
+ *
+ * @param *chunk - raw chunk to be written
+ * @param *ckpt - checkpoint the chunk is written into
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_zbatch_write_pages(struct tcmi_ckpt_zchunk *chunk, 
+					struct tcmi_ckpt *ckpt)
+{
+	unsigned long addr;
+	int idx, n = 0;
+
+	for (idx = 0; idx < TCMI_CKPT_ZCHUNK_PAGES; idx++) {
+		if (!(chunk->hdr.present & (1 << idx)))
+			continue;
+		addr = chunk->hdr.start + idx * PAGE_SIZE;
+		if (tcmi_ckpt_write_page(ckpt, addr, chunk->raw + n++ * PAGE_SIZE) < 0) {
+			mdbg(ERR3, "Error writing page at %08lx", addr);
+			return -EINVAL;
+		}
+	}
+	return 0;
+}
+
+/**
+ * \<\<private\>\> Compresses a single chunk. When the data can't be
+ * compressed, the chunk is marked raw and stored as is.
+ *
+ * @param *job - job embedded in the chunk
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_zbatch_compress(struct tcmi_ckpt_pool_job *job)
+{
+	struct tcmi_ckpt_zchunk *chunk = 
+		container_of(job, struct tcmi_ckpt_zchunk, job);
+	size_t raw_len = tcmi_ckpt_zchunk_pages(chunk) * PAGE_SIZE;
+	size_t z_len;
+
+	if (lzo1x_1_compress(chunk->raw, raw_len, chunk->z, &z_len, 
+			     chunk->wrkmem) != LZO_E_OK || z_len >= raw_len) {
+		chunk->hdr.flags |= TCMI_CKPT_ZCHUNK_RAW;
+		chunk->hdr.length = raw_len;
+		return 0;
+	}
+	chunk->hdr.length = z_len;
+	return 0;
+}
+
+/**
+ * \<\<private\>\> Decompresses a single chunk. The decompressed size
+ * must match the number of present pages.
+ *
+ * @param *job - job embedded in the chunk
+ * @return 0 upon success
+ */
+static int tcmi_ckpt_zbatch_decompress(struct tcmi_ckpt_pool_job *job)
+{
+	struct tcmi_ckpt_zchunk *chunk = 
+		container_of(job, struct tcmi_ckpt_zchunk, job);
+	size_t raw_len = TCMI_CKPT_ZCHUNK_SIZE;
+	int err;
+
+	if ((err = lzo1x_decompress_safe(chunk->z, chunk->hdr.length, 
+					 chunk->raw, &raw_len)) != LZO_E_OK) {
+		mdbg(ERR3, "Failed to decompress chunk at %08llx: %d", 
+		     (unsigned long long)chunk->hdr.start, err);
+		return -EINVAL;
+	}
+	if (raw_len != tcmi_ckpt_zchunk_pages(chunk) * PAGE_SIZE) {
+		mdbg(ERR3, "Chunk at %08llx has %lu bytes, expected %d pages", 
+		     (unsigned long long)chunk->hdr.start, (unsigned long)raw_len, 
+		     tcmi_ckpt_zchunk_pages(chunk));
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,205 @@
+/**
+ * @file tcmi_ckpt_zbatch.h - a helper class that (de)compresses batches
+ *                            of process pages
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CKPT_ZBATCH_H
+#define _TCMI_CKPT_ZBATCH_H
+
+#include <linux/lzo.h>
+
+#include "tcmi_ckpt.h"
+#include "tcmi_ckpt_pool.h"
+
+/** @defgroup tcmi_ckpt_zbatch_class tcmi_ckpt_zbatch class
+ *
+ * @ingroup tcmi_ckpt_vm_area_class
+ *
+ * This is a helper class used by the \link tcmi_ckpt_vm_area_class
+ * VM area \endlink to store compressed areas. The area is split into
+ * chunks of TCMI_CKPT_ZCHUNK_PAGES pages, each chunk is compressed
+ * (LZO) separately. Chunks are collected into batches that are
+ * compressed in parallel by the \link tcmi_ckpt_pool_class worker
+ * pool \endlink, while the checkpointed process only copies the pages.
+ *
+ * Each batch is stored as:
+ * - chunk count (0 terminates the area)
+ * - chunk index - header of each chunk in the batch
+ * - compressed data of all chunks in the order of the index
+ *
+ * As the index precedes the data, the reader knows the size of all
+ * chunks upfront and decompresses them in parallel too. The image is
+ * written strictly sequentially, so it can be streamed as well.
+ *
+ * @{
+ */
+
+/** Number of pages in a single chunk, matches the present bitmap. */
+#define TCMI_CKPT_ZCHUNK_PAGES 32
+/** Size of uncompressed chunk. */
+#define TCMI_CKPT_ZCHUNK_SIZE (TCMI_CKPT_ZCHUNK_PAGES * PAGE_SIZE)
+/** Maximum number of chunks in a batch. */
+#define TCMI_CKPT_ZBATCH_CHUNKS 16
+
+/** Chunk data are stored uncompressed (compression didn't help). */
+#define TCMI_CKPT_ZCHUNK_RAW 0x1
+
+/** Describes a single chunk in the chunk index. */
+struct tcmi_ckpt_zchunk_hdr {
+	/** address of the first page covered by the chunk */
+	u_int64_t start;
+	/** bitmap of pages stored in the chunk, untouched pages are left out */
+	u_int32_t present;
+	/** size of the stored data */
+	u_int32_t length;
+	/** TCMI_CKPT_ZCHUNK_* flags */
+	u_int32_t flags;
+} __attribute__((__packed__));
+
+/** A chunk along with its buffers. */
+struct tcmi_ckpt_zchunk {
+	/** header as stored in the index */
+	struct tcmi_ckpt_zchunk_hdr hdr;
+	/** present pages, uncompressed and packed */
+	void *raw;
+	/** compressed data */
+	void *z;
+	/** LZO compressor working memory */
+	void *wrkmem;
+	/** compression/decompression job */
+	struct tcmi_ckpt_pool_job job;
+};
+
+/** Batch of chunks that is processed in parallel. */
+struct tcmi_ckpt_zbatch {
+	/** number of used chunks */
+	int count;
+	/** chunks along with their buffers */
+	struct tcmi_ckpt_zchunk chunks[TCMI_CKPT_ZBATCH_CHUNKS];
+	/** tracks the running jobs */
+	struct tcmi_ckpt_pool_batch jobs;
+	/** memory holding all buffers */
+	void *mem;
+};
+
+/** \<\<public\>\> Batch constructor. */
+extern struct tcmi_ckpt_zbatch* tcmi_ckpt_zbatch_new(void);
+/** \<\<public\>\> Releases the batch. */
+extern void tcmi_ckpt_zbatch_free(struct tcmi_ckpt_zbatch *self);
+
+/** \<\<public\>\> Compresses and writes the batch into the checkpoint. */
+extern int tcmi_ckpt_zbatch_write(struct tcmi_ckpt_zbatch *self, struct tcmi_ckpt *ckpt);
+/** \<\<public\>\> Terminates the compressed area. */
+extern int tcmi_ckpt_zbatch_write_end(struct tcmi_ckpt *ckpt);
+/** \<\<public\>\> Reads and decompresses a batch from the checkpoint. */
+extern int tcmi_ckpt_zbatch_read(struct tcmi_ckpt_zbatch *self, struct tcmi_ckpt *ckpt);
+
+/**
+ * \<\<public\>\> Batch of the checkpoint, it is allocated upon first
+ * use and reused by all its compressed areas.
+ *
+ * @param *ckpt - checkpoint instance
+ * @return batch or NULL
+ */
+static inline struct tcmi_ckpt_zbatch* tcmi_ckpt_zbatch(struct tcmi_ckpt *ckpt)
+{
+	if (!ckpt->zbatch)
+		ckpt->zbatch = tcmi_ckpt_zbatch_new();
+	return ckpt->zbatch;
+}
+
+/**
+ * \<\<public\>\> Starts a new chunk in the batch.
+ *
+ * @param *self - this batch
+ * @param start - address of the first page of the chunk
+ * @return new chunk or NULL when the batch is full
+ */
+static inline struct tcmi_ckpt_zchunk* tcmi_ckpt_zbatch_add(struct tcmi_ckpt_zbatch *self,
+							    unsigned long start)
+{
+	struct tcmi_ckpt_zchunk *chunk;
+
+	if (self->count == TCMI_CKPT_ZBATCH_CHUNKS)
+		return NULL;
+	chunk = &self->chunks[self->count++];
+	chunk->hdr.start = start;
+	chunk->hdr.present = 0;
+	chunk->hdr.length = 0;
+	chunk->hdr.flags = 0;
+	return chunk;
+}
+
+/**
+ * \<\<public\>\> Number of pages stored in the chunk.
+ *
+ * @param *self - this chunk
+ * @return number of present pages
+ */
+static inline int tcmi_ckpt_zchunk_pages(struct tcmi_ckpt_zchunk *self)
+{
+	return hweight32(self->hdr.present);
+}
+
+/**
+ * \<\<public\>\> Copies a page into the chunk. Pages have to be added
+ * in ascending order.
+ *
+ * @param *self - this chunk
+ * @param idx - index of the page within the chunk
+ * @param *kaddr - page data
+ */
+static inline void tcmi_ckpt_zchunk_add_page(struct tcmi_ckpt_zchunk *self, int idx,
+					     void *kaddr)
+{
+	memcpy(self->raw + tcmi_ckpt_zchunk_pages(self) * PAGE_SIZE, kaddr, PAGE_SIZE);
+	self->hdr.present |= 1 << idx;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CKPT_ZBATCH_PRIVATE
+
+/** Writes the pages of a raw chunk one by one. */
+static int tcmi_ckpt_zbatch_write_pages(struct tcmi_ckpt_zchunk *chunk, 
+					struct tcmi_ckpt *ckpt);
+
+/** Compresses a single chunk, runs in the worker. */
+static int tcmi_ckpt_zbatch_compress(struct tcmi_ckpt_pool_job *job);
+
+/** Decompresses a single chunk, runs in the worker. */
+static int tcmi_ckpt_zbatch_decompress(struct tcmi_ckpt_pool_job *job);
+
+/** Size of the compressed data buffer. */
+#define TCMI_CKPT_ZCHUNK_ZSIZE ALIGN(lzo1x_worst_compress(TCMI_CKPT_ZCHUNK_SIZE), 8)
+
+#endif /* TCMI_CKPT_ZBATCH_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_CKPT_ZBATCH_H */
+
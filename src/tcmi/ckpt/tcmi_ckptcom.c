@@ -31,8 +31,10 @@
 #include <linux/module.h>
 #include <linux/fs_struct.h>
 #include <linux/fdtable.h>
+#include <linux/shmem_fs.h>
 
 #include "tcmi_ckpt.h"
+#include "tcmi_ckpt_stream.h"
 #include "tcmi_ckpt_mm.h"
 #include "tcmi_ckpt_regs.h"
 #include "tcmi_ckpt_thread.h"
@@ -43,15 +45,54 @@
 #include "tcmi_ckptcom.h"
 #include "tcmi_ckpt_sig.h"
 #include "tcmi_ckpt_npm_params.h"
+#include "tcmi_ckpt_pool.h"
+#include "tcmi_ckpt_pagecache.h"
+#include "tcmi_ckpt_dedup.h"
 
 #include <arch/current/restart_fixup.h>
+#include <tcmi/task/tcmi_task.h>
+#include <tcmi/manager/tcmi_migman.h>
+#include <director/director.h>
+/* the checkpoint component is loaded first, so it owns the migration tracepoints */
+#define CREATE_TRACE_POINTS
+#include <tcmi/migration/tcmi_migtrace.h>
 #include <linux/vmalloc.h>
 
+/** Heavy memory areas are compressed by the worker pool */
+static int compress = 1;
+module_param(compress, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(compress, "Compress pages of heavy checkpoints (default 1)");
+
+/** Writable private file mappings are stored as a difference against the file. Such
+ * images are not self-contained, the restart fails once the file has changed, so this
+ * is left to clusters that keep their binaries and libraries in place. */
+static int diff = 0;
+module_param(diff, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(diff, "Store only diverged pages of private file mappings (default 0)");
+
+/** Heavy areas of at least this number of pages are written by the worker pool */
+static int parallel_pages = 16384;
+module_param(parallel_pages, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(parallel_pages, "Write heavy areas of at least this many pages in parallel, 0 disables (default 16384)");
+
+/** Default restart readahead window, unless the emigration requests its own */
+static int readahead = 0;
+module_param(readahead, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(readahead, "Pages of each heavy or file mapped area populated eagerly upon restart, 0 disables (default 0)");
+
+/**
+ * Format of written images. Nodes without the table of contents
+ * support can't restart version 2 images, so the indexed format has
+ * to be enabled explicitly once the whole cluster reads it.
+ */
+static int version = 1;
+module_param(version, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(version, "Checkpoint image format version, 1 or 2 (default 1)");
+
 /** 
  * \<\<private\>\> Helper method that handles both PPM and NPM checkpoint creation
  * 
  * This consists of:
- * - creating a new checkpoint instance 
  * - writing a checkpoint header - might fail if the process can't be
  * checkpointed (e.g. has open files or memory areas that are not
  * supported)
@@ -60,8 +101,9 @@
  * - writing memory areas along with pages
  * - writing process state (registers)
  * - writing signal handlers
+ * - writing the table of contents (version 2 images only)
  *
- * @param *file - file where the checkpoint is to be stored
+ * @param *ckpt - checkpoint instance (file based or streamed)
  * @param *regs - registers of the checkpointed process
  * @param heavy - if set a full checkpoint of all process pages
  * is made, all memory mapped files will be then restored
@@ -71,102 +113,238 @@
  *
  * @return 0 upon success
  */
-static int tcmi_ckptcom_checkpoint(struct file *file, struct pt_regs *regs,
+static int tcmi_ckptcom_checkpoint(struct tcmi_ckpt *ckpt, struct pt_regs *regs,
 			    int heavy, struct tcmi_npm_params* npm_params)
 {
-	struct tcmi_ckpt *ckpt;
 	int is_npm = npm_params != NULL;
+	struct tcmi_task *task;
+	int node;
 	u64 beg_time, end_time;
 	
 	beg_time = cpu_clock(smp_processor_id());
-
-	mdbg(INFO3, "Start checkpointing. Is_npm: %d", is_npm);
+	if ((task = tcmi_ckptcom_traced_task(&node)))
+		trace_tcmi_mig_ckpt_start(current->pid, node, tcmi_task_mig_mode(task), 0);
+	/* deduplicated pages have to be sent one by one */
+	ckpt->compress = compress && !ckpt->dedup;
+	ckpt->diff = diff;
+	ckpt->parallel = parallel_pages;
+	if (!ckpt->readahead)
+		ckpt->readahead = readahead;
+	ckpt->version = version;
+
+	mdbg(INFO3, "Start checkpointing. Is_npm: %d Streamed: %d Compressed: %d Diff: %d Dedup: %d", 
+	     is_npm, ckpt->sock != NULL, ckpt->compress, ckpt->diff, ckpt->dedup != NULL);
 	if ( !regs ) {
 		mdbg(ERR3, "Failed to create a checkpoint file. No regs provided");
 		goto exit0;
 	}
-	
-	ckpt = tcmi_ckpt_new(file);
-	if ( IS_ERR(ckpt) ) {
-		mdbg(ERR3, "Failed to create a checkpoint file. Err: %ld", PTR_ERR(ckpt));
-		goto exit0;
-	}
-	if ( ckpt == NULL ) {
-		mdbg(ERR3, "Failed to create a checkpoint file.");
-		goto exit0;
-	}
 
+	tcmi_ckpt_profile_begin(ckpt, 0);
 	if (tcmi_ckpt_write_hdr(ckpt, is_npm) < 0) {
 		mdbg(ERR3, "Error writing checkpoint header!");
-		goto exit1;
+		goto exit0;
 	}
 	if (tcmi_ckpt_write_rlimit(ckpt, current) < 0) {
 		mdbg(ERR3, "Error writing checkpoint rlimit!");
-		goto exit1;
+		goto exit0;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_HDR);
+	tcmi_ckpt_section(ckpt, TCMI_CKPT_SECTION_FILES);
 	if (tcmi_ckpt_write_files(ckpt) < 0) {
 		mdbg(ERR3, "Error writing checkpoint files!");
-		goto exit1;
+		goto exit0;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_FILES);
+	tcmi_ckpt_section(ckpt, TCMI_CKPT_SECTION_MM);
 	if (tcmi_ckpt_mm_write(ckpt) < 0) {
 		mdbg(ERR3, "Error writing memory descriptor!");
-		goto exit1;
+		goto exit0;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_MM);
 	
 	if ( !is_npm ) {
+		tcmi_ckpt_section(ckpt, TCMI_CKPT_SECTION_VMAS);
 		if (tcmi_ckpt_write_vmas(ckpt, heavy) < 0) {
 			mdbg(ERR3, "Error writing VM areas type: %d", heavy);
-			goto exit1;
+			goto exit0;
 		}
+		tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_VMAS);
 	}
 
+	tcmi_ckpt_section(ckpt, TCMI_CKPT_SECTION_REGS);
 	if (tcmi_ckpt_regs_write(ckpt, regs) < 0) {
 		mdbg(ERR3, "Error writing processor registers descriptor!");
-		goto exit1;
+		goto exit0;
 	}
 	if (tcmi_ckpt_tls_write(ckpt, current) < 0) {
 		mdbg(ERR3, "Error writing process tls!");
-		goto exit1;
+		goto exit0;
 	}
 	if (tcmi_ckpt_fsstruct_write(ckpt, current) < 0) {
 		mdbg(ERR3, "Error writing process fs struct!");
-		goto exit1;
+		goto exit0;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_REGS);
+	tcmi_ckpt_section(ckpt, TCMI_CKPT_SECTION_SIGS);
 	if (tcmi_ckpt_sig_write(ckpt) < 0) {
 		mdbg(ERR3, "Error writing signal data!");
-		goto exit1;
+		goto exit0;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_SIGS);
 
 	if ( is_npm ) {
+		tcmi_ckpt_section(ckpt, TCMI_CKPT_SECTION_NPM_PARAMS);
 		if (tcmi_ckpt_npm_params_write(ckpt, npm_params) < 0) {
 			mdbg(ERR3, "Error writing npm params!");
-			goto exit1;
+			goto exit0;
 		}	
 	}
+	if (tcmi_ckpt_write_toc(ckpt) < 0) {
+		mdbg(ERR3, "Error writing table of contents!");
+		goto exit0;
+	}
+	tcmi_ckptcom_profile_publish(ckpt);
+	if (task)
+		trace_tcmi_mig_ckpt_end(current->pid, node, tcmi_task_mig_mode(task),
+					tcmi_ckpt_profile_bytes(&ckpt->profile));
 
 	end_time = cpu_clock(smp_processor_id());
 	mdbg(INFO3, "Checkpoint (npm: %d) took '%llu' ms.'", is_npm, (end_time - beg_time) / 1000000);
-	printk("Checkpoint (npm: %d) took '%llu' ms.\n'", is_npm, (end_time - beg_time) / 1000000);
-
 
-	tcmi_ckpt_put(ckpt);
 	return 0;
 
 	/* error handling */
- exit1:
-	tcmi_ckpt_put(ckpt);
  exit0:
 	return -ENOEXEC;
 }
 
+/** 
+ * \<\<private\>\> Creates a checkpoint into a file.
+ *
+ * @param *file - file where the checkpoint is to be stored
+ * @param *regs - registers of the checkpointed process
+ * @param heavy - full checkpoint of all process pages
+ * @param npm_params - Non-preemptive checkpoint params or NULL
+ * @return 0 upon success
+ */
+static int tcmi_ckptcom_checkpoint_file(struct file *file, struct pt_regs *regs,
+					int heavy, struct tcmi_npm_params* npm_params)
+{
+	struct tcmi_ckpt *ckpt;
+	int err;
+
+	ckpt = tcmi_ckpt_new(file);
+	if ( IS_ERR(ckpt) ) {
+		mdbg(ERR3, "Failed to create a checkpoint file. Err: %ld", PTR_ERR(ckpt));
+		return -ENOEXEC;
+	}
+	if ( ckpt == NULL ) {
+		mdbg(ERR3, "Failed to create a checkpoint file.");
+		return -ENOEXEC;
+	}
+	err = tcmi_ckptcom_checkpoint(ckpt, regs, heavy, npm_params);
+	tcmi_ckpt_put(ckpt);
+
+	return err;
+}
+
+/** 
+ * \<\<private\>\> Streams a checkpoint into a socket. The stream is
+ * always terminated, if the checkpoint fails, the receiver is told
+ * to discard the image.
+ *
+ * The caller is responsible for holding the send lock of a shared
+ * socket as the image must not interleave with other messages.
+ *
+ * @param *sock - socket where the checkpoint is to be streamed
+ * @param *regs - registers of the checkpointed process
+ * @param heavy - full checkpoint of all process pages
+ * @param npm_params - Non-preemptive checkpoint params or NULL
+ * @param *dedup - page hashes negotiated with the receiver or NULL
+ * @param window - restart readahead window in pages, 0 selects the
+ * default, negative value disables it
+ * @return 0 upon success
+ */
+static int tcmi_ckptcom_checkpoint_sock(struct kkc_sock *sock, struct pt_regs *regs,
+					int heavy, struct tcmi_npm_params* npm_params,
+					struct tcmi_ckpt_dedup *dedup, int window)
+{
+	struct tcmi_ckpt *ckpt;
+	int err;
+
+	if (!(ckpt = tcmi_ckpt_new_stream(sock))) {
+		mdbg(ERR3, "Failed to create a streamed checkpoint.");
+		return -ENOEXEC;
+	}
+	ckpt->readahead = window;
+	err = 0;
+	if (dedup) {
+		ckpt->dedup = tcmi_ckpt_dedup_get(dedup);
+		if (tcmi_ckpt_dedup_session(dedup) && 
+		    tcmi_ckpt_stream_session(ckpt, tcmi_ckpt_dedup_session(dedup)) < 0)
+			err = -EIO;
+	}
+	if (!err)
+		err = tcmi_ckptcom_checkpoint(ckpt, regs, heavy, npm_params);
+	if (tcmi_ckpt_stream_end(ckpt, err < 0) < 0) {
+		mdbg(ERR3, "Failed to terminate the streamed checkpoint.");
+		err = -EIO;
+	}
+	mdbg(INFO3, "Streamed checkpoint size: %lld", (long long)tcmi_ckpt_pos(ckpt));
+	tcmi_ckpt_put(ckpt);
+
+	return err;
+}
+
 /** \<\<public\>\> Creates a preemptive process checkpoint. */
 int tcmi_ckptcom_checkpoint_ppm(struct file *file, struct pt_regs *regs, int heavy) {
-	return tcmi_ckptcom_checkpoint(file, regs, heavy, NULL);
+	return tcmi_ckptcom_checkpoint_file(file, regs, heavy, NULL);
+}
+
+/** 
+ * \<\<public\>\> Creates a preemptive process checkpoint in kernel
+ * memory. The image is stored in an unlinked in-memory (shmem) file,
+ * so no filesystem is touched. The image can be later transferred
+ * by tcmi_ckpt_stream_send_file().
+ *
+ * @param *regs - registers of the checkpointed process
+ * @param heavy - full checkpoint of all process pages
+ * @return file with the image positioned at its start or an error pointer
+ */
+struct file* tcmi_ckptcom_checkpoint_ppm_mem(struct pt_regs *regs, int heavy)
+{
+	struct file *file;
+	int err;
+
+	file = shmem_file_setup("tcmi-ckpt", 0, VM_NORESERVE);
+	if (IS_ERR(file)) {
+		mdbg(ERR3, "Can't create in-memory file for the image: %ld", PTR_ERR(file));
+		return file;
+	}
+	if ((err = tcmi_ckptcom_checkpoint_file(file, regs, heavy, NULL)) < 0) {
+		fput(file);
+		return ERR_PTR(err);
+	}
+	mdbg(INFO3, "In-memory checkpoint size: %lld", (long long)i_size_read(file->f_dentry->d_inode));
+	vfs_llseek(file, 0, 0);
+
+	return file;
 }
 
 /** \<\<public\>\> Creates a non-preemptive process checkpoint. */
 int tcmi_ckptcom_checkpoint_npm(struct file *file, struct pt_regs *regs, struct tcmi_npm_params* params) {
-	return tcmi_ckptcom_checkpoint(file, regs, 0, params);
+	return tcmi_ckptcom_checkpoint_file(file, regs, 0, params);
+}
+
+/** \<\<public\>\> Streams a preemptive process checkpoint into a socket. */
+int tcmi_ckptcom_checkpoint_ppm_stream(struct kkc_sock *sock, struct pt_regs *regs, int heavy,
+				       struct tcmi_ckpt_dedup *dedup, int window) {
+	return tcmi_ckptcom_checkpoint_sock(sock, regs, heavy, NULL, dedup, window);
+}
+
+/** \<\<public\>\> Streams a non-preemptive process checkpoint into a socket. */
+int tcmi_ckptcom_checkpoint_npm_stream(struct kkc_sock *sock, struct pt_regs *regs, struct tcmi_npm_params* params) {
+	return tcmi_ckptcom_checkpoint_sock(sock, regs, 0, params, NULL, 0);
 }
 
 /** 
@@ -175,7 +353,9 @@ int tcmi_ckptcom_checkpoint_npm(struct file *file, struct pt_regs *regs, struct
  *
  * - creating a new checkpoint instance 
  * - reading a checkpoint header - might fail, if the magic number
- * doesn't match.
+ * doesn't match or the table of contents of a version 2 image is
+ * corrupted. Sections of a version 2 image are then located through
+ * the table.
  * - reading open files
  * - reading memory descriptor
  * - reading memory areas along with pages
@@ -192,6 +372,8 @@ int tcmi_ckptcom_restart(struct linux_binprm *bprm, struct pt_regs *regs)
 {
 	struct tcmi_ckpt *ckpt;
 	struct pt_regs* original_regs;	
+	struct tcmi_task *task;
+	int node;
 //	int i;	
 	u64 beg_time, end_time;
 	
@@ -209,10 +391,13 @@ int tcmi_ckptcom_restart(struct linux_binprm *bprm, struct pt_regs *regs)
 	}
 	
 	mdbg(INFO3, "Restarting '%s'", bprm->filename);
+	if ((task = tcmi_ckptcom_traced_task(&node)))
+		trace_tcmi_mig_restart_begin(current->pid, node, tcmi_task_mig_mode(task), 0);
 	if (!(ckpt = tcmi_ckpt_new(bprm->file))) {
 		mdbg(ERR3, "Failed to instantiate a checkpoint");
 		goto exit0;
 	}
+	tcmi_ckpt_profile_begin(ckpt, 1);
 	if (tcmi_ckpt_read_hdr(ckpt) < 0) {
 		mdbg(ERR3, "Error reading checkpoint header!");
 		goto exit1;
@@ -223,36 +408,46 @@ memory_sanity_check("Post header");
 		mdbg(ERR3, "Error flushing the old execution context!");
 		goto exit0;
 	}
+	/* The image might have been opened via a close-on-exec descriptor (streamed checkpoints) */
+	tcmi_ckptcom_close_on_exec();
 memory_sanity_check("Pre-rlimit");
 	if (tcmi_ckpt_read_rlimit(ckpt, current) < 0) {
 		mdbg(ERR3, "Error reading checkpoint rlimit!");
 		goto exit1;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_HDR);
 memory_sanity_check("Post-rlimit");
 	if ( FD_ISSET(0, current->files->fdt->open_fds) ) {
 		mdbg(INFO3, "Closing open fs.. this should not happend though..");
 		sys_close(0);
 	}
 memory_sanity_check("Pre files");
-	if (tcmi_ckpt_read_files(ckpt) < 0) {
+	if (tcmi_ckpt_toc_seek(ckpt, TCMI_CKPT_SECTION_FILES) < 0 ||
+	    tcmi_ckpt_read_files(ckpt) < 0) {
 		mdbg(ERR3, "Error reading checkpoint files!");
 		goto exit1;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_FILES);
 memory_sanity_check("Post - files");
-	if (tcmi_ckpt_mm_read(ckpt) < 0) {
+	if (tcmi_ckpt_toc_seek(ckpt, TCMI_CKPT_SECTION_MM) < 0 ||
+	    tcmi_ckpt_mm_read(ckpt) < 0) {
 		mdbg(ERR3, "Error reading memory descriptor!");
 		goto exit1;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_MM);
 memory_sanity_check("Post mm");
 	if ( !ckpt->hdr.is_npm ) {
-		if (tcmi_ckpt_read_vmas(ckpt) < 0) {
+		if (tcmi_ckpt_toc_seek(ckpt, TCMI_CKPT_SECTION_VMAS) < 0 ||
+		    tcmi_ckpt_read_vmas(ckpt) < 0) {
 			mdbg(ERR3, "Error reading VM areas");
 			goto exit1;
 		}
+		tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_VMAS);
 	}
 
 	*original_regs = *regs;
-	if (tcmi_ckpt_regs_read(ckpt, regs) < 0) {
+	if (tcmi_ckpt_toc_seek(ckpt, TCMI_CKPT_SECTION_REGS) < 0 ||
+	    tcmi_ckpt_regs_read(ckpt, regs) < 0) {
 		mdbg(ERR3, "Error reading processor registers descriptor!");
 		goto exit1;
 	}
@@ -264,10 +459,13 @@ memory_sanity_check("Post mm");
 		mdbg(ERR3, "Error reading process fsstruct!");
 		goto exit1;
 	}
-	if (tcmi_ckpt_sig_read(ckpt) < 0) {
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_REGS);
+	if (tcmi_ckpt_toc_seek(ckpt, TCMI_CKPT_SECTION_SIGS) < 0 ||
+	    tcmi_ckpt_sig_read(ckpt) < 0) {
 		mdbg(ERR3, "Error reading signals informations!");
 		goto exit1;
 	}
+	tcmi_ckpt_phase(ckpt, TCMI_CKPT_PHASE_SIGS);
 	if ( ckpt->hdr.is_npm ) {
 		struct tcmi_npm_params* params = vmalloc(sizeof(struct tcmi_npm_params));
 		int exec_result = -EFAULT;
@@ -280,10 +478,12 @@ memory_sanity_check("Post mm");
 		}
 		
 
-		if (tcmi_ckpt_npm_params_read(ckpt, params) < 0) {
+		if (tcmi_ckpt_toc_seek(ckpt, TCMI_CKPT_SECTION_NPM_PARAMS) < 0 ||
+		    tcmi_ckpt_npm_params_read(ckpt, params) < 0) {
 			mdbg(ERR3, "Error reading npm params!");
 			goto exit1;
 		}				
+		tcmi_ckptcom_profile_publish(ckpt);
 		tcmi_ckpt_put(ckpt);
 
 		// TEMPORARY DEBUG!
@@ -332,9 +532,12 @@ memory_sanity_check("Post mm");
 			return -EFAULT;
 		}
 
+		/* the checkpoint is gone, its profile has been published to the task */
+		if (task)
+			trace_tcmi_mig_restart_end(current->pid, node, tcmi_task_mig_mode(task),
+						   tcmi_ckpt_profile_bytes(tcmi_task_profile(task)));
 		end_time = cpu_clock(smp_processor_id());
 		mdbg(INFO3, "Checkpoint NPM took '%llu' ms.'", (end_time - beg_time) / 1000000);
-		printk("Checkpoint NPM took '%llu' ms.\n'", (end_time - beg_time) / 1000000);
 
 		return 0;
 	} else {
@@ -344,12 +547,17 @@ memory_sanity_check("Post mm");
 	kfree(original_regs);
 	
 	/* flush_signals(current);*/
+	tcmi_ckptcom_profile_publish(ckpt);
+	/* the process returns to its first user space instruction right after this */
+	if (task)
+		trace_tcmi_mig_restart_end(current->pid, node, tcmi_task_mig_mode(task),
+					   tcmi_ckpt_profile_bytes(&ckpt->profile));
 	tcmi_ckpt_put(ckpt);
 	/* successul execution of the image - need to set the format */
 	set_binfmt(&tcmi_ckptcom_format);
 
+	end_time = cpu_clock(smp_processor_id());
 	mdbg(INFO3, "Checkpoint PPM took '%llu' ms.'", (end_time - beg_time) / 1000000);
-	printk("Checkpoint PPM took '%llu' ms.\n'", (end_time - beg_time) / 1000000);
 
 	/* Something went wrong, return the inode and free the argument pages*/
 /* 
@@ -368,6 +576,73 @@ What is the point of the following code? It does not really seem to free memory,
 	return -ENOEXEC;
 }
 
+/**
+ * \<\<private\>\> Closes all descriptors marked close-on-exec. The
+ * checkpoint restart doesn't go through setup_new_exec(), so this
+ * has to be done here, before the descriptors of the checkpointed
+ * process are restored.
+ */
+static void tcmi_ckptcom_close_on_exec(void)
+{
+	struct files_struct *files = current->files;
+	struct fdtable *fdt;
+	int fd;
+
+	spin_lock(&files->file_lock);
+	fdt = files_fdtable(files);
+	for (fd = 0; fd < fdt->max_fds; fd++) {
+		if (!FD_ISSET(fd, fdt->close_on_exec))
+			continue;
+		spin_unlock(&files->file_lock);
+		mdbg(INFO3, "Closing close-on-exec descriptor %d", fd);
+		sys_close(fd);
+		spin_lock(&files->file_lock);
+		fdt = files_fdtable(files);
+	}
+	spin_unlock(&files->file_lock);
+}
+
+/**
+ * \<\<private\>\> Publishes the profile of a finished checkpoint or
+ * restart. The profile is kept by the TCMI task of the current
+ * process (if there is any) that exports it via its ctlfs
+ * entry. A restarted process has just arrived at this node, so the
+ * director is notified right away. Checkpoints are reported by the
+ * tasks once the peer has confirmed the migration.
+ *
+ * @param *ckpt - checkpoint that has been written or restarted
+ */
+static void tcmi_ckptcom_profile_publish(struct tcmi_ckpt *ckpt)
+{
+	struct tcmi_ckpt_profile *profile = &ckpt->profile;
+
+	if (current->tcmi.tcmi_task)
+		tcmi_task_set_profile(TCMI_TASK(current->tcmi.tcmi_task), profile);
+	if (profile->restart)
+		director_task_migrated(current->pid, 1, TCMI_CKPT_PHASE_COUNT,
+				       profile->time, profile->bytes);
+}
+
+/**
+ * \<\<private\>\> Finds the TCMI task of the current process, only
+ * processes controlled by a task are reported by the migration
+ * tracepoints. The task provides the migration mode.
+ *
+ * @param *node - slot index of the migration manager of the task
+ * (i.e. the peer node) is stored here, -1 if there is none
+ * @return task of the current process or NULL
+ */
+static struct tcmi_task* tcmi_ckptcom_traced_task(int *node)
+{
+	struct tcmi_task *task;
+
+	if (!current->tcmi.tcmi_task)
+		return NULL;
+	task = TCMI_TASK(current->tcmi.tcmi_task);
+	*node = task->migman ? tcmi_migman_slot_index(task->migman) : -1;
+	return task;
+}
+
 /**
  * Core dumping function.
  * Currently just logs some process data.
@@ -381,23 +656,44 @@ static int tcmi_core_dump(struct coredump_params *cprm) {
 
 
 /** 
- * Initializes the migration component.  This requires registering a
- * new binary format with the kernel.
+ * Initializes the migration component.  This requires building the
+ * register conversion tables, starting the checkpoint worker pool, the page cache and registering a new binary
+ * format with the kernel.
  *
  * @return 0 upon success
  */
 static int __init tcmi_ckptcom_init(void)
 {
-	return register_binfmt(&tcmi_ckptcom_format);
+	int err;
+
+	regs_conv_init();
+	if ((err = tcmi_ckpt_pool_init()) < 0)
+		goto exit0;
+	if ((err = tcmi_ckpt_pagecache_init()) < 0)
+		goto exit1;
+	if ((err = register_binfmt(&tcmi_ckptcom_format)) < 0)
+		goto exit2;
+	return 0;
+
+	/* error handling */
+ exit2:
+	tcmi_ckpt_pagecache_exit();
+ exit1:
+	tcmi_ckpt_pool_exit();
+ exit0:
+	return err;
 }
 
 /** 
  * Shutdown for the migration component.  This requires unregistering
- * a new binary format with the kernel.
+ * a new binary format with the kernel, releasing the page cache and
+ * stopping the worker pool.
  */
 static void __exit tcmi_ckptcom_exit(void)
 {
 	unregister_binfmt(&tcmi_ckptcom_format);
+	tcmi_ckpt_pagecache_exit();
+	tcmi_ckpt_pool_exit();
 }
 
 
@@ -422,8 +718,22 @@ module_init(tcmi_ckptcom_init);
 module_exit(tcmi_ckptcom_exit);
 
 EXPORT_SYMBOL_GPL(tcmi_ckptcom_checkpoint_ppm);
+EXPORT_SYMBOL_GPL(tcmi_ckptcom_checkpoint_ppm_mem);
 EXPORT_SYMBOL_GPL(tcmi_ckptcom_checkpoint_npm);
+EXPORT_SYMBOL_GPL(tcmi_ckptcom_checkpoint_ppm_stream);
+EXPORT_SYMBOL_GPL(tcmi_ckptcom_checkpoint_npm_stream);
 EXPORT_SYMBOL_GPL(tcmi_ckptcom_restart);
 
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_request);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_frozen);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_ckpt_start);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_ckpt_end);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_msg_sent);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_guest_spawned);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_mounts_done);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_restart_begin);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_restart_end);
+EXPORT_TRACEPOINT_SYMBOL_GPL(tcmi_mig_shadow_notified);
+
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Jan Capek");
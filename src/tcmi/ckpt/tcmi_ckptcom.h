@@ -35,6 +35,8 @@
 #include <linux/binfmts.h>
 
 struct tcmi_npm_params;
+struct kkc_sock;
+struct tcmi_ckpt_dedup;
 
 /** @defgroup tcmi_ckptcom_class checkpointing component
  *
@@ -45,7 +47,8 @@ struct tcmi_npm_params;
  * the state of the process.
  *
  * It provides a simple interface that that allows:
- * - creating a checkpoint into a specified file
+ * - creating a checkpoint into a specified file, into kernel memory
+ * or streaming it directly into a socket
  * - restoring the checkpoint via a new bin_fmt handler that it
  * registers in the kernel.
  *
@@ -58,8 +61,15 @@ struct tcmi_npm_params;
 
 /** \<\<public\>\> Creates a preemptive process checkpoint. */
 extern int tcmi_ckptcom_checkpoint_ppm(struct file *file, struct pt_regs *regs, int heavy);
+/** \<\<public\>\> Creates a preemptive process checkpoint in kernel memory. */
+extern struct file* tcmi_ckptcom_checkpoint_ppm_mem(struct pt_regs *regs, int heavy);
 /** \<\<public\>\> Creates a non-preemptive process checkpoint. */
 extern int tcmi_ckptcom_checkpoint_npm(struct file *file, struct pt_regs *regs, struct tcmi_npm_params* params);
+/** \<\<public\>\> Streams a preemptive process checkpoint into a socket. */
+extern int tcmi_ckptcom_checkpoint_ppm_stream(struct kkc_sock *sock, struct pt_regs *regs, int heavy,
+					      struct tcmi_ckpt_dedup *dedup, int window);
+/** \<\<public\>\> Streams a non-preemptive process checkpoint into a socket. */
+extern int tcmi_ckptcom_checkpoint_npm_stream(struct kkc_sock *sock, struct pt_regs *regs, struct tcmi_npm_params* params);
 /** \<\<public\>\> Restarts a process from a checkpoint (new binfmt handler). */
 extern int tcmi_ckptcom_restart(struct linux_binprm *bprm, struct pt_regs *regs);
 
@@ -68,6 +78,15 @@ extern int tcmi_ckptcom_restart(struct linux_binprm *bprm, struct pt_regs *regs)
 /** New checkpoint binary format for the kernel. */
 static struct linux_binfmt tcmi_ckptcom_format;
 
+/** Closes all descriptors marked close-on-exec. */
+static void tcmi_ckptcom_close_on_exec(void);
+
+/** Publishes the profile of a finished checkpoint or restart. */
+static void tcmi_ckptcom_profile_publish(struct tcmi_ckpt *ckpt);
+
+/** Finds the task of the current process for the migration tracepoints. */
+static struct tcmi_task* tcmi_ckptcom_traced_task(int *node);
+
 #endif /* TCMI_CKPTCOM_PRIVATE */
 
 
@@ -31,6 +31,11 @@
 #define _TCMI_FDCACHE_H
 
 #include <asm/atomic.h>
+#include <linux/hash.h>
+#include <linux/list.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 
 #include <dbg.h>
 
@@ -43,6 +48,11 @@
  * file descriptor. This is needed when checkpointing open files of a
  * process.
  *
+ * The entries are hashed by the file object, so that processes with
+ * thousands of open descriptors don't have to scan all of them for
+ * each file being checkpointed. The number of buckets is derived
+ * from the size of the descriptor table of the process.
+ *
  * There is no need for locking nor reference counting as fdcache is a
  * temporary object (as well as \link tcmi_ckpt_class a checkpoint
  * object \endlink) accessed from a single thread of execution. The
@@ -54,6 +64,8 @@
 
 /** Describes an fd cache entry. */
 struct tcmi_fdcache_entry {
+	/** node in the hash bucket */
+	struct hlist_node node;
 	/** file descriptor. */
 	int fd;
 	/** file that references. */
@@ -65,6 +77,10 @@ struct tcmi_fdcache {
 	/** File descriptor cache - used when indentifying descriptors
 	 * referencing the same file. */
 	struct tcmi_fdcache_entry *entries;
+	/** hash buckets of the entries, indexed by the file object */
+	struct hlist_head *buckets;
+	/** number of bits of the bucket index */
+	int bits;
 	/** current files in the cache. */
 	int used;
 	/** actual cache size. */
@@ -73,30 +89,51 @@ struct tcmi_fdcache {
 	atomic_t ref_count;
 };
 
+/** Upper bound of the bucket count, hash chains are short anyway */
+#define TCMI_FDCACHE_MAX_BUCKETS (1 << 12)
+
 /**
  * \<\<public\>\> Creates a file descriptor cache of the specified
  * size. This requires:
  * - creating new instance
- * - allocating a requested number of entries
+ * - allocating a requested number of entries along with the hash
+ * buckets, large tables are vmalloc'ed
  *
  * @param size - maximum number of entries - should match the current
  * number of open files of a process - this handles the worst case
  * when there are none duplicate descriptors but one.
+ * @param max_fds - size of the descriptor table of the process, used
+ * for sizing the hash table
  * @return fdcache instance or NULL
  */
-static inline struct tcmi_fdcache* tcmi_fdcache_new(int size)
+static inline struct tcmi_fdcache* tcmi_fdcache_new(int size, int max_fds)
 {
 	struct tcmi_fdcache *fdcache;
+	unsigned long buckets;
+	size_t length;
+	int i;
+
 	if (!(fdcache = kmalloc(sizeof(struct tcmi_fdcache), 
 				GFP_KERNEL))) {
 		mdbg(ERR3, "Can't allocate memory for TCMI fdcache");
 		goto exit0;
 	}
-	if (!(fdcache->entries = kmalloc(sizeof(struct tcmi_fdcache_entry) * size,
-					 GFP_KERNEL))) {
+	/* at least 2 buckets, hash_ptr() can't produce a 0 bit index */
+	buckets = roundup_pow_of_two(clamp(max_fds, 2, TCMI_FDCACHE_MAX_BUCKETS));
+	length = sizeof(struct tcmi_fdcache_entry) * size + 
+		sizeof(struct hlist_head) * buckets;
+	if (length > PAGE_SIZE)
+		fdcache->entries = vmalloc(length);
+	else
+		fdcache->entries = kmalloc(length, GFP_KERNEL);
+	if (!fdcache->entries) {
 		mdbg(ERR3, "Can't get memory for TCMI fdcache %d entries", size);
 		goto exit1;
 	}
+	fdcache->buckets = (struct hlist_head*)(fdcache->entries + size);
+	for (i = 0; i < buckets; i++)
+		INIT_HLIST_HEAD(&fdcache->buckets[i]);
+	fdcache->bits = ilog2(buckets);
 	atomic_set(&fdcache->ref_count, 1);
 	fdcache->size = size;
 	/* no used entries yet */
@@ -133,7 +170,10 @@ static inline void tcmi_fdcache_put(struct tcmi_fdcache *self)
 {
 	if (self && atomic_dec_and_test(&self->ref_count)) {
 		mdbg(INFO4, "Destroying TCMI fdcache, %p", self);
-		kfree(self->entries);
+		if (is_vmalloc_addr(self->entries))
+			vfree(self->entries);
+		else
+			kfree(self->entries);
 		kfree(self);
 	}
 }
@@ -157,6 +197,7 @@ static inline int tcmi_fdcache_add(struct tcmi_fdcache *self, int fd, struct fil
 	entry = &self->entries[self->used++];
 	entry->fd = fd;
 	entry->file = file;
+	hlist_add_head(&entry->node, &self->buckets[hash_ptr(file, self->bits)]);
 	return 0;
 
 	/* error handling */
@@ -173,20 +214,17 @@ static inline int tcmi_fdcache_add(struct tcmi_fdcache *self, int fd, struct fil
  */
 static inline int tcmi_fdcache_lookup(struct tcmi_fdcache *self, struct file *file)
 {
-	int i;
-	int fd = -EINVAL;
-	/* safes dereferences */
-	int used = self->used;
-	struct tcmi_fdcache_entry *entry = self->entries;
-	for (i = 0; i < used; i++, entry++) {
+	struct tcmi_fdcache_entry *entry;
+	struct hlist_node *pos;
+
+	hlist_for_each_entry(entry, pos, &self->buckets[hash_ptr(file, self->bits)], node) {
 		if (entry->file == file) {
-			fd = entry->fd;
-			mdbg(INFO4, "Found descriptor %d in the fdcache", fd);
-			break;
+			mdbg(INFO4, "Found descriptor %d in the fdcache", entry->fd);
+			return entry->fd;
 		}
 	}
 
-	return fd;
+	return -EINVAL;
 }
 
 #endif /* TCMI_FDCACHE_PRIVATE */
@@ -0,0 +1,125 @@
+/**
+ * @file tcmi_child_event_procmsg.h - TCMI child event, sent by guest task
+ *                                 from PEN
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CHILD_EVENT_PROCMSG_H
+#define _TCMI_CHILD_EVENT_PROCMSG_H
+
+#include "tcmi_procmsg.h"
+
+/** @defgroup tcmi_child_event_procmsg_class tcmi_child_event_procmsg class
+ *
+ * @ingroup tcmi_procmsg_class
+ *
+ * This class represents a notification sent by a guest task to its
+ * shadow about a change of its children the shadow can't see on its
+ * own, see tcmi_zombiecache_class:
+ * - TCMI_CHILD_EVENT_REAP - the guest has consumed the exit record of
+ * a zombie child, the shadow reaps the child
+ * - TCMI_CHILD_EVENT_FORK - the guest has forked a child using a stub
+ * leased by the CCN, the shadow lists the stub among the children
+ * even before the stub is claimed
+ *
+ * @{
+ */
+
+/** Compound structure, inherits from tcmi_procmsg_class */
+struct tcmi_child_event_procmsg {
+	/** parent class instance. */
+	struct tcmi_procmsg super;
+	/** TCMI_CHILD_EVENT_REAP or TCMI_CHILD_EVENT_FORK */
+	u_int32_t event;
+	/** PID of the child (as seen by the CCN) */
+	int32_t pid;
+};
+
+/** Exit record of the child has been consumed by the guest */
+#define TCMI_CHILD_EVENT_REAP 1
+/** Guest has forked the child using a leased stub */
+#define TCMI_CHILD_EVENT_FORK 2
+
+
+
+
+/** \<\<public\>\> Child event process message constructor for receiving. */
+extern struct tcmi_msg* tcmi_child_event_procmsg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Child event process message constructor for transferring. */
+extern struct tcmi_msg* tcmi_child_event_procmsg_new_tx(pid_t dst_pid, u_int32_t event, pid_t pid);
+
+
+/** Message descriptor for the factory class, there is no error
+ * handling as this is the starting request */
+#define TCMI_CHILD_EVENT_PROCMSG_DSC TCMI_MSG_DSC(TCMI_CHILD_EVENT_PROCMSG_ID, tcmi_child_event_procmsg_new_rx, NULL)
+
+/** Casts to the tcmi_child_event_procmsg instance. */
+#define TCMI_CHILD_EVENT_PROCMSG(m) ((struct tcmi_child_event_procmsg*)m)
+
+/**
+ * Event accessor.
+ * 
+ * @param *self - this message instance
+ * @return TCMI_CHILD_EVENT_REAP or TCMI_CHILD_EVENT_FORK
+ */
+static inline u_int32_t tcmi_child_event_procmsg_event(struct tcmi_child_event_procmsg *self) 
+{
+	return self->event;
+}
+
+/**
+ * Child PID accessor.
+ * 
+ * @param *self - this message instance
+ * @return PID of the child
+ */
+static inline pid_t tcmi_child_event_procmsg_pid(struct tcmi_child_event_procmsg *self) 
+{
+	return self->pid;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CHILD_EVENT_PROCMSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_child_event_procmsg_recv(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_child_event_procmsg_send(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_procmsg_ops child_event_procmsg_ops;
+
+#endif /* TCMI_CHILD_EVENT_PROCMSG_PRIVATE */
+
+
+/**
+ * @}
+ */
+
+
+#endif /* _TCMI_CHILD_EVENT_PROCMSG_H */
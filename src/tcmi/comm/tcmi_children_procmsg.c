@@ -0,0 +1,191 @@
+/**
+ * @file tcmi_children_procmsg.c - TCMI children snapshot, sent by shadow task
+ *                                 from CCN
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <linux/slab.h>
+
+#include "tcmi_transaction.h"
+
+#define TCMI_CHILDREN_PROCMSG_PRIVATE
+#include "tcmi_children_procmsg.h"
+
+
+#include <dbg.h>
+
+
+
+/** 
+ * \<\public\>\> Children snapshot message rx constructor.
+ * This method is called by the factory class.
+ *
+ * @param msg_id - message ID - used for verification
+ * instance.
+ * @return a new children snapshot message or NULL.
+ */
+struct tcmi_msg* tcmi_children_procmsg_new_rx(u_int32_t msg_id)
+{
+	struct tcmi_children_procmsg *msg;
+
+	/* Check if the factory is building what it really thinks. */
+	if (msg_id != TCMI_CHILDREN_PROCMSG_ID) {
+		mdbg(ERR3, "Factory specified message ID(%x) doesn't match real ID(%x)",
+		     msg_id, TCMI_CHILDREN_PROCMSG_ID);
+		goto exit0;
+	}
+	/* Allocate the instance */
+	if (!(msg = TCMI_CHILDREN_PROCMSG(kmalloc(sizeof(struct tcmi_children_procmsg), GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate children snapshot message");
+		goto exit0;
+	}
+	/* Initialized the message for receiving. */
+	if (tcmi_procmsg_init_rx(TCMI_PROCMSG(msg), TCMI_CHILDREN_PROCMSG_ID, &children_procmsg_ops)) {
+		mdbg(ERR3, "Error initializing children snapshot message %x", msg_id);
+		goto exit1;
+	}
+
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+}
+
+/** 
+ * \<\public\>\> Children snapshot message tx constructor.
+ *
+ * The notification has no transaction associated, no response is
+ * expected.
+ *
+ * @param dst_pid - destination process PID
+ * @param *children - snapshot of the children, it is copied into the message
+ * @return a new message ready for the transfer or NULL.
+ */
+struct tcmi_msg* tcmi_children_procmsg_new_tx(pid_t dst_pid, struct tcmi_children *children)
+{
+	struct tcmi_children_procmsg *msg;
+
+	if (!(msg = TCMI_CHILDREN_PROCMSG(kmalloc(sizeof(struct tcmi_children_procmsg), GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate children snapshot message");
+		goto exit0;
+	}
+
+	/* Initialize the message for transfer, no transaction to be
+	 * created, no response expected, no timeout for response, not a reply to any transaction */
+	if (tcmi_procmsg_init_tx(TCMI_PROCMSG(msg), TCMI_CHILDREN_PROCMSG_ID, &children_procmsg_ops, 
+				 dst_pid, 0,
+				 NULL, 0, 
+				 0, TCMI_TRANSACTION_INVAL_ID)) {
+		mdbg(ERR3, "Error initializing children snapshot message");
+		goto exit1;
+	}
+	msg->children = *children;
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+	
+}
+
+
+/** @addtogroup tcmi_children_procmsg_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Receives the snapshot via a specified connection.
+ * The counts are checked, so that the snapshot can be used as is.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for receiving message data
+ * @return 0 when successfully received.
+ */
+static int tcmi_children_procmsg_recv(struct tcmi_procmsg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct tcmi_children *children = &TCMI_CHILDREN_PROCMSG(self)->children;
+
+	if ((err = kkc_sock_recv(sock, children, 
+				 sizeof(*children), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive children snapshot");
+		goto exit0;
+	}
+	if (children->nchildren > TCMI_CHILDREN_MAX || children->nzombies > TCMI_CHILDREN_ZOMBIES) {
+		mdbg(ERR3, "Invalid children snapshot %u children, %u zombies", 
+		     children->nchildren, children->nzombies);
+		err = -EINVAL;
+		goto exit0;
+	}
+	mdbg(INFO3, "Received children snapshot: %u children, %u zombies, seq %u", 
+	     children->nchildren, children->nzombies, children->seq);
+
+	return 0;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Sends the snapshot via a specified connection.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for receiving message data
+ * @return 0 when successfully sent.
+ */
+static int tcmi_children_procmsg_send(struct tcmi_procmsg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct tcmi_children *children = &TCMI_CHILDREN_PROCMSG(self)->children;
+
+	err = kkc_sock_send(sock, children, 
+			    sizeof(*children), KKC_SOCK_BLOCK);
+
+	mdbg(INFO3, "Sent children snapshot: %u children, %u zombies, seq %u", 
+	     children->nchildren, children->nzombies, children->seq);
+
+	return err;
+}
+
+
+
+/** Message operations that support polymorphism. */
+static struct tcmi_procmsg_ops children_procmsg_ops = {
+	.recv = tcmi_children_procmsg_recv,
+	.send = tcmi_children_procmsg_send
+};
+
+
+/**
+ * @}
+ */
@@ -0,0 +1,141 @@
+/**
+ * @file tcmi_children_procmsg.h - TCMI children snapshot, sent by shadow task
+ *                                 from CCN
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_CHILDREN_PROCMSG_H
+#define _TCMI_CHILDREN_PROCMSG_H
+
+#include "tcmi_procmsg.h"
+
+/** @defgroup tcmi_children_procmsg_class tcmi_children_procmsg class
+ *
+ * @ingroup tcmi_procmsg_class
+ *
+ * This class represents a snapshot of the children of a process
+ * that a shadow task pushes to its guest whenever the children
+ * change on the CCN. Only children that a plain wait4() can reap are
+ * listed. The snapshot also carries the exit status of the children
+ * that are zombies, so that the guest can serve wait4() without
+ * asking the CCN, see tcmi_zombiecache_class.
+ *
+ * @{
+ */
+
+/** Max number of children in a snapshot */
+#define TCMI_CHILDREN_MAX 64
+/** Max number of zombies in a snapshot */
+#define TCMI_CHILDREN_ZOMBIES 16
+
+/** The snapshot is not complete, the guest has to ask the CCN */
+#define TCMI_CHILDREN_OVERFLOW 0x1
+/** There are more zombies than listed in the snapshot */
+#define TCMI_CHILDREN_MORE_ZOMBIES 0x2
+
+/** Exit record of a zombie child */
+struct tcmi_children_zombie {
+	/** PID of the child */
+	int32_t pid;
+	/** status as reported by wait4() */
+	int32_t status;
+} __attribute__((__packed__));
+
+/** Snapshot of the children, transferred as is */
+struct tcmi_children {
+	/** number of child events of the guest processed by the shadow */
+	u_int32_t seq;
+	/** TCMI_CHILDREN_OVERFLOW, TCMI_CHILDREN_MORE_ZOMBIES */
+	u_int32_t flags;
+	/** number of children including zombies */
+	u_int32_t nchildren;
+	/** number of zombie records */
+	u_int32_t nzombies;
+	/** bit i set when the shadow may signal children[i] */
+	u_int64_t killable;
+	/** PIDs of the children */
+	int32_t children[TCMI_CHILDREN_MAX];
+	/** zombie records */
+	struct tcmi_children_zombie zombies[TCMI_CHILDREN_ZOMBIES];
+} __attribute__((__packed__));
+
+/** Compound structure, inherits from tcmi_procmsg_class */
+struct tcmi_children_procmsg {
+	/** parent class instance. */
+	struct tcmi_procmsg super;
+	/** the snapshot */
+	struct tcmi_children children;
+};
+
+
+
+
+/** \<\<public\>\> Children snapshot process message constructor for receiving. */
+extern struct tcmi_msg* tcmi_children_procmsg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Children snapshot process message constructor for transferring. */
+extern struct tcmi_msg* tcmi_children_procmsg_new_tx(pid_t dst_pid, struct tcmi_children *children);
+
+
+/** Message descriptor for the factory class, there is no error
+ * handling as this is the starting request */
+#define TCMI_CHILDREN_PROCMSG_DSC TCMI_MSG_DSC(TCMI_CHILDREN_PROCMSG_ID, tcmi_children_procmsg_new_rx, NULL)
+
+/** Casts to the tcmi_children_procmsg instance. */
+#define TCMI_CHILDREN_PROCMSG(m) ((struct tcmi_children_procmsg*)m)
+
+/**
+ * Snapshot accessor.
+ *
+ * @param *self - this message instance
+ * @return snapshot of the children
+ */
+static inline struct tcmi_children* tcmi_children_procmsg_children(struct tcmi_children_procmsg *self)
+{
+	return &self->children;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_CHILDREN_PROCMSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_children_procmsg_recv(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_children_procmsg_send(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_procmsg_ops children_procmsg_ops;
+
+#endif /* TCMI_CHILDREN_PROCMSG_PRIVATE */
+
+
+/**
+ * @}
+ */
+
+
+#endif /* _TCMI_CHILDREN_PROCMSG_H */
@@ -0,0 +1,249 @@
+/**
+ * @file tcmi_dataconn.c - data connection for bulk transfers that
+ *                     bypass the migration manager connection
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <linux/sched.h>
+#include <linux/string.h>
+#include <linux/random.h>
+#include <linux/err.h>
+
+#define TCMI_DATACONN_PRIVATE
+#include "tcmi_dataconn.h"
+
+#include <dbg.h>
+
+
+/**
+ * \<\<public\>\> Starts listening for the receiver. The listening
+ * socket is opened on an ephemeral port of the local interface of
+ * the migration manager connection, so that the peer can reach it
+ * the same way it reaches us. A new token is generated.
+ *
+ * @param *self - this data connection instance
+ * @param *sock - migration manager connection
+ * @return 0 on success
+ */
+int tcmi_dataconn_listen(struct tcmi_dataconn *self, struct kkc_sock *sock)
+{
+	int err, len;
+	char *addr = self->addr;
+	char *last_colon_char;
+
+	memset(addr, 0, TCMI_DATACONN_ADDR_LENGTH);
+	kkc_sock_getarchname(sock, addr, KKC_MAX_ARCH_LENGTH);
+	len = strlen(addr);
+	addr[len] = ':';
+	kkc_sock_getsockname(sock, addr + len + 1, TCMI_DATACONN_ADDR_LENGTH - len - 2);
+	if (!(last_colon_char = strrchr(addr + len + 1, ':'))) {
+		mdbg(ERR3, "Unexpected local address '%s'", addr);
+		return -EINVAL;
+	}
+	/* any port */
+	strcpy(last_colon_char + 1, "0");
+	if ((err = kkc_listen(&self->sock, addr))) {
+		mdbg(ERR3, "Failed listening on '%s': %d", addr, err);
+		self->sock = NULL;
+		return err < 0 ? err : -EINVAL;
+	}
+	/* publish the port actually assigned */
+	kkc_sock_getsockname(self->sock, addr + len + 1, TCMI_DATACONN_ADDR_LENGTH - len - 2);
+	get_random_bytes(self->token, TCMI_DATACONN_TOKEN_SIZE);
+	mdbg(INFO3, "Data connection listening on '%s'", addr);
+
+	return 0;
+}
+
+/**
+ * \<\<public\>\> Waits for the receiver to connect. The listening
+ * socket is polled until a connection arrives from the peer of the
+ * migration manager connection and presents the token. Other
+ * connections are dropped. Waiting is given up when a signal arrives,
+ * when the transaction is no longer running - the peer has responded
+ * without connecting or the transaction has expired - or, for
+ * messages without a transaction, when the timeout elapses.
+ *
+ * @param *self - this data connection instance
+ * @param *sock - migration manager connection
+ * @param *trans - transaction of the message or NULL
+ * @param timeout - time to wait in jiffies when there is no transaction
+ * @return connected data socket or an error pointer
+ */
+struct kkc_sock* tcmi_dataconn_accept(struct tcmi_dataconn *self, struct kkc_sock *sock,
+				      struct tcmi_transaction *trans, unsigned long timeout)
+{
+	int err;
+	struct kkc_sock *data_sock;
+	char peer[KKC_SOCK_MAX_ADDR_LENGTH];
+	char *last_colon_char;
+	int peer_len;
+	unsigned long deadline = jiffies + timeout;
+
+	if (!self->sock)
+		return ERR_PTR(-ENOTCONN);
+	memset(peer, 0, KKC_SOCK_MAX_ADDR_LENGTH);
+	kkc_sock_getpeername(sock, peer, KKC_SOCK_MAX_ADDR_LENGTH - 1);
+	if (!(last_colon_char = strrchr(peer, ':')))
+		return ERR_PTR(-EINVAL);
+	/* compare the IP addresses including the colon */
+	peer_len = last_colon_char - peer + 1;
+
+	while (tcmi_dataconn_waiting(trans, deadline)) {
+		if ((err = kkc_sock_accept(self->sock, &data_sock, KKC_SOCK_NONBLOCK)) < 0) {
+			if (err != -EAGAIN)
+				return ERR_PTR(err);
+			schedule_timeout_interruptible(TCMI_DATACONN_POLL);
+			if (signal_pending(current))
+				return ERR_PTR(-ERESTARTSYS);
+			continue;
+		}
+		if (strncmp(kkc_sock_getpeername2(data_sock), peer, peer_len)) {
+			mdbg(ERR3, "Dropping data connection from '%s', expected peer '%s'",
+			     kkc_sock_getpeername2(data_sock), peer);
+			kkc_sock_put(data_sock);
+			continue;
+		}
+		if (!(err = tcmi_dataconn_check_token(self, data_sock, trans, deadline)))
+			return data_sock;
+		kkc_sock_put(data_sock);
+		if (err == -ERESTARTSYS)
+			return ERR_PTR(err);
+	}
+
+	return ERR_PTR(-ETIMEDOUT);
+}
+
+/**
+ * \<\<public\>\> Stops listening. Safe to call on a closed data
+ * connection.
+ *
+ * @param *self - this data connection instance
+ */
+void tcmi_dataconn_close(struct tcmi_dataconn *self)
+{
+	kkc_sock_put(self->sock);
+	self->sock = NULL;
+}
+
+/**
+ * \<\<public\>\> Connects to a data connection announced by the
+ * sender and presents the token.
+ *
+ * @param *addr - address of the data connection
+ * @param *token - token received along with the address
+ * @return connected data socket or an error pointer
+ */
+struct kkc_sock* tcmi_dataconn_connect(const char *addr, const u_int8_t *token)
+{
+	int err;
+	struct kkc_sock *data_sock;
+
+	if ((err = kkc_connect(&data_sock, addr))) {
+		mdbg(ERR3, "Failed connecting to the data connection '%s': %d", addr, err);
+		return ERR_PTR(err < 0 ? err : -ECONNREFUSED);
+	}
+	if ((err = kkc_sock_send(data_sock, (void*)token, TCMI_DATACONN_TOKEN_SIZE, 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed sending the data connection token: %d", err);
+		kkc_sock_put(data_sock);
+		return ERR_PTR(err);
+	}
+
+	return data_sock;
+}
+
+
+/** @addtogroup tcmi_dataconn_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Checks whether the sender still waits for the
+ * receiver.
+ *
+ * @param *trans - transaction of the message or NULL
+ * @param deadline - end of waiting when there is no transaction
+ * @return non-zero while waiting
+ */
+static int tcmi_dataconn_waiting(struct tcmi_transaction *trans, unsigned long deadline)
+{
+	if (trans)
+		return tcmi_transaction_is_running(trans);
+	return time_before(jiffies, deadline);
+}
+
+/**
+ * \<\<private\>\> Receives and checks the token of an accepted
+ * connection. The token is polled for, so that a connection that
+ * never sends anything can't block the sender.
+ *
+ * @param *self - this data connection instance
+ * @param *data_sock - accepted connection
+ * @param *trans - transaction of the message or NULL
+ * @param deadline - end of waiting when there is no transaction
+ * @return 0 when the token matches
+ */
+static int tcmi_dataconn_check_token(struct tcmi_dataconn *self, struct kkc_sock *data_sock,
+				     struct tcmi_transaction *trans, unsigned long deadline)
+{
+	u_int8_t token[TCMI_DATACONN_TOKEN_SIZE];
+	int err, len = 0;
+
+	while (len < TCMI_DATACONN_TOKEN_SIZE) {
+		if (!tcmi_dataconn_waiting(trans, deadline))
+			return -ETIMEDOUT;
+		err = kkc_sock_recv(data_sock, token + len, TCMI_DATACONN_TOKEN_SIZE - len, 
+				    KKC_SOCK_NONBLOCK);
+		if (err > 0) {
+			len += err;
+			continue;
+		}
+		if (err < 0 && err != -EAGAIN) {
+			mdbg(ERR3, "Failed receiving the data connection token: %d", err);
+			return err;
+		}
+		if (!err) {
+			mdbg(ERR3, "Data connection closed before sending the token");
+			return -ECONNRESET;
+		}
+		schedule_timeout_interruptible(TCMI_DATACONN_POLL);
+		if (signal_pending(current))
+			return -ERESTARTSYS;
+	}
+	if (memcmp(token, self->token, TCMI_DATACONN_TOKEN_SIZE)) {
+		mdbg(ERR3, "Dropping data connection from '%s', invalid token",
+		     kkc_sock_getpeername2(data_sock));
+		return -EACCES;
+	}
+
+	return 0;
+}
+
+/**
+ * @}
+ */
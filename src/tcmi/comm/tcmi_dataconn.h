@@ -0,0 +1,117 @@
+/**
+ * @file tcmi_dataconn.h - data connection for bulk transfers that
+ *                     bypass the migration manager connection
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_DATACONN_H
+#define _TCMI_DATACONN_H
+
+#include <linux/types.h>
+
+#include <kkc/kkc.h>
+
+#include "tcmi_transaction.h"
+
+/** @defgroup tcmi_dataconn_class tcmi_dataconn class
+ *
+ * @ingroup tcmi_msg_class
+ *
+ * This class represents a data connection that carries bulk data
+ * (checkpoint images) of a single message, so that the migration
+ * manager connection isn't locked by the transfer. The sender of the
+ * message listens on an ephemeral port of the local interface of the
+ * migration manager connection and sends the address along with a
+ * random token in the message. Once the message is out, the sender
+ * accepts the connection and transfers the data. The receiver
+ * connects from its own context and presents the token first, so
+ * that nobody else - not even another process on the same host - can
+ * take over the transfer.
+ *
+ * @{
+ */
+
+/** Size of the token in bytes */
+#define TCMI_DATACONN_TOKEN_SIZE 16
+/** Maximum length of the data connection address including the architecture prefix */
+#define TCMI_DATACONN_ADDR_LENGTH (KKC_MAX_WHERE_LENGTH + 2)
+
+/** Compound structure holding the listening side */
+struct tcmi_dataconn {
+	/** listening socket, NULL when closed */
+	struct kkc_sock *sock;
+	/** address the receiver connects to */
+	char addr[TCMI_DATACONN_ADDR_LENGTH];
+	/** token the receiver has to present */
+	u_int8_t token[TCMI_DATACONN_TOKEN_SIZE];
+};
+
+/**
+ * \<\<public\>\> Initializes a closed data connection.
+ *
+ * @param *self - this data connection instance
+ */
+static inline void tcmi_dataconn_init(struct tcmi_dataconn *self)
+{
+	self->sock = NULL;
+	self->addr[0] = '\0';
+}
+
+/** \<\<public\>\> Starts listening for the receiver. */
+extern int tcmi_dataconn_listen(struct tcmi_dataconn *self, struct kkc_sock *sock);
+
+/** \<\<public\>\> Waits for the receiver to connect. */
+extern struct kkc_sock* tcmi_dataconn_accept(struct tcmi_dataconn *self, struct kkc_sock *sock,
+					     struct tcmi_transaction *trans, unsigned long timeout);
+
+/** \<\<public\>\> Stops listening. */
+extern void tcmi_dataconn_close(struct tcmi_dataconn *self);
+
+/** \<\<public\>\> Connects to a data connection announced by the sender. */
+extern struct kkc_sock* tcmi_dataconn_connect(const char *addr, const u_int8_t *token);
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_DATACONN_PRIVATE
+
+/** Checks whether the sender still waits for the receiver. */
+static int tcmi_dataconn_waiting(struct tcmi_transaction *trans, unsigned long deadline);
+
+/** Receives and checks the token of an accepted connection. */
+static int tcmi_dataconn_check_token(struct tcmi_dataconn *self, struct kkc_sock *data_sock,
+				     struct tcmi_transaction *trans, unsigned long deadline);
+
+/** Poll period of the listener */
+#define TCMI_DATACONN_POLL (HZ/50)
+
+#endif /* TCMI_DATACONN_PRIVATE */
+
+
+/**
+ * @}
+ */
+
+
+#endif /* _TCMI_DATACONN_H */
@@ -0,0 +1,105 @@
+/**
+ * @file tcmi_ident_changed_procmsg.h - TCMI identity change notification, sent
+ *                                 by shadow task from CCN
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_IDENT_CHANGED_PROCMSG_H
+#define _TCMI_IDENT_CHANGED_PROCMSG_H
+
+#include "tcmi_procmsg.h"
+
+/** @defgroup tcmi_ident_changed_procmsg_class tcmi_ident_changed_procmsg class
+ *
+ * @ingroup tcmi_procmsg_class
+ *
+ * This class represents a notification sent by a shadow task when
+ * some of the identity values of the process (credentials, parent,
+ * process group or session) have changed on the CCN. The guest drops
+ * the affected values from its identity cache, see
+ * tcmi_identcache_class. The message carries a mask of the changed
+ * entries.
+ *
+ * @{
+ */
+
+/** Compound structure, inherits from tcmi_procmsg_class */
+struct tcmi_ident_changed_procmsg {
+	/** parent class instance. */
+	struct tcmi_procmsg super;
+	/** mask of the changed identity cache entries. */
+	u_int32_t mask;
+};
+
+
+
+
+/** \<\<public\>\> Identity change process message constructor for receiving. */
+extern struct tcmi_msg* tcmi_ident_changed_procmsg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Identity change process message constructor for transferring. */
+extern struct tcmi_msg* tcmi_ident_changed_procmsg_new_tx(pid_t dst_pid, u_int32_t mask);
+
+
+/** Message descriptor for the factory class, there is no error
+ * handling as this is the starting request */
+#define TCMI_IDENT_CHANGED_PROCMSG_DSC TCMI_MSG_DSC(TCMI_IDENT_CHANGED_PROCMSG_ID, tcmi_ident_changed_procmsg_new_rx, NULL)
+
+/** Casts to the tcmi_ident_changed_procmsg instance. */
+#define TCMI_IDENT_CHANGED_PROCMSG(m) ((struct tcmi_ident_changed_procmsg*)m)
+
+/**
+ * Changed entries accessor.
+ * 
+ * @param *self - this message instance
+ * @return mask of the changed identity cache entries
+ */
+static inline u_int32_t tcmi_ident_changed_procmsg_mask(struct tcmi_ident_changed_procmsg *self) 
+{
+	return self->mask;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_IDENT_CHANGED_PROCMSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_ident_changed_procmsg_recv(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_ident_changed_procmsg_send(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_procmsg_ops ident_changed_procmsg_ops;
+
+#endif /* TCMI_IDENT_CHANGED_PROCMSG_PRIVATE */
+
+
+/**
+ * @}
+ */
+
+
+#endif /* _TCMI_IDENT_CHANGED_PROCMSG_H */
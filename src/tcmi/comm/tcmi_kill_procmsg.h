@@ -0,0 +1,118 @@
+/**
+ * @file tcmi_kill_procmsg.h - TCMI one-way kill, sent by guest task
+ *                                 from PEN
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_KILL_PROCMSG_H
+#define _TCMI_KILL_PROCMSG_H
+
+#include "tcmi_procmsg.h"
+
+/** @defgroup tcmi_kill_procmsg_class tcmi_kill_procmsg class
+ *
+ * @ingroup tcmi_procmsg_class
+ *
+ * This class represents a kill() a guest task asks its shadow to
+ * perform without waiting for the result. It is used only when the
+ * guest knows the call can't fail - a standard signal sent to a
+ * child the \link tcmi_zombiecache_class children snapshot \endlink
+ * lists. Everything else is still sent as the TCMI_RPC_SYS_KILL RPC,
+ * since the caller needs the error code.
+ *
+ * @{
+ */
+
+/** Compound structure, inherits from tcmi_procmsg_class */
+struct tcmi_kill_procmsg {
+	/** parent class instance. */
+	struct tcmi_procmsg super;
+	/** PID of the target (as seen by the CCN) */
+	int32_t pid;
+	/** signal to be sent */
+	int32_t sig;
+};
+
+
+
+
+/** \<\<public\>\> Kill process message constructor for receiving. */
+extern struct tcmi_msg* tcmi_kill_procmsg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Kill process message constructor for transferring. */
+extern struct tcmi_msg* tcmi_kill_procmsg_new_tx(pid_t dst_pid, pid_t pid, int sig);
+
+
+/** Message descriptor for the factory class, there is no error
+ * handling as this is the starting request */
+#define TCMI_KILL_PROCMSG_DSC TCMI_MSG_DSC(TCMI_KILL_PROCMSG_ID, tcmi_kill_procmsg_new_rx, NULL)
+
+/** Casts to the tcmi_kill_procmsg instance. */
+#define TCMI_KILL_PROCMSG(m) ((struct tcmi_kill_procmsg*)m)
+
+/**
+ * Target PID accessor.
+ * 
+ * @param *self - this message instance
+ * @return PID of the target
+ */
+static inline pid_t tcmi_kill_procmsg_pid(struct tcmi_kill_procmsg *self) 
+{
+	return self->pid;
+}
+
+/**
+ * Signal accessor.
+ * 
+ * @param *self - this message instance
+ * @return signal to be sent
+ */
+static inline int tcmi_kill_procmsg_sig(struct tcmi_kill_procmsg *self) 
+{
+	return self->sig;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_KILL_PROCMSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_kill_procmsg_recv(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_kill_procmsg_send(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_procmsg_ops kill_procmsg_ops;
+
+#endif /* TCMI_KILL_PROCMSG_PRIVATE */
+
+
+/**
+ * @}
+ */
+
+
+#endif /* _TCMI_KILL_PROCMSG_H */
@@ -52,8 +52,17 @@
 #include "tcmi_guest_started_procmsg.h"
 #include "tcmi_ppm_p_migr_back_guestreq_procmsg.h"
 #include "tcmi_ppm_p_migr_back_shadowreq_procmsg.h"
+#include "tcmi_ppm_v_migr_back_guestreq_procmsg.h"
+#include "tcmi_ppm_v_migr_back_shadowreq_procmsg.h"
 #include "tcmi_vfork_done_procmsg.h"
+#include "tcmi_ident_changed_procmsg.h"
+#include "tcmi_children_procmsg.h"
+#include "tcmi_child_event_procmsg.h"
+#include "tcmi_kill_procmsg.h"
 #include "tcmi_generic_user_msg.h"
+#include "tcmi_page_hashes_msg.h"
+#include "tcmi_page_hashes_resp_msg.h"
+#include "tcmi_sigset_msg.h"
 
 /** @defgroup tcmi_messages_dsc message descriptors
  *
@@ -91,6 +100,9 @@ static struct tcmi_msg_dsc mig_messages[] = {
 	TCMI_P_EMIGRATE_MSG_DSC,
 	TCMI_SIGNAL_MSG_DSC,
 	TCMI_GENERIC_USER_MSG_DSC,
+	TCMI_PAGE_HASHES_MSG_DSC,
+	TCMI_PAGE_HASHES_RESP_MSG_DSC,
+	TCMI_SIGSET_MSG_DSC,
 };
 
 
@@ -107,6 +119,12 @@ static struct tcmi_msg_dsc proc_messages[] = {
 	TCMI_PPM_P_MIGR_BACK_SHADOWREQ_PROCMSG_DSC,
 	TCMI_RPC_PROCMSG_DSC,
 	TCMI_RPCRESP_PROCMSG_DSC,	
+	TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_DSC,
+	TCMI_PPM_V_MIGR_BACK_SHADOWREQ_PROCMSG_DSC,
+	TCMI_IDENT_CHANGED_PROCMSG_DSC,
+	TCMI_CHILDREN_PROCMSG_DSC,
+	TCMI_CHILD_EVENT_PROCMSG_DSC,
+	TCMI_KILL_PROCMSG_DSC,
 };
 
 
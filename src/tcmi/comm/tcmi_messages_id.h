@@ -122,6 +122,9 @@ enum {
 	TCMI_P_EMIGRATE_MSG_ID,                              	 /* TCMI phys. emigration message */
 	TCMI_SIGNAL_MSG_ID,                                      /* TCMI signal message */
         TCMI_GENERIC_USER_MSG_ID,                            /* Generic user message */
+	TCMI_PAGE_HASHES_MSG_ID,                                 /* TCMI page hashes offered to the PEN */
+	TCMI_PAGE_HASHES_RESP_MSG_ID,                            /* TCMI pages known to the PEN */
+	TCMI_SIGSET_MSG_ID,                                      /* TCMI coalesced standard signals */
 	TCMI_LAST_MSG_ID                                         /* Last ID */
 };
 
@@ -136,6 +139,12 @@ enum {
 	TCMI_PPM_P_MIGR_BACK_SHADOWREQ_PROCMSG_ID,                     /* TCMI migrate back request from shadow task */
 	TCMI_RPC_PROCMSG_ID,                                          /* TCMI RPC mesage */
 	TCMI_RPCRESP_PROCMSG_ID,                                      /* TCMI RPC response mesage */
+	TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_ID,                     /* TCMI in-memory migrate back guest request */
+	TCMI_PPM_V_MIGR_BACK_SHADOWREQ_PROCMSG_ID,                    /* TCMI in-memory migrate back request from shadow task */
+	TCMI_IDENT_CHANGED_PROCMSG_ID,                                /* TCMI identity of the process has changed on CCN */
+	TCMI_CHILDREN_PROCMSG_ID,                                     /* TCMI snapshot of the children on CCN */
+	TCMI_CHILD_EVENT_PROCMSG_ID,                                  /* TCMI guest reaped or forked a child */
+	TCMI_KILL_PROCMSG_ID,                                         /* TCMI one-way kill requested by guest */
 
 	TCMI_LAST_PROCMSG_ID                                          /* Last ID */
 };
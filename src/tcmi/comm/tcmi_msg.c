@@ -129,6 +129,9 @@ int tcmi_msg_init_tx(struct tcmi_msg *self, u_int32_t msg_id,
  * communicated to the user.
  *
  * This method is also to be used for sending one-way request messages.
+ * Those may transfer bulk data via their sent() operation once the
+ * connection is unlocked again, a failure there is only logged as
+ * the message itself has been delivered.
  * 
  * @param *self - pointer to this message instance
  * @param *sock - KKC socket used for sending message data
@@ -138,7 +141,12 @@ int tcmi_msg_init_tx(struct tcmi_msg *self, u_int32_t msg_id,
 int tcmi_msg_send_anonymous(struct tcmi_msg *self, struct kkc_sock *sock)
 {
 	int err;
+	int ret;
 	err = tcmi_msg_send(self, sock, TCMI_TRANS_FLAGS_ANONYMOUS);
+
+	/* the receiver handles a missing follow-up on its own */
+	if (!err && self->msg_ops && self->msg_ops->sent && (ret = self->msg_ops->sent(self, sock)) < 0)
+		mdbg(ERR3, "Message follow-up failed(Msg=%p ID=%x): %d", self, self->msg_id, ret);
 	return err;
 }
 
@@ -151,7 +159,10 @@ int tcmi_msg_send_anonymous(struct tcmi_msg *self, struct kkc_sock *sock)
  * expires.
  *
  * The actual work is delegated to tcmi_msg_send() specifying no extra
- * flags for the transaction. The thread is then put to sleep waiting
+ * flags for the transaction. Messages that carry bulk data outside of
+ * the connection get a chance to transfer it via their sent()
+ * operation, the connection is no longer locked at that point. The
+ * thread is then put to sleep waiting
  * for completion of the transaction. When its woken up again, the transaction
  * has:
  * - been aborted - the user gets NULL in the response message parameter 
@@ -189,6 +200,10 @@ int tcmi_msg_send_and_receive(struct tcmi_msg *self, struct kkc_sock *sock,
 	if (!self->transaction || err < 0)
 		goto exit0;
 
+	/* the peer reports a failure of the follow-up transfer in its response */
+	if (self->msg_ops && self->msg_ops->sent && (ret = self->msg_ops->sent(self, sock)) < 0)
+		mdbg(ERR3, "Message follow-up failed(Msg=%p ID=%x): %d", self, self->msg_id, ret);
+
 	/* wait till the transaction expires */
 	ret = tcmi_transaction_wait_interruptible(trans);
 	switch (ret) {
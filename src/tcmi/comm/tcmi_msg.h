@@ -129,6 +129,10 @@ struct tcmi_msg_ops {
 	int (*recv)(struct tcmi_msg*, struct kkc_sock*);
 	/** Sends the message via a specified connection. */
 	int (*send)(struct tcmi_msg*, struct kkc_sock*);
+	/** Optional, called by tcmi_msg_send_and_receive() and
+	 * tcmi_msg_send_anonymous() once the message has been sent and
+	 * the connection unlocked, before waiting for the response. */
+	int (*sent)(struct tcmi_msg*, struct kkc_sock*);
 	/** Frees custom message resources. The destruction of the
 	 * actual message instance is handled internally by this
 	 * class */
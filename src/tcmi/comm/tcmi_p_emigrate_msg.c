@@ -30,6 +30,16 @@
  */
 #include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/file.h>
+#include <linux/sched.h>
+
+#include <kkc/kkc.h>
+
+#include <tcmi/ckpt/tcmi_ckptcom.h>
+#include <tcmi/ckpt/tcmi_ckpt_stream.h>
+#include <tcmi/ckpt/tcmi_ckpt_dedup.h>
+#include <tcmi/task/tcmi_task.h>
+#include <tcmi/migration/tcmi_migtrace.h>
 
 #include "tcmi_transaction.h"
 
@@ -65,6 +75,13 @@ struct tcmi_msg* tcmi_p_emigrate_msg_new_rx(u_int32_t msg_id)
 		mdbg(ERR3, "Can't allocate test request message");
 		goto exit0;
 	}
+	msg->ckpt_name = NULL;
+	msg->exec_name = NULL;
+	msg->regs = NULL;
+	msg->npm_params = NULL;
+	msg->dedup = NULL;
+	msg->readahead = 0;
+	tcmi_dataconn_init(&msg->dataconn);
 	/* Initialized the message for receiving. */
 	if (tcmi_msg_init_rx(TCMI_MSG(msg), TCMI_P_EMIGRATE_MSG_ID, &p_emigrate_msg_ops)) {
 		mdbg(ERR3, "Error initializing test request message %x", msg_id);
@@ -101,6 +118,108 @@ struct tcmi_msg* tcmi_p_emigrate_msg_new_rx(u_int32_t msg_id)
  */
 struct tcmi_msg* tcmi_p_emigrate_msg_new_tx(struct tcmi_slotvec *transactions, 
 						       pid_t reply_pid, char *exec_name, char *ckpt_name, int16_t euid, int16_t egid, int16_t fsuid, int16_t fsgid)
+{
+	return TCMI_MSG(tcmi_p_emigrate_msg_alloc_tx(transactions, reply_pid, exec_name, ckpt_name,
+						     euid, egid, fsuid, fsgid, 0));
+}
+
+/** 
+ * \<\<public\>\> Physical emigration message tx constructor - streamed
+ * checkpoint version.
+ *
+ * No checkpoint name is sent, instead a data connection is opened
+ * and its address and token are sent. The checkpoint of the current
+ * process is streamed over the data connection after the message has
+ * been sent. Therefore, the message has to be sent in context of the
+ * process that is being migrated.
+ *
+ * Response message ID is TCMI_GUEST_STARTED_PROCMSG_ID.
+ *
+ * @param *transactions - storage for the new transaction
+ * @param *sock - migration manager connection the message is sent through
+ * @param reply_pid - denotes the pid that the reply to this message
+ * should be directed to.
+ * @param *regs - registers of the process that is to be checkpointed
+ * @param *npm_params - non-preemptive migration params or NULL for
+ * a preemptive checkpoint
+ * @param *dedup - page hashes negotiated with the PEN or NULL, the
+ * message holds its own reference
+ * @param readahead - number of pages of each heavy area populated on
+ * restart, 0 selects the default, negative value disables it
+ * @return a new message ready for the transfer or NULL.
+ */
+struct tcmi_msg* tcmi_p_emigrate_msg_new_stream_tx(struct tcmi_slotvec *transactions, 
+						   struct kkc_sock *sock,
+						   pid_t reply_pid, char *exec_name, struct pt_regs *regs,
+						   struct tcmi_npm_params *npm_params,
+						   struct tcmi_ckpt_dedup *dedup, int readahead,
+						   int16_t euid, int16_t egid, int16_t fsuid, int16_t fsgid)
+{
+	struct tcmi_p_emigrate_msg *msg;
+	struct tcmi_dataconn dataconn;
+
+	if (tcmi_dataconn_listen(&dataconn, sock) < 0)
+		return NULL;
+	if (!(msg = tcmi_p_emigrate_msg_alloc_tx(transactions, reply_pid, exec_name, dataconn.addr,
+						 euid, egid, fsuid, fsgid, 1))) {
+		tcmi_dataconn_close(&dataconn);
+		return NULL;
+	}
+	msg->dataconn = dataconn;
+	memcpy(msg->pid_and_size.token, dataconn.token, TCMI_DATACONN_TOKEN_SIZE);
+	msg->regs = regs;
+	msg->npm_params = npm_params;
+	msg->readahead = readahead;
+	if (dedup)
+		msg->dedup = tcmi_ckpt_dedup_get(dedup);
+
+	return TCMI_MSG(msg);
+}
+
+/** 
+ * \<\<public\>\> Fetches the streamed checkpoint image. Connects to
+ * the data connection announced by the sender, presents its token
+ * and spools the image
+ * into an in-memory file. This is called by the guest in its own
+ * context, so the transfer doesn't hold up the receiving thread of
+ * the migration manager.
+ *
+ * @param *self - this message instance
+ * @param owner - page cache owner of the sender
+ * @return file with the image or an error pointer, -ENOEXEC when the
+ * sender has aborted the transfer
+ */
+struct file* tcmi_p_emigrate_msg_fetch_image(struct tcmi_p_emigrate_msg *self, u_int64_t owner)
+{
+	struct kkc_sock *data_sock;
+	struct file *image;
+
+	if (IS_ERR(data_sock = tcmi_dataconn_connect(self->ckpt_name, self->pid_and_size.token)))
+		return ERR_CAST(data_sock);
+	if (IS_ERR(image = tcmi_ckpt_stream_recv(data_sock, owner)))
+		mdbg(ERR3, "Failed to receive streamed checkpoint: %ld", PTR_ERR(image));
+	kkc_sock_put(data_sock);
+
+	return image;
+}
+
+
+/** @addtogroup tcmi_p_emigrate_msg_class
+ *
+ * @{
+ */
+
+/** 
+ * \<\<private\>\> Allocates and initializes the message for
+ * transferring. Common part of both tx constructors.
+ *
+ * @param streamed - when set, the checkpoint image follows the message
+ * @return a new message or NULL
+ */
+static struct tcmi_p_emigrate_msg* tcmi_p_emigrate_msg_alloc_tx(struct tcmi_slotvec *transactions, 
+								pid_t reply_pid, char *exec_name, char *ckpt_name,
+								int16_t euid, int16_t egid, int16_t fsuid, int16_t fsgid,
+								int streamed)
 {
 	struct tcmi_p_emigrate_msg *msg;
 
@@ -115,6 +234,12 @@ struct tcmi_msg* tcmi_p_emigrate_msg_new_tx(struct tcmi_slotvec *transactions,
 	msg->pid_and_size.fsgid = fsgid;
 	msg->pid_and_size.size = strlen(ckpt_name) + 1;
 	msg->pid_and_size.exec_name_size = strlen(exec_name) + 1;
+	msg->pid_and_size.streamed = streamed;
+	msg->regs = NULL;
+	msg->npm_params = NULL;
+	msg->dedup = NULL;
+	tcmi_dataconn_init(&msg->dataconn);
+	memset(msg->pid_and_size.token, 0, TCMI_DATACONN_TOKEN_SIZE);
 
 	if (!(msg->ckpt_name = (char*)kmalloc(msg->pid_and_size.size, GFP_KERNEL))) {
 		mdbg(ERR3, "Can't allocate memory for checkpoint name");
@@ -131,11 +256,12 @@ struct tcmi_msg* tcmi_p_emigrate_msg_new_tx(struct tcmi_slotvec *transactions,
 	/* Initialize the message for transfer */
 	if (tcmi_msg_init_tx(TCMI_MSG(msg), TCMI_P_EMIGRATE_MSG_ID, &p_emigrate_msg_ops, 
 			     transactions, TCMI_GUEST_STARTED_PROCMSG_ID,
-			     TCMI_P_EMIGRATE_MSGTIMEOUT, TCMI_TRANSACTION_INVAL_ID)) {
+			     (streamed ? TCMI_P_EMIGRATE_STREAM_MSGTIMEOUT : TCMI_P_EMIGRATE_MSGTIMEOUT),
+			     TCMI_TRANSACTION_INVAL_ID)) {
 		mdbg(ERR3, "Error initializing test request message message");
 		goto exit3;
 	}
-	return TCMI_MSG(msg);
+	return msg;
 
 	/* error handling */
  exit3:
@@ -146,21 +272,17 @@ struct tcmi_msg* tcmi_p_emigrate_msg_new_tx(struct tcmi_slotvec *transactions,
 	kfree(msg);
  exit0:
 	return NULL;
-	
 }
 
-
-/** @addtogroup tcmi_p_emigrate_msg_class
- *
- * @{
- */
-
 /**
  * \<\<private\>\> Receives the message via a specified connection.
  * Receiving the message requires reading the remote PID and
  * checkpoint size.  Based on the size, allocate space for the
  * checkpoint name string and read it to from the specified connection
  *
+ * A streamed checkpoint is not received here, the guest fetches it
+ * over the data connection later on.
+ *
  * @param *self - this message instance
  * @param *sock - KKC socket used for receiving message data
  * @return 0 when successfully received.
@@ -245,6 +367,15 @@ static int tcmi_p_emigrate_msg_send(struct tcmi_msg *self, struct kkc_sock *sock
 		goto exit0;
 	}
 
+	/* the message is sent by the emigrating process, its task
+	 * holds the checkpoint profile, streamed ones are traced once
+	 * the image has been transferred */
+	if (!self_msg->pid_and_size.streamed && current->tcmi.tcmi_task) {
+		struct tcmi_task *task = TCMI_TASK(current->tcmi.tcmi_task);
+		trace_tcmi_mig_msg_sent(self_msg->pid_and_size.reply_pid, 
+					tcmi_task_migman_slot_index(task), tcmi_task_mig_mode(task),
+					tcmi_ckpt_profile_bytes(tcmi_task_profile(task)));
+	}
 	mdbg(INFO2, "Physical emigrate message sent PID=%d, size=%d, ckptname='%s'",
 	     self_msg->pid_and_size.reply_pid, self_msg->pid_and_size.size, self_msg->ckpt_name);
 
@@ -255,6 +386,58 @@ static int tcmi_p_emigrate_msg_send(struct tcmi_msg *self, struct kkc_sock *sock
 	
 }
 
+/**
+ * \<\<private\>\> Streams the checkpoint over the data connection.
+ * Called after the message has been sent, the migration manager
+ * connection is not locked anymore, so other messages can pass while
+ * the image is being transferred. When the checkpoint can't be
+ * created, the stream is terminated as aborted and the PEN reports
+ * the failure in its response.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket the message has been sent through
+ * @return 0 when the image has been transferred
+ */
+static int tcmi_p_emigrate_msg_sent(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct kkc_sock *data_sock;
+	struct tcmi_p_emigrate_msg *self_msg = TCMI_P_EMIGRATE_MSG(self);
+
+	if (!self_msg->pid_and_size.streamed)
+		return 0;
+	if (IS_ERR(data_sock = tcmi_dataconn_accept(&self_msg->dataconn, sock, 
+						    self->transaction, 0)))
+		return PTR_ERR(data_sock);
+	/* nobody else is going to connect */
+	tcmi_dataconn_close(&self_msg->dataconn);
+
+	if (self_msg->npm_params)
+		err = tcmi_ckptcom_checkpoint_npm_stream(data_sock, self_msg->regs, 
+							 self_msg->npm_params);
+	else
+		err = tcmi_ckptcom_checkpoint_ppm_stream(data_sock, self_msg->regs, 1,
+							 self_msg->dedup,
+							 self_msg->readahead);
+	if (err < 0) {
+		mdbg(ERR3, "Failed to stream the checkpoint: %d", err);
+		goto exit0;
+	}
+	if (current->tcmi.tcmi_task) {
+		struct tcmi_task *task = TCMI_TASK(current->tcmi.tcmi_task);
+		trace_tcmi_mig_msg_sent(self_msg->pid_and_size.reply_pid, 
+					tcmi_task_migman_slot_index(task), tcmi_task_mig_mode(task),
+					tcmi_ckpt_profile_bytes(tcmi_task_profile(task)));
+	}
+	mdbg(INFO2, "Streamed checkpoint transferred PID=%d via '%s'",
+	     self_msg->pid_and_size.reply_pid, kkc_sock_getsockname2(data_sock));
+	err = 0;
+	/* error handling */
+ exit0:
+	kkc_sock_put(data_sock);
+	return err;
+}
+
 /**
  * \<\<private\>\> Frees custom message resources.
  * The checkpoint image name string is released from memory.
@@ -269,6 +452,8 @@ static void tcmi_p_emigrate_msg_free(struct tcmi_msg *self)
 	     self_msg->pid_and_size.reply_pid, self_msg->pid_and_size.size, self_msg->ckpt_name);
 	kfree(self_msg->ckpt_name);
 	kfree(self_msg->exec_name);
+	tcmi_dataconn_close(&self_msg->dataconn);
+	tcmi_ckpt_dedup_put(self_msg->dedup);
 }
 
 
@@ -276,6 +461,7 @@ static void tcmi_p_emigrate_msg_free(struct tcmi_msg *self)
 static struct tcmi_msg_ops p_emigrate_msg_ops = {
 	.recv = tcmi_p_emigrate_msg_recv,
 	.send = tcmi_p_emigrate_msg_send,
+	.sent = tcmi_p_emigrate_msg_sent,
 	.free = tcmi_p_emigrate_msg_free
 };
 
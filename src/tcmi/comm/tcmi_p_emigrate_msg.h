@@ -32,6 +32,10 @@
 #define _TCMI_P_EMIGRATE_MSG_H
 
 #include "tcmi_msg.h"
+#include "tcmi_dataconn.h"
+
+struct tcmi_npm_params;
+struct tcmi_ckpt_dedup;
 
 /** @defgroup tcmi_p_emigrate_msg_class tcmi_p_emigrate_msg class
  *
@@ -52,6 +56,19 @@
  * it for further communication via process control connection. Also,
  * the checkpoint file name is specified as part of the message.
  *
+ * Alternatively, the checkpoint image is streamed (see \link
+ * tcmi_ckpt_stream_class checkpoint stream \endlink) over a separate
+ * data connection, so that no shared filesystem is involved in the
+ * transfer. The sender passes the address of the \link
+ * tcmi_dataconn_class data connection \endlink instead of the
+ * checkpoint name, its token travels in the message too. Once the
+ * message is out and the migration manager connection unlocked, the
+ * sender accepts the connection from the PEN and creates the image
+ * directly into it. The
+ * guest fetches the image into an in-memory file in its own context,
+ * the receiving thread of the migration manager is never blocked by
+ * the transfer.
+ *
  * @{
  */
 
@@ -77,12 +94,27 @@ struct tcmi_p_emigrate_msg {
 		int16_t fsuid;
 		/** fsgid of the process on the core node.. may be needed for DFS mount before the checkpoint is read */
 		int16_t fsgid;
+		/** set when the checkpoint image follows the message */
+		int8_t streamed;
+		/** token of the data connection when streamed */
+		u_int8_t token[TCMI_DATACONN_TOKEN_SIZE];
 	} pid_and_size  __attribute__((__packed__));
 
 	/** name of the executable of the process. */
 	char *exec_name;
-	/** name of the checkpoint file. */
+	/** name of the checkpoint file, data connection address when streamed. */
 	char *ckpt_name;
+
+	/** registers of the process to be streamed (tx only) */
+	struct pt_regs *regs;
+	/** non-preemptive migration params of the streamed process or NULL (tx only) */
+	struct tcmi_npm_params *npm_params;
+	/** page hashes negotiated with the PEN or NULL (tx only) */
+	struct tcmi_ckpt_dedup *dedup;
+	/** restart readahead window in pages, 0 selects the default (tx only) */
+	int readahead;
+	/** data connection of the streamed checkpoint (tx only) */
+	struct tcmi_dataconn dataconn;
 };
 
 
@@ -95,12 +127,26 @@ extern struct tcmi_msg* tcmi_p_emigrate_msg_new_rx(u_int32_t msg_id);
 extern struct tcmi_msg* tcmi_p_emigrate_msg_new_tx(struct tcmi_slotvec *transactions, 
 						       pid_t reply_pid, char *exec_name, char *ckpt_name, int16_t euid, int16_t egid, int16_t fsuid, int16_t fsgid);
 
+/** \<\<public\>\> Phys. emigrate message constructor for transferring a streamed checkpoint. */
+extern struct tcmi_msg* tcmi_p_emigrate_msg_new_stream_tx(struct tcmi_slotvec *transactions, 
+							  struct kkc_sock *sock,
+							  pid_t reply_pid, char *exec_name, struct pt_regs *regs,
+							  struct tcmi_npm_params *npm_params,
+							  struct tcmi_ckpt_dedup *dedup, int readahead,
+							  int16_t euid, int16_t egid, int16_t fsuid, int16_t fsgid);
+
+
+/** \<\<public\>\> Fetches the streamed checkpoint image over the data connection. */
+extern struct file* tcmi_p_emigrate_msg_fetch_image(struct tcmi_p_emigrate_msg *self, u_int64_t owner);
+
 
 /** \<\<public\>\> Message descriptor for the factory class, there is no error
  * handling as this is the starting request */
 #define TCMI_P_EMIGRATE_MSG_DSC TCMI_MSG_DSC(TCMI_P_EMIGRATE_MSG_ID, tcmi_p_emigrate_msg_new_rx, NULL)
 /** Response time out is set to 10 seconds*/
 #define TCMI_P_EMIGRATE_MSGTIMEOUT (10*HZ)
+/** Streamed messages include the whole image transfer, so they get a minute */
+#define TCMI_P_EMIGRATE_STREAM_MSGTIMEOUT (60*HZ)
 
 /** Casts to the tcmi_p_emigrate_msg instance. */
 #define TCMI_P_EMIGRATE_MSG(m) ((struct tcmi_p_emigrate_msg*)m)
@@ -138,6 +184,17 @@ static inline char* tcmi_p_emigrate_msg_ckpt_name(struct tcmi_p_emigrate_msg *se
 	return self->ckpt_name;
 }
 
+/**
+ * \<\<public\>\> Streamed checkpoint flag accessor.
+ * 
+ * @param *self - this message instance
+ * @return 1 if the checkpoint image is streamed over a data connection
+ */
+static inline int tcmi_p_emigrate_msg_streamed(struct tcmi_p_emigrate_msg *self)
+{
+	return self->pid_and_size.streamed;
+}
+
 /**
  * \<\<public\>\> Fsuid accesses
  * 
@@ -185,12 +242,21 @@ static inline int16_t tcmi_p_emigrate_msg_egid(struct tcmi_p_emigrate_msg *self)
 /********************** PRIVATE METHODS AND DATA ******************************/
 #ifdef TCMI_P_EMIGRATE_MSG_PRIVATE
 
+/** Allocates and initializes the message for transferring. */
+static struct tcmi_p_emigrate_msg* tcmi_p_emigrate_msg_alloc_tx(struct tcmi_slotvec *transactions, 
+								pid_t reply_pid, char *exec_name, char *ckpt_name,
+								int16_t euid, int16_t egid, int16_t fsuid, int16_t fsgid,
+								int streamed);
+
 /** Receives the message via a specified connection. */
 static int tcmi_p_emigrate_msg_recv(struct tcmi_msg *self, struct kkc_sock *sock);
 
 /** Sends the message via a specified connection. */
 static int tcmi_p_emigrate_msg_send(struct tcmi_msg *self, struct kkc_sock *sock);
 
+/** Streams the checkpoint over the data connection once the message is sent. */
+static int tcmi_p_emigrate_msg_sent(struct tcmi_msg *self, struct kkc_sock *sock);
+
 /** Message operations that support polymorphism. */
 static struct tcmi_msg_ops p_emigrate_msg_ops;
 
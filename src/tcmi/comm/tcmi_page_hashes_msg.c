@@ -0,0 +1,234 @@
+/**
+ * @file tcmi_page_hashes_msg.c - page hashes offered to the PEN page cache
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+
+#include <tcmi/ckpt/tcmi_ckpt_dedup.h>
+
+#include "tcmi_transaction.h"
+
+#include "tcmi_page_hashes_resp_msg.h"
+#define TCMI_PAGE_HASHES_MSG_PRIVATE
+#include "tcmi_page_hashes_msg.h"
+
+#include <dbg.h>
+
+/** 
+ * \<\<public\>\> Message rx constructor.
+ * This method is called by the factory class.
+ *
+ * @param msg_id - message ID that will be used for this message
+ * instance.
+ * @return a new message or NULL.
+ */
+struct tcmi_msg* tcmi_page_hashes_msg_new_rx(u_int32_t msg_id)
+{
+	struct tcmi_page_hashes_msg *msg;
+
+	/* Check if the factory is building what it really thinks. */
+	if (msg_id != TCMI_PAGE_HASHES_MSG_ID) {
+		mdbg(ERR3, "Factory specified message ID(%x) doesn't match real ID(%x)",
+		     msg_id, TCMI_PAGE_HASHES_MSG_ID);
+		goto exit0;
+	}
+	/* Allocate the instance */
+	if (!(msg = TCMI_PAGE_HASHES_MSG(kmalloc(sizeof(struct tcmi_page_hashes_msg), GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate page hashes message");
+		goto exit0;
+	}
+	msg->count = 0;
+	msg->hashes = NULL;
+	msg->dedup = NULL;
+	/* Initialized the message for receiving. */
+	if (tcmi_msg_init_rx(TCMI_MSG(msg), TCMI_PAGE_HASHES_MSG_ID, &page_hashes_msg_ops)) {
+		mdbg(ERR3, "Error initializing page hashes message %x", msg_id);
+		goto exit1;
+	}
+
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+}
+
+/** 
+ * \<\<public\>\> Page hashes message tx constructor. The message
+ * references the hashes of the deduplication instance, no copy is
+ * made.
+ *
+ * Response message ID is TCMI_PAGE_HASHES_RESP_MSG_ID.
+ *
+ * @param *transactions - storage for the new transaction
+ * @param *dedup - hashes of the migrating process
+ * @return a new message ready for the transfer or NULL.
+ */
+struct tcmi_msg* tcmi_page_hashes_msg_new_tx(struct tcmi_slotvec *transactions, 
+					     struct tcmi_ckpt_dedup *dedup)
+{
+	struct tcmi_page_hashes_msg *msg;
+
+	if (!(msg = TCMI_PAGE_HASHES_MSG(kmalloc(sizeof(struct tcmi_page_hashes_msg), GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate page hashes message");
+		goto exit0;
+	}
+	msg->count = tcmi_ckpt_dedup_count(dedup);
+	msg->hashes = tcmi_ckpt_dedup_hashes(dedup);
+	msg->dedup = tcmi_ckpt_dedup_get(dedup);
+
+	/* Initialize the message for transfer */
+	if (tcmi_msg_init_tx(TCMI_MSG(msg), TCMI_PAGE_HASHES_MSG_ID, &page_hashes_msg_ops, 
+			     transactions, TCMI_PAGE_HASHES_RESP_MSG_ID,
+			     TCMI_PAGE_HASHES_MSGTIMEOUT, TCMI_TRANSACTION_INVAL_ID)) {
+		mdbg(ERR3, "Error initializing page hashes message");
+		goto exit1;
+	}
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	tcmi_ckpt_dedup_put(msg->dedup);
+	kfree(msg);
+ exit0:
+	return NULL;
+}
+
+
+/** @addtogroup tcmi_page_hashes_msg_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Receives the message via a specified connection. 
+ * The number of hashes is checked against a sane limit before the
+ * storage is allocated.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for receiving message data
+ * @return 0 when successfully received.
+ */
+static int tcmi_page_hashes_msg_recv(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct tcmi_page_hashes_msg *self_msg = TCMI_PAGE_HASHES_MSG(self);
+
+	if ((err = kkc_sock_recv(sock, &self_msg->count, 
+				 sizeof(self_msg->count), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive number of page hashes");
+		goto exit0;
+	}
+	if (!self_msg->count || self_msg->count > TCMI_PAGE_HASHES_MSG_MAX) {
+		mdbg(ERR3, "Invalid number of page hashes %u", self_msg->count);
+		err = -EINVAL;
+		goto exit0;
+	}
+	if (!(self_msg->hashes = vmalloc(self_msg->count * sizeof(struct tcmi_ckpt_page_hash)))) {
+		mdbg(ERR3, "Can't allocate memory for %u page hashes", self_msg->count);
+		err = -ENOMEM;
+		goto exit0;
+	}
+	if ((err = kkc_sock_recv(sock, self_msg->hashes, 
+				 self_msg->count * sizeof(struct tcmi_ckpt_page_hash), 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive page hashes");
+		goto exit0;
+	}
+	mdbg(INFO3, "Page hashes message received, %u hashes", self_msg->count);
+
+	return 0;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Sends the message via a specified connection. 
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for sending message data
+ * @return 0 when successfully sent.
+ */
+static int tcmi_page_hashes_msg_send(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct tcmi_page_hashes_msg *self_msg = TCMI_PAGE_HASHES_MSG(self);
+
+	if ((err = kkc_sock_send(sock, &self_msg->count, 
+				 sizeof(self_msg->count), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send number of page hashes");
+		goto exit0;
+	}
+	if ((err = kkc_sock_send(sock, self_msg->hashes, 
+				 self_msg->count * sizeof(struct tcmi_ckpt_page_hash), 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send page hashes");
+		goto exit0;
+	}
+	mdbg(INFO3, "Page hashes message sent, %u hashes", self_msg->count);
+
+	return 0;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Frees custom message resources. Received hashes
+ * are released, a sent message just drops its reference to the
+ * deduplication instance.
+ *
+ * @param *self - this message instance
+ */
+static void tcmi_page_hashes_msg_free(struct tcmi_msg *self)
+{
+	struct tcmi_page_hashes_msg *self_msg = TCMI_PAGE_HASHES_MSG(self);
+
+	if (self_msg->dedup)
+		tcmi_ckpt_dedup_put(self_msg->dedup);
+	else
+		vfree(self_msg->hashes);
+}
+
+
+/** Message operations that support polymorphism. */
+static struct tcmi_msg_ops page_hashes_msg_ops = {
+	.recv = tcmi_page_hashes_msg_recv,
+	.send = tcmi_page_hashes_msg_send,
+	.free = tcmi_page_hashes_msg_free
+};
+
+
+/**
+ * @}
+ */
@@ -0,0 +1,125 @@
+/**
+ * @file tcmi_page_hashes_msg.h - page hashes offered to the PEN page cache
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_PAGE_HASHES_MSG_H
+#define _TCMI_PAGE_HASHES_MSG_H
+
+#include "tcmi_msg.h"
+
+#include <tcmi/ckpt/tcmi_ckpt_pagecache.h>
+
+struct tcmi_ckpt_dedup;
+
+/** @defgroup tcmi_page_hashes_msg_class tcmi_page_hashes_msg class
+ *
+ * @ingroup tcmi_msg_class
+ *
+ * This message is sent by a migrating process to the PEN right
+ * before its checkpoint is streamed. It carries hashes of the
+ * process pages (see \link tcmi_ckpt_dedup_class page
+ * deduplication \endlink). The PEN pins the pages it has in its \link
+ * tcmi_ckpt_pagecache_class page cache \endlink and replies with
+ * \link tcmi_page_hashes_resp_msg_class TCMI_PAGE_HASHES_RESP_MSG
+ * \endlink, so that the pinned pages are sent only as references.
+ *
+ * @{
+ */
+
+/** Compound structure, inherits from tcmi_msg_class */
+struct tcmi_page_hashes_msg {
+	/** parent class instance. */
+	struct tcmi_msg super;
+	/** number of page hashes */
+	u_int32_t count;
+	/** page hashes */
+	struct tcmi_ckpt_page_hash *hashes;
+	/** hashes of the migrating process, owns the hashes (tx only) */
+	struct tcmi_ckpt_dedup *dedup;
+};
+
+/** \<\<public\>\> Page hashes message constructor for receiving. */
+extern struct tcmi_msg* tcmi_page_hashes_msg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Page hashes message constructor for transferring. */
+extern struct tcmi_msg* tcmi_page_hashes_msg_new_tx(struct tcmi_slotvec *transactions, 
+						    struct tcmi_ckpt_dedup *dedup);
+
+/** \<\<public\>\> Message descriptor for the factory class, there is no error
+ * handling as this is the starting request */
+#define TCMI_PAGE_HASHES_MSG_DSC TCMI_MSG_DSC(TCMI_PAGE_HASHES_MSG_ID, tcmi_page_hashes_msg_new_rx, NULL)
+/** Response time out is set to 10 seconds */
+#define TCMI_PAGE_HASHES_MSGTIMEOUT (10*HZ)
+/** Upper bound of hashes accepted in a single message */
+#define TCMI_PAGE_HASHES_MSG_MAX (1 << 20)
+
+/** Casts to the tcmi_page_hashes_msg instance. */
+#define TCMI_PAGE_HASHES_MSG(m) ((struct tcmi_page_hashes_msg*)m)
+
+/**
+ * \<\<public\>\> Number of hashes accessor.
+ * 
+ * @param *self - this message instance
+ * @return number of page hashes
+ */
+static inline u_int32_t tcmi_page_hashes_msg_count(struct tcmi_page_hashes_msg *self)
+{
+	return self->count;
+}
+
+/**
+ * \<\<public\>\> Page hashes accessor.
+ * 
+ * @param *self - this message instance
+ * @return array of page hashes
+ */
+static inline struct tcmi_ckpt_page_hash* tcmi_page_hashes_msg_hashes(struct tcmi_page_hashes_msg *self)
+{
+	return self->hashes;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_PAGE_HASHES_MSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_page_hashes_msg_recv(struct tcmi_msg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_page_hashes_msg_send(struct tcmi_msg *self, struct kkc_sock *sock);
+
+/** Frees custom message resources. */
+static void tcmi_page_hashes_msg_free(struct tcmi_msg *self);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_msg_ops page_hashes_msg_ops;
+
+#endif /* TCMI_PAGE_HASHES_MSG_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_PAGE_HASHES_MSG_H */
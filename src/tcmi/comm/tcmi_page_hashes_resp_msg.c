@@ -0,0 +1,224 @@
+/**
+ * @file tcmi_page_hashes_resp_msg.c - pages of the PEN page cache pinned for a migration
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+
+#include <tcmi/ckpt/tcmi_ckpt_pagecache.h>
+
+#include "tcmi_page_hashes_msg.h"
+#define TCMI_PAGE_HASHES_RESP_MSG_PRIVATE
+#include "tcmi_page_hashes_resp_msg.h"
+
+#include <dbg.h>
+
+/** 
+ * \<\<public\>\> Message rx constructor.
+ * This method is called by the factory class.
+ *
+ * @param msg_id - message ID that will be used for this message
+ * instance.
+ * @return a new message or NULL.
+ */
+struct tcmi_msg* tcmi_page_hashes_resp_msg_new_rx(u_int32_t msg_id)
+{
+	struct tcmi_page_hashes_resp_msg *msg;
+
+	/* Check if the factory is building what it really thinks. */
+	if (msg_id != TCMI_PAGE_HASHES_RESP_MSG_ID) {
+		mdbg(ERR3, "Factory specified message ID(%x) doesn't match real ID(%x)",
+		     msg_id, TCMI_PAGE_HASHES_RESP_MSG_ID);
+		goto exit0;
+	}
+	if (!(msg = TCMI_PAGE_HASHES_RESP_MSG(kmalloc(sizeof(struct tcmi_page_hashes_resp_msg), 
+						       GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate page hashes response message");
+		goto exit0;
+	}
+	msg->known = NULL;
+	/* Initialized the message for receiving, message ID is extended with error flags */
+	if (tcmi_msg_init_rx(TCMI_MSG(msg), TCMI_PAGE_HASHES_RESP_MSG_ID, &page_hashes_resp_msg_ops)) {
+		mdbg(ERR3, "Error initializing page hashes response message %x", msg_id);
+		goto exit1;
+	}
+
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+}
+
+/** 
+ * \<\<public\>\> Page hashes response message tx constructor. The
+ * message takes over the bitmap.
+ *
+ * @param trans_id - transaction ID that this message is replying to.
+ * @param session - page cache session ID
+ * @param count - number of hashes the bitmap describes
+ * @param *known - vmalloc'ed bitmap of known pages
+ * @return a new message for the transfer or NULL.
+ */
+struct tcmi_msg* tcmi_page_hashes_resp_msg_new_tx(u_int32_t trans_id, u_int32_t session,
+						  u_int32_t count, u_int8_t *known)
+{
+	struct tcmi_page_hashes_resp_msg *msg;
+
+	if (!(msg = TCMI_PAGE_HASHES_RESP_MSG(kmalloc(sizeof(struct tcmi_page_hashes_resp_msg), 
+						       GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate page hashes response message");
+		goto exit0;
+	}
+	msg->hdr.session = session;
+	msg->hdr.count = count;
+	msg->known = known;
+
+	if (tcmi_msg_init_tx(TCMI_MSG(msg), TCMI_PAGE_HASHES_RESP_MSG_ID, &page_hashes_resp_msg_ops, 
+			     NULL, 0, 0, trans_id)) {
+		mdbg(ERR3, "Error initializing page hashes response message");
+		goto exit1;
+	}
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	vfree(known);
+	return NULL;
+}
+
+
+/** @addtogroup tcmi_page_hashes_resp_msg_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Receives the message via a specified connection. 
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for receiving message data
+ * @return 0 when successfully received.
+ */
+static int tcmi_page_hashes_resp_msg_recv(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct tcmi_page_hashes_resp_msg *self_msg = TCMI_PAGE_HASHES_RESP_MSG(self);
+
+	if ((err = kkc_sock_recv(sock, &self_msg->hdr, 
+				 sizeof(self_msg->hdr), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive page cache session");
+		goto exit0;
+	}
+	if (self_msg->hdr.count > TCMI_PAGE_HASHES_MSG_MAX) {
+		mdbg(ERR3, "Invalid number of page hashes %u", self_msg->hdr.count);
+		err = -EINVAL;
+		goto exit0;
+	}
+	if (!self_msg->hdr.count)
+		return 0;
+	if (!(self_msg->known = vmalloc(tcmi_ckpt_pagecache_bitmap_size(self_msg->hdr.count)))) {
+		mdbg(ERR3, "Can't allocate memory for known pages bitmap");
+		err = -ENOMEM;
+		goto exit0;
+	}
+	if ((err = kkc_sock_recv(sock, self_msg->known, 
+				 tcmi_ckpt_pagecache_bitmap_size(self_msg->hdr.count), 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive known pages bitmap");
+		goto exit0;
+	}
+	mdbg(INFO3, "Page hashes response received, session %u", self_msg->hdr.session);
+
+	return 0;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Sends the message via a specified connection. 
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for sending message data
+ * @return 0 when successfully sent.
+ */
+static int tcmi_page_hashes_resp_msg_send(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct tcmi_page_hashes_resp_msg *self_msg = TCMI_PAGE_HASHES_RESP_MSG(self);
+
+	if ((err = kkc_sock_send(sock, &self_msg->hdr, 
+				 sizeof(self_msg->hdr), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send page cache session");
+		goto exit0;
+	}
+	if (self_msg->hdr.count &&
+	    (err = kkc_sock_send(sock, self_msg->known, 
+				 tcmi_ckpt_pagecache_bitmap_size(self_msg->hdr.count), 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send known pages bitmap");
+		goto exit0;
+	}
+
+	return 0;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Frees custom message resources.
+ * The bitmap is released unless somebody has taken it over.
+ *
+ * @param *self - this message instance
+ */
+static void tcmi_page_hashes_resp_msg_free(struct tcmi_msg *self)
+{
+	struct tcmi_page_hashes_resp_msg *self_msg = TCMI_PAGE_HASHES_RESP_MSG(self);
+
+	vfree(self_msg->known);
+}
+
+
+/** Message operations that support polymorphism. */
+static struct tcmi_msg_ops page_hashes_resp_msg_ops = {
+	.recv = tcmi_page_hashes_resp_msg_recv,
+	.send = tcmi_page_hashes_resp_msg_send,
+	.free = tcmi_page_hashes_resp_msg_free
+};
+
+
+/**
+ * @}
+ */
@@ -0,0 +1,132 @@
+/**
+ * @file tcmi_page_hashes_resp_msg.h - pages of the PEN page cache pinned for a migration
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_PAGE_HASHES_RESP_MSG_H
+#define _TCMI_PAGE_HASHES_RESP_MSG_H
+
+#include "tcmi_msg.h"
+#include "tcmi_err_msg.h"
+
+/** @defgroup tcmi_page_hashes_resp_msg_class tcmi_page_hashes_resp_msg class
+ *
+ * @ingroup tcmi_msg_class
+ *
+ * This message is a response to \link tcmi_page_hashes_msg_class
+ * TCMI_PAGE_HASHES_MSG \endlink. It carries ID of the \link
+ * tcmi_ckpt_pagecache_class page cache \endlink session that pins
+ * the pages and a bitmap of the offered hashes, whose pages the PEN
+ * already has. Bit 'i' of the bitmap is stored in byte 'i / 8'.
+ *
+ * @{
+ */
+
+/** Compound structure, inherits from tcmi_msg_class */
+struct tcmi_page_hashes_resp_msg {
+	/** parent class instance. */
+	struct tcmi_msg super;
+	/** groups the session ID and count, so they can be sent at once */
+	struct {
+		/** page cache session ID, 0 when no page is known */
+		u_int32_t session;
+		/** number of hashes the bitmap describes */
+		u_int32_t count;
+	} hdr __attribute__((__packed__));
+	/** bitmap of known pages */
+	u_int8_t *known;
+};
+
+/** \<\<public\>\> Page hashes response message constructor for receiving. */
+extern struct tcmi_msg* tcmi_page_hashes_resp_msg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Page hashes response message constructor for transferring. */
+extern struct tcmi_msg* tcmi_page_hashes_resp_msg_new_tx(u_int32_t trans_id, u_int32_t session,
+							 u_int32_t count, u_int8_t *known);
+
+/** \<\<public\>\> Message descriptor for the factory class */
+#define TCMI_PAGE_HASHES_RESP_MSG_DSC TCMI_MSG_DSC(TCMI_PAGE_HASHES_RESP_MSG_ID, tcmi_page_hashes_resp_msg_new_rx, tcmi_err_msg_new_rx)
+
+/** Casts to the tcmi_page_hashes_resp_msg instance. */
+#define TCMI_PAGE_HASHES_RESP_MSG(m) ((struct tcmi_page_hashes_resp_msg*)m)
+
+/**
+ * \<\<public\>\> Session ID accessor.
+ * 
+ * @param *self - this message instance
+ * @return page cache session ID
+ */
+static inline u_int32_t tcmi_page_hashes_resp_msg_session(struct tcmi_page_hashes_resp_msg *self)
+{
+	return self->hdr.session;
+}
+
+/**
+ * \<\<public\>\> Number of described hashes accessor.
+ * 
+ * @param *self - this message instance
+ * @return number of hashes
+ */
+static inline u_int32_t tcmi_page_hashes_resp_msg_count(struct tcmi_page_hashes_resp_msg *self)
+{
+	return self->hdr.count;
+}
+
+/**
+ * \<\<public\>\> Takes over the bitmap of known pages. The caller is
+ * responsible for releasing it by vfree().
+ * 
+ * @param *self - this message instance
+ * @return bitmap of known pages
+ */
+static inline u_int8_t* tcmi_page_hashes_resp_msg_take_known(struct tcmi_page_hashes_resp_msg *self)
+{
+	u_int8_t *known = self->known;
+	self->known = NULL;
+	return known;
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_PAGE_HASHES_RESP_MSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_page_hashes_resp_msg_recv(struct tcmi_msg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_page_hashes_resp_msg_send(struct tcmi_msg *self, struct kkc_sock *sock);
+
+/** Frees custom message resources. */
+static void tcmi_page_hashes_resp_msg_free(struct tcmi_msg *self);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_msg_ops page_hashes_resp_msg_ops;
+
+#endif /* TCMI_PAGE_HASHES_RESP_MSG_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_PAGE_HASHES_RESP_MSG_H */
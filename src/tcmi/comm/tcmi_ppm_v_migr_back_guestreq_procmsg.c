@@ -0,0 +1,315 @@
+/**
+ * @file tcmi_ppm_v_migr_back_guestreq_procmsg.c - in-memory migrate back request
+ *                                                 initiated by guest
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <linux/slab.h>
+#include <linux/file.h>
+
+#include <tcmi/ckpt/tcmi_ckpt_stream.h>
+
+#include "tcmi_transaction.h"
+
+#define TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_PRIVATE
+#include "tcmi_ppm_v_migr_back_guestreq_procmsg.h"
+
+
+#include <dbg.h>
+
+
+
+/** 
+ * \<\<public\>\> PPM_V message rx constructor.
+ * This method is called by the factory class.
+ *
+ * @param msg_id - message ID that will be used for this message
+ * instance.
+ * @return a new message or NULL.
+ */
+struct tcmi_msg* tcmi_ppm_v_migr_back_guestreq_procmsg_new_rx(u_int32_t msg_id)
+{
+	struct tcmi_ppm_v_migr_back_guestreq_procmsg *msg;
+
+	/* Check if the factory is building what it really thinks. */
+	if (msg_id != TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_ID) {
+		mdbg(ERR3, "Factory specified message ID(%x) doesn't match real ID(%x)",
+		     msg_id, TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_ID);
+		goto exit0;
+	}
+	/* Allocate the instance */
+	if (!(msg = TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(kmalloc(sizeof(struct tcmi_ppm_v_migr_back_guestreq_procmsg), 
+								 GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate migrate back guest request message");
+		goto exit0;
+	}
+	msg->addr = NULL;
+	msg->image = NULL;
+	tcmi_dataconn_init(&msg->dataconn);
+	/* Initialize the message for receiving. */
+	if (tcmi_procmsg_init_rx(TCMI_PROCMSG(msg), TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_ID, 
+				 &ppm_v_migr_back_guestreq_procmsg_ops)) {
+		mdbg(ERR3, "Error initializing migrate back guest request message %x", msg_id);
+		goto exit1;
+	}
+
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+}
+
+/** 
+ * \<\<public\>\> Guest request for in-memory migration back tx
+ * constructor.
+ *
+ * Generates a one-way request message that announces a data
+ * connection, the specified checkpoint image is streamed over it once
+ * the message has been sent. The message holds its own reference to
+ * the image until it is released.
+ *
+ * @param dst_pid - PID of the target process that will receive this message
+ * @param *image - in-memory checkpoint image positioned at its start
+ * @param *sock - connection the message is sent through, the data
+ * connection listens on its local address
+ * @return a new message ready for the transfer or NULL.
+ */
+struct tcmi_msg* tcmi_ppm_v_migr_back_guestreq_procmsg_new_tx(pid_t dst_pid, struct file *image,
+								     struct kkc_sock *sock)
+{
+	struct tcmi_ppm_v_migr_back_guestreq_procmsg *msg;
+
+	if (!(msg = TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(kmalloc(sizeof(struct tcmi_ppm_v_migr_back_guestreq_procmsg), 
+								 GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't create migrate back guest request message");
+		goto exit0;
+	}
+	msg->addr = NULL;
+	if (tcmi_dataconn_listen(&msg->dataconn, sock) < 0)
+		goto exit1;
+	msg->conn.addr_size = strlen(msg->dataconn.addr) + 1;
+	memcpy(msg->conn.token, msg->dataconn.token, TCMI_DATACONN_TOKEN_SIZE);
+	msg->image = get_file(image);
+
+	/* Initialize the message for transfer, no transaction
+	 * required, no timout, no response ID */
+	if (tcmi_procmsg_init_tx(TCMI_PROCMSG(msg), TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_ID,
+				 &ppm_v_migr_back_guestreq_procmsg_ops,
+				 dst_pid, 0,
+				 NULL, 0, 0, TCMI_TRANSACTION_INVAL_ID)) {
+		mdbg(ERR3, "Error initializing migrate back guest request message");
+		goto exit2;
+	}
+
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit2:
+	fput(msg->image);
+	tcmi_dataconn_close(&msg->dataconn);
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+}
+
+/** 
+ * \<\<public\>\> Fetches the checkpoint image. Connects to the data
+ * connection announced by the guest, presents its token and spools
+ * the image into an in-memory file. This is called by the shadow in
+ * its own context, so the transfer doesn't hold up the receiving
+ * thread of the migration manager.
+ *
+ * @param *self - this message instance
+ * @return file with the image or an error pointer, -ENOEXEC when the
+ * guest has aborted the transfer
+ */
+struct file* tcmi_ppm_v_migr_back_guestreq_procmsg_fetch_image(struct tcmi_ppm_v_migr_back_guestreq_procmsg *self)
+{
+	struct kkc_sock *data_sock;
+	struct file *image;
+
+	if (IS_ERR(data_sock = tcmi_dataconn_connect(self->addr, self->conn.token)))
+		return ERR_CAST(data_sock);
+	if (IS_ERR(image = tcmi_ckpt_stream_recv(data_sock, 0)))
+		mdbg(ERR3, "Failed to receive checkpoint image: %ld", PTR_ERR(image));
+	kkc_sock_put(data_sock);
+
+	return image;
+}
+
+
+/** @addtogroup tcmi_ppm_v_migr_back_guestreq_procmsg_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Receives the message via a specified connection.
+ * Only the data connection is received here, the shadow fetches the
+ * image later on.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for receiving message data
+ * @return 0 when successfully received.
+ */
+static int tcmi_ppm_v_migr_back_guestreq_procmsg_recv(struct tcmi_procmsg *self, struct kkc_sock *sock)
+{
+	int err = -EINVAL;
+	struct tcmi_ppm_v_migr_back_guestreq_procmsg *self_msg = TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(self);
+
+	if ((err = kkc_sock_recv(sock, &self_msg->conn, sizeof(self_msg->conn), 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive data connection size and token");
+		goto exit0;
+	}
+	if (self_msg->conn.addr_size <= 0 || 
+	    self_msg->conn.addr_size > TCMI_DATACONN_ADDR_LENGTH) {
+		mdbg(ERR3, "Invalid data connection address size %d", self_msg->conn.addr_size);
+		err = -EINVAL;
+		goto exit0;
+	}
+	if (!(self_msg->addr = (char*)kmalloc(self_msg->conn.addr_size, GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate memory for data connection address");
+		err = -ENOMEM;
+		goto exit0;
+	}
+	if ((err = kkc_sock_recv(sock, self_msg->addr, self_msg->conn.addr_size, 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive data connection address");
+		goto exit0;
+	}
+	self_msg->addr[self_msg->conn.addr_size - 1] = '\0';
+	mdbg(INFO2, "PPM_V migrate back guest request received guest PID=%d, data connection: '%s'",
+	     tcmi_procmsg_dst_pid(self), self_msg->addr);
+
+	return 0;
+	/* error handling*/
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Sends the PPM_V migrate back guest request - the
+ * address and token of the data connection.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for sending message data
+ * @return 0 when successfully sent.
+ */
+static int tcmi_ppm_v_migr_back_guestreq_procmsg_send(struct tcmi_procmsg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct tcmi_ppm_v_migr_back_guestreq_procmsg *self_msg = TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(self);
+
+	if ((err = kkc_sock_send(sock, &self_msg->conn, sizeof(self_msg->conn), 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send data connection size and token");
+		goto exit0;
+	}
+	if ((err = kkc_sock_send(sock, self_msg->dataconn.addr, self_msg->conn.addr_size, 
+				 KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send data connection address");
+		goto exit0;
+	}
+	mdbg(INFO2, "PPM_V migrate back guest request sent guest PID=%d, data connection: '%s'",
+	     tcmi_procmsg_dst_pid(self), self_msg->dataconn.addr);
+
+	return 0;
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Streams the checkpoint image over the data
+ * connection. Called after the message has been sent, the migration
+ * manager connection is not locked anymore. There is no transaction
+ * to watch, the guest waits for the shadow at most
+ * TCMI_PPM_V_MIGR_BACK_FETCH_TIMEOUT.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket the message has been sent through
+ * @return 0 when the image has been transferred
+ */
+static int tcmi_ppm_v_migr_back_guestreq_procmsg_sent(struct tcmi_procmsg *self, struct kkc_sock *sock)
+{
+	int err;
+	struct kkc_sock *data_sock;
+	struct tcmi_ppm_v_migr_back_guestreq_procmsg *self_msg = TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(self);
+
+	if (IS_ERR(data_sock = tcmi_dataconn_accept(&self_msg->dataconn, sock, NULL,
+						    TCMI_PPM_V_MIGR_BACK_FETCH_TIMEOUT)))
+		return PTR_ERR(data_sock);
+	/* nobody else is going to connect */
+	tcmi_dataconn_close(&self_msg->dataconn);
+
+	if ((err = tcmi_ckpt_stream_send_file(data_sock, self_msg->image)) < 0) {
+		mdbg(ERR3, "Failed to stream the checkpoint image: %d", err);
+		goto exit0;
+	}
+	mdbg(INFO2, "PPM_V checkpoint image transferred guest PID=%d via '%s'",
+	     tcmi_procmsg_dst_pid(self), kkc_sock_getsockname2(data_sock));
+	/* error handling */
+ exit0:
+	kkc_sock_put(data_sock);
+	return err;
+}
+
+/**
+ * \<\<private\>\> Frees custom message resources.
+ * The reference to the checkpoint image is dropped, an in-memory
+ * image is released once nobody else holds it.
+ *
+ * @param *self - this message instance
+ */
+static void tcmi_ppm_v_migr_back_guestreq_procmsg_free(struct tcmi_procmsg *self)
+{
+	struct tcmi_ppm_v_migr_back_guestreq_procmsg *self_msg = TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(self);
+
+	mdbg(INFO3, "Freeing PPM_V guest migrate back message PID=%d, image: %p",
+	     tcmi_procmsg_dst_pid(TCMI_PROCMSG(self)), self_msg->image);
+	if (self_msg->image)
+		fput(self_msg->image);
+	kfree(self_msg->addr);
+	tcmi_dataconn_close(&self_msg->dataconn);
+}
+
+
+/** Message operations that support polymorphism. */
+static struct tcmi_procmsg_ops ppm_v_migr_back_guestreq_procmsg_ops = {
+	.recv = tcmi_ppm_v_migr_back_guestreq_procmsg_recv,
+	.send = tcmi_ppm_v_migr_back_guestreq_procmsg_send,
+	.sent = tcmi_ppm_v_migr_back_guestreq_procmsg_sent,
+	.free = tcmi_ppm_v_migr_back_guestreq_procmsg_free
+};
+
+
+/**
+ * @}
+ */
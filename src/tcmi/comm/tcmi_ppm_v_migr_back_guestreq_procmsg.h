@@ -0,0 +1,131 @@
+/**
+ * @file tcmi_ppm_v_migr_back_guestreq_procmsg.h - in-memory migrate back request
+ *                                                 initiated by guest
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_H
+#define _TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_H
+
+#include <linux/fs.h>
+
+#include "tcmi_procmsg.h"
+#include "tcmi_err_procmsg.h"
+#include "tcmi_dataconn.h"
+
+/** @defgroup tcmi_ppm_v_migr_back_guestreq_procmsg_class tcmi_ppm_v_migr_back_guestreq_procmsg class
+ *
+ * @ingroup tcmi_procmsg_class
+ *
+ * This class represents a message that is sent by guest task to the
+ * shadow task as a request to migrate the process back to CCN using
+ * a virtual (in-memory) checkpoint image.
+ *
+ * Unlike \link tcmi_ppm_p_migr_back_guestreq_procmsg_class its
+ * physical counterpart \endlink, the message doesn't carry a
+ * checkpoint name. The image is created in kernel memory by the guest,
+ * the message carries the address and token of a \link
+ * tcmi_dataconn_class data connection \endlink instead. Once the
+ * message is out and the migration manager connection unlocked, the
+ * guest accepts the connection from the shadow and streams the image
+ * over it (see \link tcmi_ckpt_stream_class checkpoint stream
+ * \endlink). The shadow fetches the image into an in-memory file in
+ * its own context and restarts from it, so no filesystem is touched
+ * on either side and neither the send lock nor the receiving thread
+ * of the migration manager is held by the transfer.
+ *
+ * @{
+ */
+
+/** Compound structure, inherits from tcmi_procmsg_class */
+struct tcmi_ppm_v_migr_back_guestreq_procmsg {
+	/** parent class instance */
+	struct tcmi_procmsg super;
+	/** groups the address size and the token, so they can be
+	 * sent/received at once */
+	struct {
+		/** size of the data connection address in bytes
+		 * (including trailing zero) */
+		int32_t addr_size;
+		/** token of the data connection */
+		u_int8_t token[TCMI_DATACONN_TOKEN_SIZE];
+	} conn __attribute__((__packed__));
+	/** address of the data connection */
+	char *addr;
+	/** checkpoint image being sent (tx only) */
+	struct file *image;
+	/** data connection of the image (tx only) */
+	struct tcmi_dataconn dataconn;
+};
+
+/** How long the guest waits for the shadow to fetch the image */
+#define TCMI_PPM_V_MIGR_BACK_FETCH_TIMEOUT (60*HZ)
+
+
+/** \<\<public\>\> Guest request for in-memory migration back rx constructor. */
+extern struct tcmi_msg* tcmi_ppm_v_migr_back_guestreq_procmsg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Guest request for in-memory migration back tx constructor. */
+extern struct tcmi_msg* tcmi_ppm_v_migr_back_guestreq_procmsg_new_tx(pid_t dst_pid, struct file *image,
+								     struct kkc_sock *sock);
+
+/** \<\<public\>\> Fetches the checkpoint image over the data connection. */
+extern struct file* tcmi_ppm_v_migr_back_guestreq_procmsg_fetch_image(struct tcmi_ppm_v_migr_back_guestreq_procmsg *self);
+
+
+/** Message descriptor for the factory class, for error handling we used tcmi_errmsg_class */
+#define TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_DSC \
+TCMI_MSG_DSC(TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_ID, tcmi_ppm_v_migr_back_guestreq_procmsg_new_rx, tcmi_err_procmsg_new_rx)
+
+/** Casts to the tcmi_ppm_v_migr_back_guestreq_procmsg instance. */
+#define TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(m) ((struct tcmi_ppm_v_migr_back_guestreq_procmsg*)m)
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_ppm_v_migr_back_guestreq_procmsg_recv(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_ppm_v_migr_back_guestreq_procmsg_send(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Streams the image over the data connection once the message has been sent. */
+static int tcmi_ppm_v_migr_back_guestreq_procmsg_sent(struct tcmi_procmsg *self, struct kkc_sock *sock);
+
+/** Frees custom message resources. */
+static void tcmi_ppm_v_migr_back_guestreq_procmsg_free(struct tcmi_procmsg *self);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_procmsg_ops ppm_v_migr_back_guestreq_procmsg_ops;
+
+#endif /* TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_PRIVATE */
+
+
+/**
+ * @}
+ */
+
+
+#endif /* _TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_H */
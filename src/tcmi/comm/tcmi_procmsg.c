@@ -175,6 +175,25 @@ static int tcmi_procmsg_send(struct tcmi_msg *self, struct kkc_sock *sock)
 	return err;
 }
 
+/**
+ * \<\<private\>\> Transfers follow-up data once the message has
+ * been sent. Delegated to a specific process message method if it
+ * has any.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket the message has been sent through
+ * @return 0 when successfully transferred.
+ */
+static int tcmi_procmsg_sent(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	struct tcmi_procmsg *self_proc = TCMI_PROCMSG(self);
+	struct tcmi_procmsg_ops *ops = self_proc->msg_ops;
+
+	if (ops && ops->sent)
+		return ops->sent(self_proc, sock);
+	return 0;
+}
+
 /**
  * \<\<private\>\> Frees custom message resources
  * All work is delegated to a specific process message method
@@ -196,6 +215,7 @@ static void tcmi_procmsg_free(struct tcmi_msg *self)
 static struct tcmi_msg_ops procmsg_ops = {
 	.recv = tcmi_procmsg_recv,
 	.send = tcmi_procmsg_send,
+	.sent = tcmi_procmsg_sent,
 	.free = tcmi_procmsg_free
 };
 
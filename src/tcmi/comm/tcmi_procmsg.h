@@ -69,6 +69,9 @@ struct tcmi_procmsg_ops {
 	int (*recv)(struct tcmi_procmsg*, struct kkc_sock*);
 	/** Sends the message via a specified connection. */
 	int (*send)(struct tcmi_procmsg*, struct kkc_sock*);
+	/** Optional, called once the message has been sent and the
+	 * connection unlocked. */
+	int (*sent)(struct tcmi_procmsg*, struct kkc_sock*);
 	/** Frees custom message resources. The destruction of the
 	 * actual message instance is handled internally by this
 	 * class */
@@ -124,6 +127,9 @@ static int tcmi_procmsg_recv(struct tcmi_msg *self, struct kkc_sock *sock);
 /** Sends the process message via a specified connection. */
 static int tcmi_procmsg_send(struct tcmi_msg *self, struct kkc_sock *sock);
 
+/** Transfers follow-up data of the process message. */
+static int tcmi_procmsg_sent(struct tcmi_msg *self, struct kkc_sock *sock);
+
 /** Frees process message resources. */
 static void tcmi_procmsg_free(struct tcmi_msg *self);
 
@@ -0,0 +1,228 @@
+/**
+ * @file tcmi_sigset_msg.c - standard signals forwarded to a guest at once
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <linux/slab.h>
+
+#include "tcmi_transaction.h"
+
+#define TCMI_SIGSET_MSG_PRIVATE
+#include "tcmi_sigset_msg.h"
+
+
+#include <dbg.h>
+
+
+
+/**
+ * \<\<public\>\> Signal set message rx constructor.
+ * This method is called by the factory class.
+ *
+ * @param msg_id - message ID - used for verification
+ * @return a new signal set message or NULL.
+ */
+struct tcmi_msg* tcmi_sigset_msg_new_rx(u_int32_t msg_id)
+{
+	struct tcmi_sigset_msg *msg;
+
+	/* Check if the factory is building what it really thinks. */
+	if (msg_id != TCMI_SIGSET_MSG_ID) {
+		mdbg(ERR3, "Factory specified message ID(%x) doesn't match real ID(%x)",
+		     msg_id, TCMI_SIGSET_MSG_ID);
+		goto exit0;
+	}
+	/* Allocate the instance */
+	if (!(msg = TCMI_SIGSET_MSG(kmalloc(sizeof(struct tcmi_sigset_msg), GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate signal set message");
+		goto exit0;
+	}
+	/* Initialized the message for receiving. */
+	if (tcmi_msg_init_rx(TCMI_MSG(msg), TCMI_SIGSET_MSG_ID, &sigset_msg_ops)) {
+		mdbg(ERR3, "Error initializing signal set message %x", msg_id);
+		goto exit1;
+	}
+
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+}
+
+/**
+ * \<\<public\>\> Signal set message tx constructor. The set is
+ * empty, signals are added by tcmi_sigset_msg_add().
+ *
+ * The message is one-way, no transaction is associated with it.
+ *
+ * @param pid - PID of the guest the signals are for
+ * @return a new message ready for the transfer or NULL.
+ */
+struct tcmi_msg* tcmi_sigset_msg_new_tx(pid_t pid)
+{
+	struct tcmi_sigset_msg *msg;
+
+	if (!(msg = TCMI_SIGSET_MSG(kmalloc(sizeof(struct tcmi_sigset_msg), GFP_KERNEL)))) {
+		mdbg(ERR3, "Can't allocate signal set message");
+		goto exit0;
+	}
+
+	/* Initialize the message for transfer */
+	if (tcmi_msg_init_tx(TCMI_MSG(msg), TCMI_SIGSET_MSG_ID, &sigset_msg_ops,
+			     NULL, 0,
+			     TCMI_SIGSET_MSGTIMEOUT, TCMI_TRANSACTION_INVAL_ID)) {
+		mdbg(ERR3, "Error initializing signal set message");
+		goto exit1;
+	}
+	msg->pid = pid;
+	msg->mask = 0;
+	return TCMI_MSG(msg);
+
+	/* error handling */
+ exit1:
+	kfree(msg);
+ exit0:
+	return NULL;
+
+}
+
+/**
+ * \<\<public\>\> Adds a standard signal to the set. A signal that is
+ * in the set already keeps its original siginfo, the same way the
+ * kernel drops a standard signal that is already pending.
+ *
+ * @param *self - this message instance
+ * @param *info - info of the signal
+ * @return 1 if the signal has been added, 0 if it has been merged
+ * with the pending one, -EINVAL for a real-time signal
+ */
+int tcmi_sigset_msg_add(struct tcmi_sigset_msg *self, siginfo_t *info)
+{
+	int sig = info->si_signo;
+
+	if (!TCMI_SIGSET_STANDARD(sig))
+		return -EINVAL;
+	if (tcmi_sigset_msg_has(self, sig))
+		return 0;
+	self->mask |= 1U << (sig - 1);
+	memcpy(&self->info[sig - 1], info, sizeof(siginfo_t));
+	return 1;
+}
+
+
+/** @addtogroup tcmi_sigset_msg_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<private\>\> Receives the message via a specified connection.
+ * The siginfo follows for each signal present in the set.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for receiving message data
+ * @return 0 when successfully received.
+ */
+static int tcmi_sigset_msg_recv(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	struct tcmi_sigset_msg *self_msg = TCMI_SIGSET_MSG(self);
+	int err, sig;
+
+	if ((err = kkc_sock_recv(sock, &self_msg->pid,
+				 sizeof(self_msg->pid) + sizeof(self_msg->mask), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to receive signal set");
+		goto exit0;
+	}
+	if (self_msg->mask >> TCMI_SIGSET_MAX) {
+		mdbg(ERR3, "Invalid signal set %x", self_msg->mask);
+		err = -EINVAL;
+		goto exit0;
+	}
+	for (sig = 1; sig <= TCMI_SIGSET_MAX; sig++) {
+		if (!tcmi_sigset_msg_has(self_msg, sig))
+			continue;
+		if ((err = kkc_sock_recv(sock, tcmi_sigset_msg_info(self_msg, sig),
+					 sizeof(siginfo_t), KKC_SOCK_BLOCK)) < 0) {
+			mdbg(ERR3, "Failed to receive info of signal %d", sig);
+			goto exit0;
+		}
+	}
+	mdbg(INFO2, "Signal set %x received for PID %d", self_msg->mask, self_msg->pid);
+
+	return 0;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/**
+ * \<\<private\>\> Sends the message via a specified connection.
+ *
+ * @param *self - this message instance
+ * @param *sock - KKC socket used for sending message data
+ * @return 0 when successfully sent.
+ */
+static int tcmi_sigset_msg_send(struct tcmi_msg *self, struct kkc_sock *sock)
+{
+	struct tcmi_sigset_msg *self_msg = TCMI_SIGSET_MSG(self);
+	int err, sig;
+
+	if ((err = kkc_sock_send(sock, &self_msg->pid,
+				 sizeof(self_msg->pid) + sizeof(self_msg->mask), KKC_SOCK_BLOCK)) < 0) {
+		mdbg(ERR3, "Failed to send signal set");
+		goto exit0;
+	}
+	for (sig = 1; sig <= TCMI_SIGSET_MAX; sig++) {
+		if (!tcmi_sigset_msg_has(self_msg, sig))
+			continue;
+		if ((err = kkc_sock_send(sock, tcmi_sigset_msg_info(self_msg, sig),
+					 sizeof(siginfo_t), KKC_SOCK_BLOCK)) < 0) {
+			mdbg(ERR3, "Failed to send info of signal %d", sig);
+			goto exit0;
+		}
+	}
+	mdbg(INFO2, "Signal set %x sent to PID %d", self_msg->mask, self_msg->pid);
+
+	return 0;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
+/** Message operations that support polymorphism. */
+static struct tcmi_msg_ops sigset_msg_ops = {
+	.recv = tcmi_sigset_msg_recv,
+	.send = tcmi_sigset_msg_send
+};
+
+
+/**
+ * @}
+ */
@@ -0,0 +1,158 @@
+/**
+ * @file tcmi_sigset_msg.h - standard signals forwarded to a guest at once
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_SIGSET_MSG_H
+#define _TCMI_SIGSET_MSG_H
+
+#include <linux/signal.h>
+
+#include "tcmi_msg.h"
+
+/** @defgroup tcmi_sigset_msg_class tcmi_sigset_msg class
+ *
+ * @ingroup tcmi_msg_class
+ *
+ * This message carries the standard (non real-time) signals a shadow
+ * has received since it forwarded signals to its guest the last
+ * time. Standard signals are not queued by the kernel - a signal
+ * that is already pending is dropped. The shadow does the same: it
+ * collects the signals dequeued in one pass in this message and
+ * keeps the siginfo of the first occurrence of each signal only.
+ * The whole batch is delivered to the guest as one message instead
+ * of one \link tcmi_signal_msg_class TCMI_SIGNAL_MSG \endlink per
+ * signal.
+ *
+ * Only the siginfo of signals present in the set is transferred.
+ *
+ * @{
+ */
+
+/** Number of standard signals - signals 1 .. SIGRTMIN - 1 */
+#define TCMI_SIGSET_MAX (SIGRTMIN - 1)
+
+/** Checks whether a signal is a standard one and can be coalesced */
+#define TCMI_SIGSET_STANDARD(sig) ((sig) > 0 && (sig) < SIGRTMIN)
+
+/** Compound structure, inherits from tcmi_msg_class */
+struct tcmi_sigset_msg {
+	/** parent class instance */
+	struct tcmi_msg super;
+	/** Target PID */
+	int32_t pid;
+	/** Set of the signals, bit (n - 1) stands for signal n */
+	u_int32_t mask;
+	/** Siginfo of each signal in the set, indexed by signal - 1 */
+	siginfo_t info[TCMI_SIGSET_MAX];
+} __attribute__((__packed__));
+
+
+/** \<\<public\>\> Signal set message constructor for receiving. */
+extern struct tcmi_msg* tcmi_sigset_msg_new_rx(u_int32_t msg_id);
+
+/** \<\<public\>\> Signal set message constructor for transferring, the set is empty. */
+extern struct tcmi_msg* tcmi_sigset_msg_new_tx(pid_t pid);
+
+/** \<\<public\>\> Adds a signal to the set. */
+extern int tcmi_sigset_msg_add(struct tcmi_sigset_msg *self, siginfo_t *info);
+
+/** Message descriptor for the factory class, there is no error
+ * handling as this is the starting request */
+#define TCMI_SIGSET_MSG_DSC TCMI_MSG_DSC(TCMI_SIGSET_MSG_ID, tcmi_sigset_msg_new_rx, NULL)
+/** Signal set message transaction timeout set to 5 seconds*/
+#define TCMI_SIGSET_MSGTIMEOUT 5*HZ
+
+/** Casts to the tcmi_sigset_msg instance. */
+#define TCMI_SIGSET_MSG(m) ((struct tcmi_sigset_msg*)m)
+
+/**
+ * Target PID accessor.
+ *
+ * @param *self - this message instance
+ * @return PID of the guest
+ */
+static inline pid_t tcmi_sigset_msg_pid(struct tcmi_sigset_msg *self)
+{
+	return self->pid;
+}
+
+/**
+ * Signal set accessor.
+ *
+ * @param *self - this message instance
+ * @return the set, bit (n - 1) stands for signal n
+ */
+static inline u_int32_t tcmi_sigset_msg_mask(struct tcmi_sigset_msg *self)
+{
+	return self->mask;
+}
+
+/**
+ * Checks whether a signal is in the set.
+ *
+ * @param *self - this message instance
+ * @param sig - signal number
+ * @return non-zero if the signal is in the set
+ */
+static inline int tcmi_sigset_msg_has(struct tcmi_sigset_msg *self, int sig)
+{
+	return TCMI_SIGSET_STANDARD(sig) && (self->mask & (1U << (sig - 1)));
+}
+
+/**
+ * Siginfo accessor.
+ *
+ * @param *self - this message instance
+ * @param sig - signal number, has to be in the set
+ * @return siginfo of the signal
+ */
+static inline siginfo_t* tcmi_sigset_msg_info(struct tcmi_sigset_msg *self, int sig)
+{
+	return &self->info[sig - 1];
+}
+
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_SIGSET_MSG_PRIVATE
+
+/** Receives the message via a specified connection. */
+static int tcmi_sigset_msg_recv(struct tcmi_msg *self, struct kkc_sock *sock);
+
+/** Sends the message via a specified connection. */
+static int tcmi_sigset_msg_send(struct tcmi_msg *self, struct kkc_sock *sock);
+
+/** Message operations that support polymorphism. */
+static struct tcmi_msg_ops sigset_msg_ops;
+
+#endif /* TCMI_SIGSET_MSG_PRIVATE */
+
+
+/**
+ * @}
+ */
+
+
+#endif /* _TCMI_SIGSET_MSG_H */
@@ -34,6 +34,7 @@
 
 #include <linux/module.h>
 #include <linux/errno.h>
+#include <asm/uaccess.h>
 
 #define TCMI_CTLFS_FILE_PRIVATE
 #include "tcmi_ctlfs_file.h"
@@ -128,7 +129,6 @@ struct tcmi_ctlfs_entry* tcmi_ctlfs_strfile_new(struct tcmi_ctlfs_entry *parent,
  * @param maxlen - maximum length of the data in bytes
  * @param namefmt - nameformat string (printf style)
  * @return pointer to the new file or NULL
- * @note Currently not implemented
  */
 struct tcmi_ctlfs_entry* tcmi_ctlfs_rawfile_new(struct tcmi_ctlfs_entry *parent,
 						mode_t mode,
@@ -138,7 +138,16 @@ struct tcmi_ctlfs_entry* tcmi_ctlfs_rawfile_new(struct tcmi_ctlfs_entry *parent,
 						int maxlen,
 						const char namefmt[], ...)
 {
-	return NULL;
+	struct tcmi_ctlfs_entry *file;
+	va_list args;
+	va_start(args, namefmt);
+	/* the methods get the data along with its length */
+	file = tcmi_ctlfs_genericfile_new(parent, mode, object,
+					  read_method, write_method,
+					  sizeof(struct tcmi_ctlfs_raw) + maxlen, 
+					  tcmi_ctlfs_file_doraw, namefmt, args);
+	va_end(args);
+	return file;
 }
 
 
@@ -246,7 +255,7 @@ static struct tcmi_ctlfs_entry* tcmi_ctlfs_genericfile_new(struct tcmi_ctlfs_ent
 		mdbg(ERR3, "Failed to create the file");
 		goto exit1;
 	}
-	if (!(file->data = kmalloc(maxlen, GFP_ATOMIC))) {
+	if (!(file->data = kzalloc(maxlen, GFP_ATOMIC))) {
 		mdbg(ERR3, "Failed to allocate %d bytes of file data", maxlen);
 		goto exit2;
 	}
@@ -292,6 +301,47 @@ static void tcmi_ctlfs_file_release(struct tcmi_ctlfs_entry *entry)
 }
 
 
+/** 
+ * \<\<private\>\> Data handler of raw files, it has the same
+ * signature as the sysctl handlers. The data is just copied from/to
+ * the user space and its length is recorded in the tcmi_ctlfs_raw
+ * header. Writes must start at offset 0 and fit in the file.
+ *
+ * @param *table - data(struct tcmi_ctlfs_raw) and its maximal length
+ * including the header
+ * @param write - 1 when writing into the file
+ * @param *buffer - user buffer
+ * @param *lenp - in/out number of bytes to be processed
+ * @param *ppos - position in the file
+ * @return 0 upon success
+ */
+static int tcmi_ctlfs_file_doraw(struct ctl_table *table, int write,
+				 void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	struct tcmi_ctlfs_raw *raw = (struct tcmi_ctlfs_raw *)table->data;
+	size_t maxlen = table->maxlen - sizeof(struct tcmi_ctlfs_raw);
+	size_t len;
+
+	if (write) {
+		if (*ppos || *lenp > maxlen)
+			return -EINVAL;
+		if (copy_from_user(raw->data, buffer, *lenp))
+			return -EFAULT;
+		raw->len = *lenp;
+	} else {
+		if (*ppos >= raw->len) {
+			*lenp = 0;
+			return 0;
+		}
+		len = min(*lenp, (size_t)(raw->len - *ppos));
+		if (copy_to_user(buffer, raw->data + *ppos, len))
+			return -EFAULT;
+		*lenp = len;
+	}
+	*ppos += *lenp;
+	return 0;
+}
+
 /** 
  * \<\<private\>\> The read file operation, called by the read system call. 
  * The access to the file associated data is serialized, so that the
@@ -74,8 +74,9 @@ typedef int object_method (void *object, void *data);
  * - string files  - methods of file instantiators accept/return string data.
  *                   String parsing (overflow checks, new lines conversion) is 
  *                   handled internally by this class.
- * - raw files     - methods of file instantiators accept raw data.
- *                   No conversion is performed.
+ * - raw files     - methods of file instantiators accept raw data
+ *                   (struct tcmi_ctlfs_raw). No conversion is performed,
+ *                   a single write must pass the whole data.
  *
  * The object that creates the control file, specifies maximum allowed
  * data length as it is in sysctl.
@@ -139,6 +140,14 @@ struct tcmi_ctlfs_file {
 /** Casts an entry to file */
 #define TCMI_CTLFS_FILE(e) ((struct tcmi_ctlfs_file *)e)
 
+/** Data of a raw file as passed to the methods of the registered object. */
+struct tcmi_ctlfs_raw {
+	/** number of valid bytes */
+	int len;
+	/** the data itself, up to maxlen bytes */
+	char data[0];
+};
+
 /** \<\<public\>\> Creates a new integer file instance. */
 extern struct tcmi_ctlfs_entry* tcmi_ctlfs_intfile_new(struct tcmi_ctlfs_entry *parent,
 						      mode_t mode,
@@ -237,6 +246,10 @@ static struct tcmi_ctlfs_entry* tcmi_ctlfs_genericfile_new(struct tcmi_ctlfs_ent
 /** A forward declaration, frees all file resources. */
 static void tcmi_ctlfs_file_release(struct tcmi_ctlfs_entry *entry);
 
+/** A forward declaration, data handler of raw files. */
+static int tcmi_ctlfs_file_doraw(struct ctl_table *table, int write,
+				 void __user *buffer, size_t *lenp, loff_t *ppos);
+
 
 
 /** A forward declaration, read operation for VFS. */
@@ -693,6 +693,7 @@ static struct tcmi_man_ops ccnman_ops = {
 	.emigrate_ppm_p = tcmi_migcom_emigrate_ccn_ppm_p,
 	.emigrate_npm = tcmi_migcom_emigrate_ccn_npm,
 	.migrate_home_ppm_p = tcmi_migcom_migrate_home_ppm_p,
+	.migrate_home_ppm_v = tcmi_migcom_migrate_home_ppm_v,
 	.fork = tcmi_migcom_shadow_fork,
 };
 
@@ -32,6 +32,8 @@
 #include <linux/types.h>
 #include <linux/random.h>
 #include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/slab.h>
 
 #include <tcmi/ctlfs/tcmi_ctlfs.h>
 #include <tcmi/lib/tcmi_sock.h>
@@ -39,6 +41,7 @@
 #include "tcmi_ccnmigman.h"
 
 #include <kkc/kkc.h>
+#include <director/director.h>
 
 #define TCMI_MAN_PRIVATE
 #include "tcmi_man.h"
@@ -286,21 +289,38 @@ static int tcmi_man_init_ctlfs_files(struct tcmi_man *self)
 	if (!(self->f_emig_ppm_p = 
 	      tcmi_ctlfs_intfile_new(self->d_mig, TCMI_PERMS_FILE_W,
 				     self, NULL, tcmi_man_emig_ppm_p,
-				     sizeof(int) * 2, "emigrate-ppm-p")))
+				     sizeof(int) * 3, "emigrate-ppm-p")))
 		goto exit1;
 	if (!(self->f_mig_home_ppm_p = 
 	      tcmi_ctlfs_intfile_new(self->d_mig, TCMI_PERMS_FILE_W,
 				     self, NULL, tcmi_man_mig_home_ppm_p,
 				     sizeof(int), "migrate-home")))
 		goto exit2;
+	if (!(self->f_mig_home_ppm_v = 
+	      tcmi_ctlfs_intfile_new(self->d_mig, TCMI_PERMS_FILE_W,
+				     self, NULL, tcmi_man_mig_home_ppm_v,
+				     sizeof(int), "migrate-home-ppm-v")))
+		goto exit3;
+	if (!(self->f_mig_batch = 
+	      tcmi_ctlfs_rawfile_new(self->d_mig, TCMI_PERMS_FILE_W,
+				     self, NULL, tcmi_man_mig_batch,
+				     DIRECTOR_MIGRATION_BATCH_MAX * sizeof(struct director_migration), 
+				     "migrate-batch")))
+		goto exit4;
 	if (self->ops->init_ctlfs_files && self->ops->init_ctlfs_files()) {
 		mdbg(ERR3, "Failed to create specific ctlfs files!");
-		goto exit3;
+		goto exit5;
 	}
 	return 0;
 
 
 	/* error handling */
+ exit5:
+	tcmi_ctlfs_file_unregister(self->f_mig_batch);
+	tcmi_ctlfs_entry_put(self->f_mig_batch);
+ exit4:
+	tcmi_ctlfs_file_unregister(self->f_mig_home_ppm_v);
+	tcmi_ctlfs_entry_put(self->f_mig_home_ppm_v);
  exit3:
 	tcmi_ctlfs_file_unregister(self->f_mig_home_ppm_p);
 	tcmi_ctlfs_entry_put(self->f_mig_home_ppm_p);
@@ -353,6 +373,12 @@ static void tcmi_man_stop_ctlfs_files(struct tcmi_man *self)
 
 	tcmi_ctlfs_file_unregister(self->f_mig_home_ppm_p);
 	tcmi_ctlfs_entry_put(self->f_mig_home_ppm_p);
+
+	tcmi_ctlfs_file_unregister(self->f_mig_home_ppm_v);
+	tcmi_ctlfs_entry_put(self->f_mig_home_ppm_v);
+
+	tcmi_ctlfs_file_unregister(self->f_mig_batch);
+	tcmi_ctlfs_entry_put(self->f_mig_batch);
 }
 
 /** 
@@ -447,23 +473,46 @@ static int tcmi_man_stop(void *obj, void *data)
  * - call instance specific emigration method.
  *
  * @param *obj - pointer to a particular TCMI manager singleton instance
- * @param *data - an array of two integers first contains PID, second
- * one contains the desired manager identifier as it appears in 
- * ctlfs. It is the name of its directory.
+ * @param *data - an array of up to three integers first contains
+ * PID, second one contains the desired manager identifier as it
+ * appears in ctlfs. It is the name of its directory. The optional
+ * third one is the restart readahead window in pages (0 selects the
+ * default, negative value disables it), it is reset after each
+ * request.
  * @return 0 upon success
  */
 static int tcmi_man_emig_ppm_p(void *obj, void *data)
 {
-	int err = 0;
 	pid_t pid = *((int *)data);
 	u_int32_t migman_id = *(((int *)data) + 1);
-	struct tcmi_man *self = TCMI_MAN(obj);
+	int readahead = *(((int *)data) + 2);
+	
+	/* the window is optional, don't let it stick to the next request */
+	*(((int *)data) + 2) = 0;
+
+	return tcmi_man_do_emig_ppm_p(TCMI_MAN(obj), pid, migman_id, readahead);
+}
+
+/** 
+ * \<\<private\>\> Emigrates a task preemptively to the node of a
+ * given migration manager.
+ *
+ * @param *self - a particular TCMI manager singleton instance
+ * @param pid - task that is to be migrated
+ * @param migman_id - the desired manager identifier as it appears in
+ * ctlfs
+ * @param readahead - restart readahead window in pages (0 selects
+ * the default, negative value disables it)
+ * @return 0 upon success
+ */
+static int tcmi_man_do_emig_ppm_p(struct tcmi_man *self, pid_t pid, u_int32_t migman_id, int readahead)
+{
+	int err = 0;
 	struct tcmi_slot *slot;
 	struct tcmi_migman *migman = NULL;
 
-	
-	mdbg(INFO2, "Emigration request PID %d, migration manager %d", 
-	     pid, migman_id);
+	mdbg(INFO2, "Emigration request PID %d, migration manager %d, readahead %d", 
+	     pid, migman_id, readahead);
 	
 	/* lookup the migration manager first */
 	tcmi_slotvec_lock(self->mig_mans);
@@ -481,7 +530,7 @@ static int tcmi_man_emig_ppm_p(void *obj, void *data)
 	tcmi_slotvec_unlock(self->mig_mans);
 
 	if (self->ops->emigrate_ppm_p)
-		err = self->ops->emigrate_ppm_p(pid, migman);
+		err = self->ops->emigrate_ppm_p(pid, migman, readahead);
 
 	/* release the migration manager */
 	tcmi_migman_put(migman);
@@ -626,6 +675,170 @@ static int tcmi_man_mig_home_ppm_p(void *obj, void *data)
 	return err;
 }
 
+/** 
+ * \<\<private\>\> TCMI ctlfs write method - migration home using an
+ * in-memory checkpoint image. Same as tcmi_man_mig_home_ppm_p(), the
+ * checkpoint just never touches a filesystem.
+ *
+ * @param *obj - pointer to a particular TCMI manager singleton instance
+ * @param *data - contains PID that is to be migrated home
+ * @return 0 upon success
+ */
+static int tcmi_man_mig_home_ppm_v(void *obj, void *data)
+{
+	int err = 0;
+	pid_t pid = *((int *)data);
+	struct tcmi_man *self = TCMI_MAN(obj);
+	
+	mdbg(INFO2, "In-memory migration home request for PID %d", pid);
+
+	if (self->ops->migrate_home_ppm_v)
+		err = self->ops->migrate_home_ppm_v(pid);
+
+	return err;
+}
+
+/**
+ * A batch of migrations. The migrations are taken one by one by the
+ * threads executing the batch, the last thread frees the batch.
+ */
+struct tcmi_man_batch {
+	/** manager that performs the migrations */
+	struct tcmi_man *man;
+	/** index of the next migration to be executed */
+	atomic_t next;
+	/** each executing thread holds a reference */
+	atomic_t ref_count;
+	/** number of migrations */
+	int count;
+	/** the migrations */
+	struct director_migration migrations[0];
+};
+
+/** 
+ * \<\<public\>\> Starts a batch of migrations. The migrations are
+ * executed concurrently by up to TCMI_MAN_BATCH_WORKERS kernel
+ * threads, so that a slow migration (e.g. waiting for its task to
+ * be picked up) doesn't delay the others. The method doesn't wait
+ * for the migrations, failures are reported to the director the
+ * same way as for single migrations.
+ *
+ * @param *self - a particular TCMI manager singleton instance
+ * @param count - number of migrations
+ * @param *migrations - migrations to be performed, they are copied
+ * @return 0 when the migrations have been started
+ */
+int tcmi_man_migrate_batch(struct tcmi_man *self, int count, struct director_migration *migrations)
+{
+	struct tcmi_man_batch *batch;
+	struct task_struct *thread;
+	int workers, i;
+
+	if (count <= 0 || count > DIRECTOR_MIGRATION_BATCH_MAX) {
+		mdbg(ERR3, "Invalid number of migrations in a batch: %d", count);
+		goto exit0;
+	}
+	if (!(batch = kmalloc(sizeof(struct tcmi_man_batch) + 
+			      count * sizeof(struct director_migration), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate a batch of %d migrations", count);
+		return -ENOMEM;
+	}
+	batch->man = self;
+	atomic_set(&batch->next, 0);
+	batch->count = count;
+	memcpy(batch->migrations, migrations, count * sizeof(struct director_migration));
+
+	workers = min(count, TCMI_MAN_BATCH_WORKERS);
+	/* the submitter holds a reference until all threads are started */
+	atomic_set(&batch->ref_count, workers + 1);
+	for (i = 0; i < workers; i++) {
+		/* a thread must not outlive the module */
+		__module_get(THIS_MODULE);
+		thread = kthread_run(tcmi_man_batch_thread, batch, "tcmi_migd");
+		if (IS_ERR(thread)) {
+			mdbg(ERR3, "Failed to start a batch migration thread");
+			module_put(THIS_MODULE);
+			atomic_sub(workers - i, &batch->ref_count);
+			break;
+		}
+	}
+	mdbg(INFO2, "Started batch of %d migrations, %d threads", count, i);
+
+	if (atomic_dec_and_test(&batch->ref_count))
+		kfree(batch);
+
+	return i ? 0 : -ENOMEM;
+
+	/* error handling */
+ exit0:
+	return -EINVAL;
+}
+
+/** 
+ * \<\<private\>\> TCMI ctlfs write method - batch migration. The
+ * file data is an array of struct director_migration.
+ *
+ * @param *obj - pointer to a particular TCMI manager singleton instance
+ * @param *data - raw data of the file
+ * @return 0 upon success
+ */
+static int tcmi_man_mig_batch(void *obj, void *data)
+{
+	struct tcmi_ctlfs_raw *raw = (struct tcmi_ctlfs_raw *)data;
+
+	if (raw->len % sizeof(struct director_migration)) {
+		mdbg(ERR3, "Malformed migration batch of %d bytes", raw->len);
+		return -EINVAL;
+	}
+
+	return tcmi_man_migrate_batch(TCMI_MAN(obj), raw->len / sizeof(struct director_migration), 
+				      (struct director_migration *)raw->data);
+}
+
+/** 
+ * \<\<private\>\> Thread executing migrations of a batch. It takes
+ * migrations that haven't been taken yet by other threads of the
+ * batch until there are none left.
+ *
+ * @param *data - the batch
+ * @return doesn't return, the module reference is dropped on exit
+ */
+static int tcmi_man_batch_thread(void *data)
+{
+	struct tcmi_man_batch *batch = (struct tcmi_man_batch *)data;
+	struct tcmi_man *self = batch->man;
+	struct director_migration *mig;
+	int i, err;
+
+	while ((i = atomic_inc_return(&batch->next) - 1) < batch->count) {
+		mig = &batch->migrations[i];
+		err = -EINVAL;
+		switch (mig->mode) {
+		case DIRECTOR_MIGRATION_EMIGRATE_PPM_P:
+			err = tcmi_man_do_emig_ppm_p(self, mig->pid, mig->slot_index, 0);
+			break;
+		case DIRECTOR_MIGRATION_HOME_PPM_P:
+			if (self->ops->migrate_home_ppm_p)
+				err = self->ops->migrate_home_ppm_p(mig->pid);
+			break;
+		case DIRECTOR_MIGRATION_HOME_PPM_V:
+			if (self->ops->migrate_home_ppm_v)
+				err = self->ops->migrate_home_ppm_v(mig->pid);
+			break;
+		default:
+			mdbg(ERR3, "Unknown migration mode %d", mig->mode);
+			break;
+		}
+		if (err)
+			mdbg(ERR3, "Batch migration of PID %d (mode %d) failed: %d", 
+			     mig->pid, mig->mode, err);
+	}
+
+	if (atomic_dec_and_test(&batch->ref_count))
+		kfree(batch);
+	module_put_and_exit(0);
+}
+
 
 /**
  * @}
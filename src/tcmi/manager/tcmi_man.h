@@ -42,6 +42,10 @@
 #include <tcmi/ctlfs/tcmi_ctlfs_file.h>
 
 struct tcmi_npm_params;
+struct director_migration;
+
+/** Max number of threads that execute a single migration batch */
+#define TCMI_MAN_BATCH_WORKERS 8
 
 /** @defgroup tcmi_man_class tcmi_man class 
  *
@@ -118,6 +122,12 @@ struct tcmi_man {
 	/** TCMI ctlfs - migration control file (PPM physical ckpt.) */
 	struct tcmi_ctlfs_entry *f_mig_home_ppm_p;
 
+	/** TCMI ctlfs - migration control file (PPM virtual ckpt.) */
+	struct tcmi_ctlfs_entry *f_mig_home_ppm_v;
+
+	/** TCMI ctlfs - batch migration control file */
+	struct tcmi_ctlfs_entry *f_mig_batch;
+
 	/** Unique manager ID. */
 	u_int32_t id;
 
@@ -135,11 +145,13 @@ struct tcmi_man_ops {
 	/** Destroys all TCMI ctlfs files. */
 	void (*stop_ctlfs_files)(void);
 	/** Preemptive emigration method. */
-	int (*emigrate_ppm_p)(pid_t, struct tcmi_migman*);
+	int (*emigrate_ppm_p)(pid_t, struct tcmi_migman*, int);
 	/** Non-preemptive emigration method. */
 	int (*emigrate_npm)(pid_t, struct tcmi_migman*, struct pt_regs* regs, struct tcmi_npm_params*);
 	/** Migrate home method. */
 	int (*migrate_home_ppm_p)(pid_t);	
+	/** Migrate home method - in-memory checkpoint image. */
+	int (*migrate_home_ppm_v)(pid_t);
 	/** Transforms forked process to a same type of task as parent and assigns it with a same manager. */
 	int (*fork)(struct task_struct* parent, struct task_struct* child, struct tcmi_migman*);
 
@@ -239,6 +251,9 @@ static inline u_int32_t tcmi_man_id(struct tcmi_man *self)
 /** \<\<public\>\> Method that performs non-preemtive migration  */
 extern int tcmi_man_emig_npm(struct tcmi_man *self, pid_t pid, u_int32_t migman_id, struct pt_regs* regs, struct tcmi_npm_params* npm_params);
 
+/** \<\<public\>\> Starts a batch of migrations */
+extern int tcmi_man_migrate_batch(struct tcmi_man *self, int count, struct director_migration *migrations);
+
 /** \<\<public\>\> Method that performs task fork */
 extern int tcmi_man_fork(struct tcmi_man *self, struct task_struct* parent, struct task_struct* child);
 
@@ -270,6 +285,18 @@ static int tcmi_man_stop(void *obj, void *data);
 static int tcmi_man_emig_ppm_p(void *obj, void *data);
 /** TCMI ctlfs write method - migration home */
 static int tcmi_man_mig_home_ppm_p(void *obj, void *data);
+/** TCMI ctlfs write method - migration home with in-memory image */
+static int tcmi_man_mig_home_ppm_v(void *obj, void *data);
+/** TCMI ctlfs write method - batch migration */
+static int tcmi_man_mig_batch(void *obj, void *data);
+
+/** Looks up the migration manager and emigrates a task */
+static int tcmi_man_do_emig_ppm_p(struct tcmi_man *self, pid_t pid, u_int32_t migman_id, int readahead);
+
+/** Batch of migrations shared by the threads that execute it */
+struct tcmi_man_batch;
+/** Thread executing migrations of a batch */
+static int tcmi_man_batch_thread(void *data);
 
 #endif /* TCMI_MAN_PRIVATE */
 
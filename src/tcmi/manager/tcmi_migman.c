@@ -744,6 +744,8 @@ int tcmi_migman_remove_task(struct tcmi_migman *self, struct tcmi_task* task) {
 	//tcmi_slotvec_unlock(self->tasks);
 
 	mdbg(INFO3, "Removed task PID=%d from slot with hash %d", tcmi_task_local_pid(task), hash);
+	if (self->ops->task_removed)
+		self->ops->task_removed(self, task);
 
 	return 0;
 }
@@ -171,6 +171,8 @@ struct tcmi_migman_ops {
 	
 	/** Request to stop this migration manager and terminate its connection with peer. */
 	void (*stop)(struct tcmi_migman*, int);
+	/** Notifies that a task has been removed from this migration manager. */
+	void (*task_removed)(struct tcmi_migman*, struct tcmi_task*);
 
 };
 
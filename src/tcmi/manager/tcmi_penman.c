@@ -276,6 +276,7 @@ static struct tcmi_man_ops penman_ops = {
 	.stop_ctlfs_files = tcmi_penman_stop_ctlfs_files,
 	.stop = tcmi_penman_stop,
 	.migrate_home_ppm_p = tcmi_migcom_migrate_home_ppm_p,
+	.migrate_home_ppm_v = tcmi_migcom_migrate_home_ppm_v,
 	.fork = tcmi_migcom_guest_fork,
 };
 
@@ -94,10 +94,15 @@
                   6547/migman->../../nodes/7 -> a  symbolic link pointing to
                                                 its current  CCN
 		       remote-pid -> process PID at its original CCN
+		       profile -> durations and sizes of the last checkpoint/restart phases
   ------------ T C M I  P E N  p p m  c o m p o n e n t --------------
                 emigrate-ppm-p -> writing a PID + PEN id pair into this file starts process 
                             migration to the specified PEN.
                 migrate-home -> allows migrating a specified process back to CCN
+                migrate-home-ppm-v -> same as migrate-home, the checkpoint image is
+                            kept in memory and streamed, no filesystem is involved
+                migrate-batch -> binary file, writing an array of struct director_migration
+                            (pid, node slot, mode) starts all the migrations concurrently
   ------------ T C M I  P E N  n p m  c o m p o n e n t (not implemented) --------------
                 policy -> interface for the migration policy, the npm component
                           uses this interface to ask the migration policy for migration
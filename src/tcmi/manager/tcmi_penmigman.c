@@ -33,12 +33,19 @@
 #include <tcmi/lib/tcmi_slotvec.h>
 #include <tcmi/task/tcmi_task.h>
 #include <linux/sched.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
 
 #define TCMI_PENMIGMAN_PRIVATE
 #include "tcmi_penmigman.h"
 
 #include <tcmi/comm/tcmi_authenticate_msg.h>
 #include <tcmi/comm/tcmi_authenticate_resp_msg.h>
+#include <tcmi/comm/tcmi_page_hashes_msg.h>
+#include <tcmi/comm/tcmi_page_hashes_resp_msg.h>
+#include <tcmi/comm/tcmi_sigset_msg.h>
+#include <tcmi/ckpt/tcmi_ckpt_pagecache.h>
+#include <linux/vmalloc.h>
 #include <arch/current/regs.h>
 #include <tcmi/lib/util.h>
 
@@ -46,13 +53,12 @@
 
 #include <dbg.h>
 
-/** Forward declaration */
-static int tcmi_penmigman_migrate_all_home(void *obj, void *data);
-
 /**
  * \<\<public\>\> TCMI PEN migration manager constructor.
  * The initialization is accomplished exactly in this order:
  * - create new instance
+ * - starts the namespace pool
+ * - initializes the drain state
  * - delegates all remaining intialization work to the generic manager.
  *
  * @param *sock - socket where the new PEN is registering
@@ -78,18 +84,33 @@ struct tcmi_migman* tcmi_penmigman_new(struct kkc_sock *sock, u_int32_t pen_id,
 		mdbg(ERR3, "Can't allocate memory for CCM migration manager");
 		goto exit0;
 	}
+	/* the pool has to be ready before its ctlfs file is created */
+	if (tcmi_nspool_init(&migman->ns_pool, TCMI_MIGMAN(migman)) < 0) {
+		mdbg(ERR3, "Can't initialize the namespace pool");
+		goto exit1;
+	}
+	spin_lock_init(&migman->drain_lock);
+	migman->drain_running = 0;
+	migman->drain_stopped = 0;
+	migman->cache_owner = tcmi_ckpt_pagecache_owner_new();
+	migman->drain_parallel = TCMI_PENMIGMAN_DRAIN_PARALLEL;
+	memset(migman->drain_progress, 0, sizeof(migman->drain_progress));
+	atomic_set(&migman->drain_events, 0);
+	init_waitqueue_head(&migman->drain_wait);
 	va_start(args, namefmt);
 	if (tcmi_migman_init(TCMI_MIGMAN(migman), sock, 0, pen_id, UNKNOWN, manager_slot, root, migproc,
 			     &penmigman_ops, namefmt, args) < 0) {
 		mdbg(ERR3, "TCMI PEN migman initializtion failed!");
 		va_end(args);
-		goto exit1;
+		goto exit2;
 	}
 	va_end(args);
 	
 	return TCMI_MIGMAN(migman);
 
 	/* error handling */
+ exit2:
+	tcmi_nspool_stop(&migman->ns_pool);
  exit1:
 	kfree(migman);
  exit0:
@@ -162,8 +183,37 @@ static int tcmi_penmigman_init_ctlfs_files(struct tcmi_migman *self)
 				    sizeof(int),"migrate-home-all")))
 		goto exit0;
 
+	if (!(self_pen->f_ns_pool_size = 
+	      tcmi_ctlfs_intfile_new(self->d_migman, TCMI_PERMS_FILE_RW,
+				     self, tcmi_penmigman_get_ns_pool_size, 
+				     tcmi_penmigman_set_ns_pool_size,
+				     sizeof(int), "ns-pool-size")))
+		goto exit1;
+
+	if (!(self_pen->f_mighome_parallel = 
+	      tcmi_ctlfs_intfile_new(self->d_migman, TCMI_PERMS_FILE_RW,
+				     self, tcmi_penmigman_get_mighome_parallel, 
+				     tcmi_penmigman_set_mighome_parallel,
+				     sizeof(int), "migrate-home-parallel")))
+		goto exit2;
+
+	if (!(self_pen->f_mighome_progress = 
+	      tcmi_ctlfs_intfile_new(self->d_migman, TCMI_PERMS_FILE_R,
+				     self, tcmi_penmigman_show_mighome_progress, NULL,
+				     sizeof(self_pen->drain_progress), "migrate-home-progress")))
+		goto exit3;
+
 	return 0;
 
+exit3:
+	tcmi_ctlfs_file_unregister(self_pen->f_mighome_parallel);
+	tcmi_ctlfs_entry_put(self_pen->f_mighome_parallel);
+exit2:
+	tcmi_ctlfs_file_unregister(self_pen->f_ns_pool_size);
+	tcmi_ctlfs_entry_put(self_pen->f_ns_pool_size);
+exit1:
+	tcmi_ctlfs_file_unregister(self_pen->f_mighome_all);
+	tcmi_ctlfs_entry_put(self_pen->f_mighome_all);
 exit0:
 	return -EINVAL;
 }
@@ -181,28 +231,303 @@ static void tcmi_penmigman_stop_ctlfs_files(struct tcmi_migman *self)
 
 	tcmi_ctlfs_file_unregister(self_pen->f_mighome_all);
 	tcmi_ctlfs_entry_put(self_pen->f_mighome_all);
+	tcmi_ctlfs_file_unregister(self_pen->f_ns_pool_size);
+	tcmi_ctlfs_entry_put(self_pen->f_ns_pool_size);
+	tcmi_ctlfs_file_unregister(self_pen->f_mighome_parallel);
+	tcmi_ctlfs_entry_put(self_pen->f_mighome_parallel);
+	tcmi_ctlfs_file_unregister(self_pen->f_mighome_progress);
+	tcmi_ctlfs_entry_put(self_pen->f_mighome_progress);
+
+}
+
+/** 
+ * \<\<private\>\> Read method for the ns-pool-size control file.
+ *
+ * @param *obj - pointer to this migration manager instance
+ * @param *data - output buffer for the number of namespaces per user
+ * @return 0
+ */
+static int tcmi_penmigman_get_ns_pool_size(void *obj, void *data)
+{
+	*((int *)data) = tcmi_nspool_size(&TCMI_PENMIGMAN(obj)->ns_pool);
+	return 0;
+}
+
+/** 
+ * \<\<private\>\> Write method for the ns-pool-size control
+ * file. Sets how many namespaces are kept prepared for each user
+ * immigrating tasks from the CCN, 0 disables the pool.
+ *
+ * @param *obj - pointer to this migration manager instance
+ * @param *data - new number of namespaces per user
+ * @return 0
+ */
+static int tcmi_penmigman_set_ns_pool_size(void *obj, void *data)
+{
+	tcmi_nspool_set_size(&TCMI_PENMIGMAN(obj)->ns_pool, *((int *)data));
+	return 0;
+}
+
+/** 
+ * \<\<private\>\> Read method for the migrate-home-parallel control
+ * file.
+ *
+ * @param *obj - pointer to this migration manager instance
+ * @param *data - output buffer for the number of guests
+ * @return 0
+ */
+static int tcmi_penmigman_get_mighome_parallel(void *obj, void *data)
+{
+	*((int *)data) = TCMI_PENMIGMAN(obj)->drain_parallel;
+	return 0;
+}
+
+/** 
+ * \<\<private\>\> Write method for the migrate-home-parallel
+ * control file. Sets how many guests migrate home at once during a
+ * drain, the change applies to a running drain as well.
+ *
+ * @param *obj - pointer to this migration manager instance
+ * @param *data - new number of guests
+ * @return 0 upon success, -EINVAL when out of range
+ */
+static int tcmi_penmigman_set_mighome_parallel(void *obj, void *data)
+{
+	int parallel = *((int *)data);
+
+	if (parallel < 1 || parallel > TCMI_PENMIGMAN_DRAIN_MAX_PARALLEL)
+		return -EINVAL;
+	TCMI_PENMIGMAN(obj)->drain_parallel = parallel;
+	return 0;
+}
 
+/** 
+ * \<\<private\>\> Read method for the migrate-home-progress control
+ * file. Reports progress of the running or the last drain: number of
+ * guests to be migrated, number of guests that have left the node,
+ * number of guests that couldn't be requested to migrate and number
+ * of guests migrating right now.
+ *
+ * @param *obj - pointer to this migration manager instance
+ * @param *data - output buffer for the progress values
+ * @return 0
+ */
+static int tcmi_penmigman_show_mighome_progress(void *obj, void *data)
+{
+	struct tcmi_penmigman *self = TCMI_PENMIGMAN(obj);
+
+	spin_lock(&self->drain_lock);
+	memcpy(data, self->drain_progress, sizeof(self->drain_progress));
+	spin_unlock(&self->drain_lock);
+	return 0;
 }
 
 /** 
  * \<\<private\>\> Emigrates all contained tasks back to home node
- * The method is asynchrounous. Migrate home requests are issued to all contained tasks,
- * but we do not wait till the migration back is performed.
+ * The method is asynchrounous. It starts a drain thread that issues
+ * the migrate home requests and keeps at most migrate-home-parallel
+ * guests migrating at once. We do not wait till the migration back
+ * is performed. A request while a drain is running or after the
+ * manager has been stopped is ignored.
  *
  * @param *obj - pointer to this migration manager instance
  * @param *data - not used
+ * @return 0 upon success
  */
 static int tcmi_penmigman_migrate_all_home(void *obj, void *data) {
+	struct tcmi_penmigman *self = TCMI_PENMIGMAN(obj);
+	struct task_struct *thread;
+
+	mdbg(INFO3, "Penmigman migrate all home requested");
+	spin_lock(&self->drain_lock);
+	if (self->drain_running || self->drain_stopped) {
+		spin_unlock(&self->drain_lock);
+		mdbg(INFO3, "Drain already running or manager stopped");
+		return 0;
+	}
+	self->drain_running = 1;
+	spin_unlock(&self->drain_lock);
+
+	/* the thread holds a manager reference and must not outlive the module */
+	tcmi_migman_get(TCMI_MIGMAN(self));
+	__module_get(THIS_MODULE);
+	thread = kthread_run(tcmi_penmigman_drain_thread, self, "tcmi_draind");
+	if (IS_ERR(thread)) {
+		mdbg(ERR3, "Failed to start the drain thread");
+		module_put(THIS_MODULE);
+		tcmi_migman_put(TCMI_MIGMAN(self));
+		spin_lock(&self->drain_lock);
+		self->drain_running = 0;
+		spin_unlock(&self->drain_lock);
+		return PTR_ERR(thread);
+	}
+
+	return 0;
+}
+
+/** 
+ * \<\<private\>\> Collects PIDs of all guests of the manager. The
+ * guests that arrive later are not included.
+ *
+ * @param *self - pointer to this migration manager instance
+ * @param **pids - array of the PIDs is stored here, the caller
+ * releases it by kfree()
+ * @return number of guests or -ENOMEM
+ */
+static int tcmi_penmigman_guest_pids(struct tcmi_migman *self, pid_t **pids)
+{
+	struct tcmi_task* task;
+	struct tcmi_slot *slot;
+	tcmi_slot_node_t* node;
+	int count = 0, i = 0;
+
+	/* we protect the iteration so that migration backs do not interfere with the iteration */
+	tcmi_slotvec_lock(self->tasks);
+	tcmi_slotvec_for_each_used_slot(slot, self->tasks) {
+		tcmi_slot_for_each(node, slot) {
+			count++;
+		};
+	};
+	tcmi_slotvec_unlock(self->tasks);
+
+	/* one extra entry, so that an empty manager doesn't need special handling */
+	if (!(*pids = kmalloc(sizeof(pid_t) * (count + 1), GFP_KERNEL)))
+		return -ENOMEM;
+
+	tcmi_slotvec_lock(self->tasks);
+	tcmi_slotvec_for_each_used_slot(slot, self->tasks) {
+		tcmi_slot_for_each(node, slot) {
+			/* guests that have arrived in the meantime are left for the next drain */
+			if (i == count)
+				break;
+			task = tcmi_slot_entry(node, struct tcmi_task, node);
+			(*pids)[i++] = tcmi_task_local_pid(task);
+		};
+	};
+	tcmi_slotvec_unlock(self->tasks);
+
+	return i;
+}
+
+/** 
+ * \<\<private\>\> Checks whether a guest is still managed by the
+ * manager, i.e. whether it hasn't left the node yet.
+ *
+ * @param *self - pointer to this migration manager instance
+ * @param pid - local PID of the guest
+ * @return 1 if the guest is still here
+ */
+static int tcmi_penmigman_has_guest(struct tcmi_migman *self, pid_t pid)
+{
+	struct tcmi_task* task;
+	struct tcmi_slot *slot;
+	tcmi_slot_node_t* node;
+	int found = 0;
+
+	tcmi_slotvec_lock(self->tasks);
+	if ((slot = tcmi_slotvec_at(self->tasks, tcmi_task_hash(pid, tcmi_slotvec_hashmask(self->tasks))))) {
+		tcmi_slot_for_each(node, slot) {
+			task = tcmi_slot_entry(node, struct tcmi_task, node);
+			if (tcmi_task_local_pid(task) == pid) {
+				found = 1;
+				break;
+			}
+		};
+	}
+	tcmi_slotvec_unlock(self->tasks);
+
+	return found;
+}
+
+/** 
+ * \<\<private\>\> Drain thread - migrates all guests that are in
+ * the manager home. At most migrate-home-parallel guests are
+ * migrating at once, a new migration is requested whenever a guest
+ * leaves. A guest leaves the node either when it has migrated home
+ * or when it failed to do so, in both cases its slot is released.
+ * The thread quits early when the manager is stopped, the stop
+ * requests the remaining guests itself.
+ *
+ * @param *data - pointer to this migration manager instance
+ * @return doesn't return, the module reference is dropped on exit
+ */
+static int tcmi_penmigman_drain_thread(void *data)
+{
+	struct tcmi_penmigman *self = TCMI_PENMIGMAN(data);
+	struct tcmi_migman *migman = TCMI_MIGMAN(data);
+	pid_t in_flight[TCMI_PENMIGMAN_DRAIN_MAX_PARALLEL];
+	pid_t *pids;
+	int count, next = 0, running = 0, gone, failed, events, i;
+
+	if ((count = tcmi_penmigman_guest_pids(migman, &pids)) < 0) {
+		mdbg(ERR3, "Can't collect guests to be migrated home");
+		goto exit0;
+	}
+	spin_lock(&self->drain_lock);
+	memset(self->drain_progress, 0, sizeof(self->drain_progress));
+	self->drain_progress[TCMI_PENMIGMAN_DRAIN_TOTAL] = count;
+	spin_unlock(&self->drain_lock);
+	mdbg(INFO3, "Draining %d guests", count);
+
+	while ((next < count || running) && !self->drain_stopped) {
+		/* read before checking the guests, so that no departure is missed */
+		events = atomic_read(&self->drain_events);
+		gone = failed = 0;
+		for (i = 0; i < running; ) {
+			if (tcmi_penmigman_has_guest(migman, in_flight[i])) {
+				i++;
+				continue;
+			}
+			in_flight[i] = in_flight[--running];
+			gone++;
+		}
+		while (running < self->drain_parallel && next < count) {
+			mdbg(INFO3, "Sending migrate home request to task: local_pid=%d", pids[next]);
+			if (tcmi_migcom_migrate_home_ppm_p(pids[next]) < 0) {
+				/* the guest has likely terminated meanwhile */
+				failed++;
+			} else
+				in_flight[running++] = pids[next];
+			next++;
+		}
+		spin_lock(&self->drain_lock);
+		self->drain_progress[TCMI_PENMIGMAN_DRAIN_GONE] += gone;
+		self->drain_progress[TCMI_PENMIGMAN_DRAIN_FAILED] += failed;
+		self->drain_progress[TCMI_PENMIGMAN_DRAIN_IN_FLIGHT] = running;
+		spin_unlock(&self->drain_lock);
+
+		/* the timeout covers guests that disappear without leaving the manager */
+		if (running)
+			wait_event_timeout(self->drain_wait, 
+					   atomic_read(&self->drain_events) != events ||
+					   self->drain_stopped, HZ);
+	}
+	kfree(pids);
+	mdbg(INFO3, "Penmigman migrate all home done");
+
+ exit0:
+	spin_lock(&self->drain_lock);
+	self->drain_running = 0;
+	spin_unlock(&self->drain_lock);
+	tcmi_migman_put(migman);
+	module_put_and_exit(0);
+}
+
+/** 
+ * \<\<private\>\> Requests all guests of the manager to migrate
+ * home right away, without any throttling. Migrate home requests are
+ * issued, but we do not wait till the migration back is performed.
+ *
+ * @param *self - pointer to this migration manager instance
+ */
+static void tcmi_penmigman_request_all_home(struct tcmi_migman *self)
+{
 	struct tcmi_task* task;
 	struct tcmi_slot *slot;
 	tcmi_slot_node_t* node;
-	
-	struct tcmi_migman *self  = TCMI_MIGMAN(obj);
 
-	mdbg(INFO3, "Penmigman migrate all home requested");
 	/* we protect the iteration so that migration backs do not interfere with the iteration */
 	tcmi_slotvec_lock(self->tasks);
-	/* Iterate over all managed tasks */
 	tcmi_slotvec_for_each_used_slot(slot, self->tasks) {
 		tcmi_slot_for_each(node, slot) {
 			task = tcmi_slot_entry(node, struct tcmi_task, node);
@@ -211,13 +536,26 @@ static int tcmi_penmigman_migrate_all_home(void *obj, void *data) {
 		};
 	};
 	tcmi_slotvec_unlock(self->tasks);
-	mdbg(INFO3, "Penmigman migrate all home done");
+}
 
-	return 0;
+/** 
+ * \<\<private\>\> Called whenever a task leaves the manager, wakes
+ * up the drain thread that may be waiting for it.
+ *
+ * @param *self - pointer to this migration manager instance
+ * @param *task - task that has been removed
+ */
+static void tcmi_penmigman_task_removed(struct tcmi_migman *self, struct tcmi_task *task)
+{
+	struct tcmi_penmigman *self_pen = TCMI_PENMIGMAN(self);
+
+	atomic_inc(&self_pen->drain_events);
+	wake_up(&self_pen->drain_wait);
 }
 
 static inline void tcmi_penmigman_free(struct tcmi_migman *self) {
-	/* struct tcmi_penmigman *self_ppn  = TCMI_PENMIGMAN(self); */
+	/* no-op when the manager has been stopped */
+	tcmi_nspool_stop(&TCMI_PENMIGMAN(self)->ns_pool);
 	
 	/** 
 		TODO: We cannot do it so simply as this method won't get called if there are tasks pointing to the migman.. either tasks should not keep reference to migman
@@ -231,12 +569,22 @@ static inline void tcmi_penmigman_free(struct tcmi_migman *self) {
 /** 
  * \<\<private\>\> Called on stop request
  * 
- * Emigrates all contained tasks back to home node (asynchronously - only emigration requests are issued in context of this method)
+ * Stops the namespace pool and emigrates all contained tasks back to home node (asynchronously - only emigration requests are issued in context of this method)
+ * A running drain is stopped, the remaining guests are requested at once instead of being throttled,
+ * so they all have been asked to leave by the time the disconnection is reported.
  *
  * @param *self - pointer to this migration manager instance
  */
 static void tcmi_penmigman_stop(struct tcmi_migman *self, int remote_requested) {
-    tcmi_penmigman_migrate_all_home(self, NULL);
+    /* no more immigrations, release the prepared namespaces */
+    tcmi_nspool_stop(&TCMI_PENMIGMAN(self)->ns_pool);
+    spin_lock(&TCMI_PENMIGMAN(self)->drain_lock);
+    TCMI_PENMIGMAN(self)->drain_stopped = 1;
+    spin_unlock(&TCMI_PENMIGMAN(self)->drain_lock);
+    wake_up(&TCMI_PENMIGMAN(self)->drain_wait);
+    tcmi_penmigman_request_all_home(self);
+    /* pages of the CCN are of no use to anybody else */
+    tcmi_ckpt_pagecache_forget(TCMI_PENMIGMAN(self)->cache_owner);
     
     director_node_disconnected(tcmi_migman_slot_index(self), 0, remote_requested);
 }
@@ -260,6 +608,64 @@ static void tcmi_penmigman_send_signal(struct tcmi_migman *self, int pid, siginf
 		send_sig_info(sig, info, task);
 }
 
+/**
+ * \<\<private\>\> Delivers the standard signals a shadow has
+ * coalesced into one message. The signals are sent in ascending
+ * order, each with the siginfo of its first occurrence on the CCN.
+ *
+ * @param *self - pointer to this migration manager instance
+ * @param *m - signal set message
+ */
+static void tcmi_penmigman_send_sigset(struct tcmi_migman *self, struct tcmi_sigset_msg *m)
+{
+	struct task_struct *task;
+	int sig;
+
+	rcu_read_lock();
+	task = task_find_by_pid(tcmi_sigset_msg_pid(m));
+	mdbg(INFO2, "Sending signal set %x to task %p (PID %d)", tcmi_sigset_msg_mask(m), task, tcmi_sigset_msg_pid(m));
+	for (sig = 1; task && sig <= TCMI_SIGSET_MAX; sig++) {
+		if (tcmi_sigset_msg_has(m, sig))
+			send_sig_info(sig, tcmi_sigset_msg_info(m, sig), task);
+	}
+	rcu_read_unlock();
+}
+
+
+/**
+ * \<\<private\>\> Pins pages of the page cache, whose hashes are
+ * offered by a migrating process, and replies with the page cache
+ * session and the bitmap of pinned pages. When the session can't be
+ * created, an empty session is announced and the process sends all
+ * pages.
+ *
+ * @param *self - pointer to this migration manager instance
+ * @param *m - page hashes message
+ */
+static void tcmi_penmigman_page_hashes(struct tcmi_migman *self, struct tcmi_page_hashes_msg *m)
+{
+	struct tcmi_ckpt_pagecache_session *session = NULL;
+	struct tcmi_msg *resp;
+	u_int32_t count = tcmi_page_hashes_msg_count(m);
+	u_int8_t *known;
+
+	if ((known = vmalloc(tcmi_ckpt_pagecache_bitmap_size(count))))
+		session = tcmi_ckpt_pagecache_session_new(TCMI_PENMIGMAN(self)->cache_owner,
+							  tcmi_page_hashes_msg_hashes(m),
+							  count, known);
+	if (!session) {
+		vfree(known);
+		known = NULL;
+		count = 0;
+	}
+	if (!(resp = tcmi_page_hashes_resp_msg_new_tx(tcmi_msg_req_id(TCMI_MSG(m)), 
+						       session ? tcmi_ckpt_pagecache_session_id(session) : 0,
+						       count, known))) {
+		mdbg(ERR3, "Failed to create page hashes response");
+		return;
+	}
+	tcmi_msg_send_anonymous(resp, tcmi_migman_sock(self));
+}
 
 /**
  * \<\<private\>\> Processes a TCMI message m. 
@@ -305,6 +711,9 @@ static void tcmi_penmigman_process_msg(struct tcmi_migman *self, struct tcmi_msg
 			tcmi_penmigman_send_signal(self, TCMI_SIGNAL_MSG(m)->pid,
 					&TCMI_SIGNAL_MSG(m)->info);
 			break;
+		case TCMI_SIGSET_MSG_ID:
+			tcmi_penmigman_send_sigset(self, TCMI_SIGSET_MSG(m));
+			break;
 		case TCMI_P_EMIGRATE_MSG_ID:
 			minfo(INFO1, "Physical emigrate message has arrived..");
 			if (tcmi_migcom_immigrate(m, self) < 0) {
@@ -317,6 +726,9 @@ static void tcmi_penmigman_process_msg(struct tcmi_migman *self, struct tcmi_msg
 				}
 			}
 			break;
+		case TCMI_PAGE_HASHES_MSG_ID:
+			tcmi_penmigman_page_hashes(self, TCMI_PAGE_HASHES_MSG(m));
+			break;
 		case TCMI_GENERIC_USER_MSG_ID:
 			user_msg = TCMI_GENERIC_USER_MSG(m);
 			minfo(INFO1, "User message arrived in pen.");
@@ -345,6 +757,7 @@ static struct tcmi_migman_ops penmigman_ops = {
 //	.free = tcmi_penmigman_free,
 	.stop = tcmi_penmigman_stop,
 	.process_msg = tcmi_penmigman_process_msg,
+	.task_removed = tcmi_penmigman_task_removed,
 };
 
 /**
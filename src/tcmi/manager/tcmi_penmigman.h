@@ -32,9 +32,14 @@
 #define _TCMI_PENMIGMAN_H
 
 #include <linux/wait.h>
+#include <linux/spinlock.h>
 
 #include "tcmi_migman.h"
 #include <tcmi/migration/fs/fs_mount_params.h>
+#include <tcmi/migration/tcmi_nspool.h>
+
+struct tcmi_page_hashes_msg;
+struct tcmi_sigset_msg;
 
 /** @defgroup tcmi_penmigman_class tcmi_penmigman class 
  *
@@ -48,6 +53,16 @@
  * There are specific tasks that it needs to accomplish:
  * - authenticate at the CCN that it is connected to
  * - accept migrating tasks
+ * - keep a pool of namespaces prepared for immigrating tasks, its
+ * size is controlled by the ns-pool-size file
+ * - drain the node - migrate all guests home on request of the
+ * migrate-home-all file or when the manager stops. The guests are
+ * migrated by a drain thread, up to migrate-home-parallel of them at
+ * once, so that the transfers saturate the link but don't starve
+ * each other. The migrate-home-progress file reports the number of
+ * guests of the last drain, how many of them have left the node, how
+ * many couldn't be requested to migrate and how many are migrating
+ * right now.
  *
  * 
  * @{
@@ -63,13 +78,53 @@ struct tcmi_penmigman {
 	struct tcmi_migman super;
 	/** TCMI ctlfs - migrate-home-all file */
 	struct tcmi_ctlfs_entry *f_mighome_all;
+	/** TCMI ctlfs - ns-pool-size file */
+	struct tcmi_ctlfs_entry *f_ns_pool_size;
+	/** TCMI ctlfs - migrate-home-parallel file */
+	struct tcmi_ctlfs_entry *f_mighome_parallel;
+	/** TCMI ctlfs - migrate-home-progress file */
+	struct tcmi_ctlfs_entry *f_mighome_progress;
+
+	/** serializes access to the drain state */
+	spinlock_t drain_lock;
+	/** set while a drain thread is running */
+	int drain_running;
+	/** set when the manager stops, no drain is started or continued */
+	int drain_stopped;
+	/** maximum number of guests migrating home at once */
+	int drain_parallel;
+	/** progress of the last drain - guests total, gone, failed, in flight */
+	int drain_progress[4];
+	/** counts tasks removed from the manager, wakes up the drain thread */
+	atomic_t drain_events;
+	/** the drain thread waits here for the guests to leave */
+	wait_queue_head_t drain_wait;
 
 	/** Mount params to be used when starting processes from associated CCN */
 	struct fs_mount_params mount_params;
+
+	/** Namespaces prepared for tasks immigrating from the CCN */
+	struct tcmi_nspool ns_pool;
+
+	/** page cache owner of the pages received from the CCN */
+	u_int64_t cache_owner;
 };
 /** Casts to the CCN migration manager. */
 #define TCMI_PENMIGMAN(migman) ((struct tcmi_penmigman *)migman)
 
+/** Default number of guests migrating home at once during a drain */
+#define TCMI_PENMIGMAN_DRAIN_PARALLEL 4
+/** Maximum number of guests migrating home at once during a drain */
+#define TCMI_PENMIGMAN_DRAIN_MAX_PARALLEL 32
+
+/** Indices of the drain progress values */
+enum {
+	TCMI_PENMIGMAN_DRAIN_TOTAL,
+	TCMI_PENMIGMAN_DRAIN_GONE,
+	TCMI_PENMIGMAN_DRAIN_FAILED,
+	TCMI_PENMIGMAN_DRAIN_IN_FLIGHT
+};
+
 
 /** \<\<public\>\> TCMI PEN migration manager constructor. */
 extern struct tcmi_migman* tcmi_penmigman_new(struct kkc_sock *sock, u_int32_t pen_id, struct tcmi_slot* manager_slot,
@@ -80,11 +135,34 @@ extern struct tcmi_migman* tcmi_penmigman_new(struct kkc_sock *sock, u_int32_t p
 /** \<\<public\>\> Tries authenticating itself at the CCN that it is connected to. */
 extern int tcmi_penmigman_auth_ccn(struct tcmi_penmigman *self,  int auth_data_length, char* auth_data);
 
+/**
+ * \<\<public\>\> Page cache owner accessor.
+ *
+ * @param *self - pointer to this migration manager instance
+ * @return owner of the pages received from the CCN
+ */
+static inline u_int64_t tcmi_penmigman_cache_owner(struct tcmi_penmigman *self) {
+	return self->cache_owner;
+}
+
 /** \<\<public\>\> Getter of mount params structure. */
 static inline struct fs_mount_params* tcmi_penmigman_get_mount_params(struct tcmi_penmigman *self) {
 	return &self->mount_params;
 };
 
+/** 
+ * \<\<public\>\> Takes a prepared namespace for an immigrating task.
+ *
+ * @param *self - pointer to this migration manager instance
+ * @param fsuid - fsuid of the immigrating task
+ * @param fsgid - fsgid of the immigrating task
+ * @return namespace or NULL if there is none prepared
+ */
+static inline struct tcmi_nspool_ns* tcmi_penmigman_ns_pool_get(struct tcmi_penmigman *self, int16_t fsuid, int16_t fsgid) 
+{
+	return tcmi_nspool_get(&self->ns_pool, fsuid, fsgid);
+}
+
 /********************** PRIVATE METHODS AND DATA ******************************/
 #ifdef TCMI_PENMIGMAN_PRIVATE
 
@@ -94,10 +172,41 @@ static int tcmi_penmigman_init_ctlfs_files(struct tcmi_migman *self);
 /** Destroys all TCMI ctlfs files. */
 static void tcmi_penmigman_stop_ctlfs_files(struct tcmi_migman *self);
 
+/** Reads the namespace pool size. */
+static int tcmi_penmigman_get_ns_pool_size(void *obj, void *data);
+/** Sets the namespace pool size. */
+static int tcmi_penmigman_set_ns_pool_size(void *obj, void *data);
+
+/** Reads the number of guests migrating home at once. */
+static int tcmi_penmigman_get_mighome_parallel(void *obj, void *data);
+/** Sets the number of guests migrating home at once. */
+static int tcmi_penmigman_set_mighome_parallel(void *obj, void *data);
+/** Reads progress of the last drain. */
+static int tcmi_penmigman_show_mighome_progress(void *obj, void *data);
+
+/** Starts a drain thread that migrates all guests home. */
+static int tcmi_penmigman_migrate_all_home(void *obj, void *data);
+/** Collects PIDs of all guests of the manager. */
+static int tcmi_penmigman_guest_pids(struct tcmi_migman *self, pid_t **pids);
+/** Checks whether a guest is still managed by the manager. */
+static int tcmi_penmigman_has_guest(struct tcmi_migman *self, pid_t pid);
+/** Drain thread. */
+static int tcmi_penmigman_drain_thread(void *data);
+/** Requests all guests to migrate home at once. */
+static void tcmi_penmigman_request_all_home(struct tcmi_migman *self);
+/** Wakes up the drain thread when a guest leaves. */
+static void tcmi_penmigman_task_removed(struct tcmi_migman *self, struct tcmi_task *task);
+
 
 /** Frees CCN mig. manager specific resources. */
 static void tcmi_penmigman_free(struct tcmi_migman *self);
 
+/** Delivers coalesced standard signals to a guest. */
+static void tcmi_penmigman_send_sigset(struct tcmi_migman *self, struct tcmi_sigset_msg *m);
+
+/** Pins cached pages offered by a migrating process. */
+static void tcmi_penmigman_page_hashes(struct tcmi_migman *self, struct tcmi_page_hashes_msg *m);
+
 /** Processes a TCMI message m. */
 static void tcmi_penmigman_process_msg(struct tcmi_migman *self, struct tcmi_msg *m);
 
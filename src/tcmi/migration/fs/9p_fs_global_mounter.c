@@ -4,44 +4,218 @@
 #include "9p_fs_helper.h"
 #include <tcmi/lib/util.h>
 
-#define MAX_MOUNT_ROOT_PATH 300
+#include <linux/slab.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/syscalls.h>
+#include <asm/uaccess.h>
+
+/** How long is a mount kept after its last use */
+#define SHARED_MOUNT_IDLE_TIMEOUT (60*HZ)
+
+/** Global mount shared by guests of a single CCN export and user */
+struct shared_9p_mount {
+	struct list_head node;
+	char mount_root[MAX_MOUNT_ROOT_PATH];
+	/** Number of private namespaces being created from the mount */
+	int users;
+	/** Last time the mount was in use */
+	unsigned long last_used;
+};
+
+/** All shared mounts */
+static LIST_HEAD(shared_mounts);
+/** Protects the shared mounts, it is held over the mount so that we do not do multiple mounts */
+static DEFINE_MUTEX(shared_mounts_lock);
+
+static void reap_idle_mounts(struct work_struct *work);
+static DECLARE_DELAYED_WORK(reaper_work, reap_idle_mounts);
 
 static void get_mount_root(const char* device, int fsuid, int fsgid, char* mount_root) {
 	// TODO: Now we have fixed "root" of mount to /mnt/clondike.. maybe we can parametrize that? ;)
 	sprintf(mount_root, "/mnt/clondike/%s-%d-%d", device, fsuid, fsgid);
 }
 
-static int global_9p_mount(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid) {	
+void shared_9p_mount_root(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid, char* mount_root) {
+	get_mount_root(mounter->params.mount_device, fsuid, fsgid, mount_root);
+}
+
+/**
+ * Checks whether there is a file system mounted at the path.
+ *
+ * @return -1 if there is no mount, otherwise the number of active mounts of the file system (i.e. the global one plus its 
+ * copies in private namespaces)
+ */
+static int get_mount_users(const char* mount_root) {
+	struct nameidata nd;
+	int users = -1;
+
+	if ( path_lookup(mount_root, LOOKUP_FOLLOW | LOOKUP_DIRECTORY ,&nd) )
+		return -1;
+
+	if ( nd.path.mnt->mnt_root == nd.path.dentry && strcmp(nd.path.mnt->mnt_sb->s_type->name, "9p") == 0 )
+		users = atomic_read(&nd.path.mnt->mnt_sb->s_active);
+
+	path_put(&nd.path);
+	return users;
+}
+
+static struct shared_9p_mount* find_shared_mount(const char* mount_root) {
+	struct shared_9p_mount* mount;
+
+	list_for_each_entry(mount, &shared_mounts, node) {
+		if ( strcmp(mount->mount_root, mount_root) == 0 )
+			return mount;
+	}
+
+	return NULL;
+}
+
+static int do_global_9p_mount(struct fs_mounter* mounter, const char* mount_root, int16_t fsuid, int16_t fsgid) {	
 	int err = 0;
-	char mount_buffer[MAX_MOUNT_ROOT_PATH], root_buffer[MAX_MOUNT_ROOT_PATH+6];
 	struct nameidata nd;
-	get_mount_root(mounter->params.mount_device, fsuid, fsgid, mount_buffer);
-	err = path_lookup(mount_buffer, LOOKUP_FOLLOW | LOOKUP_DIRECTORY ,&nd);
+
+	err = path_lookup(mount_root, LOOKUP_FOLLOW | LOOKUP_DIRECTORY ,&nd);
 	if ( err ) {
-		minfo(ERR1, "Failed to lookup path %s: %d. Trying to create", mount_buffer, err);
-		err = mk_dir(mount_buffer, 777);
+		minfo(ERR1, "Failed to lookup path %s: %d. Trying to create", mount_root, err);
+		err = mk_dir(mount_root, 777);
+	} else {
+		path_put(&nd.path);
 	}
 	if ( err ) {
 		// TODO: For now, the dirs for mount have to be precreated.. they can be for example
 		// auto created via a user-space controller. In kernel, we do not have access to mkdir, right?
-		minfo(ERR1, "Failed to lookup path %s: %d. Creation failed.", mount_buffer, err);
+		minfo(ERR1, "Failed to lookup path %s: %d. Creation failed.", mount_root, err);
+		return err;
+	}
+
+	// Mounted before we started tracking it (module reload)
+	if ( get_mount_users(mount_root) > 0 )
+		return 0;
+
+	if ( (err = mount_9p_fs(mount_root, mounter, fsuid, fsgid)) ) {
+		minfo(ERR1, "Mount failed with err %d", err);
 		return err;
 	}
-	sprintf(root_buffer, "%s/root", mount_buffer);
-	// TODO: In critical section so that we do not do multiple mounts
-	err = path_lookup(root_buffer, LOOKUP_FOLLOW | LOOKUP_DIRECTORY ,&nd);	
-	if ( err ) {
-		// We've checked that "root"/root does not exist (We assume existence of a root dir in root of fs
-		// => 9p is not yet globally mount => mount
-		if ( (err = mount_9p_fs(mount_buffer, mounter, fsuid, fsgid)) ) {
-			minfo(ERR1, "Mount failed with err %d", err);
-			return err;
-		}
-	}		
 
 	return 0;
 }
 
+int get_shared_9p_mount(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid) {	
+	int err = 0;
+	char mount_buffer[MAX_MOUNT_ROOT_PATH];
+	struct shared_9p_mount* mount;
+
+	get_mount_root(mounter->params.mount_device, fsuid, fsgid, mount_buffer);
+
+	mutex_lock(&shared_mounts_lock);
+	mount = find_shared_mount(mount_buffer);
+	if ( mount && get_mount_users(mount_buffer) > 0 ) {
+		mdbg(INFO2, "Reusing shared mount %s", mount_buffer);
+		goto out;
+	}
+
+	if ( (err = do_global_9p_mount(mounter, mount_buffer, fsuid, fsgid)) )
+		goto exit0;
+
+	if ( !mount ) {
+		mount = kmalloc(sizeof(struct shared_9p_mount), GFP_KERNEL);
+		if ( !mount ) {
+			// The mount is usable, it just won't be shared
+			minfo(ERR1, "Cannot track mount %s", mount_buffer);
+			goto exit0;
+		}
+		strcpy(mount->mount_root, mount_buffer);
+		mount->users = 0;
+		if ( list_empty(&shared_mounts) )
+			schedule_delayed_work(&reaper_work, SHARED_MOUNT_IDLE_TIMEOUT);
+		list_add(&mount->node, &shared_mounts);
+	}
+
+out:
+	mount->users++;
+	mount->last_used = jiffies;
+exit0:
+	mutex_unlock(&shared_mounts_lock);
+	return err;
+}
+
+void put_shared_9p_mount(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid) {	
+	char mount_buffer[MAX_MOUNT_ROOT_PATH];
+	struct shared_9p_mount* mount;
+
+	get_mount_root(mounter->params.mount_device, fsuid, fsgid, mount_buffer);
+
+	mutex_lock(&shared_mounts_lock);
+	mount = find_shared_mount(mount_buffer);
+	if ( mount && mount->users > 0 ) {
+		mount->users--;
+		mount->last_used = jiffies;
+	}
+	mutex_unlock(&shared_mounts_lock);
+}
+
+/**
+ * Unmounts global mounts that have not been used by any private namespace for SHARED_MOUNT_IDLE_TIMEOUT.
+ * Runs from the kernel workqueue, i.e. in the global namespace.
+ */
+static void reap_idle_mounts(struct work_struct *work) {
+	struct shared_9p_mount *mount, *tmp;
+	mm_segment_t old_fs;
+	int users, err;
+
+	mutex_lock(&shared_mounts_lock);
+	list_for_each_entry_safe(mount, tmp, &shared_mounts, node) {
+		if ( mount->users )
+			continue;
+
+		users = get_mount_users(mount->mount_root);
+		if ( users < 0 ) {
+			// Unmounted by someone else
+			list_del(&mount->node);
+			kfree(mount);
+			continue;
+		}
+		if ( users > 1 )
+			mount->last_used = jiffies;
+
+		if ( time_before(jiffies, mount->last_used + SHARED_MOUNT_IDLE_TIMEOUT) )
+			continue;
+
+		old_fs = get_fs();
+		set_fs(KERNEL_DS);
+		err = sys_umount((char __user *)mount->mount_root, 0);
+		set_fs(old_fs);
+		if ( err ) {
+			// Most likely some user-space mounts on top of it (ccfs)
+			mdbg(INFO2, "Cannot unmount idle mount %s: %d", mount->mount_root, err);
+			mount->last_used = jiffies;
+			continue;
+		}
+
+		minfo(INFO1, "Unmounted idle mount %s", mount->mount_root);
+		list_del(&mount->node);
+		kfree(mount);
+	}
+	if ( !list_empty(&shared_mounts) )
+		schedule_delayed_work(&reaper_work, SHARED_MOUNT_IDLE_TIMEOUT);
+	mutex_unlock(&shared_mounts_lock);
+}
+
+void destroy_shared_9p_mounts(void) {
+	struct shared_9p_mount *mount, *tmp;
+
+	cancel_delayed_work_sync(&reaper_work);
+
+	mutex_lock(&shared_mounts_lock);
+	list_for_each_entry_safe(mount, tmp, &shared_mounts, node) {
+		list_del(&mount->node);
+		kfree(mount);
+	}
+	mutex_unlock(&shared_mounts_lock);
+}
+
 static int chroot_to_mount(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid) {	
 	int err = 0;
 	char mount_buffer[MAX_MOUNT_ROOT_PATH];
@@ -61,7 +235,8 @@ struct fs_mounter* new_9p_global_fs_mounter(struct fs_mount_params* params) {
 	if ( !mounter )
 		return NULL;
 
-	mounter->global_mount = global_9p_mount;
+	mounter->global_mount = get_shared_9p_mount;
+	mounter->global_release = put_shared_9p_mount;
 	mounter->private_mount = chroot_to_mount;
 	mounter->free = NULL;
 	mounter->params = *params;
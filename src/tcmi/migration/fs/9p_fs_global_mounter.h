@@ -1,14 +1,36 @@
 #ifndef _9P_GLOBAL_FS_MOUNTER_H
 #define _9P_GLOBAL_FS_MOUNTER_H
 
+#include <linux/types.h>
+
 struct fs_mounter;
 struct fs_mount_params;
 
+/** Max length of a path where the global mount is performed */
+#define MAX_MOUNT_ROOT_PATH 300
+
 /**
  * 9p mounter handles mounting of Plan9 filesystem in a public namespace. It does not support any security right not.
+ *
+ * There is a single global mount per CCN export (device) and user, shared by all guests of the user. Guests get a copy of it 
+ * in their private namespace, so the CCN 9p server sees one session with warm caches instead of one per guest. 
+ * Mounts are reference counted while a namespace is being created from them and unmounted after they have not been 
+ * used by any namespace for SHARED_MOUNT_IDLE_TIMEOUT.
  */
 
 /** Creates a new instance of the 9p file system mounter */
 struct fs_mounter* new_9p_global_fs_mounter(struct fs_mount_params* params);
 
+/** Mounts the shared global mount, if it is not mounted yet, and takes a reference to it */
+int get_shared_9p_mount(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid);
+
+/** Releases a reference taken by get_shared_9p_mount, the mount is unmounted once idle */
+void put_shared_9p_mount(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid);
+
+/** Path of the shared global mount */
+void shared_9p_mount_root(struct fs_mounter* mounter, int16_t fsuid, int16_t fsgid, char* mount_root);
+
+/** Stops tracking of shared mounts, mounts are left mounted */
+void destroy_shared_9p_mounts(void);
+
 #endif
@@ -25,7 +25,9 @@ struct fs_mounter* new_9p_fs_mounter(struct fs_mount_params* params) {
 	if ( !mounter )
 		return NULL;
 
+	/* the user export must not appear in the global namespace, see the 9p-global mounter for shared mounts */
 	mounter->global_mount = NULL;
+	mounter->global_release = NULL;
 	mounter->private_mount = do_private_9p_mount;
 	mounter->free = NULL;
 	mounter->params = *params;
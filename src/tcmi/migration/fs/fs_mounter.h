@@ -12,6 +12,8 @@ struct fs_mounter {
 	struct fs_mount_params params;
 	/** Called, in context of a kernel process, it can make mounts to a global namespace*/
 	int (*global_mount)(struct fs_mounter* self, int16_t fsuid, int16_t fsgid);
+	/** Called, in context of a kernel process, once the private namespace has been created from the global one */
+	void (*global_release)(struct fs_mounter* self, int16_t fsuid, int16_t fsgid);
 	/** Called, in context of a new process, in its private namespace */
 	int (*private_mount)(struct fs_mounter* self, int16_t fsuid, int16_t fsgid);
 	/** Custom free method */
@@ -31,3 +31,8 @@ void free_mounter(struct fs_mounter* mounter) {
 
 	kfree(mounter);
 }
+
+/** Releases global state of all mounters, called on module unload */
+void destroy_mounters(void) {
+	destroy_shared_9p_mounts();
+}
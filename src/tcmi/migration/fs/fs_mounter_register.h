@@ -12,4 +12,7 @@ struct fs_mounter* get_new_mounter(struct fs_mount_params* params);
 /** Releases mounter instance */
 void free_mounter(struct fs_mounter* mounter);
 
+/** Releases global state of all mounters, called on module unload */
+void destroy_mounters(void);
+
 #endif
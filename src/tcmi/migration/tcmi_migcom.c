@@ -39,6 +39,8 @@
 #include <tcmi/migration/fs/fs_mounter_register.h>
 #include <tcmi/migration/fs/fs_mounter.h>
 #include "tcmi_npm_params.h"
+#include "tcmi_nspool.h"
+#include "tcmi_migtrace.h"
 
 #include <director/director.h>
 
@@ -90,7 +92,7 @@ exit0:
 	return err;
 }
 
-static const char proc_path[] = "/mnt/local/proc";
+static const char proc_path[] = TCMI_MIGCOM_LOCAL_PROC_PATH;
 /** Mounts local machine procfs into some directory in chrooted env, so that it can be later accessed if required */
 static int mount_local_procfs(struct kkc_sock* sock) {
 	struct nameidata nd;
@@ -146,13 +148,17 @@ static int tcmi_task_mount_proxyfs(void *self, struct tcmi_method_wrapper *wr) {
  * @param pid - task that is to be migrated
  * @param *migman - migration manager that will provide the communication
  * channel for the migrated task.
+ * @param readahead - number of pages of each heavy area populated on
+ * restart, 0 selects the default, negative value disables it
  * @return 0 upon success;
  */
-int tcmi_migcom_emigrate_ccn_ppm_p(pid_t pid, struct tcmi_migman *migman)
+int tcmi_migcom_emigrate_ccn_ppm_p(pid_t pid, struct tcmi_migman *migman, int readahead)
 {
 	int err = 0;
 	struct tcmi_task *shadow;
 
+	trace_tcmi_mig_request(pid, tcmi_migman_slot_index(migman), TCMI_MIGTRACE_EMIGRATE_PPM, 0);
+
 	/* create a new PPM shadow task for physical ckpt image  */
 	if (!(shadow = 
 	      tcmi_shadowtask_new(pid, migman, 
@@ -162,6 +168,7 @@ int tcmi_migcom_emigrate_ccn_ppm_p(pid_t pid, struct tcmi_migman *migman)
 		minfo(ERR3, "Error creating a shadow task");
 		goto exit0;
 	}
+	tcmi_shadowtask_set_readahead(shadow, readahead);
 
 	/* submit the emigrate method */
 	mdbg(INFO3, "Submitting emigrate_ppm_p");
@@ -203,6 +210,8 @@ int tcmi_migcom_emigrate_ccn_npm(pid_t pid, struct tcmi_migman *migman, struct p
 	int err = 0;
 	struct tcmi_task *shadow;
 
+	trace_tcmi_mig_request(pid, tcmi_migman_slot_index(migman), TCMI_MIGTRACE_EMIGRATE_NPM, 0);
+
 	/* create a new PPM shadow task for physical ckpt image  */
 	if (!(shadow = 
 	      tcmi_shadowtask_new(pid, migman, 
@@ -255,26 +264,15 @@ int tcmi_migcom_emigrate_ccn_npm(pid_t pid, struct tcmi_migman *migman, struct p
 
 };
 
-/** Helper struct to be passed to immigration statup thread */
-struct  immigrate_startup_params {
-	/** used to signal the thread the guest(or fs mount respectively) is ready */	
-	struct completion guest_ready, fs_ready;
-	/** Params for mounting of distributed fs */
-	struct fs_mount_params* mount_params;
-	/** Migman socket.. used to determine peers address so that we can mount its proxyfs */
-	struct kkc_sock* sock;
-	/** Credentials that can be used for fs mounting */
-	int16_t fsuid, fsgid;
-};
-
 /** 
  * \<\<public\>\> Immigrates a task - handles accepting the task on
  * the PEN side.  This method immigrates a new task based on an
  * emigration message that a PEN has received as follows:
  *
- * - creates a new kernel thread that will wait until the new guest
- * process is instantiated (waits with timeout on guest_ready
- * completion)
+ * - takes a prepared namespace from the namespace pool of the
+ * migration manager. If there is none, it creates a new kernel thread
+ * with a private namespace that will wait until the new guest
+ * process is instantiated (waits on guest_ready completion)
  * - instantiates a new guest task. 
  * - delivers the migration message to it and makes a necessary setup,
  * so that the guest task processes the message as soon as it becomes
@@ -296,16 +294,16 @@ int tcmi_migcom_immigrate(struct tcmi_msg *m, struct tcmi_migman *migman)
 	int pid;
 	int wait_for_msg = 0;
 
-	struct fs_mounter* mounter;
-
-	struct immigrate_startup_params startup_params;
+	struct tcmi_nspool_ns *ns;
 	struct tcmi_task *guest;
 	struct tcmi_penmigman* penmigman = TCMI_PENMIGMAN(migman);
 	struct tcmi_p_emigrate_msg* msg = TCMI_P_EMIGRATE_MSG(m);
 	int accept = 0;
 
 
-	int call_res = director_immigration_request(tcmi_migman_slot_index(migman), tcmi_p_emigrate_msg_euid(msg), tcmi_p_emigrate_msg_exec_name(msg), &accept);
+	int call_res;
+
+	call_res = director_immigration_request(tcmi_migman_slot_index(migman), tcmi_p_emigrate_msg_euid(msg), tcmi_p_emigrate_msg_exec_name(msg), &accept);
 	if ( call_res == 0 ) {
 		if ( !accept ) {
 			mdbg(INFO2, "Immigration rejected by director.");
@@ -314,46 +312,29 @@ int tcmi_migcom_immigrate(struct tcmi_msg *m, struct tcmi_migman *migman)
 		}
 	}
 
-
-	init_completion(&startup_params.guest_ready);
-	init_completion(&startup_params.fs_ready);
-	startup_params.mount_params = tcmi_penmigman_get_mount_params(penmigman);
-	startup_params.sock = tcmi_migman_sock(migman);
-	startup_params.fsuid = tcmi_p_emigrate_msg_fsuid(msg);
-	startup_params.fsgid = tcmi_p_emigrate_msg_fsgid(msg);
-
-	// Global part of mount
-	mounter = get_new_mounter(startup_params.mount_params);	
-	if ( mounter && mounter->global_mount ) {
-		/* Some file system mounter is registered => perform the mount */
-		mdbg(INFO2, "Doing global mount");
-		err = mounter->global_mount(mounter, startup_params.fsuid, startup_params.fsgid);
-		if ( err ) {
-			free_mounter(mounter);
+	ns = tcmi_penmigman_ns_pool_get(penmigman, tcmi_p_emigrate_msg_fsuid(msg), 
+					tcmi_p_emigrate_msg_fsgid(msg));
+	if ( ns ) {
+		mdbg(INFO2, "Using prepared namespace of thread %d", ns->pid);
+	} else {
+		if (!(ns = tcmi_nspool_ns_new(migman, tcmi_p_emigrate_msg_fsuid(msg), 
+					      tcmi_p_emigrate_msg_fsgid(msg)))) {
+			err = -ENOMEM;
 			goto exit0;
 		}
+		if ((err = tcmi_migcom_prepare_ns(ns)))
+			goto exit1;
 	}
-	free_mounter(mounter);
-
-
-	/* new thread is started with a private namespace so that the mounts in that thread are not global */
-	if ((pid = kernel_thread(tcmi_migcom_migrated_task, &startup_params, CLONE_NEWNS)) < 0) {
-		mdbg(ERR3, "Cannot start kernel thread for guest process %d", pid);
-		goto exit0;
-	}
-
-	/* before we proceed with restarting, we have to wait till the file system mount is ready (if it is performed) */
-	if ((err = wait_for_completion_interruptible(&startup_params.fs_ready))) {
-		minfo(ERR3, "Received signal fs not ready");
-		goto exit0;
-	}
+	pid = ns->pid;
+	trace_tcmi_mig_guest_spawned(pid, tcmi_migman_slot_index(migman), TCMI_MIGTRACE_IMMIGRATE, 0);
 	
 	if (!(guest = tcmi_guesttask_new(pid, migman, 
 					tcmi_migman_sock(migman), 
 					tcmi_migman_migproc_dir(migman), 
 					tcmi_migman_root(migman)))) {
 		mdbg(ERR3, "Error creating a guest task");
-		goto exit0;
+		err = -EINVAL;
+		goto exit1;
 	}
 	/* have the guest task deliver the message to itself, extra message reference is for the guest.*/
 	if (tcmi_task_deliver_msg(guest, tcmi_msg_get(m)) < 0) {
@@ -369,16 +350,19 @@ int tcmi_migcom_immigrate(struct tcmi_msg *m, struct tcmi_migman *migman)
 	if (tcmi_taskhelper_attach(guest, tcmi_migcom_mig_mode_handler) < 0) {
 		minfo(ERR3, "Failed attaching guest PID=%d to its thread", 
 		      tcmi_task_local_pid(guest));
-		goto exit1;
+		err = -EINVAL;
+		goto exit2;
 	}
 
 	/* signal the new thread that the guest is ready. */
-	complete(&startup_params.guest_ready);
+	complete(&ns->guest_ready);
+	tcmi_nspool_ns_put(ns);
 
 	/* wait for pickup */
 	if (tcmi_taskhelper_wait_for_pick_up_timeout(guest, 2*HZ) < 0) {
 		mdbg(ERR1, "Guest not picked up: %p!!!!", guest);
-		goto exit1;
+		tcmi_task_put(guest);
+		return -EINVAL;
 	}
 	mdbg(INFO2, "Guest successfully picked up: %p", guest);
 	director_immigration_confirmed(tcmi_migman_slot_index(migman), tcmi_p_emigrate_msg_euid(msg), tcmi_p_emigrate_msg_exec_name(msg), pid, tcmi_p_emigrate_msg_reply_pid(msg));	
@@ -386,13 +370,81 @@ int tcmi_migcom_immigrate(struct tcmi_msg *m, struct tcmi_migman *migman)
 	return 0;
 
 	/* error handling */
- exit1:
+ exit2:
 	tcmi_task_put(guest);
+ exit1:
+	/* the thread would wait for the guest forever */
+	tcmi_nspool_ns_cancel(ns);
  exit0:
 	return err;
 
 }
 
+/** 
+ * \<\<public\>\> Prepares a private namespace for a task that is
+ * going to immigrate:
+ *
+ * - performs the global part of the distributed filesystem mount,
+ * the global mount is shared by all namespaces of the user
+ * - starts a new kernel thread with a private namespace, that does
+ * the private mounts and then waits until a guest task is attached
+ * to it (see tcmi_migcom_migrated_task())
+ * - waits till the thread finishes the mounts
+ *
+ * The namespace is either used immediately by an immigration or kept
+ * in the namespace pool of the migration manager. When it is not
+ * needed, it has to be released by tcmi_nspool_ns_cancel(), so that
+ * the thread exits.
+ *
+ * @param *ns - namespace descriptor to be prepared
+ * @return 0 upon success, ns->pid is the PID of the thread
+ */
+int tcmi_migcom_prepare_ns(struct tcmi_nspool_ns *ns)
+{
+	int err = 0;
+	int pid;
+	struct fs_mounter* mounter;
+
+	// Global part of mount
+	mounter = get_new_mounter(ns->mount_params);	
+	if ( mounter && mounter->global_mount ) {
+		/* Some file system mounter is registered => perform the mount */
+		mdbg(INFO2, "Doing global mount");
+		err = mounter->global_mount(mounter, ns->fsuid, ns->fsgid);
+		if ( err ) {
+			free_mounter(mounter);
+			goto exit0;
+		}
+	}
+
+	/* extra reference is for the thread */
+	tcmi_nspool_ns_get(ns);
+	/* new thread is started with a private namespace so that the mounts in that thread are not global */
+	pid = kernel_thread(tcmi_migcom_migrated_task, ns, CLONE_NEWNS);
+	/* the namespace holds a copy of the global mount now */
+	if ( mounter && mounter->global_mount && mounter->global_release )
+		mounter->global_release(mounter, ns->fsuid, ns->fsgid);
+	free_mounter(mounter);
+	if (pid < 0) {
+		mdbg(ERR3, "Cannot start kernel thread for guest process %d", pid);
+		tcmi_nspool_ns_put(ns);
+		err = pid;
+		goto exit0;
+	}
+	ns->pid = pid;
+
+	/* before we proceed with restarting, we have to wait till the file system mount is ready (if it is performed) */
+	if ((err = wait_for_completion_interruptible(&ns->fs_ready))) {
+		minfo(ERR3, "Received signal fs not ready");
+		goto exit0;
+	}
+	err = ns->err;
+
+	/* error handling */
+ exit0:
+	return err;
+}
+
 
 /** 
  * \<\<public\>\> Migrates a task back to its home node using
@@ -411,11 +463,34 @@ int tcmi_migcom_migrate_home_ppm_p(pid_t pid)
 	/* set priority for the method - causes all methods to be flushed */
 	int prio = 1;
 	mdbg(INFO4, "request to migrate home pid %d", pid);
+	trace_tcmi_mig_request(pid, -1, TCMI_MIGTRACE_HOME_PPM_P, 0);
 	return tcmi_taskhelper_notify_by_pid(pid, tcmi_task_migrateback_ppm_p, 
 					     NULL, 0, prio);
 }
 
 
+/** 
+ * \<\<public\>\> Migrates a task back to its home node using
+ * preemptive migration with a virtual (in-memory) checkpoint image.
+ * The checkpoint is created in kernel memory and streamed over the
+ * migration manager socket, so no filesystem is involved. The
+ * notification is delivered the same way as in
+ * tcmi_migcom_migrate_home_ppm_p().
+ *
+ * @param pid - task that is to be migrated
+ * @return 0 upon success;
+ */
+int tcmi_migcom_migrate_home_ppm_v(pid_t pid)
+{
+	/* set priority for the method - causes all methods to be flushed */
+	int prio = 1;
+	mdbg(INFO4, "request to migrate home pid %d (in-memory image)", pid);
+	trace_tcmi_mig_request(pid, -1, TCMI_MIGTRACE_HOME_PPM_V, 0);
+	return tcmi_taskhelper_notify_by_pid(pid, tcmi_task_migrateback_ppm_v, 
+					     NULL, 0, prio);
+}
+
+
 /** @addtogroup tcmi_migcom_class
  *
  * @{
@@ -430,7 +505,9 @@ int tcmi_migcom_migrate_home_ppm_p(pid_t pid)
  * - waits until signalled, that the guest is ready
  * - runs its migration mode handler (this picks up the task).
  *
- * @param *data - pointer to startup parameters
+ * The thread exits when the namespace is cancelled instead.
+ *
+ * @param *data - namespace descriptor, the thread owns a reference
  * @return shouldn't return as the execve will overlay current
  * execution image.
  * @todo process identity should be set according to the
@@ -439,17 +516,21 @@ int tcmi_migcom_migrate_home_ppm_p(pid_t pid)
 static int tcmi_migcom_migrated_task(void *data)
 {
 	int err = -EINVAL;
-	struct immigrate_startup_params* startup_params = (struct immigrate_startup_params*) data;
-	struct completion *guest_ready = &startup_params->guest_ready;
-	struct completion *fs_ready = &startup_params->fs_ready;
+	struct tcmi_nspool_ns* ns = (struct tcmi_nspool_ns*) data;
+	struct completion *guest_ready = &ns->guest_ready;
+	struct completion *fs_ready = &ns->fs_ready;
 	struct fs_mounter* mounter;
 	struct cred* new_cred;
 	
 	mdbg(INFO2, "New potential guest thread started. Pid: %d", current->pid);
 
 	new_cred = prepare_creds();
-	if ( !new_cred )
-		return -ENOMEM;
+	if ( !new_cred ) {
+		err = -ENOMEM;
+		ns->err = err;
+		complete(fs_ready);
+		goto exit0;
+	}
 
 	/* set process credentials */
 	new_cred->uid = new_cred->euid = new_cred->suid = new_cred->fsuid = 
@@ -473,34 +554,37 @@ static int tcmi_migcom_migrated_task(void *data)
 	sys_close(1);
 	sys_close(2);
 
-	mdbg(INFO2, "Creating mounter: %s", startup_params->mount_params->mount_type);
-	mounter = get_new_mounter(startup_params->mount_params);	
+	mdbg(INFO2, "Creating mounter: %s", ns->mount_params->mount_type);
+	mounter = get_new_mounter(ns->mount_params);	
 	mdbg(INFO2, "Created mounter: %p", mounter);
 	if ( mounter ) {
 		/* Some file system mounter is registered => perform the mount */
-		err = mounter->private_mount(mounter, startup_params->fsuid, startup_params->fsgid);
+		err = mounter->private_mount(mounter, ns->fsuid, ns->fsgid);
 		if ( !err )
 			mdbg(INFO2, "Private Mount succeeded");
 		free_mounter(mounter);
 		mdbg(INFO2, "Freed mounter");
 		if ( err ) {
 			/* We must notify anyway to prevent blocking */
+			ns->err = err;
 			complete(fs_ready);	
 			goto exit0;
 		}		
 	}
 	
-	err = mount_proxyfs(startup_params->sock);
+	err = mount_proxyfs(ns->sock);
 	if ( !err )
-		err = mount_local_procfs(startup_params->sock);
+		err = mount_local_procfs(ns->sock);
 
 	if ( err ) {
 		// We must notify anyway to prevent blocking
+		ns->err = err;
 		complete(fs_ready);	
 		goto exit0;
 	}
 
-	/* Notify about file system mount finished */
+	/* Notify about file system mount finished, the namespace doesn't know its migration manager */
+	trace_tcmi_mig_mounts_done(current->pid, -1, TCMI_MIGTRACE_IMMIGRATE, 0);
 	complete(fs_ready);
 
 	mdbg(INFO2, "Starting new thread for migrating task..");
@@ -508,19 +592,25 @@ static int tcmi_migcom_migrated_task(void *data)
 		minfo(INFO1, "Received signal guest not ready");
 		goto exit0;
 	}
+	if (ns->cancelled) {
+		mdbg(INFO2, "Namespace cancelled, no guest will come");
+		err = -EINVAL;
+		goto exit0;
+	}
 	mdbg(INFO3, "Guest task is ready by now..");
+	tcmi_nspool_ns_put(ns);
 
 	/* migration mode handler picks up the task  */
 	if (tcmi_taskhelper_run_mig_mode_handler() < 0) {
 		mdbg(ERR3, "Failed to run migration mode handler");
-		goto exit0;
+		return -EINVAL;
 	}
 
 	return 0;
 
 	/* error handling */
  exit0:
-
+	tcmi_nspool_ns_put(ns);
 	return err;
 }
 
@@ -578,6 +668,8 @@ int tcmi_migcom_shadow_fork(struct task_struct* parent, struct task_struct* chil
 		minfo(ERR3, "Error creating a shadow task for forked child");
 		goto exit0;
 	}
+	if (tcmi_shadowtask_leasing(TCMI_TASK(parent->tcmi.tcmi_task)))
+		tcmi_shadowtask_set_leased(shadow, task_pgrp_vnr(parent));
 	
 	// Submit process message so that the task is started in a main waiting loop
 	// First expected message to get is either about successful start, or about start failure
@@ -652,6 +744,9 @@ static void tcmi_migcom_mig_mode_handler(void)
 	case TCMI_TASK_KILL_ME:
 		mdbg(INFO2, "KILL ME - request %d", res);
 		tmp = tcmi_taskhelper_detach();
+		/* a stub dying unclaimed has to be reaped without its parent */
+		if (tcmi_task_get_type(tmp) == shadow)
+			tcmi_shadowtask_release_lease(tmp);
 		/* get the exit code prior terminating. */
 		exit_code = tcmi_task_exit_code(tmp);
 		tcmi_task_put(tmp);
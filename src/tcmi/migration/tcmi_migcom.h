@@ -48,8 +48,11 @@ struct tcmi_npm_params;
  * @{
  */
 
+/** Local procfs mount point in the private namespace of an immigrated task */
+#define TCMI_MIGCOM_LOCAL_PROC_PATH "/mnt/local/proc"
+
 /** \<\<public\>\> Migrates a task from a CCN to a PEN */
-extern int tcmi_migcom_emigrate_ccn_ppm_p(pid_t pid, struct tcmi_migman *migman);
+extern int tcmi_migcom_emigrate_ccn_ppm_p(pid_t pid, struct tcmi_migman *migman, int readahead);
 
 /** \<\<public\>\> Migrates non-preemptively a task from a CCN to a PEN */
 extern int tcmi_migcom_emigrate_ccn_npm(pid_t pid, struct tcmi_migman *migman, struct pt_regs* regs, struct tcmi_npm_params* npm_params);
@@ -57,9 +60,16 @@ extern int tcmi_migcom_emigrate_ccn_npm(pid_t pid, struct tcmi_migman *migman, s
 /** \<\<public\>\> Immigrates a task - handles accepting the task on the PEN side */
 extern int tcmi_migcom_immigrate(struct tcmi_msg *m, struct tcmi_migman *migman);
 
+struct tcmi_nspool_ns;
+/** \<\<public\>\> Prepares a private namespace for an immigrating task. */
+extern int tcmi_migcom_prepare_ns(struct tcmi_nspool_ns *ns);
+
 /** \<\<public\>\> Migrates task home from PEN (method can be used both on PEN or CCN) */
 extern int tcmi_migcom_migrate_home_ppm_p(pid_t pid);
 
+/** \<\<public\>\> Migrates task home from PEN using an in-memory checkpoint image */
+extern int tcmi_migcom_migrate_home_ppm_v(pid_t pid);
+
 /** \<\<public\>\> Fork of guest */
 extern int tcmi_migcom_guest_fork(struct task_struct* parent, struct task_struct* child, struct tcmi_migman* migman);
 
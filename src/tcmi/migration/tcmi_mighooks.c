@@ -33,6 +33,8 @@
 #include <linux/module.h>
 #include <linux/vmalloc.h>
 #include <linux/resource.h>
+#include <linux/fs.h>
+#include <linux/err.h>
 
 #include <tcmi/task/tcmi_taskhelper.h>
 #include <tcmi/comm/tcmi_vfork_done_procmsg.h>
@@ -179,15 +181,29 @@ static void tcmi_try_npm_on_exec(const char *filename, char __user * __user * ar
 		struct tcmi_man* man, int is_guest) 
 {
 	struct rusage rusage;
+	struct file *file = NULL;
 	mm_segment_t old_fs;
 	int migman_to_use = -1;
 	int migrate_home = 0;
+	int res;
+
+	// The binary is resolved just once, the director cache keys on what is really executed. Nothing to key on without cached decisions
+	if ( !director_npm_cache_empty() ) {
+		file = open_exec(filename);
+		if ( IS_ERR(file) )
+			return;
+	}
 
 	old_fs = get_fs();
 	set_fs(get_ds());
 	getrusage(current, RUSAGE_SELF, &rusage);
 	set_fs(old_fs);
-	if (director_npm_check(current->pid, current_euid(), is_guest, filename, argv, envp, &migman_to_use, &migrate_home, &rusage) != 1 )
+	res = director_npm_check(current->pid, current_euid(), is_guest, filename, file, argv, envp, &migman_to_use, &migrate_home, &rusage);
+	if ( file ) {
+		allow_write_access(file);
+		fput(file);
+	}
+	if ( res != 1 )
 		return;
 
 	migrate_home = is_guest ? migrate_home : 0;
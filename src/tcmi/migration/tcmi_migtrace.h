@@ -0,0 +1,156 @@
+/**
+ * @file tcmi_migtrace.h - tracepoints marking the stages of a migration
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/** @defgroup tcmi_migtrace tcmi migration tracepoints
+ *
+ * @ingroup tcmi_migration_group
+ *
+ * Each stage of a migration fires a tracepoint of the \em tcmi
+ * trace system, so that ftrace or perf can provide a timestamped
+ * breakdown of a migration latency without the text logging. The
+ * stages of an emigration follow in this order:
+ *
+ * - tcmi_mig_request - migration has been requested (CCN)
+ * - tcmi_mig_frozen - the process and its threads are frozen in the
+ * migration mode (CCN)
+ * - tcmi_mig_ckpt_start, tcmi_mig_ckpt_end - checkpoint is being
+ * written (CCN)
+ * - tcmi_mig_msg_sent - emigration message along with the streamed
+ * image has been sent (CCN)
+ * - tcmi_mig_guest_spawned - thread that becomes the guest is
+ * available (PEN)
+ * - tcmi_mig_mounts_done - the thread has done its mounts, for a
+ * namespace from the pool this happens ahead of the migration (PEN)
+ * - tcmi_mig_restart_begin - restart from the image starts (PEN)
+ * - tcmi_mig_restart_end - the process has been restarted and is
+ * about to execute its first user space instruction (PEN)
+ * - tcmi_mig_shadow_notified - the shadow has received the guest
+ * started confirmation (CCN)
+ *
+ * Migration home fires the request, frozen, checkpoint, message and
+ * restart stages, with the roles of the nodes swapped.
+ *
+ * Each event carries the local PID of the process, slot index of its
+ * migration manager (i.e. the peer node, -1 if unknown), mode of the
+ * migration and the number of image bytes processed so far.
+ *
+ * The checkpoint and restart stages are fired by the checkpoint
+ * component, that is loaded before the TCMI module. Therefore the
+ * tracepoints are created and exported by tcmi_ckptcom.c.
+ *
+ * @{
+ */
+#ifndef _TCMI_MIGTRACE_MODE_H
+#define _TCMI_MIGTRACE_MODE_H
+
+/** Modes of migrations reported by the tracepoints */
+enum tcmi_migtrace_mode {
+	/** preemptive emigration to a PEN */
+	TCMI_MIGTRACE_EMIGRATE_PPM,
+	/** non-preemptive emigration to a PEN */
+	TCMI_MIGTRACE_EMIGRATE_NPM,
+	/** preemptive migration home via checkpoint file */
+	TCMI_MIGTRACE_HOME_PPM_P,
+	/** preemptive migration home via in-memory image */
+	TCMI_MIGTRACE_HOME_PPM_V,
+	/** non-preemptive migration home */
+	TCMI_MIGTRACE_HOME_NPM,
+	/** receiving side of an emigration, the image decides PPM/NPM */
+	TCMI_MIGTRACE_IMMIGRATE,
+};
+
+#endif /* _TCMI_MIGTRACE_MODE_H */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM tcmi
+
+#if !defined(_TCMI_MIGTRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TCMI_MIGTRACE_H
+
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(tcmi_mig_stage,
+
+	TP_PROTO(pid_t pid, int node, int mode, u64 size),
+
+	TP_ARGS(pid, node, mode, size),
+
+	TP_STRUCT__entry(
+		__field(pid_t, pid)
+		__field(int, node)
+		__field(int, mode)
+		__field(u64, size)
+	),
+
+	TP_fast_assign(
+		__entry->pid = pid;
+		__entry->node = node;
+		__entry->mode = mode;
+		__entry->size = size;
+	),
+
+	TP_printk("pid=%d node=%d mode=%s size=%llu",
+		  __entry->pid, __entry->node,
+		  __print_symbolic(__entry->mode,
+				   { TCMI_MIGTRACE_EMIGRATE_PPM, "emigrate_ppm" },
+				   { TCMI_MIGTRACE_EMIGRATE_NPM, "emigrate_npm" },
+				   { TCMI_MIGTRACE_HOME_PPM_P, "home_ppm_p" },
+				   { TCMI_MIGTRACE_HOME_PPM_V, "home_ppm_v" },
+				   { TCMI_MIGTRACE_HOME_NPM, "home_npm" },
+				   { TCMI_MIGTRACE_IMMIGRATE, "immigrate" }),
+		  (unsigned long long)__entry->size)
+);
+
+#define DEFINE_TCMI_MIG_STAGE(name)					\
+DEFINE_EVENT(tcmi_mig_stage, name,					\
+	TP_PROTO(pid_t pid, int node, int mode, u64 size),		\
+	TP_ARGS(pid, node, mode, size))
+
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_request);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_frozen);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_ckpt_start);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_ckpt_end);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_msg_sent);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_guest_spawned);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_mounts_done);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_restart_begin);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_restart_end);
+DEFINE_TCMI_MIG_STAGE(tcmi_mig_shadow_notified);
+
+#endif /* _TCMI_MIGTRACE_H */
+
+/**
+ * @}
+ */
+
+/* The header is looked up relative to the source root (-I$(src)) */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH tcmi/migration
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE tcmi_migtrace
+#include <trace/define_trace.h>
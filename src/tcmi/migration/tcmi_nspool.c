@@ -0,0 +1,379 @@
+/**
+ * @file tcmi_nspool.c - a pool of prepared private namespaces for
+ *                       immigrating tasks
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/jiffies.h>
+#include <linux/err.h>
+
+#define TCMI_NSPOOL_PRIVATE
+#include "tcmi_nspool.h"
+
+#include <tcmi/manager/tcmi_penmigman.h>
+#include "tcmi_migcom.h"
+
+#include <dbg.h>
+
+/** Pool counter, used to name the pool threads */
+static atomic_t tcmi_nspool_counter = ATOMIC_INIT(0);
+
+/** 
+ * \<\<public\>\> Initializes the pool and starts the thread that
+ * refills it. The pool is empty and disabled (size 0) until its size
+ * is set. The migration manager doesn't have to be initialized yet,
+ * it is not accessed until the first immigration.
+ *
+ * @param *self - this pool instance
+ * @param *migman - PEN migration manager the namespaces are prepared for
+ * @return 0 upon success
+ */
+int tcmi_nspool_init(struct tcmi_nspool *self, struct tcmi_migman *migman)
+{
+	INIT_LIST_HEAD(&self->namespaces);
+	self->user_count = 0;
+	self->size = 0;
+	spin_lock_init(&self->lock);
+	init_waitqueue_head(&self->wait);
+	self->refill = 0;
+	self->migman = migman;
+
+	self->thread = kthread_run(tcmi_nspool_thread, self, "tcmi_nspoold_%02d",
+				   atomic_inc_return(&tcmi_nspool_counter));
+	if (IS_ERR(self->thread)) {
+		mdbg(ERR3, "Failed to create a namespace pool thread!");
+		self->thread = NULL;
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/** 
+ * \<\<public\>\> Stops the pool thread and cancels all prepared
+ * namespaces. It is safe to call the method repeatedly.
+ *
+ * @param *self - this pool instance
+ */
+void tcmi_nspool_stop(struct tcmi_nspool *self)
+{
+	struct tcmi_nspool_ns *ns, *tmp;
+	LIST_HEAD(cancelled);
+
+	if (!self->thread)
+		return;
+
+	/* ensures synchronous thread termination */
+	kthread_stop(self->thread);
+	self->thread = NULL;
+
+	spin_lock(&self->lock);
+	list_splice_init(&self->namespaces, &cancelled);
+	self->user_count = 0;
+	self->size = 0;
+	spin_unlock(&self->lock);
+
+	list_for_each_entry_safe(ns, tmp, &cancelled, node) {
+		list_del_init(&ns->node);
+		tcmi_nspool_ns_cancel(ns);
+	}
+}
+
+/** 
+ * \<\<public\>\> Takes a prepared namespace for a user out of the
+ * pool. The user is remembered, so that the pool thread prepares
+ * namespaces for their next immigrations. When the pool is full of
+ * users, the least recently used one is replaced and its namespaces
+ * are cancelled.
+ *
+ * @param *self - this pool instance
+ * @param fsuid - fsuid of the immigrating task
+ * @param fsgid - fsgid of the immigrating task
+ * @return namespace ready to become a guest task or NULL if there is
+ * none. The caller owns the returned reference.
+ */
+struct tcmi_nspool_ns* tcmi_nspool_get(struct tcmi_nspool *self, int16_t fsuid, int16_t fsgid)
+{
+	struct tcmi_nspool_ns *ns, *tmp, *found = NULL;
+	struct tcmi_nspool_user *user = NULL, *evicted = NULL;
+	LIST_HEAD(cancelled);
+	int i;
+
+	if (!self->thread || !self->size)
+		return NULL;
+
+	spin_lock(&self->lock);
+	for (i = 0; i < self->user_count; i++) {
+		if (self->users[i].fsuid == fsuid && self->users[i].fsgid == fsgid) {
+			user = &self->users[i];
+			break;
+		}
+		if (!evicted || time_before(self->users[i].last_used, evicted->last_used))
+			evicted = &self->users[i];
+	}
+
+	if (!user) {
+		if (self->user_count < TCMI_NSPOOL_MAX_USERS) {
+			user = &self->users[self->user_count++];
+		} else {
+			/* replace the least recently used user */
+			list_for_each_entry_safe(ns, tmp, &self->namespaces, node) {
+				if (ns->fsuid == evicted->fsuid && ns->fsgid == evicted->fsgid)
+					list_move(&ns->node, &cancelled);
+			}
+			user = evicted;
+		}
+		user->fsuid = fsuid;
+		user->fsgid = fsgid;
+	}
+	user->last_used = jiffies;
+
+	list_for_each_entry(ns, &self->namespaces, node) {
+		if (ns->fsuid == fsuid && ns->fsgid == fsgid) {
+			list_del_init(&ns->node);
+			found = ns;
+			break;
+		}
+	}
+	self->refill = 1;
+	spin_unlock(&self->lock);
+
+	wake_up(&self->wait);
+
+	list_for_each_entry_safe(ns, tmp, &cancelled, node) {
+		list_del_init(&ns->node);
+		tcmi_nspool_ns_cancel(ns);
+	}
+
+	return found;
+}
+
+/** 
+ * \<\<public\>\> Sets the number of namespaces kept for each
+ * user. Namespaces exceeding the new size are cancelled, size 0
+ * disables the pool.
+ *
+ * @param *self - this pool instance
+ * @param size - new number of namespaces per user
+ */
+void tcmi_nspool_set_size(struct tcmi_nspool *self, int size)
+{
+	struct tcmi_nspool_ns *ns, *tmp;
+	int counts[TCMI_NSPOOL_MAX_USERS] = { 0 };
+	LIST_HEAD(cancelled);
+	int i;
+
+	if (size < 0)
+		size = 0;
+	if (size > TCMI_NSPOOL_MAX_SIZE)
+		size = TCMI_NSPOOL_MAX_SIZE;
+
+	spin_lock(&self->lock);
+	self->size = size;
+	list_for_each_entry_safe(ns, tmp, &self->namespaces, node) {
+		i = tcmi_nspool_user_index(self, ns);
+		if (i < 0 || ++counts[i] > size)
+			list_move(&ns->node, &cancelled);
+	}
+	if (!size)
+		self->user_count = 0;
+	self->refill = 1;
+	spin_unlock(&self->lock);
+
+	wake_up(&self->wait);
+
+	list_for_each_entry_safe(ns, tmp, &cancelled, node) {
+		list_del_init(&ns->node);
+		tcmi_nspool_ns_cancel(ns);
+	}
+	mdbg(INFO2, "Namespace pool size set to %d", size);
+}
+
+/** 
+ * \<\<public\>\> Creates a namespace descriptor for a task
+ * immigrating via a given migration manager. The namespace has to be
+ * prepared by tcmi_migcom_prepare_ns().
+ *
+ * @param *migman - PEN migration manager
+ * @param fsuid - credentials used for the file system mounts
+ * @param fsgid - credentials used for the file system mounts
+ * @return new descriptor with a single reference or NULL
+ */
+struct tcmi_nspool_ns* tcmi_nspool_ns_new(struct tcmi_migman *migman, int16_t fsuid, int16_t fsgid)
+{
+	struct tcmi_nspool_ns *ns;
+
+	if (!(ns = kmalloc(sizeof(struct tcmi_nspool_ns), GFP_KERNEL))) {
+		mdbg(ERR3, "Can't allocate memory for a namespace descriptor");
+		return NULL;
+	}
+	INIT_LIST_HEAD(&ns->node);
+	atomic_set(&ns->ref_count, 1);
+	init_completion(&ns->guest_ready);
+	init_completion(&ns->fs_ready);
+	ns->mount_params = tcmi_penmigman_get_mount_params(TCMI_PENMIGMAN(migman));
+	ns->sock = tcmi_migman_sock(migman);
+	ns->fsuid = fsuid;
+	ns->fsgid = fsgid;
+	ns->pid = 0;
+	ns->err = 0;
+	ns->cancelled = 0;
+
+	return ns;
+}
+
+/** 
+ * \<\<public\>\> Tells the thread of a namespace that there will be
+ * no guest task for it, so that it exits. Releases the caller's
+ * reference.
+ *
+ * @param *ns - namespace descriptor
+ */
+void tcmi_nspool_ns_cancel(struct tcmi_nspool_ns *ns)
+{
+	ns->cancelled = 1;
+	complete(&ns->guest_ready);
+	tcmi_nspool_ns_put(ns);
+}
+
+/** @addtogroup tcmi_nspool_class
+ *
+ * @{
+ */
+
+/** 
+ * \<\<private\>\> Pool thread. Sleeps until the pool is asked to be
+ * refilled and then prepares namespaces for users that lack
+ * them. Namespaces are prepared one by one, the lock is not held
+ * during the preparation, so the user may be replaced in the
+ * meantime - the namespace is cancelled in that case.
+ *
+ * @param *data - this pool instance
+ * @return 0 upon thread termination
+ */
+static int tcmi_nspool_thread(void *data)
+{
+	struct tcmi_nspool *self = (struct tcmi_nspool*)data;
+	struct tcmi_nspool_user *user;
+	struct tcmi_nspool_ns *ns;
+	int16_t fsuid, fsgid;
+	int err;
+
+	mdbg(INFO3, "Namespace pool thread up and running %p", current);
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(self->wait, self->refill || kthread_should_stop());
+
+		spin_lock(&self->lock);
+		self->refill = 0;
+		spin_unlock(&self->lock);
+
+		while (!kthread_should_stop()) {
+			spin_lock(&self->lock);
+			user = tcmi_nspool_find_hungry(self);
+			if (user) {
+				fsuid = user->fsuid;
+				fsgid = user->fsgid;
+			}
+			spin_unlock(&self->lock);
+			if (!user)
+				break;
+
+			if (!(ns = tcmi_nspool_ns_new(self->migman, fsuid, fsgid)))
+				break;
+			if ((err = tcmi_migcom_prepare_ns(ns))) {
+				/* don't retry until the next immigration */
+				mdbg(ERR3, "Failed to prepare a namespace for %d:%d, err=%d",
+				     fsuid, fsgid, err);
+				tcmi_nspool_ns_cancel(ns);
+				break;
+			}
+
+			mdbg(INFO3, "Prepared namespace of thread %d for %d:%d", 
+			     ns->pid, fsuid, fsgid);
+			spin_lock(&self->lock);
+			if (tcmi_nspool_user_index(self, ns) >= 0 && 
+			    tcmi_nspool_find_hungry(self)) {
+				list_add_tail(&ns->node, &self->namespaces);
+				ns = NULL;
+			}
+			spin_unlock(&self->lock);
+			/* user has been replaced or the pool shrunk */
+			if (ns)
+				tcmi_nspool_ns_cancel(ns);
+		}
+	}
+
+	mdbg(INFO3, "Namespace pool thread terminating %p", current);
+	return 0;
+}
+
+/** 
+ * \<\<private\>\> Finds a user that has less namespaces in the pool
+ * than the pool size. Requires the pool lock.
+ *
+ * @param *self - this pool instance
+ * @return the user or NULL when the pool is full
+ */
+static struct tcmi_nspool_user* tcmi_nspool_find_hungry(struct tcmi_nspool *self)
+{
+	struct tcmi_nspool_ns *ns;
+	int counts[TCMI_NSPOOL_MAX_USERS] = { 0 };
+	int i;
+
+	list_for_each_entry(ns, &self->namespaces, node) {
+		if ((i = tcmi_nspool_user_index(self, ns)) >= 0)
+			counts[i]++;
+	}
+	for (i = 0; i < self->user_count; i++) {
+		if (counts[i] < self->size)
+			return &self->users[i];
+	}
+	return NULL;
+}
+
+/** 
+ * \<\<private\>\> Finds the user a namespace has been prepared
+ * for. Requires the pool lock.
+ *
+ * @param *self - this pool instance
+ * @param *ns - namespace descriptor
+ * @return index of the user or -1 if the user is no longer known
+ */
+static int tcmi_nspool_user_index(struct tcmi_nspool *self, struct tcmi_nspool_ns *ns)
+{
+	int i;
+
+	for (i = 0; i < self->user_count; i++) {
+		if (self->users[i].fsuid == ns->fsuid && self->users[i].fsgid == ns->fsgid)
+			return i;
+	}
+	return -1;
+}
+
+/**
+ * @}
+ */
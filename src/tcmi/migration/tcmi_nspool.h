@@ -0,0 +1,194 @@
+/**
+ * @file tcmi_nspool.h - a pool of prepared private namespaces for
+ *                       immigrating tasks
+ *
+ *
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ *
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_NSPOOL_H
+#define _TCMI_NSPOOL_H
+
+#include <linux/types.h>
+#include <linux/list.h>
+#include <linux/completion.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <linux/slab.h>
+#include <asm/atomic.h>
+
+struct tcmi_migman;
+struct fs_mount_params;
+struct kkc_sock;
+struct task_struct;
+
+/** @defgroup tcmi_nspool_class tcmi_nspool class 
+ *
+ * @ingroup tcmi_migration_group
+ *
+ * Each immigrating task needs a private mount namespace with the
+ * distributed filesystem of its CCN, the proxyfs and the local procfs
+ * mounted. Preparing it takes several network round trips, that
+ * delay the restart of the task.
+ *
+ * This class keeps a pool of namespaces that have been prepared in
+ * advance for a PEN migration manager - i.e. for a single CCN. Each
+ * prepared namespace is owned by a kernel thread that has done all
+ * the mounts and waits to become a guest task. Namespaces are kept
+ * separately for each user (fsuid, fsgid pair), as the mounts are
+ * done with user's credentials. The pool is refilled by a pool
+ * thread, for each user that has recently immigrated a task there
+ * are up to \em size prepared namespaces. The size is 0 by default,
+ * which disables the pool, and is tunable via the ns-pool-size
+ * ctlfs file of the migration manager.
+ *
+ * @{
+ */
+
+/** Maximum number of users the pool prepares namespaces for */
+#define TCMI_NSPOOL_MAX_USERS 8
+/** Maximum number of prepared namespaces for a single user */
+#define TCMI_NSPOOL_MAX_SIZE 16
+
+/** Private namespace of a future guest task, prepared by its thread. */
+struct tcmi_nspool_ns {
+	/** node in the list of prepared namespaces */
+	struct list_head node;
+	/** the thread and its creator each hold a reference */
+	atomic_t ref_count;
+	/** used to signal the thread the guest(or fs mount respectively) is ready */	
+	struct completion guest_ready, fs_ready;
+	/** Params for mounting of distributed fs */
+	struct fs_mount_params* mount_params;
+	/** Migman socket.. used to determine peers address so that we can mount its proxyfs */
+	struct kkc_sock* sock;
+	/** Credentials that can be used for fs mounting */
+	int16_t fsuid, fsgid;
+	/** PID of the thread that owns the namespace */
+	pid_t pid;
+	/** result of the mounts, valid once fs_ready is completed */
+	int err;
+	/** set when the thread is to exit instead of becoming a guest */
+	int cancelled;
+};
+
+/** A user the pool prepares namespaces for. */
+struct tcmi_nspool_user {
+	int16_t fsuid, fsgid;
+	/** time of the last immigration, used to replace the oldest user */
+	unsigned long last_used;
+};
+
+/** Pool of prepared namespaces of a PEN migration manager. */
+struct tcmi_nspool {
+	/** prepared namespaces */
+	struct list_head namespaces;
+	/** users the namespaces are prepared for */
+	struct tcmi_nspool_user users[TCMI_NSPOOL_MAX_USERS];
+	int user_count;
+	/** number of namespaces kept for each user */
+	int size;
+	/** protects the namespaces and users */
+	spinlock_t lock;
+
+	/** thread refilling the pool */
+	struct task_struct *thread;
+	/** the thread waits here for refill requests */
+	wait_queue_head_t wait;
+	/** set when the pool needs to be refilled */
+	int refill;
+	/** migration manager the namespaces are prepared for */
+	struct tcmi_migman *migman;
+};
+
+/** \<\<public\>\> Initializes the pool and starts its thread. */
+extern int tcmi_nspool_init(struct tcmi_nspool *self, struct tcmi_migman *migman);
+
+/** \<\<public\>\> Stops the pool thread and releases all prepared namespaces. */
+extern void tcmi_nspool_stop(struct tcmi_nspool *self);
+
+/** \<\<public\>\> Takes a prepared namespace for a user out of the pool. */
+extern struct tcmi_nspool_ns* tcmi_nspool_get(struct tcmi_nspool *self, int16_t fsuid, int16_t fsgid);
+
+/** \<\<public\>\> Sets the number of namespaces kept for each user. */
+extern void tcmi_nspool_set_size(struct tcmi_nspool *self, int size);
+
+/** \<\<public\>\> Creates a namespace descriptor, it still has to be prepared. */
+extern struct tcmi_nspool_ns* tcmi_nspool_ns_new(struct tcmi_migman *migman, int16_t fsuid, int16_t fsgid);
+
+/** \<\<public\>\> Tells the thread of a namespace to exit and releases the namespace. */
+extern void tcmi_nspool_ns_cancel(struct tcmi_nspool_ns *ns);
+
+/** 
+ * \<\<public\>\> Number of namespaces kept for each user.
+ *
+ * @param *self - this pool instance
+ */
+static inline int tcmi_nspool_size(struct tcmi_nspool *self)
+{
+	return self->size;
+}
+
+/** 
+ * \<\<public\>\> Gets a reference to a namespace.
+ *
+ * @param *ns - namespace descriptor
+ * @return the namespace descriptor
+ */
+static inline struct tcmi_nspool_ns* tcmi_nspool_ns_get(struct tcmi_nspool_ns *ns)
+{
+	atomic_inc(&ns->ref_count);
+	return ns;
+}
+
+/** 
+ * \<\<public\>\> Releases a reference to a namespace, the last one
+ * frees the descriptor.
+ *
+ * @param *ns - namespace descriptor
+ */
+static inline void tcmi_nspool_ns_put(struct tcmi_nspool_ns *ns)
+{
+	if (atomic_dec_and_test(&ns->ref_count))
+		kfree(ns);
+}
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_NSPOOL_PRIVATE
+
+/** Pool thread that prepares namespaces. */
+static int tcmi_nspool_thread(void *data);
+
+/** Finds a user that lacks prepared namespaces. */
+static struct tcmi_nspool_user* tcmi_nspool_find_hungry(struct tcmi_nspool *self);
+
+/** Finds the user a namespace belongs to. */
+static int tcmi_nspool_user_index(struct tcmi_nspool *self, struct tcmi_nspool_ns *ns);
+
+#endif /* TCMI_NSPOOL_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_NSPOOL_H */
@@ -7,12 +7,16 @@
 #include <linux/uaccess.h>
 
 #include <arch/types.h>
+#include <tcmi/task/tcmi_guesttask.h>
 #include "tcmi_guest_fork_rpc.h"
 
 /** 
  * All version of system call based on fork RPC 
  * Called in the beginning of do_fork method
  *
+ * A plain fork of a guest that has forked before asks the CCN to lease
+ * a block of stubs for the subsequent forks, see tcmi_guesttask_class.
+ *
  * @param rpc_num - RPC number
  * @param params  - pointer to array with RPC parameters - clone_flags, stack_start, regs, stack_size, parent_tidptr, child_tidptr
  *
@@ -23,7 +27,8 @@ TCMI_GUEST_RPC_CALL_DEF(fork)
 	struct tcmi_msg *r; 
 	long rtn;
 	// platform independend params
-	uint64_t clone_flags, stack_start, stack_size;
+	uint64_t clone_flags, stack_start, stack_size, lease;
+	struct tcmi_task *self = TCMI_TASK(current->tcmi.tcmi_task);
 
 	// Real results
 	int parent_tid, child_tid;
@@ -31,6 +36,7 @@ TCMI_GUEST_RPC_CALL_DEF(fork)
 	clone_flags = params[0];
 	stack_start = params[1];
 	stack_size  = params[3];
+	lease = tcmi_guesttask_lease_wanted(self, params[0]);
 
 	mdbg(INFO3, "Forwarding fork syscall. Ptid filled: %d Ctid filled: %d", (void*)params[4] != NULL, (void*)params[5] != NULL);
 
@@ -38,6 +44,7 @@ TCMI_GUEST_RPC_CALL_DEF(fork)
 			sizeof(uint64_t), &clone_flags, 
 			sizeof(uint64_t), &stack_start, 
 			sizeof(uint64_t), &stack_size, 
+			sizeof(uint64_t), &lease, 
 			(size_t)0); 
 
 	if(r == NULL){
@@ -52,6 +59,10 @@ TCMI_GUEST_RPC_CALL_DEF(fork)
 	rtn = tcmi_rpcresp_procmsg_rtn( TCMI_RPCRESP_PROCMSG(r) );
 
 	if ( rtn > 0 ) { // Perform this only in case fork succeeded!		
+		// Stubs leased for the subsequent forks
+		if ( TCMI_RPCRESP_PROCMSG(r)->nmemb > 2 )
+			tcmi_guesttask_add_leases(self, (int32_t*)tcmi_rpcresp_procmsg_data_base(TCMI_RPCRESP_PROCMSG(r), 2),
+						  tcmi_rpcresp_procmsg_data_size(TCMI_RPCRESP_PROCMSG(r), 2) / sizeof(int32_t));
 		// Copies them to a user space provided buffer	
 /* TODO: THis is not correct think to do.. the value needs to be set "lazily"
 		if ( (void*)params[4] != NULL ) {
@@ -29,6 +29,7 @@
 #define _TCMI_GUEST_RPC_H
 
 #include "tcmi_rpc.h"
+#include <tcmi/task/tcmi_guesttask.h>
 /** @defgroup tcmi_guest_rpc_class tcmi_guest_rpc class 
  *
  * @ingroup tcmi_rpc_class
@@ -41,6 +42,69 @@
 /** tcmi_guest_rpc class declaration */
 extern struct tcmi_rpc *tcmi_guest_rpc;
 
+/**
+ * \<\<public\>\> Identity cache of the current guest task.
+ *
+ * @return identity cache or NULL when current is not attached to a guest task
+ */
+static inline struct tcmi_identcache* tcmi_guest_rpc_identcache(void)
+{
+	struct tcmi_task *task = TCMI_TASK(current->tcmi.tcmi_task);
+	return task ? tcmi_guesttask_identcache(task) : NULL;
+}
+
+/** \<\<public\>\> Do a rpc with 1 parameter, whose result is served from the identity cache
+ * of the guest whenever the cached entry is still valid.
+ *
+ * @param entry - identity cache entry holding the result
+ * @param rpc_num - Identification number of called procedure
+ * @param param1  - First parametr of called procedure
+ *
+ * @return RPC return code
+ */
+static inline long tcmi_guest_rpc_cached_call1(enum tcmi_ident_entry entry, unsigned int rpc_num, long param1)
+{
+	struct tcmi_identcache *cache = tcmi_guest_rpc_identcache();
+	u_int32_t gen;
+	long rtn;
+
+	if ( !cache )
+		return tcmi_rpc_call1(tcmi_guest_rpc, rpc_num, param1);
+	if ( tcmi_identcache_get(cache, entry, &rtn) )
+		return rtn;
+	/* Generation is sampled before the call, so a concurrent invalidation discards the result */
+	gen = tcmi_identcache_gen(cache);
+	rtn = tcmi_rpc_call1(tcmi_guest_rpc, rpc_num, param1);
+	if ( rtn >= 0 )
+		tcmi_identcache_set(cache, entry, gen, rtn);
+	return rtn;
+}
+
+/** \<\<public\>\> Do a rpc with 0 parameters, whose result is cached.
+ * @see tcmi_guest_rpc_cached_call1
+ */
+static inline long tcmi_guest_rpc_cached_call0(enum tcmi_ident_entry entry, unsigned int rpc_num)
+{
+	return tcmi_guest_rpc_cached_call1(entry, rpc_num, 0);
+}
+
+/** \<\<public\>\> Drops everything cached by the current guest, used after the identity
+ * has been changed by a set* call. The stubs leased so far carry the former credentials and
+ * session, so they are released as well. A process group change keeps them, a claimed stub
+ * joins the current process group of its parent.
+ *
+ * @param pgrp_only - set when only the process group could have changed
+ */
+static inline void tcmi_guest_rpc_ident_changed(int pgrp_only)
+{
+	struct tcmi_task *task = TCMI_TASK(current->tcmi.tcmi_task);
+	if ( !task )
+		return;
+	tcmi_identcache_invalidate(tcmi_guesttask_identcache(task), TCMI_IDENT_ALL);
+	if ( !pgrp_only )
+		tcmi_guesttask_release_leases(task);
+}
+
 /** Creates default RPC call for system call declaration
  *
  * @param name - name of system call
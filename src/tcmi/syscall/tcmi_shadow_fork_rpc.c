@@ -8,6 +8,7 @@
 #include <arch/types.h>
 #include <dbg.h>
 
+#include <tcmi/task/tcmi_shadowtask.h>
 #include "tcmi_shadow_fork_rpc.h"
 #include "exported_symbols.h"
 #include <arch/current/regs.h>
@@ -21,12 +22,14 @@ TCMI_SHADOW_RPC_GENERIC_CALL_DEF(do_fork)
 	struct pt_regs *regs = task_pt_regs(current);
 
 	// Platform independend params
-	uint64_t clone_flags, stack_start, stack_size;
+	uint64_t clone_flags, stack_start, stack_size, lease;
 
 	// Platform independend return values
-	int32_t* parent_tid_ind, *child_tid_ind;
+	int32_t* parent_tid_ind, *child_tid_ind, *leases = NULL;
 	// Return values	
 	int parent_tid, child_tid;
+	long stub;
+	int nleases = 0;
 	
 	mdbg(INFO3, "Forwarded fork syscall being processed");
 
@@ -36,6 +39,9 @@ TCMI_SHADOW_RPC_GENERIC_CALL_DEF(do_fork)
 	clone_flags = *(uint64_t*)tcmi_rpc_procmsg_data_base( TCMI_RPC_PROCMSG(m), 0);
 	stack_start = *(uint64_t*)tcmi_rpc_procmsg_data_base( TCMI_RPC_PROCMSG(m), 1);
 	stack_size = *(uint64_t*)tcmi_rpc_procmsg_data_base( TCMI_RPC_PROCMSG(m), 2);
+	lease = *(uint64_t*)tcmi_rpc_procmsg_data_base( TCMI_RPC_PROCMSG(m), 3);
+	if ( lease > TCMI_SHADOWTASK_MAX_LEASE )
+		lease = TCMI_SHADOWTASK_MAX_LEASE;
 
 	// We disable VFORK clonning on core node.. detached node is waiting
 	// TODO: This is not really good solution, because when detached node child migrates away, the waiting is broken.
@@ -50,6 +56,24 @@ TCMI_SHADOW_RPC_GENERIC_CALL_DEF(do_fork)
 	set_fs(KERNEL_DS);
 	// TODO: Check if passing parent & child is correct here
 	rtn = do_fork(clone_flags, stack_start, regs, stack_size, &parent_tid, &child_tid);
+
+	// Stubs for the subsequent forks of the guest. They are forked without an exit signal, so that
+	// wait() doesn't see them until the guest claims them, see tcmi_shadowtask_end_lease() and
+	// tcmi_shadowtask_only_leases() for the __WALL waits. Each
+	// stub gets a process group of its own, so that job control of the parent's group skips it
+	if ( rtn > 0 && lease && (leases = kmalloc(lease * sizeof(*leases), GFP_KERNEL)) ) {
+		tcmi_shadowtask_set_leasing(TCMI_TASK(current->tcmi.tcmi_task), 1);
+		while ( nleases < lease ) {
+			stub = do_fork(0, stack_start, regs, stack_size, NULL, NULL);
+			if ( stub <= 0 )
+				break;
+			if ( sys_setpgid(stub, stub) )
+				mdbg(ERR3, "Stub %ld stays in the process group of its parent", stub);
+			leases[nleases++] = stub;
+		}
+		tcmi_shadowtask_set_leasing(TCMI_TASK(current->tcmi.tcmi_task), 0);
+		mdbg(INFO3, "Leased %d stubs to the guest", nleases);
+	}
 	set_fs(old_fs);
 
 	mdbg(INFO3, "Forwarded fork syscall finished.");
@@ -57,31 +81,44 @@ TCMI_SHADOW_RPC_GENERIC_CALL_DEF(do_fork)
 	// Convert results to platform independend values
 	parent_tid_ind = kmalloc(sizeof(*parent_tid_ind), GFP_KERNEL);
 	if ( !parent_tid_ind ) {
+		kfree(leases);
 		return -ENOMEM;
 	}
 
 	child_tid_ind = kmalloc(sizeof(*child_tid_ind), GFP_KERNEL);
 	if ( !child_tid_ind ) {
 		kfree(parent_tid_ind);
+		kfree(leases);
 		return -ENOMEM;
 	}
 
 	*parent_tid_ind = parent_tid;
 	*child_tid_ind = child_tid;	
 	
-	// Create response with the results
-	*resp = tcmi_rpcresp_procmsg_create(m, rtn, sizeof(*parent_tid_ind), parent_tid_ind,
-						    sizeof(*child_tid_ind), child_tid_ind,
-						(size_t)0 );
+	// Create response with the results, PIDs of the leased stubs are appended when there are any
+	if ( nleases )
+		*resp = tcmi_rpcresp_procmsg_create(m, rtn, sizeof(*parent_tid_ind), parent_tid_ind,
+							    sizeof(*child_tid_ind), child_tid_ind,
+							    nleases * sizeof(*leases), leases,
+							(size_t)0 );
+	else
+		*resp = tcmi_rpcresp_procmsg_create(m, rtn, sizeof(*parent_tid_ind), parent_tid_ind,
+							    sizeof(*child_tid_ind), child_tid_ind,
+							(size_t)0 );
 
 	if( *resp == NULL ) {
 		kfree(parent_tid_ind);
 		kfree(child_tid_ind);
+		kfree(leases);
 		return -1;
 	}
 
 	tcmi_rpcresp_procmsg_free_on_put( TCMI_RPCRESP_PROCMSG(*resp), 0, TCMI_RPCRESP_PROCMSG_KFREE );
 	tcmi_rpcresp_procmsg_free_on_put( TCMI_RPCRESP_PROCMSG(*resp), 1, TCMI_RPCRESP_PROCMSG_KFREE );
+	if ( nleases )
+		tcmi_rpcresp_procmsg_free_on_put( TCMI_RPCRESP_PROCMSG(*resp), 2, TCMI_RPCRESP_PROCMSG_KFREE );
+	else
+		kfree(leases);
 
 	return 0;
 }
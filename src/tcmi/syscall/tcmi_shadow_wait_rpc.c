@@ -8,6 +8,7 @@
 #include <arch/types.h>
 #include <dbg.h>
 
+#include <tcmi/task/tcmi_shadowtask.h>
 #include "tcmi_shadow_wait_rpc.h"
 #include "exported_symbols.h"
 
@@ -42,11 +43,17 @@ TCMI_SHADOW_RPC_GENERIC_CALL_DEF(sys_wait4)
 
 	mdbg(INFO3, "Waiting for pid: %d", pid);
 
-	// Perform the call
-	old_fs = get_fs();
-	set_fs(KERNEL_DS);
-	rtn = sys_wait4(pid, &result_stats , options, result_usage);
-	set_fs(old_fs);
+	// Perform the call, unclaimed stubs leased to the guest are not its children yet
+	result_stats = 0;
+	memset(result_usage, 0, sizeof(*result_usage));
+	if ( pid == -1 && tcmi_shadowtask_only_leases(options) ) {
+		rtn = -ECHILD;
+	} else {
+		old_fs = get_fs();
+		set_fs(KERNEL_DS);
+		rtn = sys_wait4(pid, &result_stats , options, result_usage);
+		set_fs(old_fs);
+	}
 
 	// Convert resuls to platform independend values
 	result_usage_ind = kmalloc(sizeof(*result_usage_ind), GFP_KERNEL);
@@ -83,7 +83,7 @@ void tcmi_syscall_hooks_groupident_exit(void)
  */
 static long tcmi_syscall_hooks_sys_getgid(void)
 {
-	return tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_GETGID);
+	return tcmi_guest_rpc_cached_call0(TCMI_IDENT_GID, TCMI_RPC_SYS_GETGID);
 }
 
 /**
@@ -93,7 +93,7 @@ static long tcmi_syscall_hooks_sys_getgid(void)
  */
 static long tcmi_syscall_hooks_sys_getegid(void)
 {
-	return tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_GETEGID);
+	return tcmi_guest_rpc_cached_call0(TCMI_IDENT_EGID, TCMI_RPC_SYS_GETEGID);
 }
 
 
@@ -104,7 +104,9 @@ static long tcmi_syscall_hooks_sys_getegid(void)
  */
 static long tcmi_syscall_hooks_sys_setgid(gid_t gid)
 {
-	return tcmi_rpc_call1(tcmi_guest_rpc, TCMI_RPC_SYS_SETGID, gid);
+	long rtn = tcmi_rpc_call1(tcmi_guest_rpc, TCMI_RPC_SYS_SETGID, gid);
+	tcmi_guest_rpc_ident_changed(0);
+	return rtn;
 }
 
 /**
@@ -114,7 +116,9 @@ static long tcmi_syscall_hooks_sys_setgid(gid_t gid)
  */
 static long tcmi_syscall_hooks_sys_setregid(gid_t rgid, gid_t egid)
 {
-	return tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETREGID, rgid, egid);
+	long rtn = tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETREGID, rgid, egid);
+	tcmi_guest_rpc_ident_changed(0);
+	return rtn;
 }
 
 /**
@@ -124,7 +128,23 @@ static long tcmi_syscall_hooks_sys_setregid(gid_t rgid, gid_t egid)
  */
 static long tcmi_syscall_hooks_sys_getresgid(gid_t *rgid, gid_t *egid, gid_t *sgid)
 {
-	return tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_GETRESGID, (unsigned long)rgid, (unsigned long)egid, (unsigned long)sgid);
+	struct tcmi_identcache *cache = tcmi_guest_rpc_identcache();
+	u_int32_t ids[3], gen = 0;
+	long rtn;
+
+	if ( cache && tcmi_identcache_get_res(cache, TCMI_IDENT_RESGID, ids) ) {
+		if ( put_user(ids[0], rgid) || put_user(ids[1], egid) || put_user(ids[2], sgid) )
+			return -EFAULT;
+		return 0;
+	}
+
+	if ( cache )
+		gen = tcmi_identcache_gen(cache);
+	rtn = tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_GETRESGID, (unsigned long)rgid, (unsigned long)egid, (unsigned long)sgid);
+	// The response has been stored in userspace, read it back to fill the cache
+	if ( cache && rtn == 0 && !get_user(ids[0], rgid) && !get_user(ids[1], egid) && !get_user(ids[2], sgid) )
+		tcmi_identcache_set_res(cache, TCMI_IDENT_RESGID, gen, ids);
+	return rtn;
 }
 
 /**
@@ -134,7 +154,9 @@ static long tcmi_syscall_hooks_sys_getresgid(gid_t *rgid, gid_t *egid, gid_t *sg
  */
 static long tcmi_syscall_hooks_sys_setresgid(gid_t rgid, gid_t egid, gid_t sgid)
 {
-	return tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_SETRESGID, rgid, egid, sgid);
+	long rtn = tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_SETRESGID, rgid, egid, sgid);
+	tcmi_guest_rpc_ident_changed(0);
+	return rtn;
 }
 
 /**
@@ -144,13 +166,38 @@ static long tcmi_syscall_hooks_sys_setresgid(gid_t rgid, gid_t egid, gid_t sgid)
  */
 static long tcmi_syscall_hooks_sys_getgroups(int size, gid_t *groups)
 {
-	if( size == 0 )
-		return tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_GETGROUPS, 0, (unsigned long)NULL);
-	else{
-		if( !access_ok( VERIFY_WRITE, groups, size * sizeof(gid_t) ) )
+	struct tcmi_identcache *cache = tcmi_guest_rpc_identcache();
+	gid_t cached[TCMI_IDENTCACHE_GROUPS];
+	u_int32_t gen = 0;
+	long rtn;
+
+	if( size < 0 )
+		return -EINVAL;
+	if( size > 0 && !access_ok( VERIFY_WRITE, groups, size * sizeof(gid_t) ) )
+		return -EFAULT;
+
+	if( cache && (rtn = tcmi_identcache_get_groups(cache, cached)) >= 0 ){
+		if( size == 0 )
+			return rtn;
+		if( rtn > size )
+			return -EINVAL;
+		if( __copy_to_user(groups, cached, rtn * sizeof(gid_t)) )
 			return -EFAULT;
-		return tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_GETGROUPS, size, (unsigned long)groups);
+		return rtn;
 	}
+
+	if( cache )
+		gen = tcmi_identcache_gen(cache);
+	if( size == 0 )
+		rtn = tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_GETGROUPS, 0, (unsigned long)NULL);
+	else
+		rtn = tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_GETGROUPS, size, (unsigned long)groups);
+
+	// Only a complete list that fits the cache is stored, it has been copied to userspace by the RPC
+	if( cache && rtn >= 0 && rtn <= TCMI_IDENTCACHE_GROUPS && (rtn == 0 || size > 0) &&
+	    !__copy_from_user(cached, groups, rtn * sizeof(gid_t)) )
+		tcmi_identcache_set_groups(cache, gen, rtn, cached);
+	return rtn;
 }
 
 /**
@@ -165,8 +212,10 @@ static long tcmi_syscall_hooks_sys_setgroups(int size, const gid_t *groups)
 	else{
 		if( !access_ok(VERIFY_READ, groups, size * sizeof(gid_t)) )
 			return -EFAULT;
-		return tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETGROUPS, 
+		long rtn = tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETGROUPS, 
 				size, (unsigned long)groups );
+		tcmi_guest_rpc_ident_changed(0);
+		return rtn;
 	}
 }
 
@@ -41,6 +41,7 @@
 #include <tcmi/manager/tcmi_penman.h>
 #include <tcmi/manager/tcmi_ccnman.h>
 #include <tcmi/task/tcmi_guesttask.h>
+#include <tcmi/task/tcmi_shadowtask.h>
 
 #include <proxyfs/proxyfs_server.h>
 #include <director/director.h>
@@ -85,8 +86,15 @@ void tcmi_syscall_hooks_other_exit(void)
 
 /**
  * \<\<private\>\> sys_wait4 system call hook.  
+ * Exited children pushed by the shadow are reaped locally, see tcmi_zombiecache_class.
  */
 static long tcmi_syscall_hooks_sys_wait4(pid_t pid, int __user *stat_addr, int options, struct rusage __user *ru) {
+	struct tcmi_task* self = TCMI_TASK(current->tcmi.tcmi_task);
+	long res;
+
+	if ( self && tcmi_guesttask_wait4(self, pid, stat_addr, options, ru, &res) )
+		return res;
+
 	return tcmi_rpc_call4(tcmi_guest_rpc, TCMI_RPC_SYS_WAIT4, pid, (unsigned long)stat_addr, options, (unsigned long)ru);
 };
 
@@ -100,6 +108,12 @@ static long tcmi_syscall_hooks_pre_fork(unsigned long clone_flags, unsigned long
 ) {
 	// Pre-fork is hooked only on DN, on CN we fork normally
 	if ( current->tcmi.task_type == guest ) {
+		struct tcmi_task* self = TCMI_TASK(current->tcmi.tcmi_task);
+		pid_t remote_pid;
+		// Plain forks use stubs leased by the CCN ahead of time, the CCN learns about the fork in post-fork
+		if ( self && (remote_pid = tcmi_guesttask_take_lease(self, clone_flags)) > 0 )
+			return remote_pid;
+
 		return tcmi_rpc_call6(tcmi_guest_rpc, TCMI_RPC_SYS_FORK, clone_flags, stack_start, (unsigned long)regs, stack_size, (unsigned long)parent_tidptr, (unsigned long)child_tidptr);
 	}
 
@@ -156,6 +170,9 @@ static long tcmi_syscall_hooks_post_fork(struct task_struct* child, long res, pi
 		if (!IS_ERR((void*)res) ) {			
 			proxyfs_server_duplicate_all_parent(current, child);
 		}
+		// Stubs leased to the guest are announced to the director once a fork claims them
+		if ( tcmi_shadowtask_leasing(TCMI_TASK(current->tcmi.tcmi_task)) )
+			return res;
 	}
 
 	director_task_fork(res, current->pid);
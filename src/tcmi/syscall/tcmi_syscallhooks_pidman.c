@@ -81,7 +81,7 @@ void tcmi_syscall_hooks_pidman_exit(void)
  */
 static long tcmi_syscall_hooks_sys_getppid(void)
 {	
-	return tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_GETPPID);
+	return tcmi_guest_rpc_cached_call0(TCMI_IDENT_PPID, TCMI_RPC_SYS_GETPPID);
 }
 
 /**
@@ -104,6 +104,9 @@ static long tcmi_syscall_hooks_sys_getpid(void)
  */
 static long tcmi_syscall_hooks_sys_getpgid(pid_t pid)
 {
+	// Only our own group is cached, other processes are always asked for on the CCN
+	if ( pid == 0 || pid == tcmi_task_remote_pid(current->tcmi.tcmi_task) )
+		return tcmi_guest_rpc_cached_call1(TCMI_IDENT_PGRP, TCMI_RPC_SYS_GETPGID, pid);
 	return tcmi_rpc_call1(tcmi_guest_rpc, TCMI_RPC_SYS_GETPGID, pid);
 }
 
@@ -116,7 +119,9 @@ static long tcmi_syscall_hooks_sys_getpgid(pid_t pid)
  */
 static long tcmi_syscall_hooks_sys_setpgid(pid_t pid, pid_t pgid)
 {
-	return tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETPGID, pid, pgid);
+	long rtn = tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETPGID, pid, pgid);
+	tcmi_guest_rpc_ident_changed(1);
+	return rtn;
 }
 
 /**
@@ -127,6 +132,8 @@ static long tcmi_syscall_hooks_sys_setpgid(pid_t pid, pid_t pgid)
  */
 static long tcmi_syscall_hooks_sys_getsid(pid_t pid)
 {
+	if ( pid == 0 || pid == tcmi_task_remote_pid(current->tcmi.tcmi_task) )
+		return tcmi_guest_rpc_cached_call1(TCMI_IDENT_SID, TCMI_RPC_SYS_GETSID, pid);
 	return tcmi_rpc_call1(tcmi_guest_rpc, TCMI_RPC_SYS_GETSID, pid);
 }
 
@@ -137,7 +144,9 @@ static long tcmi_syscall_hooks_sys_getsid(pid_t pid)
  */
 static long tcmi_syscall_hooks_sys_setsid(void)
 {
-	return tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_SETSID);
+	long rtn = tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_SETSID);
+	tcmi_guest_rpc_ident_changed(0);
+	return rtn;
 }
 
 /**
@@ -147,7 +156,7 @@ static long tcmi_syscall_hooks_sys_setsid(void)
  */
 static long tcmi_syscall_hooks_sys_getpgrp(void)
 {
-	return tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_GETPGRP);
+	return tcmi_guest_rpc_cached_call0(TCMI_IDENT_PGRP, TCMI_RPC_SYS_GETPGRP);
 }
 
 
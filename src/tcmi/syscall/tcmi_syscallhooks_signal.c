@@ -71,6 +71,7 @@ void tcmi_syscall_hooks_signal_exit(void)
 
 /**
  * \<\<private\>\> Kill system call hook.  
+ * Standard signals to known children don't wait for the CCN, see tcmi_guesttask_kill().
  *
  * @param pid - PID of signal target
  * @param sig - what signal
@@ -79,6 +80,11 @@ void tcmi_syscall_hooks_signal_exit(void)
  */
 static long tcmi_syscall_hooks_sys_kill(int pid, int sig)
 {
+	struct tcmi_task* self = TCMI_TASK(current->tcmi.tcmi_task);
+
+	if ( self && tcmi_guesttask_kill(self, pid, sig) )
+		return 0;
+
 	return tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_KILL, pid, sig);
 }
 
@@ -79,7 +79,7 @@ void tcmi_syscall_hooks_userident_exit(void)
  */
 static long tcmi_syscall_hooks_sys_getuid(void)
 {
-	return tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_GETUID);
+	return tcmi_guest_rpc_cached_call0(TCMI_IDENT_UID, TCMI_RPC_SYS_GETUID);
 }
 
 /**
@@ -92,7 +92,9 @@ static long tcmi_syscall_hooks_sys_getuid(void)
  */
 static long tcmi_syscall_hooks_sys_setresuid(uid_t ruid, uid_t euid, uid_t suid)
 {
-	return tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_SETRESUID, ruid, euid, suid);
+	long rtn = tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_SETRESUID, ruid, euid, suid);
+	tcmi_guest_rpc_ident_changed(0);
+	return rtn;
 }
 
 /**
@@ -102,7 +104,7 @@ static long tcmi_syscall_hooks_sys_setresuid(uid_t ruid, uid_t euid, uid_t suid)
  */
 static long tcmi_syscall_hooks_sys_geteuid(void)
 {
-	return tcmi_rpc_call0(tcmi_guest_rpc, TCMI_RPC_SYS_GETEUID);
+	return tcmi_guest_rpc_cached_call0(TCMI_IDENT_EUID, TCMI_RPC_SYS_GETEUID);
 }
 
 /** \<\<private\>\> Setuid system call hook 
@@ -112,7 +114,9 @@ static long tcmi_syscall_hooks_sys_geteuid(void)
  */
 static long tcmi_syscall_hooks_sys_setuid(uid_t uid)
 {
-	return tcmi_rpc_call1(tcmi_guest_rpc, TCMI_RPC_SYS_SETUID, uid);
+	long rtn = tcmi_rpc_call1(tcmi_guest_rpc, TCMI_RPC_SYS_SETUID, uid);
+	tcmi_guest_rpc_ident_changed(0);
+	return rtn;
 }
 
 /** \<\<private\>\> Setreuid system call hook 
@@ -123,7 +127,9 @@ static long tcmi_syscall_hooks_sys_setuid(uid_t uid)
  */
 static long tcmi_syscall_hooks_sys_setreuid(uid_t ruid, uid_t euid)
 {
-	return tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETREUID, ruid, euid);
+	long rtn = tcmi_rpc_call2(tcmi_guest_rpc, TCMI_RPC_SYS_SETREUID, ruid, euid);
+	tcmi_guest_rpc_ident_changed(0);
+	return rtn;
 }
 
 /** \<\<private\>\> Getresuid system call hook (all pointers points to userspace)
@@ -135,5 +141,21 @@ static long tcmi_syscall_hooks_sys_setreuid(uid_t ruid, uid_t euid)
  * */
 static long tcmi_syscall_hooks_sys_getresuid(uid_t* ruid, uid_t* euid, uid_t *suid)
 {
-	return tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_GETRESUID, (unsigned long)ruid, (unsigned long)euid, (unsigned long)suid);
+	struct tcmi_identcache *cache = tcmi_guest_rpc_identcache();
+	u_int32_t ids[3], gen = 0;
+	long rtn;
+
+	if ( cache && tcmi_identcache_get_res(cache, TCMI_IDENT_RESUID, ids) ) {
+		if ( put_user(ids[0], ruid) || put_user(ids[1], euid) || put_user(ids[2], suid) )
+			return -EFAULT;
+		return 0;
+	}
+
+	if ( cache )
+		gen = tcmi_identcache_gen(cache);
+	rtn = tcmi_rpc_call3(tcmi_guest_rpc, TCMI_RPC_SYS_GETRESUID, (unsigned long)ruid, (unsigned long)euid, (unsigned long)suid);
+	// The response has been stored in userspace, read it back to fill the cache
+	if ( cache && rtn == 0 && !get_user(ids[0], ruid) && !get_user(ids[1], euid) && !get_user(ids[2], suid) )
+		tcmi_identcache_set_res(cache, TCMI_IDENT_RESUID, gen, ids);
+	return rtn;
 }
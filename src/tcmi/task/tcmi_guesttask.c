@@ -31,6 +31,7 @@
 #include <tcmi/comm/tcmi_messages_dsc.h>
 #include <tcmi/migration/tcmi_migcom.h>
 #include <tcmi/manager/tcmi_migman.h>
+#include <tcmi/manager/tcmi_penmigman.h>
 
 #include "tcmi_taskhelper.h"
 
@@ -39,6 +40,7 @@
 
 #include <proxyfs/proxyfs_helper.h>
 
+#include <tcmi/migration/tcmi_migtrace.h>
 #include <director/director.h>
 
 /** 
@@ -72,6 +74,11 @@ struct tcmi_task* tcmi_guesttask_new(pid_t local_pid, struct tcmi_migman* migman
 		mdbg(ERR3, "TCMI ppm guest task initialization failed!");
 		goto exit1;
 	}
+	task->nleases = 0;
+	task->forks = 0;
+	task->lease_taken = 0;
+	tcmi_identcache_init(&task->ident);
+	tcmi_zombiecache_init(&task->zombies);
 
 	return TCMI_TASK(task);
 
@@ -116,6 +123,9 @@ memory_sanity_check("On process message");
 		/* Is there some better way to invoke self migration home? If we call directly migrate back of this task the method queue won't be flushed as in the case of this call. */
 		tcmi_migcom_migrate_home_ppm_p(tcmi_task_local_pid(self));
 		break;
+	case TCMI_PPM_V_MIGR_BACK_SHADOWREQ_PROCMSG_ID:
+		tcmi_migcom_migrate_home_ppm_v(tcmi_task_local_pid(self));
+		break;
 	default:
 		mdbg(ERR3, "Unexpected message from the guest task: %x", tcmi_msg_id(m));
 		break;
@@ -126,6 +136,35 @@ memory_sanity_check("After process message");
 	return res;
 }
 
+/** 
+ * \<\<private\>\> Handles messages that need no processing in the
+ * task context. An identity change notification from the shadow only
+ * drops the changed entries from the identity cache and a children
+ * snapshot replaces the one in the zombie cache, so they are handled
+ * right in the receiving thread - the guest needn't be interrupted
+ * and the next query already sees them. A guest waiting for a child
+ * is woken up by the snapshot.
+ *
+ * @param *self - pointer to this task instance
+ * @param *m - message being delivered
+ * @return 1 if the message has been consumed
+ */
+static int tcmi_guesttask_intercept_msg(struct tcmi_task *self, struct tcmi_msg *m)
+{
+	switch (tcmi_msg_id(m)) {
+	case TCMI_IDENT_CHANGED_PROCMSG_ID:
+		tcmi_identcache_invalidate(tcmi_guesttask_identcache(self), 
+					   tcmi_ident_changed_procmsg_mask(TCMI_IDENT_CHANGED_PROCMSG(m)));
+		return 1;
+	case TCMI_CHILDREN_PROCMSG_ID:
+		tcmi_zombiecache_update(tcmi_guesttask_zombiecache(self), 
+					tcmi_children_procmsg_children(TCMI_CHILDREN_PROCMSG(m)));
+		return 1;
+	default:
+		return 0;
+	}
+}
+
 /** 
  * \<\<private\>\> Emigrates a task to a PEN.
  *
@@ -151,6 +190,9 @@ static int tcmi_guesttask_migrateback_p(struct tcmi_task* self, struct tcmi_npm_
 
 	mdbg(INFO2, "Process '%s' - guest local PID %d, migrating back (npm params: %p)", current->comm, tcmi_task_local_pid(self), npm_params);
 
+	tcmi_task_set_mig_mode(self, npm_params ? TCMI_MIGTRACE_HOME_NPM : TCMI_MIGTRACE_HOME_PPM_P);
+	trace_tcmi_mig_frozen(tcmi_task_local_pid(self), tcmi_task_migman_slot_index(self),
+			      tcmi_task_mig_mode(self), 0);
 	if (tcmi_taskhelper_checkpoint(self, npm_params) < 0) {
 		mdbg(ERR3, "Failed to create a checkpoint");
 		goto exit0;
@@ -164,7 +206,14 @@ static int tcmi_guesttask_migrateback_p(struct tcmi_task* self, struct tcmi_npm_
 		mdbg(ERR3, "Failed to send message!!");
 		goto exit1;
 	}
+	trace_tcmi_mig_msg_sent(tcmi_task_local_pid(self), tcmi_task_migman_slot_index(self),
+				tcmi_task_mig_mode(self), 
+				tcmi_ckpt_profile_bytes(tcmi_task_profile(self)));
 
+	tcmi_guesttask_release_leases(self);
+
+	director_task_migrated(tcmi_task_local_pid(self), 0, TCMI_CKPT_PHASE_COUNT,
+			       tcmi_task_profile(self)->time, tcmi_task_profile(self)->bytes);
 	director_migrated_home(tcmi_task_local_pid(self));
 	
 	return 0;
@@ -174,6 +223,24 @@ static int tcmi_guesttask_migrateback_p(struct tcmi_task* self, struct tcmi_npm_
 	return -EFAULT;
 }
 
+/** 
+ * \<\<private\>\> Checks whether the guest has started other
+ * threads on the PEN. Only the current thread would be checkpointed,
+ * so such a guest can't migrate home - it is left running here rather
+ * than killed along with all of its threads.
+ *
+ * @param *self - pointer to this task instance
+ * @return 1 if the guest has other threads
+ */
+static int tcmi_guesttask_threaded(struct tcmi_task *self)
+{
+	if (thread_group_empty(current))
+		return 0;
+	mdbg(ERR3, "Process '%s' - guest local PID %d has other threads, not migrating back",
+	     current->comm, tcmi_task_local_pid(self));
+	return 1;
+}
+
 /** 
  * \<\<private\>\> Migrates a task back to CCN using PPM with physical
  * checkpoint image. This requires:
@@ -194,17 +261,98 @@ static int tcmi_guesttask_migrateback_p(struct tcmi_task* self, struct tcmi_npm_
  * @TODO: The second method is also handled here, but not exactly as described.. CCN send asynchronous request to migrate back and
  * then the guest initiates the processing of migration back.. we should likely rework it on transactional case described above
  *
+ * A guest that has started other threads on the PEN can't be
+ * checkpointed, it keeps running here instead (see
+ * tcmi_guesttask_threaded()).
+ *
  * @param *self - pointer to this task instance
  * @return TCMI_KILL_ME in either case (should it fail or not) as we want
- * the task away from the PEN.
+ * the task away from the PEN, TCMI_TASK_KEEP_PUMPING for a guest with
+ * other threads.
  */
 static int tcmi_guesttask_migrateback_ppm_p(struct tcmi_task *self)
 {
+	if (tcmi_guesttask_threaded(self))
+		return TCMI_TASK_KEEP_PUMPING;
 	tcmi_guesttask_migrateback_p(self, NULL);
 	// Migration back was requested so we kill in either case
 	return TCMI_TASK_KILL_ME;
 }
 
+/** 
+ * \<\<private\>\> Migrates a task back to CCN using PPM with a
+ * virtual checkpoint image. This requires:
+ * - creating a new checkpoint of the current process in kernel memory
+ * - flush open files of the current process (prevents write conflicts
+ * after checkpoint restart)
+ * - streaming the image to the shadow over a data connection announced
+ * in the migrate back request, the migration manager connection is
+ * not held during the transfer
+ * - terminating (via KILL_ME status)
+ *
+ * The image is complete before any open file is flushed, so the
+ * shadow can't restart the process before the flush is done. No
+ * filesystem is touched, the image lives in memory only until it has
+ * been sent.
+ *
+ * @param *self - pointer to this task instance
+ * @return TCMI_KILL_ME in either case (should it fail or not) as we want
+ * the task away from the PEN, TCMI_TASK_KEEP_PUMPING for a guest with
+ * other threads.
+ */
+static int tcmi_guesttask_migrateback_ppm_v(struct tcmi_task *self)
+{
+	struct tcmi_msg *req;
+	struct file *image;
+
+	if (tcmi_guesttask_threaded(self))
+		return TCMI_TASK_KEEP_PUMPING;
+
+	mdbg(INFO2, "Process '%s' - guest local PID %d, migrating back (in-memory image)", 
+	     current->comm, tcmi_task_local_pid(self));
+
+	tcmi_task_set_mig_mode(self, TCMI_MIGTRACE_HOME_PPM_V);
+	trace_tcmi_mig_frozen(tcmi_task_local_pid(self), tcmi_task_migman_slot_index(self),
+			      TCMI_MIGTRACE_HOME_PPM_V, 0);
+	image = tcmi_ckptcom_checkpoint_ppm_mem(tcmi_task_context(self), 1);
+	if (IS_ERR(image)) {
+		mdbg(ERR3, "Failed to create an in-memory checkpoint: %ld", PTR_ERR(image));
+		goto exit0;
+	}
+	tcmi_taskhelper_flushfiles();
+	if (!(req = tcmi_ppm_v_migr_back_guestreq_procmsg_new_tx(tcmi_task_remote_pid(self), image,
+								       tcmi_task_sock(self)))) {
+		mdbg(ERR3, "Error creating a migration back message");
+		goto exit1;
+	}
+	/* the message holds its own reference to the image */
+	fput(image);
+	if (tcmi_task_check_peer_lost(self, tcmi_task_send_anonymous_msg(self, req)) < 0) {
+		mdbg(ERR3, "Failed to send message!!");
+		goto exit2;
+	}
+	tcmi_msg_put(req);
+	trace_tcmi_mig_msg_sent(tcmi_task_local_pid(self), tcmi_task_migman_slot_index(self),
+				TCMI_MIGTRACE_HOME_PPM_V, 
+				tcmi_ckpt_profile_bytes(tcmi_task_profile(self)));
+	tcmi_guesttask_release_leases(self);
+
+	director_task_migrated(tcmi_task_local_pid(self), 0, TCMI_CKPT_PHASE_COUNT,
+			       tcmi_task_profile(self)->time, tcmi_task_profile(self)->bytes);
+	director_migrated_home(tcmi_task_local_pid(self));
+
+	return TCMI_TASK_KILL_ME;
+
+	/* error handling */
+ exit2:
+	tcmi_msg_put(req);
+	return TCMI_TASK_KILL_ME;
+ exit1:
+	fput(image);
+ exit0:
+	return TCMI_TASK_KILL_ME;
+}
+
 /**
  * Handles non-preemptive migration back of guest tasks
  */
@@ -244,6 +392,7 @@ static int tcmi_guesttask_exit(struct tcmi_task *self, long code)
 
 	mdbg(INFO2, "Stub process '%s' local PID=%d terminating", 
 	      current->comm, current->pid);
+	tcmi_guesttask_release_leases(self);
 	if (!(m = tcmi_exit_procmsg_new_tx(tcmi_task_remote_pid(self), code))) {
 		mdbg(ERR3, "Can't create error message");
 		goto exit0;
@@ -292,6 +441,12 @@ static int tcmi_guesttask_do_signal(struct tcmi_task *self, unsigned long signr,
  * to the task helper to schedule a restart. This also sets the
  * checkpoint image as the most recent checkpoint of the task.
  *
+ * A streamed checkpoint image is fetched over the data connection of
+ * the shadow, installed as a close-on-exec descriptor and restarted
+ * through the local procfs mounted in the private namespace of the
+ * guest. The transfer runs here in the guest context, the migration
+ * manager keeps receiving messages in the meantime.
+ *
  * A response is sent back that will contain the guest task local
  * PID. This PID is needed for further communication between the
  * shadow and guest tasks.
@@ -310,14 +465,37 @@ static int tcmi_guesttask_process_p_emigrate_msg(struct tcmi_task *self,
 	struct tcmi_msg *resp;
 	pid_t remote_pid;
 	char *ckpt_name;
+	char image_name[64];
+	struct file *image;
+	int fd, err;
 
 	/* extract the remote PID */
 	remote_pid = tcmi_p_emigrate_msg_reply_pid(TCMI_P_EMIGRATE_MSG(m));
 	tcmi_task_set_remote_pid(self, remote_pid);
 	/* extract the checkpoint name */
 	ckpt_name =  tcmi_p_emigrate_msg_ckpt_name(TCMI_P_EMIGRATE_MSG(m));
+	/* streamed image is executed via its descriptor in the local procfs */
+	if (tcmi_p_emigrate_msg_streamed(TCMI_P_EMIGRATE_MSG(m))) {
+		if (IS_ERR(image = tcmi_p_emigrate_msg_fetch_image(TCMI_P_EMIGRATE_MSG(m),
+			tcmi_penmigman_cache_owner(TCMI_PENMIGMAN(self->migman))))) {
+			err = PTR_ERR(image);
+			mdbg(ERR3, "Streamed checkpoint has not been received: %d", err);
+			goto exit1;
+		}
+		if ((fd = get_unused_fd_flags(O_CLOEXEC)) < 0) {
+			mdbg(ERR3, "No descriptor for the streamed checkpoint: %d", fd);
+			fput(image);
+			err = fd;
+			goto exit1;
+		}
+		fd_install(fd, image);
+		snprintf(image_name, sizeof(image_name), "%s/self/fd/%d", 
+			 TCMI_MIGCOM_LOCAL_PROC_PATH, fd);
+		ckpt_name = image_name;
+	}
 		
 	mdbg(INFO2, "Processing emigration request, remote PID=%d, checkpoint: '%s'", tcmi_task_remote_pid(self), ckpt_name);
+	tcmi_task_set_mig_mode(self, TCMI_MIGTRACE_IMMIGRATE);
 
 memory_sanity_check("On processing");
 
@@ -351,12 +529,23 @@ memory_sanity_check("On processing");
 	return TCMI_TASK_KEEP_PUMPING;
 		
 	/* error handling */
+ exit1:
+	/* let the shadow know right away instead of timing out */
+	if ((resp = tcmi_err_procmsg_new_tx(TCMI_GUEST_STARTED_PROCMSG_ID, 
+					    tcmi_msg_req_id(m), err,
+					    tcmi_task_remote_pid(self)))) {
+		tcmi_task_check_peer_lost(self, tcmi_task_send_anonymous_msg(self, resp));
+		tcmi_msg_put(resp);
+	}
  exit0:
 	return TCMI_TASK_KILL_ME;
 }
 
 int tcmi_guesttask_post_fork(struct tcmi_task* self, struct tcmi_task* child, long fork_result, pid_t remote_child_pid) {
 	struct tcmi_msg *m;
+	int leased = TCMI_GUESTTASK(self)->lease_taken;
+
+	TCMI_GUESTTASK(self)->lease_taken = 0;
 
 	if ( fork_result < 0 ) {
 		// Notify CCN about fork-failed
@@ -368,6 +557,7 @@ int tcmi_guesttask_post_fork(struct tcmi_task* self, struct tcmi_task* child, lo
 	} else {
 		BUG_ON(child == NULL); // If fork succeeded, child cannot be null, right?
 
+		TCMI_GUESTTASK(self)->forks++;
 		tcmi_task_set_remote_pid(child, remote_child_pid);		
 
 		if (!(m = tcmi_guest_started_procmsg_new_tx(TCMI_TRANSACTION_INVAL_ID, 
@@ -376,6 +566,10 @@ int tcmi_guesttask_post_fork(struct tcmi_task* self, struct tcmi_task* child, lo
 			mdbg(ERR3, "Cannot create a guest response in post-fork!");
 			goto exit0;
 		}		
+
+		// The stub becomes a child for wait4() once claimed, the shadow lists it as a child already
+		if ( leased )
+			tcmi_guesttask_child_event(self, TCMI_CHILD_EVENT_FORK, remote_child_pid);
 	}
 
 	tcmi_task_send_anonymous_msg(self, m);
@@ -388,6 +582,129 @@ exit0:
 	return -EINVAL;
 }
 
+/**
+ * \<\<private\>\> Sends a child event to the shadow, see
+ * tcmi_zombiecache_class. A fork is recorded in the zombie cache
+ * first, a reap has been recorded when the zombie was consumed.
+ *
+ * @param *self - pointer to this task instance
+ * @param event - TCMI_CHILD_EVENT_REAP or TCMI_CHILD_EVENT_FORK
+ * @param pid - CCN PID of the child
+ */
+static void tcmi_guesttask_child_event(struct tcmi_task *self, u_int32_t event, pid_t pid)
+{
+	struct tcmi_msg *m;
+
+	if (event == TCMI_CHILD_EVENT_FORK)
+		tcmi_zombiecache_forked(tcmi_guesttask_zombiecache(self), pid);
+
+	if (!(m = tcmi_child_event_procmsg_new_tx(tcmi_task_remote_pid(self), event, pid))) {
+		mdbg(ERR3, "Can't create child event message, waits are forwarded from now on");
+		tcmi_zombiecache_disable(tcmi_guesttask_zombiecache(self));
+		return;
+	}
+	tcmi_task_send_anonymous_msg(self, m);
+	tcmi_msg_put(m);
+}
+
+/**
+ * \<\<public\>\> Serves wait4() from the zombie cache. Only waits
+ * for any child or a specific child without rusage and with no
+ * options besides WNOHANG are served, the rest is left to the RPC.
+ * The zombie served is reaped by the shadow asynchronously.
+ *
+ * @param *self - pointer to this task instance
+ * @param pid - pid argument of wait4()
+ * @param *stat_addr - status argument of wait4()
+ * @param options - options argument of wait4()
+ * @param *ru - rusage argument of wait4()
+ * @param *res - result of wait4()
+ * @return 1 if wait4() has been served, 0 if the RPC has to be used
+ */
+int tcmi_guesttask_wait4(struct tcmi_task *self, pid_t pid, int __user *stat_addr, 
+			 int options, struct rusage __user *ru, long *res)
+{
+	int status;
+
+	if (ru || (options & ~WNOHANG) || (pid != -1 && pid <= 0))
+		return 0;
+	if (stat_addr && !access_ok(VERIFY_WRITE, stat_addr, sizeof(*stat_addr)))
+		return 0;
+
+	*res = tcmi_zombiecache_wait(tcmi_guesttask_zombiecache(self), pid, options, &status);
+	if (*res == -EAGAIN)
+		return 0;
+	if (*res > 0) {
+		mdbg(INFO3, "Wait served from zombie cache. Pid: %ld Status: %d", *res, status);
+		tcmi_guesttask_child_event(self, TCMI_CHILD_EVENT_REAP, *res);
+		if (stat_addr && put_user(status, stat_addr))
+			*res = -EFAULT;
+	}
+	return 1;
+}
+
+/**
+ * \<\<public\>\> Performs kill() without waiting for the shadow
+ * when the call can't fail - a standard signal sent to a child the
+ * zombie cache knows and the shadow may signal according to the
+ * credentials it has cached with the snapshot. The snapshot is pushed
+ * again after each RPC, so set*id() calls of the guest are reflected
+ * before they return, changes of the child itself are caught by the
+ * periodic check of the shadow. The shadow performs the kill once it gets to
+ * the message and the caller is told it has succeeded right
+ * away. Real-time signals, signal 0, signals to the process itself,
+ * to process groups and to anybody else are left to the RPC, the
+ * caller might need the error code or the delivery before kill()
+ * returns.
+ *
+ * @param *self - pointer to this task instance
+ * @param pid - pid argument of kill()
+ * @param sig - sig argument of kill()
+ * @return 1 if the kill has been sent, 0 if the RPC has to be used
+ */
+int tcmi_guesttask_kill(struct tcmi_task *self, pid_t pid, int sig)
+{
+	struct tcmi_msg *m;
+
+	if (!TCMI_SIGSET_STANDARD(sig) || pid <= 0)
+		return 0;
+	if (!tcmi_zombiecache_may_kill(tcmi_guesttask_zombiecache(self), pid))
+		return 0;
+
+	if (!(m = tcmi_kill_procmsg_new_tx(tcmi_task_remote_pid(self), pid, sig))) {
+		mdbg(ERR3, "Can't create kill message");
+		return 0;
+	}
+	mdbg(INFO3, "One-way kill of child %d by signal %d", pid, sig);
+	if (tcmi_task_send_anonymous_msg(self, m) < 0)
+		mdbg(ERR3, "Failed to send kill message");
+	tcmi_msg_put(m);
+	return 1;
+}
+
+/** 
+ * \<\<public\>\> Releases the stubs leased by the CCN that haven't
+ * been used by any fork. Each stub is sent the same exit message as
+ * if its fork has failed, so that it terminates without its parent
+ * ever noticing it.
+ *
+ * @param *self - pointer to this task instance
+ */
+void tcmi_guesttask_release_leases(struct tcmi_task *self)
+{
+	struct tcmi_guesttask *self_tsk = TCMI_GUESTTASK(self);
+	struct tcmi_msg *m;
+
+	while (self_tsk->nleases) {
+		if (!(m = tcmi_exit_procmsg_new_tx(self_tsk->leases[--self_tsk->nleases], -ECHILD))) {
+			mdbg(ERR3, "Can't create lease release message");
+			continue;
+		}
+		tcmi_task_send_anonymous_msg(self, m);
+		tcmi_msg_put(m);
+	}
+}
+
 /** \<\<public\>\> Used to set proper tid after a new process was forked.. it must be run in that process context */
 int tcmi_guesttask_post_fork_set_tid(void *self, struct tcmi_method_wrapper *wr) {
 	int res = TCMI_TASK_KEEP_PUMPING;
@@ -425,8 +742,11 @@ static enum tcmi_task_type tcmi_guesttask_get_type(void){
 /** TCMI task operations that support polymorphism */
 static struct tcmi_task_ops guesttask_ops = {
 	.process_msg = tcmi_guesttask_process_msg,
+	.intercept_msg = tcmi_guesttask_intercept_msg,
 	.emigrate_ppm_p = tcmi_guesttask_emigrate_p,	
 	.migrateback_ppm_p = tcmi_guesttask_migrateback_ppm_p,
+	.emigrate_ppm_v = tcmi_guesttask_emigrate_p,	
+	.migrateback_ppm_v = tcmi_guesttask_migrateback_ppm_v,
 	.migrateback_npm = tcmi_guesttask_migrateback_npm,
 	.exit = tcmi_guesttask_exit,
 	.get_type = tcmi_guesttask_get_type,
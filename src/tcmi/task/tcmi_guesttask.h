@@ -30,7 +30,10 @@
 #ifndef _TCMI_GUESTTASK_H
 #define _TCMI_GUESTTASK_H
 
+#include <linux/sched.h>
 #include "tcmi_task.h"
+#include "tcmi_identcache.h"
+#include "tcmi_zombiecache.h"
 
 /** @defgroup tcmi_guesttask_class tcmi_guesttask class 
  * 
@@ -50,14 +53,42 @@
  * - non-preemptive migration via execve hook
  * (tcmi_guesttask_*_npm())
  *
+ * A guest that forks repeatedly gets a block of shadow stubs leased
+ * by the CCN along with the fork RPC. Subsequent plain forks take
+ * their CCN PIDs from the lease and complete locally, the CCN is told
+ * about them by the usual post-fork message. Unused stubs are
+ * released when the guest exits or migrates home.
+ *
+ * Identity of the process (credentials, parent, group and session)
+ * returned by the CCN is cached, see tcmi_identcache_class. So are
+ * the exited children, see tcmi_zombiecache_class.
+ *
  * @{
  */
 
+/** Number of stubs requested from the CCN when the lease is exhausted */
+#define TCMI_GUESTTASK_LEASE 4
+
+/** Clone flags besides the exit signal allowed for a fork that uses a lease */
+#define TCMI_GUESTTASK_LEASE_FLAGS (CLONE_CHILD_SETTID | CLONE_CHILD_CLEARTID | CLONE_PARENT_SETTID)
+
 /** Compound structure for the shadow task. */
 struct tcmi_guesttask {
 	/** parent class instance. */
 	struct tcmi_task super;
 
+	/** CCN PIDs of the stubs leased for the upcoming forks */
+	pid_t leases[TCMI_GUESTTASK_LEASE];
+	/** number of unused leases */
+	int nleases;
+	/** number of forks, leases are requested from the second fork on */
+	int forks;
+	/** the fork in progress uses a leased stub */
+	int lease_taken;
+	/** identity of the process as returned by the CCN */
+	struct tcmi_identcache ident;
+	/** children of the process as pushed by the shadow */
+	struct tcmi_zombiecache zombies;
 };
 
 
@@ -75,6 +106,101 @@ extern struct tcmi_task* tcmi_guesttask_new(pid_t local_pid, struct tcmi_migman*
 extern int tcmi_guesttask_post_fork(struct tcmi_task* self, struct tcmi_task* child, long fork_result, pid_t remote_child_pid);
 
 
+/**
+ * \<\<public\>\> Checks whether a fork with the specified flags can
+ * use a leased stub. Only plain forks signalling SIGCHLD can, the
+ * stubs have been forked the same way.
+ *
+ * @param clone_flags - flags of the fork
+ * @return non-zero if the fork can use a lease
+ */
+static inline int tcmi_guesttask_lease_fork(unsigned long clone_flags)
+{
+	return (clone_flags & CSIGNAL) == SIGCHLD &&
+		!(clone_flags & ~(CSIGNAL | TCMI_GUESTTASK_LEASE_FLAGS));
+}
+
+/**
+ * \<\<public\>\> Number of stubs to be requested by a fork RPC.
+ *
+ * @param *self - this guest task instance
+ * @param clone_flags - flags of the fork
+ * @return number of stubs
+ */
+static inline int tcmi_guesttask_lease_wanted(struct tcmi_task *self, unsigned long clone_flags)
+{
+	struct tcmi_guesttask *self_tsk = TCMI_GUESTTASK(self);
+
+	if (!tcmi_guesttask_lease_fork(clone_flags) || !self_tsk->forks || self_tsk->nleases)
+		return 0;
+	return TCMI_GUESTTASK_LEASE;
+}
+
+/**
+ * \<\<public\>\> Stores the stubs leased by the fork RPC.
+ *
+ * @param *self - this guest task instance
+ * @param *pids - CCN PIDs of the stubs
+ * @param count - number of the stubs
+ */
+static inline void tcmi_guesttask_add_leases(struct tcmi_task *self, int32_t *pids, int count)
+{
+	struct tcmi_guesttask *self_tsk = TCMI_GUESTTASK(self);
+
+	while (count-- > 0 && self_tsk->nleases < TCMI_GUESTTASK_LEASE)
+		self_tsk->leases[self_tsk->nleases++] = *pids++;
+}
+
+/**
+ * \<\<public\>\> Takes a leased stub for a fork.
+ *
+ * @param *self - this guest task instance
+ * @param clone_flags - flags of the fork
+ * @return CCN PID of the stub or 0 when the fork has to be forwarded
+ * to the CCN
+ */
+static inline pid_t tcmi_guesttask_take_lease(struct tcmi_task *self, unsigned long clone_flags)
+{
+	struct tcmi_guesttask *self_tsk = TCMI_GUESTTASK(self);
+
+	if (!tcmi_guesttask_lease_fork(clone_flags) || !self_tsk->nleases)
+		return 0;
+	self_tsk->lease_taken = 1;
+	return self_tsk->leases[--self_tsk->nleases];
+}
+
+/**
+ * \<\<public\>\> Accessor of the identity cache.
+ *
+ * @param *self - this guest task instance
+ * @return identity cache of the guest
+ */
+static inline struct tcmi_identcache* tcmi_guesttask_identcache(struct tcmi_task *self)
+{
+	return &TCMI_GUESTTASK(self)->ident;
+}
+
+/**
+ * \<\<public\>\> Accessor of the zombie cache.
+ *
+ * @param *self - this guest task instance
+ * @return zombie cache of the guest
+ */
+static inline struct tcmi_zombiecache* tcmi_guesttask_zombiecache(struct tcmi_task *self)
+{
+	return &TCMI_GUESTTASK(self)->zombies;
+}
+
+/** \<\<public\>\> Serves wait4() from the zombie cache. */
+extern int tcmi_guesttask_wait4(struct tcmi_task *self, pid_t pid, int __user *stat_addr, 
+				int options, struct rusage __user *ru, long *res);
+
+/** \<\<public\>\> Sends a standard signal to a child without waiting for the result. */
+extern int tcmi_guesttask_kill(struct tcmi_task *self, pid_t pid, int sig);
+
+/** \<\<public\>\> Releases the unused leased stubs. */
+extern void tcmi_guesttask_release_leases(struct tcmi_task *self);
+
 /** \<\<public\>\> Used to set proper tid after a new process was forked.. it must be run in that process context */
 extern int tcmi_guesttask_post_fork_set_tid(void *self, struct tcmi_method_wrapper *wr);
 
@@ -84,12 +210,24 @@ extern int tcmi_guesttask_post_fork_set_tid(void *self, struct tcmi_method_wrapp
 /** Processes a message. */
 static int tcmi_guesttask_process_msg(struct tcmi_task *self, struct tcmi_msg *m);
 
+/** Handles identity changes and children snapshots in the receiving thread. */
+static int tcmi_guesttask_intercept_msg(struct tcmi_task *self, struct tcmi_msg *m);
+
+/** Sends a child event to the shadow. */
+static void tcmi_guesttask_child_event(struct tcmi_task *self, u_int32_t event, pid_t pid);
+
 /** Emigrates a task to a PEN - PPM w/ physical ckpt image. */
 //static int tcmi_guesttask_emigrate_ppm_p(struct tcmi_task *self);
 
 /** Migrates a task back to CCN - PPM w/ physical ckpt image. */
 static int tcmi_guesttask_migrateback_ppm_p(struct tcmi_task *self);
 
+/** Migrates a task back to CCN - PPM w/ virtual ckpt image. */
+static int tcmi_guesttask_migrateback_ppm_v(struct tcmi_task *self);
+
+/** Checks whether the guest has other threads and can't migrate back. */
+static int tcmi_guesttask_threaded(struct tcmi_task *self);
+
 /** Exit notification for the shadow on CCN. */
 static int tcmi_guesttask_exit(struct tcmi_task *self, long code);
 
@@ -0,0 +1,237 @@
+/**
+ * @file tcmi_identcache.c - cache of the identity of a migrated process
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <linux/sched.h>
+#include <linux/cred.h>
+
+#include "tcmi_identcache.h"
+
+#include <dbg.h>
+
+/** @addtogroup tcmi_identcache_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<public\>\> Looks up a scalar entry.
+ *
+ * @param *self - this cache instance
+ * @param entry - entry to look up
+ * @param *value - storage for the value
+ * @return 1 if the entry is valid
+ */
+int tcmi_identcache_get(struct tcmi_identcache *self, enum tcmi_ident_entry entry, long *value)
+{
+	int hit;
+
+	spin_lock(&self->lock);
+	if ((hit = !!(self->valid & (1 << entry))))
+		*value = self->value[entry];
+	spin_unlock(&self->lock);
+	return hit;
+}
+
+/**
+ * \<\<public\>\> Stores a scalar entry. The value is discarded if
+ * the cache has been invalidated since the value has been obtained.
+ *
+ * @param *self - this cache instance
+ * @param entry - entry to store
+ * @param gen - generation read before the value has been obtained
+ * @param value - value to be stored
+ */
+void tcmi_identcache_set(struct tcmi_identcache *self, enum tcmi_ident_entry entry, 
+			 u_int32_t gen, long value)
+{
+	spin_lock(&self->lock);
+	if (self->gen == gen) {
+		self->value[entry] = value;
+		self->valid |= 1 << entry;
+	}
+	spin_unlock(&self->lock);
+}
+
+/**
+ * \<\<public\>\> Looks up real, effective and saved IDs.
+ *
+ * @param *self - this cache instance
+ * @param entry - TCMI_IDENT_RESUID or TCMI_IDENT_RESGID
+ * @param *ids - storage for the 3 IDs
+ * @return 1 if the entry is valid
+ */
+int tcmi_identcache_get_res(struct tcmi_identcache *self, enum tcmi_ident_entry entry, u_int32_t *ids)
+{
+	int hit;
+	int i;
+
+	spin_lock(&self->lock);
+	if ((hit = !!(self->valid & (1 << entry)))) {
+		for (i = 0; i < 3; i++)
+			ids[i] = entry == TCMI_IDENT_RESUID ? self->resuid[i] : self->resgid[i];
+	}
+	spin_unlock(&self->lock);
+	return hit;
+}
+
+/**
+ * \<\<public\>\> Stores real, effective and saved IDs.
+ *
+ * @param *self - this cache instance
+ * @param entry - TCMI_IDENT_RESUID or TCMI_IDENT_RESGID
+ * @param gen - generation read before the IDs have been obtained
+ * @param *ids - the 3 IDs
+ */
+void tcmi_identcache_set_res(struct tcmi_identcache *self, enum tcmi_ident_entry entry, 
+			     u_int32_t gen, u_int32_t *ids)
+{
+	int i;
+
+	spin_lock(&self->lock);
+	if (self->gen == gen) {
+		for (i = 0; i < 3; i++) {
+			if (entry == TCMI_IDENT_RESUID)
+				self->resuid[i] = ids[i];
+			else
+				self->resgid[i] = ids[i];
+		}
+		self->valid |= 1 << entry;
+	}
+	spin_unlock(&self->lock);
+}
+
+/**
+ * \<\<public\>\> Looks up supplementary groups.
+ *
+ * @param *self - this cache instance
+ * @param *groups - storage for TCMI_IDENTCACHE_GROUPS groups
+ * @return number of groups or -1 if the entry is not valid
+ */
+int tcmi_identcache_get_groups(struct tcmi_identcache *self, gid_t *groups)
+{
+	int ngroups = -1;
+
+	spin_lock(&self->lock);
+	if (self->valid & (1 << TCMI_IDENT_GROUPS)) {
+		ngroups = self->ngroups;
+		memcpy(groups, self->groups, ngroups * sizeof(gid_t));
+	}
+	spin_unlock(&self->lock);
+	return ngroups;
+}
+
+/**
+ * \<\<public\>\> Stores supplementary groups. Only up to
+ * TCMI_IDENTCACHE_GROUPS groups are cached, larger sets are always
+ * queried from the CCN.
+ *
+ * @param *self - this cache instance
+ * @param gen - generation read before the groups have been obtained
+ * @param ngroups - number of groups
+ * @param *groups - the groups
+ */
+void tcmi_identcache_set_groups(struct tcmi_identcache *self, u_int32_t gen, 
+				int ngroups, gid_t *groups)
+{
+	if (ngroups < 0 || ngroups > TCMI_IDENTCACHE_GROUPS)
+		return;
+
+	spin_lock(&self->lock);
+	if (self->gen == gen) {
+		self->ngroups = ngroups;
+		memcpy(self->groups, groups, ngroups * sizeof(gid_t));
+		self->valid |= 1 << TCMI_IDENT_GROUPS;
+	}
+	spin_unlock(&self->lock);
+}
+
+/**
+ * \<\<public\>\> Refreshes the cache from the identity of the
+ * current process. This is used by the shadow to find out which
+ * entries have changed since the last check. The first refresh only
+ * fills the cache.
+ *
+ * The values are read the same way the shadow RPCs read them, so
+ * they match what the guest has cached.
+ *
+ * @param *self - this cache instance
+ * @return mask of the entries that have changed
+ */
+u_int32_t tcmi_identcache_update(struct tcmi_identcache *self)
+{
+	const struct cred *cred = current_cred();
+	struct tcmi_identcache now;
+	u_int32_t changed = 0;
+	int i;
+
+	now.value[TCMI_IDENT_UID] = now.resuid[0] = cred->uid;
+	now.value[TCMI_IDENT_EUID] = now.resuid[1] = cred->euid;
+	now.resuid[2] = cred->suid;
+	now.value[TCMI_IDENT_GID] = now.resgid[0] = cred->gid;
+	now.value[TCMI_IDENT_EGID] = now.resgid[1] = cred->egid;
+	now.resgid[2] = cred->sgid;
+	now.ngroups = cred->group_info->ngroups;
+	for (i = 0; i < now.ngroups && i < TCMI_IDENTCACHE_GROUPS; i++)
+		now.groups[i] = GROUP_AT(cred->group_info, i);
+
+	rcu_read_lock();
+	now.value[TCMI_IDENT_PPID] = task_tgid_vnr(current->real_parent);
+	rcu_read_unlock();
+	now.value[TCMI_IDENT_PGRP] = task_pgrp_vnr(current);
+	now.value[TCMI_IDENT_SID] = task_session_vnr(current);
+
+	spin_lock(&self->lock);
+	if (self->valid) {
+		for (i = 0; i < TCMI_IDENT_RESUID; i++) {
+			if (now.value[i] != self->value[i])
+				changed |= 1 << i;
+		}
+		if (memcmp(now.resuid, self->resuid, sizeof(now.resuid)))
+			changed |= 1 << TCMI_IDENT_RESUID;
+		if (memcmp(now.resgid, self->resgid, sizeof(now.resgid)))
+			changed |= 1 << TCMI_IDENT_RESGID;
+		if (now.ngroups != self->ngroups || 
+		    memcmp(now.groups, self->groups, min(now.ngroups, TCMI_IDENTCACHE_GROUPS) * sizeof(gid_t)))
+			changed |= 1 << TCMI_IDENT_GROUPS;
+	}
+	memcpy(self->value, now.value, sizeof(now.value));
+	memcpy(self->resuid, now.resuid, sizeof(now.resuid));
+	memcpy(self->resgid, now.resgid, sizeof(now.resgid));
+	self->ngroups = now.ngroups;
+	memcpy(self->groups, now.groups, min(now.ngroups, TCMI_IDENTCACHE_GROUPS) * sizeof(gid_t));
+	self->valid = TCMI_IDENT_ALL;
+	spin_unlock(&self->lock);
+
+	if (changed)
+		mdbg(INFO3, "Identity of PID %d changed: %x", current->pid, changed);
+	return changed;
+}
+
+/**
+ * @}
+ */
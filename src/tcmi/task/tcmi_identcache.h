@@ -0,0 +1,183 @@
+/**
+ * @file tcmi_identcache.h - cache of the identity of a migrated process
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_IDENTCACHE_H
+#define _TCMI_IDENTCACHE_H
+
+#include <linux/types.h>
+#include <linux/spinlock.h>
+
+/** @defgroup tcmi_identcache_class tcmi_identcache class 
+ *
+ * @ingroup tcmi_task_class
+ *
+ * Identity of a migrated process - its credentials, parent, process
+ * group and session - is owned by the shadow on the CCN and each
+ * query of the guest would be a blocking RPC. Programs like shells
+ * query the identity all the time, so the guest keeps the values
+ * returned by the RPCs in this cache and answers the subsequent
+ * queries locally.
+ *
+ * The cache is kept coherent as follows:
+ * - a guest drops the whole cache once its own set* call returns,
+ * these calls stay synchronous
+ * - the shadow keeps the last values it has seen in an instance of
+ * this class too and checks them after each RPC it has served and
+ * periodically while it is idle. The entries that have changed, e.g.
+ * due to setpgid() called by the parent or reparenting, are pushed
+ * to the guest in a \link tcmi_ident_changed_procmsg_class identity
+ * change message \endlink.
+ *
+ * Changes made on the CCN by somebody else than the process itself
+ * thus reach the guest asynchronously, at most one idle period late.
+ *
+ * Invalidations arrive from the receiving thread of the migration
+ * manager while the guest might be storing a value returned by an
+ * RPC. Every invalidation bumps a generation counter and a value is
+ * stored only when the generation hasn't changed since the RPC has
+ * been issued.
+ *
+ * @{
+ */
+
+/** Cached entries, each one corresponds to a query system call */
+enum tcmi_ident_entry {
+	TCMI_IDENT_UID,
+	TCMI_IDENT_EUID,
+	TCMI_IDENT_GID,
+	TCMI_IDENT_EGID,
+	TCMI_IDENT_PPID,
+	TCMI_IDENT_PGRP,
+	TCMI_IDENT_SID,
+	/** real, effective and saved user ID */
+	TCMI_IDENT_RESUID,
+	/** real, effective and saved group ID */
+	TCMI_IDENT_RESGID,
+	/** supplementary groups */
+	TCMI_IDENT_GROUPS,
+	TCMI_IDENT_COUNT
+};
+
+/** Mask of all entries */
+#define TCMI_IDENT_ALL ((1 << TCMI_IDENT_COUNT) - 1)
+
+/** Maximum number of supplementary groups that are cached */
+#define TCMI_IDENTCACHE_GROUPS 32
+
+/** Compound structure holding the cached identity. */
+struct tcmi_identcache {
+	/** protects the cache against concurrent invalidations */
+	spinlock_t lock;
+	/** mask of the valid entries */
+	u_int32_t valid;
+	/** bumped by each invalidation */
+	u_int32_t gen;
+	/** values of the scalar entries */
+	long value[TCMI_IDENT_RESUID];
+	/** real, effective and saved user ID */
+	uid_t resuid[3];
+	/** real, effective and saved group ID */
+	gid_t resgid[3];
+	/** number of supplementary groups */
+	int ngroups;
+	/** supplementary groups */
+	gid_t groups[TCMI_IDENTCACHE_GROUPS];
+};
+
+/**
+ * \<\<public\>\> Initializes an empty cache.
+ *
+ * @param *self - this cache instance
+ */
+static inline void tcmi_identcache_init(struct tcmi_identcache *self)
+{
+	spin_lock_init(&self->lock);
+	self->valid = 0;
+	self->gen = 0;
+}
+
+/**
+ * \<\<public\>\> Current generation of the cache. Has to be read
+ * before the RPC that provides a value to be stored.
+ *
+ * @param *self - this cache instance
+ * @return generation
+ */
+static inline u_int32_t tcmi_identcache_gen(struct tcmi_identcache *self)
+{
+	u_int32_t gen;
+
+	spin_lock(&self->lock);
+	gen = self->gen;
+	spin_unlock(&self->lock);
+	return gen;
+}
+
+/**
+ * \<\<public\>\> Drops the specified entries from the cache.
+ *
+ * @param *self - this cache instance
+ * @param mask - mask of entries to be dropped
+ */
+static inline void tcmi_identcache_invalidate(struct tcmi_identcache *self, u_int32_t mask)
+{
+	spin_lock(&self->lock);
+	self->valid &= ~mask;
+	self->gen++;
+	spin_unlock(&self->lock);
+}
+
+/** \<\<public\>\> Looks up a scalar entry. */
+extern int tcmi_identcache_get(struct tcmi_identcache *self, enum tcmi_ident_entry entry, long *value);
+
+/** \<\<public\>\> Stores a scalar entry. */
+extern void tcmi_identcache_set(struct tcmi_identcache *self, enum tcmi_ident_entry entry, 
+				u_int32_t gen, long value);
+
+/** \<\<public\>\> Looks up real, effective and saved IDs. */
+extern int tcmi_identcache_get_res(struct tcmi_identcache *self, enum tcmi_ident_entry entry, u_int32_t *ids);
+
+/** \<\<public\>\> Stores real, effective and saved IDs. */
+extern void tcmi_identcache_set_res(struct tcmi_identcache *self, enum tcmi_ident_entry entry, 
+				    u_int32_t gen, u_int32_t *ids);
+
+/** \<\<public\>\> Looks up supplementary groups. */
+extern int tcmi_identcache_get_groups(struct tcmi_identcache *self, gid_t *groups);
+
+/** \<\<public\>\> Stores supplementary groups. */
+extern void tcmi_identcache_set_groups(struct tcmi_identcache *self, u_int32_t gen, 
+				       int ngroups, gid_t *groups);
+
+/** \<\<public\>\> Refreshes the cache from the identity of the current process. */
+extern u_int32_t tcmi_identcache_update(struct tcmi_identcache *self);
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_IDENTCACHE_H */
@@ -33,15 +33,19 @@
 #include <tcmi/comm/tcmi_rpc_procmsg.h>
 #include <tcmi/comm/tcmi_rpcresp_procmsg.h>
 #include <tcmi/comm/tcmi_ppm_p_migr_back_shadowreq_procmsg.h>
+#include <tcmi/comm/tcmi_ppm_v_migr_back_shadowreq_procmsg.h>
 #include <tcmi/manager/tcmi_migman.h>
 #include <tcmi/migration/tcmi_npm_params.h>
+#include <tcmi/ckpt/tcmi_ckpt_dedup.h>
 #include "tcmi_taskhelper.h"
 
 #define TCMI_SHADOWTASK_PRIVATE
 #include "tcmi_shadowtask.h"
 #include <asm/signal.h>
+#include <linux/syscalls.h>
 #include <proxyfs/proxyfs_server.h>
 
+#include <tcmi/migration/tcmi_migtrace.h>
 #include <director/director.h>
 
 /** 
@@ -103,6 +107,13 @@ struct tcmi_task* tcmi_shadowtask_new(pid_t local_pid, struct tcmi_migman* migma
 		minfo(ERR3, "TCMI shadow task initialization failed!");
 		goto exit1;
 	}
+	task->readahead = 0;
+	task->leasing = 0;
+	task->leased = 0;
+	task->lease_pgrp = 0;
+	tcmi_identcache_init(&task->ident);
+	tcmi_zombiecache_watch_init(&task->children);
+	task->sigbatch = NULL;
 	return TCMI_TASK(task);
 
 	/* error handling */
@@ -137,7 +148,13 @@ static int tcmi_shadowtask_process_msg(struct tcmi_task *self, struct tcmi_msg *
 		case TCMI_RPC_PROCMSG_ID:
 			mdbg(INFO1, "Receiced RPC message: %x", tcmi_msg_id(m));
 
+			/* The identity is checked around the call, so that a change racing with the call
+			 * is pushed too. Changes made by set* calls are pushed needlessly, they are rare. */
+			tcmi_shadowtask_check_ident(self);
 			tcmi_rpc_call2(tcmi_shadow_rpc, tcmi_rpc_procmsg_num(TCMI_RPC_PROCMSG(m)), (long)m, (long)(&resp));
+			tcmi_shadowtask_check_ident(self);
+			/* children forked or reaped by the call are known to the guest before the response */
+			tcmi_shadowtask_check_children(self);
 
 			if ( resp == NULL ) {
 				minfo(ERR3, "RPC#%d didn't returned rpc response message", 
@@ -167,6 +184,9 @@ static int tcmi_shadowtask_process_msg(struct tcmi_task *self, struct tcmi_msg *
 					tcmi_task_remote_pid(self),
 					(long)tcmi_exit_procmsg_code(TCMI_EXIT_PROCMSG(m)));
 			tcmi_task_set_exit_code(self, tcmi_exit_procmsg_code(TCMI_EXIT_PROCMSG(m)));
+			/* a negative code of a leased stub means it has never been used by a fork */
+			if ( TCMI_SHADOWTASK(self)->leased )
+				tcmi_shadowtask_end_lease(self, tcmi_exit_procmsg_code(TCMI_EXIT_PROCMSG(m)) >= 0);
 			res = TCMI_TASK_KILL_ME;
 			break;
 		/* vfork done on guest side */
@@ -180,10 +200,26 @@ static int tcmi_shadowtask_process_msg(struct tcmi_task *self, struct tcmi_msg *
 		case TCMI_PPM_P_MIGR_BACK_GUESTREQ_PROCMSG_ID:
 			res = tcmi_shadowtask_process_ppm_p_migr_back_guestreq_procmsg(self, m);
 			break;
+		case TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG_ID:
+			res = tcmi_shadowtask_process_ppm_v_migr_back_guestreq_procmsg(self, m);
+			break;
 		case TCMI_GUEST_STARTED_PROCMSG_ID: // We can get here only in double-fork
 			remote_pid = tcmi_guest_started_procmsg_guest_pid(TCMI_GUEST_STARTED_PROCMSG(m));
 			mdbg(INFO3, "Fork confirmation from guesttask - task migrated, local PID %d, guest PID %d", tcmi_task_local_pid(self), remote_pid);
 			tcmi_task_set_remote_pid(self, remote_pid);
+			if ( TCMI_SHADOWTASK(self)->leased )
+				tcmi_shadowtask_end_lease(self, 1);
+			break;
+		/* guest has consumed a zombie or forked using a leased stub */
+		case TCMI_CHILD_EVENT_PROCMSG_ID:
+			tcmi_zombiecache_watch_event(&TCMI_SHADOWTASK(self)->children, 
+						     tcmi_child_event_procmsg_event(TCMI_CHILD_EVENT_PROCMSG(m)),
+						     tcmi_child_event_procmsg_pid(TCMI_CHILD_EVENT_PROCMSG(m)));
+			tcmi_shadowtask_check_children(self);
+			break;
+		/* kill the guest doesn't wait for */
+		case TCMI_KILL_PROCMSG_ID:
+			tcmi_shadowtask_kill(self, TCMI_KILL_PROCMSG(m));
 			break;
 		default:
 			mdbg(ERR3, "Unexpected message from the guest task: %x", tcmi_msg_id(m));
@@ -193,6 +229,187 @@ static int tcmi_shadowtask_process_msg(struct tcmi_task *self, struct tcmi_msg *
 	return res;
 }
 
+/**
+ * \<\<private\>\> Checks whether the identity of the process has
+ * changed since the last check and pushes the changed entries to the
+ * guest, see tcmi_identcache_class. Called around each RPC and
+ * periodically while the shadow is idle, which catches the changes
+ * made by other processes on the CCN (setpgid() by the parent,
+ * reparenting on the parent exit).
+ *
+ * @param *self - pointer to this task instance
+ */
+static void tcmi_shadowtask_check_ident(struct tcmi_task *self)
+{
+	struct tcmi_msg *m;
+	u_int32_t changed;
+
+	changed = tcmi_identcache_update(&TCMI_SHADOWTASK(self)->ident);
+	/* a stub not started yet has nobody to notify */
+	if (!changed || !tcmi_task_remote_pid(self))
+		return;
+
+	if (!(m = tcmi_ident_changed_procmsg_new_tx(tcmi_task_remote_pid(self), changed))) {
+		mdbg(ERR3, "Can't create identity change message");
+		return;
+	}
+	tcmi_task_check_peer_lost(self, tcmi_task_send_anonymous_msg(self, m));
+	tcmi_msg_put(m);
+}
+
+/**
+ * \<\<private\>\> Pushes a snapshot of the children to the guest
+ * when they have changed since the last one, see
+ * tcmi_zombiecache_class.
+ *
+ * @param *self - pointer to this task instance
+ */
+static void tcmi_shadowtask_check_children(struct tcmi_task *self)
+{
+	struct tcmi_children *children;
+	struct tcmi_msg *m;
+
+	/* a stub not started yet has nobody to notify */
+	if (!tcmi_task_remote_pid(self))
+		return;
+	if (!(children = tcmi_zombiecache_watch_check(&TCMI_SHADOWTASK(self)->children)))
+		return;
+
+	if (!(m = tcmi_children_procmsg_new_tx(tcmi_task_remote_pid(self), children))) {
+		mdbg(ERR3, "Can't create children snapshot message");
+		return;
+	}
+	tcmi_task_check_peer_lost(self, tcmi_task_send_anonymous_msg(self, m));
+	tcmi_msg_put(m);
+}
+
+/**
+ * \<\<private\>\> Runs periodically while the shadow has no
+ * messages to process. Catches the changes of the process on the CCN
+ * the shadow is not notified about.
+ *
+ * @param *self - pointer to this task instance
+ */
+static void tcmi_shadowtask_idle(struct tcmi_task *self)
+{
+	tcmi_shadowtask_check_ident(self);
+	tcmi_shadowtask_check_children(self);
+}
+
+/**
+ * \<\<private\>\> Ends the lease of a stub that has been forked
+ * ahead of time for the guest.
+ *
+ * A stub claimed by a fork on the PEN becomes a regular child of its
+ * parent - its exit is signalled by SIGCHLD and the director learns
+ * about the fork. Its proxyfs files are updated to match the current
+ * files of the parent as the parent might have closed some files
+ * since the stub has been forked.
+ *
+ * A claimed stub also joins the process group of its parent, it has
+ * been kept in its own group while unclaimed. When the parent has
+ * left the session meanwhile, the stub joins the group the parent had
+ * when the stub has been leased instead.
+ *
+ * The rest of the state a fork inherits needn't be copied again. The
+ * guest releases its leases whenever it changes its credentials or
+ * session, see tcmi_guest_rpc_ident_changed(). The working directory,
+ * umask and resource limits of a shadow never change, they are
+ * changed by the guest on the PEN only, so a leased stub has the same
+ * as a stub forked right by the fork RPC.
+ *
+ * An unused stub is detached, so that it is reaped as soon as it
+ * exits and its parent never sees it.
+ *
+ * Must be called in the context of the stub.
+ *
+ * @param *self - pointer to this task instance
+ * @param claimed - set when the stub has been claimed by a fork
+ */
+static void tcmi_shadowtask_end_lease(struct tcmi_task *self, int claimed)
+{
+	struct task_struct *parent;
+	pid_t pgrp;
+	long err;
+
+	TCMI_SHADOWTASK(self)->leased = 0;
+
+	write_lock_irq(&tasklist_lock);
+	current->exit_signal = claimed ? SIGCHLD : -1;
+	parent = current->real_parent;
+	get_task_struct(parent);
+	write_unlock_irq(&tasklist_lock);
+
+	mdbg(INFO3, "Leased stub local PID %d %s", tcmi_task_local_pid(self), 
+	     claimed ? "claimed" : "released");
+	if ( claimed ) {
+		rcu_read_lock();
+		pgrp = task_pgrp_vnr(parent);
+		rcu_read_unlock();
+		if ( (err = sys_setpgid(0, pgrp)) == -EPERM && pgrp != TCMI_SHADOWTASK(self)->lease_pgrp ) {
+			pgrp = TCMI_SHADOWTASK(self)->lease_pgrp;
+			err = sys_setpgid(0, pgrp);
+		}
+		if ( err )
+			mdbg(ERR3, "Claimed stub can't join process group %d: %ld", pgrp, err);
+		proxyfs_server_reconcile_parent(parent, current);
+		director_task_fork(current->pid, parent->pid);
+	}
+	put_task_struct(parent);
+}
+
+/**
+ * \<\<public\>\> Releases the lease of a stub that is terminating
+ * without having been claimed, e.g. when the connection to the PEN
+ * has been lost or the stub has been killed. An unclaimed stub has no
+ * exit signal, without the release it would stay a zombie its parent
+ * never waits for.
+ *
+ * Must be called in the context of the stub.
+ *
+ * @param *self - pointer to this task instance
+ */
+void tcmi_shadowtask_release_lease(struct tcmi_task *self)
+{
+	if ( TCMI_SHADOWTASK(self)->leased )
+		tcmi_shadowtask_end_lease(self, 0);
+}
+
+/**
+ * \<\<public\>\> Checks whether a wait for any child of the current
+ * process would see unclaimed stubs only. The stubs have no exit
+ * signal, so they are skipped by regular waits. __WALL and __WCLONE
+ * waits see them though and would block or report no exited child
+ * instead of failing with ECHILD, as the stubs never become zombies.
+ *
+ * Must be called in the context of the shadow.
+ *
+ * @param options - options of the wait
+ * @return non-zero when the wait has to fail with ECHILD
+ */
+int tcmi_shadowtask_only_leases(int options)
+{
+	struct task_struct *p;
+	int leases = 0, others = 0;
+
+	if ( !(options & (__WALL | __WCLONE)) )
+		return 0;
+
+	read_lock(&tasklist_lock);
+	list_for_each_entry(p, &current->children, sibling) {
+		if ( p->exit_signal == -1 )
+			leases++;
+		else if ( (options & __WALL) || 
+			  ((p->exit_signal != SIGCHLD) == !!(options & __WCLONE)) )
+			others++;
+	}
+	if ( !list_empty(&current->ptraced) )
+		others++;
+	read_unlock(&tasklist_lock);
+
+	return leases && !others;
+}
+
 static void tcmi_shadowtask_vfork_done(struct tcmi_task *self) {
 	struct completion *vfork_done = current->vfork_done;
 	if ( current->vfork_done ) {
@@ -201,13 +418,55 @@ static void tcmi_shadowtask_vfork_done(struct tcmi_task *self) {
 	}
 }
 
+/**
+ * \<\<private\>\> Offers hashes of the process pages to the PEN. The
+ * PEN pins the pages it already has in its page cache, these pages
+ * are then sent as references only. If the PEN doesn't respond, the
+ * hashes are still used, so that the PEN caches the sent pages.
+ *
+ * @param *self - pointer to this task instance
+ * @return page hashes for the streamed checkpoint or NULL
+ */
+static struct tcmi_ckpt_dedup* tcmi_shadowtask_dedup(struct tcmi_task *self)
+{
+	struct tcmi_ckpt_dedup *dedup;
+	struct tcmi_msg *req, *resp;
+
+	if (!(dedup = tcmi_ckpt_dedup_new()))
+		return NULL;
+	if (!(req = tcmi_page_hashes_msg_new_tx(tcmi_migman_transactions(self->migman), dedup))) {
+		mdbg(ERR3, "Error creating page hashes message");
+		return dedup;
+	}
+	if (tcmi_msg_send_and_receive(req, tcmi_migman_sock(self->migman), &resp) < 0 || !resp) {
+		mdbg(ERR3, "No page hashes response from the PEN");
+		goto exit0;
+	}
+	if (tcmi_msg_id(resp) == TCMI_PAGE_HASHES_RESP_MSG_ID &&
+	    tcmi_page_hashes_resp_msg_count(TCMI_PAGE_HASHES_RESP_MSG(resp)) == tcmi_ckpt_dedup_count(dedup))
+		tcmi_ckpt_dedup_set_session(dedup, 
+					    tcmi_page_hashes_resp_msg_session(TCMI_PAGE_HASHES_RESP_MSG(resp)),
+					    tcmi_page_hashes_resp_msg_take_known(TCMI_PAGE_HASHES_RESP_MSG(resp)));
+	tcmi_msg_put(resp);
+
+	/* fall through is ok, the dedup is used without a session */
+ exit0:
+	tcmi_msg_put(req);
+	return dedup;
+}
+
 /** Internal helper method that can perform both NPM and PPM physical emigration */
 static int tcmi_shadowtask_emigrate_p(struct tcmi_task *self, struct tcmi_npm_params* npm_params) {
 	struct tcmi_msg *req, *resp;
+	struct tcmi_ckpt_dedup *dedup = NULL;
 	char* exec_name;
 	u64 beg_time, end_time;
 	
 	beg_time = cpu_clock(smp_processor_id());
+
+	tcmi_task_set_mig_mode(self, npm_params ? TCMI_MIGTRACE_EMIGRATE_NPM : TCMI_MIGTRACE_EMIGRATE_PPM);
+	trace_tcmi_mig_frozen(tcmi_task_local_pid(self), tcmi_task_migman_slot_index(self),
+			      tcmi_task_mig_mode(self), 0);
 	
 	if ( npm_params ) {
 		// For NPM, the exec name is name of the file being executed
@@ -220,19 +479,33 @@ static int tcmi_shadowtask_emigrate_p(struct tcmi_task *self, struct tcmi_npm_pa
 	mdbg(INFO2, "Process '%s' - local PID %d, emigrating",
 	     current->comm, tcmi_task_local_pid(self));
 
-	if (tcmi_taskhelper_checkpoint(self, npm_params) < 0) {
-		mdbg(ERR3, "Failed to create a checkpoint");
+	/* only the current thread would be checkpointed, the rest of the
+	 * process would be lost */
+	if (!npm_params && !thread_group_empty(current)) {
+		mdbg(ERR3, "Process '%s' has other threads, not emigrating", current->comm);
 		goto exit0;
 	}
 
-	if (!(req = tcmi_p_emigrate_msg_new_tx(tcmi_task_transactions(self), 
-						   tcmi_task_local_pid(self), 
-						   exec_name,
-						   tcmi_task_ckpt_name(self),
-						   current_euid(),
-						   current_egid(),
-						   current_fsuid(),
-						   current_fsgid()))) {
+	/* Pages already held by the PEN are sent as references */
+	if (!npm_params)
+		dedup = tcmi_shadowtask_dedup(self);
+
+	/* The checkpoint is streamed over a data connection once the
+	 * message has been sent */
+	req = tcmi_p_emigrate_msg_new_stream_tx(tcmi_task_transactions(self), 
+						tcmi_task_sock(self),
+						tcmi_task_local_pid(self), 
+						exec_name,
+						tcmi_task_context(self),
+						npm_params,
+						dedup,
+						npm_params ? 0 : TCMI_SHADOWTASK(self)->readahead,
+						current_euid(),
+						current_egid(),
+						current_fsuid(),
+						current_fsgid());
+	tcmi_ckpt_dedup_put(dedup);
+	if (!req) {
 		mdbg(ERR3, "Error creating an emigration message");
 		goto exit0;
 	}
@@ -244,10 +517,16 @@ static int tcmi_shadowtask_emigrate_p(struct tcmi_task *self, struct tcmi_npm_pa
 		mdbg(ERR3, "Failed to migrate the task '%s'", current->comm);
 		goto exit2;
 	}
+	trace_tcmi_mig_shadow_notified(tcmi_task_local_pid(self), tcmi_task_migman_slot_index(self),
+				       tcmi_task_mig_mode(self), 
+				       tcmi_ckpt_profile_bytes(tcmi_task_profile(self)));
+
+	/* the checkpoint has been streamed in our context, report its phases */
+	director_task_migrated(tcmi_task_local_pid(self), 0, TCMI_CKPT_PHASE_COUNT,
+			       tcmi_task_profile(self)->time, tcmi_task_profile(self)->bytes);
 
 	end_time = cpu_clock(smp_processor_id());
 	mdbg(INFO3, "Emigration (npm: %d) took '%llu' ms.'", npm_params != NULL, (end_time - beg_time) / 1000000);
-	printk("Emigration (npm: %d) took '%llu' ms.\n'", npm_params != NULL, (end_time - beg_time) / 1000000);
 	
 	/* 
 	   Files are flushed only after we have confirmation that the migration have succeeded.
@@ -280,12 +559,12 @@ static int tcmi_shadowtask_emigrate_p(struct tcmi_task *self, struct tcmi_npm_pa
 
 /** 
  * \<\<private\>\> Emigrates a task to a PEN.
- * - create a new checkpoint
+ * - creates a new emigration message specifying shadow task PID
+ * - send the message waiting for a response, the checkpoint is
+ * streamed over a dedicated data connection once the message is out,
+ * the migration manager socket is not held during the transfer
  * - flush open files of the current process (prevents write conflicts
  * after checkpoint restart)
- * - creates a new emigration message specifying latest checkpoint name
- * and shadow task PID
- * - send the message waiting for a response
  * - if the guest has been succesfully started submit process_msg method into
  * the method queue and quit (migration verification). The submitted method
  * will keep on processing any message that will arrive on the queue.
@@ -310,6 +589,20 @@ static int tcmi_shadowtask_emigrate_ppm_p(struct tcmi_task *self)
 	return tcmi_shadowtask_emigrate_p(self, NULL);
 }
 
+/** 
+ * \<\<private\>\> Emigrates a task to a PEN using a virtual
+ * checkpoint image. The emigration checkpoint is always streamed over
+ * a data connection into an in-memory image on the PEN, so
+ * this is the very same path as tcmi_shadowtask_emigrate_ppm_p().
+ *
+ * @param *self - pointer to this task instance
+ * @return see tcmi_shadowtask_emigrate_ppm_p()
+ */
+static int tcmi_shadowtask_emigrate_ppm_v(struct tcmi_task *self)
+{
+	return tcmi_shadowtask_emigrate_p(self, NULL);
+}
+
 static int tcmi_shadowtask_emigrate_npm(struct tcmi_task *self, struct tcmi_npm_params* npm_params)
 {
 	return tcmi_shadowtask_emigrate_p(self, npm_params);
@@ -350,6 +643,35 @@ exit0:
 }
 
 
+/** 
+ * \<\<private\>\> Migrates a task back to CCN using a virtual
+ * checkpoint image. Same as tcmi_shadowtask_migrateback_ppm_p(), the
+ * guest is asked to migrate home, the request just tells it to stream
+ * the image instead of storing it in a file.
+ *
+ * @param *self - pointer to this task instance
+ * @return TCMI_TASK_KEEP_PUMPING
+ */
+static int tcmi_shadowtask_migrateback_ppm_v(struct tcmi_task *self)
+{
+	struct tcmi_msg *msg;
+
+	mdbg(INFO2, "Process '%s' - local PID %d, remote PID %d, in-memory migrate home requested",
+	     current->comm, tcmi_task_local_pid(self), tcmi_task_remote_pid(self));
+
+	if ( !(msg = tcmi_ppm_v_migr_back_shadowreq_procmsg_new_tx(tcmi_task_remote_pid(self))) ) {
+		mdbg(ERR3, "Error creating a migrate back message");
+		goto exit0;
+	}
+
+	if ( tcmi_task_check_peer_lost(self, tcmi_task_send_anonymous_msg(self, msg)) < 0)
+		mdbg(ERR3, "Failed to send message!!");
+	tcmi_msg_put(msg);
+exit0:	
+	return TCMI_TASK_KEEP_PUMPING;
+}
+
+
 /** 
  * \<\<private\>\> Execve notification when merging shadow with
  * migrating process on CCN.  This method is called right before
@@ -375,6 +697,16 @@ static int tcmi_shadowtask_execve(struct tcmi_task *self)
  * \<\<private\>\> Processes a specified signal.  
  * All signals are forwared to the guest task.
  *
+ * Standard signals are not forwarded one by one. They are collected
+ * in a \link tcmi_sigset_msg_class signal set \endlink that is sent
+ * once all pending signals have been processed, see
+ * tcmi_shadowtask_signals_done(). A standard signal received again
+ * before the set is sent is merged with the first one, just like the
+ * kernel does with a standard signal that is already pending. A
+ * SIGCHLD storm thus costs a single message. Real-time signals are
+ * queued and each of them is forwarded right away, after the set
+ * collected so far.
+ *
  * @param *self - pointer to this task instance 
  * @param signr - signal that is to be processed
  * @param *info - info for signal to be processed
@@ -384,9 +716,27 @@ static int tcmi_shadowtask_execve(struct tcmi_task *self)
 static int tcmi_shadowtask_do_signal(struct tcmi_task *self, unsigned long signr, siginfo_t *info)
 {
 	int res = TCMI_TASK_KEEP_PUMPING;
+	struct tcmi_shadowtask *self_tsk = TCMI_SHADOWTASK(self);
 	struct tcmi_msg *msg;
 
 	mdbg(INFO2, "Shadow is processing signal %lu", signr);
+
+	/* the guest gets the exit status of the child before its SIGCHLD handler runs */
+	if ( signr == SIGCHLD )
+		tcmi_shadowtask_check_children(self);
+
+	if ( TCMI_SIGSET_STANDARD(info->si_signo) ) {
+		if ( !self_tsk->sigbatch )
+			self_tsk->sigbatch = tcmi_sigset_msg_new_tx(tcmi_task_remote_pid(self));
+		if ( self_tsk->sigbatch ) {
+			if ( !tcmi_sigset_msg_add(TCMI_SIGSET_MSG(self_tsk->sigbatch), info) )
+				mdbg(INFO2, "Signal %lu merged with the pending one", signr);
+			return res;
+		}
+		mdbg(ERR3, "Can't create signal set message, forwarding signal %lu alone", signr);
+	}
+	/* keep the order of the signals collected so far */
+	tcmi_shadowtask_signals_done(self);
 	
 	msg = tcmi_signal_msg_new(tcmi_task_remote_pid(self), info);
 	if( msg ){
@@ -397,6 +747,47 @@ static int tcmi_shadowtask_do_signal(struct tcmi_task *self, unsigned long signr
 	return res;
 }
 
+/**
+ * \<\<private\>\> Forwards the standard signals collected by
+ * tcmi_shadowtask_do_signal() to the guest in one message. Called
+ * once all pending signals of the shadow have been processed.
+ *
+ * @param *self - pointer to this task instance 
+ */
+static void tcmi_shadowtask_signals_done(struct tcmi_task *self)
+{
+	struct tcmi_shadowtask *self_tsk = TCMI_SHADOWTASK(self);
+	struct tcmi_msg *msg;
+
+	if ( !(msg = self_tsk->sigbatch) )
+		return;
+	self_tsk->sigbatch = NULL;
+
+	tcmi_task_check_peer_lost(self, tcmi_msg_send_anonymous(msg, tcmi_migman_sock(self->migman)));
+	mdbg(INFO2, "Signal set message send");
+	tcmi_msg_put(msg);
+}
+
+/**
+ * \<\<private\>\> Performs a kill the guest has sent as a
+ * one-way message. The guest has returned success to the caller
+ * already, so an error can only be logged.
+ *
+ * The kill is done in the context of the shadow, so that the target
+ * sees the same sender as with the TCMI_RPC_SYS_KILL RPC.
+ *
+ * @param *self - pointer to this task instance 
+ * @param *m - the kill request
+ */
+static void tcmi_shadowtask_kill(struct tcmi_task *self, struct tcmi_kill_procmsg *m)
+{
+	long err;
+
+	if ( (err = sys_kill(tcmi_kill_procmsg_pid(m), tcmi_kill_procmsg_sig(m))) < 0 )
+		mdbg(ERR3, "One-way kill of PID %d by signal %d failed: %ld", 
+		     tcmi_kill_procmsg_pid(m), tcmi_kill_procmsg_sig(m), err);
+}
+
 /**
  * \<\<private\>\> Verifies, that the task has been successfully migrated.
  * The verification is done based on response message the has to be
@@ -477,6 +868,8 @@ static int tcmi_shadowtask_process_ppm_p_migr_back_guestreq_procmsg(struct tcmi_
 		     tcmi_task_remote_pid(self), ckpt_name);
 
 	director_migrated_home(tcmi_task_local_pid(self));
+	/* non-preemptive migration home uses the same request */
+	tcmi_task_set_mig_mode(self, TCMI_MIGTRACE_HOME_PPM_P);
 	
 	/* schedules process restart from a checkpoint image */
 	if (tcmi_taskhelper_restart(self, ckpt_name) < 0) {
@@ -491,9 +884,71 @@ static int tcmi_shadowtask_process_ppm_p_migr_back_guestreq_procmsg(struct tcmi_
 	return TCMI_TASK_KILL_ME;
 }
 
+/** 
+ * \<\<private\>\> Processes an in-memory migrate back request. The
+ * checkpoint image is fetched over the data connection announced in
+ * the message into an in-memory file. This happens in the shadow's
+ * context, so the migration manager keeps receiving meanwhile. The
+ * image is installed as a close-on-exec descriptor and the restart is
+ * scheduled via its procfs link, so it is released once the process
+ * has been restarted.
+ *
+ * An image that couldn't be fetched or has been aborted by the guest
+ * is ignored, the guest terminates and its exit is announced the
+ * usual way.
+ *
+ * @param *self - this shadow task instance
+ * @param *m - PPM_V migrate back guest request
+ * @return TASK_KEEP_PUMPING if the restart has been successfully
+ * scheduled
+ */
+static int tcmi_shadowtask_process_ppm_v_migr_back_guestreq_procmsg(struct tcmi_task *self, 
+								   struct tcmi_msg *m)
+{
+	char ckpt_name[64];
+	struct file *image;
+	int fd;
+
+	image = tcmi_ppm_v_migr_back_guestreq_procmsg_fetch_image
+		(TCMI_PPM_V_MIGR_BACK_GUESTREQ_PROCMSG(m));
+	if (IS_ERR(image)) {
+		mdbg(ERR3, "Migrate back request without an image, remote PID=%d: %ld", 
+		     tcmi_task_remote_pid(self), PTR_ERR(image));
+		return TCMI_TASK_KEEP_PUMPING;
+	}
+	if ((fd = get_unused_fd_flags(O_CLOEXEC)) < 0) {
+		mdbg(ERR3, "No descriptor for the checkpoint image: %d", fd);
+		goto exit1;
+	}
+	fd_install(fd, image);
+	snprintf(ckpt_name, sizeof(ckpt_name), "/proc/self/fd/%d", fd);
+
+	mdbg(INFO2, "Processing in-memory migrate back request, remote PID=%d, checkpoint: '%s'",
+		     tcmi_task_remote_pid(self), ckpt_name);
+
+	director_migrated_home(tcmi_task_local_pid(self));
+	tcmi_task_set_mig_mode(self, TCMI_MIGTRACE_HOME_PPM_V);
+	
+	/* schedules process restart from a checkpoint image */
+	if (tcmi_taskhelper_restart(self, ckpt_name) < 0) {
+		mdbg(ERR3, "Cannot setup task restart!!");
+		goto exit0;
+	}
+	return TCMI_TASK_KEEP_PUMPING;
+		
+	/* error handling */
+ exit1:
+	fput(image);
+ exit0:
+	return TCMI_TASK_KILL_ME;
+}
+
 /** \<\<private\>\> Custom free method */
 static void tcmi_shadowtask_free(struct tcmi_task* self)
 {
+	/* signals collected when the pump has stopped have nobody to go to */
+	if ( TCMI_SHADOWTASK(self)->sigbatch )
+		tcmi_msg_put(TCMI_SHADOWTASK(self)->sigbatch);
 }
 
 
@@ -507,12 +962,16 @@ enum tcmi_task_type tcmi_shadowtask_get_type(void)
 /** TCMI task operations that support polymorphism */
 static struct tcmi_task_ops shadowtask_ops = {
 	.process_msg = tcmi_shadowtask_process_msg,
+	.idle = tcmi_shadowtask_idle,
 	.emigrate_ppm_p = tcmi_shadowtask_emigrate_ppm_p,
 	.emigrate_npm = tcmi_shadowtask_emigrate_npm,
 	.migrateback_ppm_p = tcmi_shadowtask_migrateback_ppm_p,
+	.emigrate_ppm_v = tcmi_shadowtask_emigrate_ppm_v,
+	.migrateback_ppm_v = tcmi_shadowtask_migrateback_ppm_v,
 	.execve = tcmi_shadowtask_execve,
 	.get_type = tcmi_shadowtask_get_type,
 	.do_signal = tcmi_shadowtask_do_signal,
+	.signals_done = tcmi_shadowtask_signals_done,
 	.free = tcmi_shadowtask_free
 };
 
@@ -31,6 +31,8 @@
 #define _TCMI_SHADOWTASK_H
 
 #include "tcmi_task.h"
+#include "tcmi_identcache.h"
+#include "tcmi_zombiecache.h"
 
 /** @defgroup tcmi_shadowtask_class tcmi_shadowtask class 
  * 
@@ -56,8 +58,28 @@
 struct tcmi_shadowtask {
 	/** parent class instance. */
 	struct tcmi_task super;
+	/** restart readahead window of the next emigration in pages,
+	 * 0 selects the default, negative value disables it */
+	int readahead;
+	/** set while forking stubs leased to the guest */
+	int leasing;
+	/** set while this task is a stub leased to the guest that
+	 * hasn't been claimed by a fork yet */
+	int leased;
+	/** process group of the parent when the stub has been leased */
+	pid_t lease_pgrp;
+	/** identity of the process last seen, changes are pushed to
+	 * the guest */
+	struct tcmi_identcache ident;
+	/** children of the process last pushed to the guest */
+	struct tcmi_zombiecache_watch children;
+	/** standard signals not forwarded to the guest yet */
+	struct tcmi_msg *sigbatch;
 };
 
+/** Maximum number of stubs leased to a guest by a single fork */
+#define TCMI_SHADOWTASK_MAX_LEASE 16
+
 
 /** Casts to the task instance. */
 #define TCMI_SHADOWTASK(t) ((struct tcmi_shadowtask*)t)
@@ -68,6 +90,64 @@ extern struct tcmi_task* tcmi_shadowtask_new(pid_t local_pid, struct tcmi_migman
 					     struct tcmi_ctlfs_entry *d_migproc, 
 					     struct tcmi_ctlfs_entry *d_migman);
 
+/** \<\<public\>\> Releases the lease of a stub that is going away unclaimed. */
+extern void tcmi_shadowtask_release_lease(struct tcmi_task *self);
+
+/** \<\<public\>\> Checks whether a wait for any child would see unclaimed stubs only. */
+extern int tcmi_shadowtask_only_leases(int options);
+
+/** 
+ * \<\<public\>\> Sets the number of pages of each heavy area that are
+ * populated when the process is restarted after its next preemptive
+ * emigration.
+ *
+ * @param *self - this shadow task instance
+ * @param readahead - window in pages, 0 selects the default, negative
+ * value disables the populating
+ */
+static inline void tcmi_shadowtask_set_readahead(struct tcmi_task *self, int readahead)
+{
+	TCMI_SHADOWTASK(self)->readahead = readahead;
+}
+
+/** 
+ * \<\<public\>\> Marks, that children forked by the task from now on
+ * are stubs leased to the guest.
+ *
+ * @param *self - this shadow task instance
+ * @param leasing - set when the stubs are being forked
+ */
+static inline void tcmi_shadowtask_set_leasing(struct tcmi_task *self, int leasing)
+{
+	TCMI_SHADOWTASK(self)->leasing = leasing;
+}
+
+/** 
+ * \<\<public\>\> Checks whether the task is forking stubs leased
+ * to the guest.
+ *
+ * @param *self - this shadow task instance
+ * @return non-zero while the stubs are being forked
+ */
+static inline int tcmi_shadowtask_leasing(struct tcmi_task *self)
+{
+	return TCMI_SHADOWTASK(self)->leasing;
+}
+
+/** 
+ * \<\<public\>\> Marks the task as a stub leased to the guest.
+ * Until a fork on the PEN claims the stub, its parent doesn't get
+ * notified about its exit and the stub stays in a process group of
+ * its own, so that job control signals don't reach it.
+ *
+ * @param *self - this shadow task instance
+ * @param pgrp - process group of the parent
+ */
+static inline void tcmi_shadowtask_set_leased(struct tcmi_task *self, pid_t pgrp)
+{
+	TCMI_SHADOWTASK(self)->leased = 1;
+	TCMI_SHADOWTASK(self)->lease_pgrp = pgrp;
+}
 
 
 /********************** PRIVATE METHODS AND DATA ******************************/
@@ -79,21 +159,51 @@ static int tcmi_shadowtask_process_msg(struct tcmi_task *self, struct tcmi_msg *
 /** Emigrates a task to a PEN. */
 static int tcmi_shadowtask_emigrate_ppm_p(struct tcmi_task *self);
 
+/** Emigrates a task to a PEN - PPM w/ virtual ckpt image. */
+static int tcmi_shadowtask_emigrate_ppm_v(struct tcmi_task *self);
+
 /** Migrates a task back to CCN. */
 static int tcmi_shadowtask_migrateback_ppm_p(struct tcmi_task *self);
 
+/** Migrates a task back to CCN - PPM w/ virtual ckpt image. */
+static int tcmi_shadowtask_migrateback_ppm_v(struct tcmi_task *self);
+
 /** Execve notification when merging shadow with migrating process on CCN. */
 static int tcmi_shadowtask_execve(struct tcmi_task *self);
 
 /** Handles a specified signal. */
 static int tcmi_shadowtask_do_signal(struct tcmi_task *self, unsigned long signr, siginfo_t *info);
 
+/** Forwards the coalesced standard signals to the guest. */
+static void tcmi_shadowtask_signals_done(struct tcmi_task *self);
+
+/** Performs a kill requested by the guest without a response. */
+static void tcmi_shadowtask_kill(struct tcmi_task *self, struct tcmi_kill_procmsg *m);
+
+/** Offers hashes of the process pages to the PEN. */
+static struct tcmi_ckpt_dedup* tcmi_shadowtask_dedup(struct tcmi_task *self);
+
+/** Pushes identity changes to the guest. */
+static void tcmi_shadowtask_check_ident(struct tcmi_task *self);
+
+/** Pushes a snapshot of the children to the guest. */
+static void tcmi_shadowtask_check_children(struct tcmi_task *self);
+
+/** Periodic checks while there are no messages. */
+static void tcmi_shadowtask_idle(struct tcmi_task *self);
+
+/** Claims or releases a stub leased to the guest. */
+static void tcmi_shadowtask_end_lease(struct tcmi_task *self, int claimed);
+
 /** Verifies a successful task migration. */
 static int tcmi_shadowtask_verify_migration(struct tcmi_task *self, struct tcmi_msg *resp);
 
 /** Processes a migrate back request. */
 static int tcmi_shadowtask_process_ppm_p_migr_back_guestreq_procmsg(struct tcmi_task *self, 
 								   struct tcmi_msg *m);
+/** Processes an in-memory migrate back request. */
+static int tcmi_shadowtask_process_ppm_v_migr_back_guestreq_procmsg(struct tcmi_task *self, 
+								   struct tcmi_msg *m);
 /** Custom free method */
 static void tcmi_shadowtask_free(struct tcmi_task* self);
 
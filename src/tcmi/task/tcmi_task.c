@@ -37,6 +37,7 @@ int errno = 0;
 
 #include <linux/hardirq.h>
 #include <linux/syscalls.h>
+#include <linux/math64.h>
 
 
 #define TCMI_TASK_PRIVATE
@@ -122,6 +123,7 @@ int tcmi_task_init(struct tcmi_task *self, pid_t local_pid, struct tcmi_migman*
 	self->sock = kkc_sock_get(sock);
 
 	self->execve_count = 0;
+	self->mig_mode = 0;
 	self->peer_lost = 0;
 
 	self->d_migman_root = d_migman;
@@ -160,9 +162,18 @@ int tcmi_task_init(struct tcmi_task *self, pid_t local_pid, struct tcmi_migman*
 		goto exit3;
 	}
 
+	memset(&self->profile, 0, sizeof(self->profile));
+	if (!(self->f_profile = 
+	      tcmi_ctlfs_intfile_new(self->d_task, TCMI_PERMS_FILE_R,
+				     self, tcmi_task_show_profile, NULL,
+				     sizeof(int) * (1 + 2 * TCMI_CKPT_PHASE_COUNT), "profile"))) {
+		mdbg(ERR3, "Can't create profile file entry for %d", local_pid);
+		goto exit4;
+	}
+
 	if ( migman && tcmi_migman_add_task(migman, self) ) {
 		mdbg(ERR3, "Can't add task to migman tasks struct: lpid %d", local_pid);
-		goto exit4;
+		goto exit5;
 	}
 
 	self->exit_code = 0;
@@ -180,6 +191,8 @@ int tcmi_task_init(struct tcmi_task *self, pid_t local_pid, struct tcmi_migman*
 	return 0;
 
 	/* error handling */
+ exit5:
+	tcmi_ctlfs_entry_put(self->f_profile);
  exit4:
 	tcmi_ctlfs_entry_put(self->f_remote_pid);
  exit3:
@@ -222,6 +235,8 @@ void tcmi_task_put(struct tcmi_task *self)
 		/* destroy all ctlfs entries */
 		tcmi_ctlfs_file_unregister(self->f_remote_pid);
 		tcmi_ctlfs_entry_put(self->f_remote_pid);
+		tcmi_ctlfs_file_unregister(self->f_profile);
+		tcmi_ctlfs_entry_put(self->f_profile);
 		tcmi_ctlfs_entry_put(self->s_migman);
 		tcmi_ctlfs_entry_put(self->d_task);
 		tcmi_ctlfs_entry_put(self->f_remote_pid_rev);
@@ -377,7 +392,9 @@ int tcmi_task_process_methods(struct tcmi_task *self)
  * \<\<public\>\> Called from method queue - Processes one message
  * from the message queue.
  *
- * - Waits for the message to arrive or a signal to wake us up.
+ * - Waits for the message to arrive or a signal to wake us up. Tasks
+ * that provide the idle method run it every TCMI_TASK_IDLE_PERIOD
+ * while waiting.
  * - Upon message arrival, the message is processed (delegated to the
  * task specific method if any) and discarded.  
  * - Eventually, the method resubmits itself into the method queue
@@ -411,7 +428,15 @@ int tcmi_task_process_msg(void *self, struct tcmi_method_wrapper *wr)
 	if ( !wait_for_messages && tcmi_queue_empty(&self_tsk->msg_queue) )
 		return res;
 
-	if ((err = tcmi_queue_wait_on_empty_interruptible(&self_tsk->msg_queue)) < 0) {
+	if (self_tsk->ops->idle) {
+		/* tasks that watch for something while idle wake up periodically */
+		while (!(err = tcmi_queue_wait_on_empty_interruptible_timout(&self_tsk->msg_queue, 
+									      TCMI_TASK_IDLE_PERIOD)))
+			self_tsk->ops->idle(self_tsk);
+	}
+	else
+		err = tcmi_queue_wait_on_empty_interruptible(&self_tsk->msg_queue);
+	if (err < 0) {
 		mdbg(INFO3, "Signal arrived %d", err);
 		goto exit0;
 	}
@@ -859,6 +884,32 @@ static int tcmi_task_show_remote_pid(void *obj, void *data)
 	return 0;
 }
 
+/** 
+ * \<\<private\>\> Read method for the TCMI ctlfs - reports the
+ * profile of the latest checkpoint or restart of the task. The first
+ * value is set for a restart, each phase then follows as a pair of
+ * its duration in microseconds and the number of image bytes it has
+ * processed. See tcmi_ckpt_profile_class for the order of the phases.
+ *
+ * @param *obj - pointer to this task instance
+ * @param *data - pointer where the profile is to be stored.
+ * @return 0 upon success
+ */
+static int tcmi_task_show_profile(void *obj, void *data)
+{
+	struct tcmi_ckpt_profile *profile = tcmi_task_profile(TCMI_TASK(obj));
+	int *values = (int*) data;
+	int i;
+
+	*values++ = profile->restart;
+	for (i = 0; i < TCMI_CKPT_PHASE_COUNT; i++) {
+		*values++ = min_t(u_int64_t, div_u64(profile->time[i], NSEC_PER_USEC), INT_MAX);
+		*values++ = min_t(u_int64_t, profile->bytes[i], INT_MAX);
+	}
+
+	return 0;
+}
+
 
 /** 
  * \<\<private\>\> Releases the execve context (execve file, argv,
@@ -897,13 +948,25 @@ static void tcmi_task_release_execve_context(struct tcmi_task *self)
  * If the message is delivered sucessfully, an enter to the migration mode
  * is requested.
  *
+ * Messages that the task specific intercept method consumes are
+ * handled right away in the context of the caller (the receiving
+ * thread) and never reach the message queue.
+ *
  * @param *self - pointer to this task instance
  * @param *m - message to be delivered.
  * @return 0 when the message has been successfully delivered.
  */
 int tcmi_task_deliver_msg(struct tcmi_task *self, struct tcmi_msg *m)
 {
-	int res = tcmi_msg_deliver(m, &self->msg_queue, self->transactions);
+	int res;
+
+	if (self->ops->intercept_msg && self->ops->intercept_msg(self, m)) {
+		mdbg(INFO4, "Message %x consumed by the receiving thread", tcmi_msg_id(m));
+		tcmi_msg_put(m);
+		return 0;
+	}
+
+	res = tcmi_msg_deliver(m, &self->msg_queue, self->transactions);
 	if ( res ) {
 		minfo(ERR3, "Failed to deliver the message: errno=%d", res);
 
@@ -47,6 +47,7 @@
 #include <tcmi/lib/tcmi_slotvec.h>
 
 #include <tcmi/comm/tcmi_msg.h>
+#include <tcmi/ckpt/tcmi_ckpt_profile.h>
 
 #include <arch/current/make_syscall.h>
 
@@ -171,6 +172,8 @@ struct tcmi_task {
 	struct tcmi_ctlfs_entry *s_migman;
 	/** TCMI ctlfs - contains remote PID. */
 	struct tcmi_ctlfs_entry *f_remote_pid;
+	/** TCMI ctlfs - reports the profile of the last checkpoint/restart. */
+	struct tcmi_ctlfs_entry *f_profile;
 
 	/** */
 	struct tcmi_ctlfs_entry *f_remote_pid_rev;
@@ -187,6 +190,9 @@ struct tcmi_task {
 	/** Pointer to the context of a process when switched into user mode. */
 	void *context;
 
+	/** phases of the latest checkpoint or restart of the task */
+	struct tcmi_ckpt_profile profile;
+
 	/** contains the pathname of the latest checkpoint file */
 	char *ckpt_pathname;
 
@@ -196,6 +202,9 @@ struct tcmi_task {
 	char **envp;
 	/** How many time was execve called on this task, since it became controlled by the tcmi */
 	int execve_count;
+	/** mode of the migration in progress as reported by the
+	 * migration tracepoints, see tcmi_migtrace_mode */
+	int mig_mode;
 
 	/** Data for proxyfs filesystem */
 	void *proxyfs_data;
@@ -219,6 +228,11 @@ struct tcmi_task {
 struct tcmi_task_ops {
 	/** Processes a message that has arrived on the message queue. */
 	int (*process_msg)(struct tcmi_task*, struct tcmi_msg*);
+	/** Handles a message in the context of the receiving thread instead of queueing it,
+	 * returns non-zero if the message has been consumed. */
+	int (*intercept_msg)(struct tcmi_task*, struct tcmi_msg*);
+	/** Called periodically while the task is waiting for messages. */
+	void (*idle)(struct tcmi_task*);
 	/** Emigrates a task to a PEN - PPM w/ physical checkpoint. */
 	int (*emigrate_ppm_p)(struct tcmi_task*);
 	/** Migrates a task back to CCN - PPM w/ physical checkpoint. */
@@ -237,12 +251,17 @@ struct tcmi_task_ops {
 	int (*execve)(struct tcmi_task*);
 	/** Handles a specific signal. */
 	int (*do_signal)(struct tcmi_task *self, unsigned long signr, siginfo_t *info);
+	/** Called once all pending signals have been handled. */
+	void (*signals_done)(struct tcmi_task *self);
 	/** Releases the instance specific resources. */
 	void (*free)(struct tcmi_task*);
 	/** Return type of task */
 	enum tcmi_task_type (*get_type)(void);
 };
 
+/** Period in which the idle method of a task waiting for messages is called */
+#define TCMI_TASK_IDLE_PERIOD HZ
+
 /** Describes the status returned by task methods that are executed
  * from the method queue. See the \link tcmi_task_class task \endlink
  * detailed description for explanation of each individual return
@@ -444,6 +463,30 @@ static int tcmi_task_show_remote_pid_rev(void *obj, void *data)
 	return 0;
 }
 
+/**
+ * \<\<public\>\> Stores the profile of the latest checkpoint or
+ * restart of the task.
+ * 
+ * @param *self - pointer to this task instance
+ * @param *profile - profile to be stored
+ */
+static inline void tcmi_task_set_profile(struct tcmi_task *self, 
+					 struct tcmi_ckpt_profile *profile)
+{
+	self->profile = *profile;
+}
+
+/**
+ * \<\<public\>\> Profile accessor.
+ * 
+ * @param *self - pointer to this task instance
+ * @return profile of the latest checkpoint or restart of the task
+ */
+static inline struct tcmi_ckpt_profile* tcmi_task_profile(struct tcmi_task *self)
+{
+	return &self->profile;
+}
+
 /**
  * \<\<public\>\> Remote PID setter.
  * 
@@ -459,6 +502,29 @@ static inline void tcmi_task_set_remote_pid(struct tcmi_task *self, pid_t remote
 
 }
 
+/**
+ * \<\<public\>\> Sets mode of the migration in progress, that is
+ * reported by the migration tracepoints of the later stages.
+ * 
+ * @param *self - pointer to this task instance
+ * @param mode - one of tcmi_migtrace_mode
+ */
+static inline void tcmi_task_set_mig_mode(struct tcmi_task *self, int mode)
+{
+	self->mig_mode = mode;
+}
+
+/**
+ * \<\<public\>\> Migration mode accessor.
+ * 
+ * @param *self - pointer to this task instance
+ * @return mode of the migration in progress
+ */
+static inline int tcmi_task_mig_mode(struct tcmi_task *self)
+{
+	return self->mig_mode;
+}
+
 /**
  * \<\<public\>\> Accessor of id of the migration manager associated with this task.
  */
@@ -512,6 +578,17 @@ static inline int tcmi_task_picked_up(struct tcmi_task *self)
 	return self->picked_up_flag > 0;
 }
 
+/**
+ * \<\<public\>\> Communication socket accessor.
+ *
+ * @param *self - pointer to this task instance
+ * @return connection of the migration manager the task belongs to
+ */
+static inline struct kkc_sock* tcmi_task_sock(struct tcmi_task *self)
+{
+	return self->sock;
+}
+
 /** 
  * \<\<public\>\> Sends a specified message.  The message is sent as
  * anonymous, so that any potential responses will be delivered to the
@@ -614,6 +691,20 @@ static inline int tcmi_task_do_signal(struct tcmi_task *self, unsigned long sign
 
 }
 
+/**
+ * \<\<public\>\> Called once all pending signals have been
+ * dequeued and handled by tcmi_task_do_signal(). Gives the task a
+ * chance to finish the work it has batched for the signals - the
+ * shadow forwards the coalesced standard signals to the guest here.
+ *
+ * @param *self - pointer to this task instance 
+ */
+static inline void tcmi_task_signals_done(struct tcmi_task *self)
+{
+	if (self->ops->signals_done)
+		self->ops->signals_done(self);
+}
+
 
 /**
  * \<\<public>\> Get task type
@@ -659,6 +750,9 @@ static inline int tcmi_task_check_peer_lost(struct tcmi_task *self, int err) {
 /** Read method for the TCMI ctlfs - reports remote PID. */
 static int tcmi_task_show_remote_pid(void *obj, void *data);
 
+/** Read method for the TCMI ctlfs - reports the checkpoint/restart profile. */
+static int tcmi_task_show_profile(void *obj, void *data);
+
 /** Releases the execve context (execve file, argv, envp). */
 static void tcmi_task_release_execve_context(struct tcmi_task *self);
 
@@ -274,6 +274,8 @@ static inline int tcmi_taskhelper_wait_for_pick_up_timeout(struct tcmi_task *t_t
  * and the task method returns TCMI_TASK_KEEP_PUMPING.
  *
  * The result of the last call of the task method is communicated back.
+ * The task is notified once the pass over the pending signals is
+ * over, so that it can flush the signals it has coalesced.
  *
  * @param *t_task - pointer to this task instance 
  * @return result of the task specific signal handling method or
@@ -304,6 +306,7 @@ static inline int tcmi_taskhelper_do_signals(struct tcmi_task *t_task)
 			if (signr != SIGUNUSED)
 				res = tcmi_task_do_signal(t_task, signr, &info);
 		}
+		tcmi_task_signals_done(t_task);
 	}
 
 	mdbg(INFO2, "Signal handling finished. Result: %d", res);
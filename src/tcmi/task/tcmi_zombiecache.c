@@ -0,0 +1,402 @@
+/**
+ * @file tcmi_zombiecache.c - cache of the exited children of a migrated process
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <linux/sched.h>
+#include <linux/cred.h>
+#include <linux/capability.h>
+#include <linux/wait.h>
+
+#define TCMI_ZOMBIECACHE_PRIVATE
+#include "tcmi_zombiecache.h"
+
+#include <tcmi/syscall/exported_symbols.h>
+
+#include <dbg.h>
+
+/** @addtogroup tcmi_zombiecache_class
+ *
+ * @{
+ */
+
+/**
+ * \<\<public\>\> Stores a new snapshot pushed by the shadow. Events
+ * the shadow hasn't processed yet are applied on top of it and
+ * waiters are woken up.
+ *
+ * @param *self - this cache instance
+ * @param *children - the snapshot
+ */
+void tcmi_zombiecache_update(struct tcmi_zombiecache *self, struct tcmi_children *children)
+{
+	int i, j;
+
+	spin_lock(&self->lock);
+	self->children = *children;
+	for (i = j = 0; i < self->npending; i++) {
+		struct tcmi_zombiecache_event *e = &self->pending[i];
+		/* the shadow has seen the event already */
+		if ((int32_t)(children->seq - e->seq) > 0)
+			continue;
+		tcmi_zombiecache_apply(self, e->event, e->pid);
+		self->pending[j++] = *e;
+	}
+	self->npending = j;
+	self->valid = 1;
+	self->gen++;
+	spin_unlock(&self->lock);
+
+	wake_up_all(&self->wait);
+}
+
+/**
+ * \<\<public\>\> Records a child forked using a leased stub. The
+ * caller has to announce the child to the shadow.
+ *
+ * @param *self - this cache instance
+ * @param pid - PID of the child
+ */
+void tcmi_zombiecache_forked(struct tcmi_zombiecache *self, pid_t pid)
+{
+	spin_lock(&self->lock);
+	tcmi_zombiecache_record(self, TCMI_CHILD_EVENT_FORK, pid);
+	spin_unlock(&self->lock);
+}
+
+/**
+ * \<\<public\>\> Waits for a zombie child the same way wait4()
+ * does. Once the zombie is found, its record is consumed and the
+ * caller has to ask the shadow to reap the child.
+ *
+ * @param *self - this cache instance
+ * @param pid - -1 for any child or PID of the child
+ * @param options - 0 or WNOHANG
+ * @param *status - storage for the exit status
+ * @return PID of the zombie, 0 if there is no zombie and WNOHANG has
+ * been specified, -ECHILD, -ERESTARTSYS or -EAGAIN if the cache
+ * can't tell and the RPC has to be used
+ */
+long tcmi_zombiecache_wait(struct tcmi_zombiecache *self, pid_t pid, int options, int *status)
+{
+	struct tcmi_children *c = &self->children;
+	u_int32_t gen;
+	long res;
+	int i;
+
+	for (;;) {
+		spin_lock(&self->lock);
+		if (!tcmi_zombiecache_usable(self)) {
+			res = -EAGAIN;
+			goto exit0;
+		}
+		for (i = 0; i < c->nzombies; i++) {
+			if (pid == -1 || c->zombies[i].pid == pid)
+				break;
+		}
+		if (i < c->nzombies) {
+			res = c->zombies[i].pid;
+			*status = c->zombies[i].status;
+			tcmi_zombiecache_record(self, TCMI_CHILD_EVENT_REAP, res);
+			goto exit0;
+		}
+		for (i = 0; i < c->nchildren; i++) {
+			if (pid == -1 || c->children[i] == pid)
+				break;
+		}
+		if (i == c->nchildren) {
+			res = -ECHILD;
+			goto exit0;
+		}
+		/* the child might be a zombie that didn't fit in the snapshot */
+		if (c->flags & TCMI_CHILDREN_MORE_ZOMBIES) {
+			res = -EAGAIN;
+			goto exit0;
+		}
+		if (options & WNOHANG) {
+			res = 0;
+			goto exit0;
+		}
+		gen = self->gen;
+		spin_unlock(&self->lock);
+
+		if (wait_event_interruptible(self->wait, tcmi_zombiecache_updated(self, gen)))
+			return -ERESTARTSYS;
+	}
+
+ exit0:
+	spin_unlock(&self->lock);
+	return res;
+}
+
+/**
+ * \<\<public\>\> Checks whether a process is a child listed by
+ * the cached snapshot that the shadow may signal. A listed child
+ * exists on the CCN - either running or as a zombie the shadow hasn't
+ * been asked to reap yet. The permission is the one kill() checks,
+ * evaluated by the shadow with the credentials of both processes when
+ * the snapshot has been taken.
+ *
+ * @param *self - this cache instance
+ * @param pid - PID of the process
+ * @return non-zero if the process is a known child the shadow may
+ * signal, 0 if it is not or the cache can't tell
+ */
+int tcmi_zombiecache_may_kill(struct tcmi_zombiecache *self, pid_t pid)
+{
+	struct tcmi_children *c = &self->children;
+	int i, res = 0;
+
+	spin_lock(&self->lock);
+	if (tcmi_zombiecache_usable(self)) {
+		for (i = 0; i < c->nchildren && c->children[i] != pid; i++);
+		res = i < c->nchildren && (c->killable & (1ULL << i));
+	}
+	spin_unlock(&self->lock);
+
+	return res;
+}
+
+/**
+ * \<\<public\>\> Processes a child event sent by the guest. A child
+ * whose record has been consumed by the guest is reaped, an
+ * announced stub is listed among the children until it is claimed.
+ *
+ * @param *self - this watch instance
+ * @param event - TCMI_CHILD_EVENT_REAP or TCMI_CHILD_EVENT_FORK
+ * @param pid - PID of the child
+ */
+void tcmi_zombiecache_watch_event(struct tcmi_zombiecache_watch *self, u_int32_t event, pid_t pid)
+{
+	int i;
+
+	self->seq++;
+	if (event == TCMI_CHILD_EVENT_REAP) {
+		mdbg(INFO3, "Reaping child %d consumed by the guest", pid);
+		sys_wait4(pid, NULL, WNOHANG, NULL);
+		return;
+	}
+
+	for (i = 0; i < self->nannounced; i++) {
+		if (self->announced[i] == pid)
+			return;
+	}
+	if (self->nannounced == TCMI_ZOMBIECACHE_ANNOUNCED) {
+		mdbg(ERR3, "Too many announced children, the guest will wait via RPC");
+		self->lost = 1;
+		return;
+	}
+	self->announced[self->nannounced++] = pid;
+}
+
+/**
+ * \<\<public\>\> Takes a snapshot of the children of the current
+ * process - the shadow. Children a plain wait4() can't reap (threads,
+ * unclaimed stubs, children with a different exit signal) are not
+ * listed unless they have been announced by the guest. The exit
+ * status is computed the same way wait4() does.
+ *
+ * @param *self - this watch instance
+ * @return the snapshot to be pushed to the guest or NULL if nothing
+ * has changed since the last one
+ */
+struct tcmi_children* tcmi_zombiecache_watch_check(struct tcmi_zombiecache_watch *self)
+{
+	struct tcmi_children *next = &self->next;
+	struct tcmi_children_zombie *z;
+	struct task_struct *p;
+	u_int32_t announced = 0;
+	int cap_kill = has_capability_noaudit(current, CAP_KILL);
+	pid_t pid;
+	int i, j;
+
+	memset(next, 0, sizeof(*next));
+	next->seq = self->seq;
+	if (self->lost)
+		next->flags |= TCMI_CHILDREN_OVERFLOW;
+
+	read_lock(&tasklist_lock);
+	rcu_read_lock();
+	list_for_each_entry(p, &current->children, sibling) {
+		pid = task_pid_vnr(p);
+		for (i = 0; i < self->nannounced && self->announced[i] != pid; i++);
+		if (p->exit_signal != SIGCHLD) {
+			if (i == self->nannounced)
+				continue;
+			/* stub forked by the guest that hasn't been claimed yet */
+			announced |= 1U << i;
+		}
+		if (p->ptrace || next->nchildren == TCMI_CHILDREN_MAX) {
+			next->flags |= TCMI_CHILDREN_OVERFLOW;
+			continue;
+		}
+		if (tcmi_zombiecache_kill_ok(p, cap_kill))
+			next->killable |= 1ULL << next->nchildren;
+		next->children[next->nchildren++] = pid;
+
+		if (p->exit_signal != SIGCHLD || p->exit_state != EXIT_ZOMBIE || delay_group_leader(p))
+			continue;
+		if (next->nzombies == TCMI_CHILDREN_ZOMBIES) {
+			next->flags |= TCMI_CHILDREN_MORE_ZOMBIES;
+			continue;
+		}
+		z = &next->zombies[next->nzombies++];
+		z->pid = pid;
+		z->status = (p->signal->flags & SIGNAL_GROUP_EXIT) ? 
+			p->signal->group_exit_code : p->exit_code;
+	}
+	rcu_read_unlock();
+	read_unlock(&tasklist_lock);
+
+	/* claimed stubs are listed as regular children from now on */
+	for (i = j = 0; i < self->nannounced; i++) {
+		if (announced & (1U << i))
+			self->announced[j++] = self->announced[i];
+	}
+	self->nannounced = j;
+
+	if (self->pushed && !memcmp(next, &self->last, sizeof(*next)))
+		return NULL;
+	self->last = *next;
+	self->pushed = 1;
+	return &self->last;
+}
+
+/**
+ * \<\<private\>\> Checks whether the cache can be used. It can't be
+ * used before the first snapshot, when the snapshot is not complete
+ * or when some events couldn't have been kept and the shadow hasn't
+ * seen them yet.
+ *
+ * @param *self - this cache instance
+ * @return non-zero if the cache can be used
+ */
+static int tcmi_zombiecache_usable(struct tcmi_zombiecache *self)
+{
+	return self->valid && !self->disabled && !(self->children.flags & TCMI_CHILDREN_OVERFLOW) &&
+		(int32_t)(self->children.seq - self->resync) >= 0;
+}
+
+/**
+ * \<\<private\>\> Applies a child event to the cached snapshot.
+ *
+ * @param *self - this cache instance
+ * @param event - TCMI_CHILD_EVENT_REAP or TCMI_CHILD_EVENT_FORK
+ * @param pid - PID of the child
+ */
+static void tcmi_zombiecache_apply(struct tcmi_zombiecache *self, u_int32_t event, pid_t pid)
+{
+	struct tcmi_children *c = &self->children;
+	int i;
+
+	for (i = 0; i < c->nchildren && c->children[i] != pid; i++);
+	if (event == TCMI_CHILD_EVENT_FORK) {
+		if (i < c->nchildren)
+			return;
+		if (c->nchildren == TCMI_CHILDREN_MAX)
+			c->flags |= TCMI_CHILDREN_OVERFLOW;
+		else
+			c->children[c->nchildren++] = pid;
+		return;
+	}
+
+	if (i < c->nchildren) {
+		c->children[i] = c->children[--c->nchildren];
+		/* the permission moves along with the last child */
+		c->killable &= ~(1ULL << i);
+		c->killable |= ((c->killable >> c->nchildren) & 1) << i;
+		c->killable &= ~(1ULL << c->nchildren);
+	}
+	for (i = 0; i < c->nzombies; i++) {
+		if (c->zombies[i].pid == pid) {
+			c->zombies[i] = c->zombies[--c->nzombies];
+			break;
+		}
+	}
+}
+
+/**
+ * \<\<private\>\> Records a child event to be sent to the shadow and
+ * applies it to the cached snapshot. An event that doesn't fit in
+ * makes the cache unusable until the shadow has seen it.
+ *
+ * @param *self - this cache instance
+ * @param event - TCMI_CHILD_EVENT_REAP or TCMI_CHILD_EVENT_FORK
+ * @param pid - PID of the child
+ */
+static void tcmi_zombiecache_record(struct tcmi_zombiecache *self, u_int32_t event, pid_t pid)
+{
+	struct tcmi_zombiecache_event *e;
+	u_int32_t seq = self->events++;
+
+	tcmi_zombiecache_apply(self, event, pid);
+	if (self->npending == TCMI_ZOMBIECACHE_PENDING) {
+		self->resync = self->events;
+		return;
+	}
+	e = &self->pending[self->npending++];
+	e->seq = seq;
+	e->event = event;
+	e->pid = pid;
+}
+
+/**
+ * \<\<private\>\> Checks whether a new snapshot has arrived.
+ *
+ * @param *self - this cache instance
+ * @param gen - generation seen by the waiter
+ * @return non-zero if there is a new snapshot
+ */
+static int tcmi_zombiecache_updated(struct tcmi_zombiecache *self, u_int32_t gen)
+{
+	return ACCESS_ONCE(self->gen) != gen;
+}
+
+/**
+ * \<\<private\>\> Checks whether the current process - the shadow -
+ * may signal a child. Mirrors the check of kill(): the real or
+ * effective UID of the sender has to match the real or saved UID of
+ * the target unless the sender has CAP_KILL. Called with the RCU read
+ * lock held.
+ *
+ * @param *p - the child
+ * @param cap_kill - non-zero if the shadow has CAP_KILL
+ * @return non-zero if the child may be signaled
+ */
+static int tcmi_zombiecache_kill_ok(struct task_struct *p, int cap_kill)
+{
+	const struct cred *cred = current_cred(), *tcred = __task_cred(p);
+
+	if (cap_kill)
+		return 1;
+	return cred->euid == tcred->suid || cred->euid == tcred->uid ||
+		cred->uid == tcred->suid || cred->uid == tcred->uid;
+}
+
+/**
+ * @}
+ */
+
@@ -0,0 +1,220 @@
+/**
+ * @file tcmi_zombiecache.h - cache of the exited children of a migrated process
+ *       
+ *                      
+ * 
+ *
+ *
+ * Date: 10/18/2026
+ *
+ * $Id$
+ *
+ * This file is part of Task Checkpointing and Migration Infrastructure(TCMI)
+ * Copyleft (C) 2005  Jan Capek
+ * 
+ * TCMI is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * TCMI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _TCMI_ZOMBIECACHE_H
+#define _TCMI_ZOMBIECACHE_H
+
+#include <linux/types.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+
+#include <tcmi/comm/tcmi_children_procmsg.h>
+#include <tcmi/comm/tcmi_child_event_procmsg.h>
+
+/** @defgroup tcmi_zombiecache_class tcmi_zombiecache class 
+ *
+ * @ingroup tcmi_task_class
+ *
+ * Children of a migrated process are children of its shadow on the
+ * CCN and wait4() used to be a blocking RPC. The shadow was stuck in
+ * the wait with the transaction open and every reaped child cost a
+ * round trip.
+ *
+ * The shadow now watches its children and pushes a \link
+ * tcmi_children_procmsg_class snapshot \endlink of them to the guest
+ * whenever they change - after each RPC it has served, on SIGCHLD and
+ * periodically while it is idle. The snapshot lists the children
+ * a plain wait4() could reap and the exit status of those that are
+ * zombies. The guest keeps the last snapshot in this cache and
+ * serves wait4() from it; the zombie is then reaped by the shadow
+ * asynchronously, the guest sends a \link
+ * tcmi_child_event_procmsg_class child event \endlink and doesn't
+ * wait for any reply.
+ *
+ * Children forked by the guest using a leased stub are not visible as
+ * children to a plain wait4() on the CCN until the stub is claimed,
+ * so the guest announces them to the shadow by a child event too.
+ *
+ * Child events and snapshots cross each other on the wire. The
+ * shadow counts the events it has processed and stamps each snapshot
+ * with the count. The guest keeps the events the snapshot hasn't seen
+ * yet and applies them on top of it again.
+ *
+ * Only wait4() for any child or a specific child, without rusage and
+ * with no options besides WNOHANG is served from the cache. Anything
+ * else and any incomplete snapshot make the guest fall back to the
+ * RPC.
+ *
+ * @{
+ */
+
+/** Maximum number of child events not seen by the shadow yet */
+#define TCMI_ZOMBIECACHE_PENDING 16
+
+/** Maximum number of announced stubs the shadow keeps track of */
+#define TCMI_ZOMBIECACHE_ANNOUNCED 32
+
+/** Child event sent to the shadow */
+struct tcmi_zombiecache_event {
+	/** sequence number of the event */
+	u_int32_t seq;
+	/** TCMI_CHILD_EVENT_REAP or TCMI_CHILD_EVENT_FORK */
+	u_int32_t event;
+	/** PID of the child */
+	pid_t pid;
+};
+
+/** Guest side of the cache. */
+struct tcmi_zombiecache {
+	/** protects the cache against concurrent snapshot updates */
+	spinlock_t lock;
+	/** waiters for a new snapshot */
+	wait_queue_head_t wait;
+	/** bumped by each snapshot */
+	u_int32_t gen;
+	/** a snapshot has been received */
+	int valid;
+	/** a child event couldn't have been sent, the cache is not used anymore */
+	int disabled;
+	/** number of child events sent */
+	u_int32_t events;
+	/** the cache can't be used until the shadow has seen this many events */
+	u_int32_t resync;
+	/** last snapshot with the pending events applied */
+	struct tcmi_children children;
+	/** number of the events not seen by the shadow */
+	int npending;
+	/** events not seen by the shadow */
+	struct tcmi_zombiecache_event pending[TCMI_ZOMBIECACHE_PENDING];
+};
+
+/** Shadow side of the cache. */
+struct tcmi_zombiecache_watch {
+	/** number of child events processed */
+	u_int32_t seq;
+	/** a snapshot has been pushed */
+	int pushed;
+	/** an announced stub didn't fit in, snapshots can't be complete */
+	int lost;
+	/** number of announced stubs */
+	int nannounced;
+	/** stubs announced by the guest and not claimed yet */
+	pid_t announced[TCMI_ZOMBIECACHE_ANNOUNCED];
+	/** last snapshot pushed */
+	struct tcmi_children last;
+	/** snapshot being built */
+	struct tcmi_children next;
+};
+
+/**
+ * \<\<public\>\> Initializes an empty cache. The cache can't be used
+ * until the first snapshot arrives.
+ *
+ * @param *self - this cache instance
+ */
+static inline void tcmi_zombiecache_init(struct tcmi_zombiecache *self)
+{
+	spin_lock_init(&self->lock);
+	init_waitqueue_head(&self->wait);
+	self->gen = 0;
+	self->valid = 0;
+	self->disabled = 0;
+	self->events = 0;
+	self->resync = 0;
+	self->npending = 0;
+}
+
+/**
+ * \<\<public\>\> Initializes the shadow side.
+ *
+ * @param *self - this watch instance
+ */
+static inline void tcmi_zombiecache_watch_init(struct tcmi_zombiecache_watch *self)
+{
+	self->seq = 0;
+	self->pushed = 0;
+	self->lost = 0;
+	self->nannounced = 0;
+}
+
+/**
+ * \<\<public\>\> Stops using the cache. Used when a child event
+ * couldn't have been sent, the shadow would never see it.
+ *
+ * @param *self - this cache instance
+ */
+static inline void tcmi_zombiecache_disable(struct tcmi_zombiecache *self)
+{
+	spin_lock(&self->lock);
+	self->disabled = 1;
+	spin_unlock(&self->lock);
+}
+
+/** \<\<public\>\> Stores a new snapshot pushed by the shadow. */
+extern void tcmi_zombiecache_update(struct tcmi_zombiecache *self, struct tcmi_children *children);
+
+/** \<\<public\>\> Records a child forked using a leased stub. */
+extern void tcmi_zombiecache_forked(struct tcmi_zombiecache *self, pid_t pid);
+
+/** \<\<public\>\> Waits for a zombie child. */
+extern long tcmi_zombiecache_wait(struct tcmi_zombiecache *self, pid_t pid, int options, int *status);
+
+/** \<\<public\>\> Checks whether a known child may be signaled. */
+extern int tcmi_zombiecache_may_kill(struct tcmi_zombiecache *self, pid_t pid);
+
+/** \<\<public\>\> Processes a child event sent by the guest. */
+extern void tcmi_zombiecache_watch_event(struct tcmi_zombiecache_watch *self, u_int32_t event, pid_t pid);
+
+/** \<\<public\>\> Takes a snapshot of the children of the current process. */
+extern struct tcmi_children* tcmi_zombiecache_watch_check(struct tcmi_zombiecache_watch *self);
+
+/********************** PRIVATE METHODS AND DATA ******************************/
+#ifdef TCMI_ZOMBIECACHE_PRIVATE
+
+/** Checks whether the cache can be used. */
+static int tcmi_zombiecache_usable(struct tcmi_zombiecache *self);
+
+/** Applies a child event to the cached snapshot. */
+static void tcmi_zombiecache_apply(struct tcmi_zombiecache *self, u_int32_t event, pid_t pid);
+
+/** Records a child event to be sent to the shadow. */
+static void tcmi_zombiecache_record(struct tcmi_zombiecache *self, u_int32_t event, pid_t pid);
+
+/** Checks whether a new snapshot has arrived. */
+static int tcmi_zombiecache_updated(struct tcmi_zombiecache *self, u_int32_t gen);
+
+/** Checks whether the current process may signal a child. */
+static int tcmi_zombiecache_kill_ok(struct task_struct *p, int cap_kill);
+
+#endif /* TCMI_ZOMBIECACHE_PRIVATE */
+
+/**
+ * @}
+ */
+
+#endif /* _TCMI_ZOMBIECACHE_H */
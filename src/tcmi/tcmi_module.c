@@ -41,6 +41,7 @@
 
 #include <tcmi/syscall/tcmi_syscallhooks.h>
 #include <tcmi/migration/tcmi_mighooks.h>
+#include <tcmi/migration/fs/fs_mounter_register.h>
 
 #include <director/director.h>
 
@@ -106,6 +107,18 @@ static void tcmi_register_director_user_message_handler(void) {
 	director_register_send_generic_user_message_handler(tcmi_send_generic_user_message_handler);
 }
 
+static int tcmi_migrate_batch_handler(int is_core_slot, int count, struct director_migration* migrations) {
+	if ( is_core_slot ) {
+		return tcmi_man_migrate_batch(TCMI_MAN(tcmi_ccnman_get_instance()), count, migrations);
+	} else {
+		return tcmi_man_migrate_batch(TCMI_MAN(tcmi_penman_get_instance()), count, migrations);
+	}
+}
+
+static void tcmi_register_director_migrate_batch_handler(void) {
+	director_register_migrate_batch_handler(tcmi_migrate_batch_handler);
+}
+
 
 /**
  * Module initialization.
@@ -130,6 +143,7 @@ static int __init tcmi_module_init(void)
 	tcmi_mighooks_init();
 	tcmi_syscall_hooks_init();
 	tcmi_register_director_user_message_handler();
+	tcmi_register_director_migrate_batch_handler();
 
 	if (tcmi_ccnman_init(root) < 0) {
 		minfo(ERR1, "Failed initializing TCMI CCN manager");
@@ -170,12 +184,15 @@ static void __exit tcmi_module_exit(void)
 
 	minfo(INFO1, "Unloading TCMI framework");
 
+	director_register_migrate_batch_handler(NULL);
+
 	/* Managers must be shutdown first, because they may need other parts of infrastructure to proceed with migration back */
 	tcmi_penman_shutdown();
 	tcmi_ccnman_shutdown();
 	
 	tcmi_mighooks_exit();
 	tcmi_syscall_hooks_exit();
+	destroy_mounters();
 
 	tcmi_ctlfs_file_unregister(debug_file);
 	tcmi_ctlfs_entry_put(debug_file);
@@ -4,6 +4,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <stdint.h>
 
 enum npm_msg_response {
 	DO_NOT_MIGRATE, 
@@ -15,9 +16,39 @@ enum npm_msg_response {
 	REQUIRE_ARGS_AND_ENVP,	
 };
 
+/** Policies of the kernel side npm decision cache, see npm_cache_set */
+enum npm_cache_policy {
+	NPM_CACHE_ASK, /* Ask director on each exec, i.e. remove any cached decision */
+	NPM_CACHE_LOCAL, /* Do not migrate, without asking director */
+};
+
+/** Modes of migrations requested by migrate_batch */
+enum director_migration_mode {
+	DIRECTOR_MIGRATION_EMIGRATE_PPM_P, /* Preemptive emigration to a node */
+	DIRECTOR_MIGRATION_HOME_PPM_P, /* Preemptive migration home */
+	DIRECTOR_MIGRATION_HOME_PPM_V, /* Preemptive migration home with an in-memory image */
+};
+
+/** Max number of migrations the kernel accepts in a single batch */
+#define DIRECTOR_MIGRATION_BATCH_MAX 256
+
+/** Single migration of a batch, the layout is shared with the kernel */
+struct director_migration {
+	int32_t pid;
+	int32_t slot_index; /* Slot index of the target node, ignored when migrating home */
+	int32_t mode; /* Element of "director_migration_mode" enum */
+	int32_t reserved; /* Must be 0 */
+};
+
 
 typedef void (*npm_check_callback_t)(pid_t pid, uid_t uid, int is_guest, const char* name, struct rusage *rusage, int* decision, int* decision_value);
 
+/**
+ * Full npm check, args and envp are NULL terminated arrays. When the check is dispatched because of a hint
+ * (see npm_hint_set), argv positions are kept: args that are not selected and precede a selected one are
+ * passed as empty strings, args past the last selected one are omitted. Only selected envs are passed.
+ * If the selected strings do not fit into a single request, npm_check callback is called instead.
+ */
 typedef void (*npm_check_full_callback_t)(pid_t pid, uid_t uid, int is_guest, const char* name, char** args, char** envp, int* decision, int* decision_value);
 
 typedef void (*immigration_request_callback_t)(uid_t uid, int slot_index, const char* exec_name, int* accept);
@@ -36,6 +67,8 @@ typedef void (*migrated_home_callback_t)(pid_t pid);
 
 typedef void (*emigration_failed_callback_t)(pid_t pid);
 
+typedef void (*task_migrated_callback_t)(pid_t pid, int restart, int phase_count, uint64_t* durations, uint64_t* bytes);
+
 typedef void (*generic_user_message_callback_t)(int node_id, int slot_type, int slot_index, int user_data_size, char* user_data);
 
 #endif
@@ -23,6 +23,7 @@
 #include "task-forked.h"
 #include "migrated-home.h"
 #include "emigration-failed.h"
+#include "task-migrated.h"
 #include "generic_user_message.h"
 
 
@@ -45,6 +46,7 @@ static uint8_t ans_mapping[DIRECTOR_MSG_MAX] = {
 	[DIRECTOR_TASK_FORK] = DIRECTOR_ACK,
 	[DIRECTOR_MIGRATED_HOME] = DIRECTOR_ACK,
 	[DIRECTOR_EMIGRATION_FAILED] = DIRECTOR_ACK,
+	[DIRECTOR_TASK_MIGRATED] = DIRECTOR_ACK,
 	[DIRECTOR_GENERIC_USER_MESSAGE] = DIRECTOR_ACK,
 };
 
@@ -340,6 +342,185 @@ done:
 	return ret_val;
 }
 
+/** Installs a kernel side npm decision cache policy for a binary. */
+int npm_cache_set(const char* name, uid_t uid, int is_guest, int policy, unsigned int ttl) {
+	struct nl_msg* msg = NULL;
+	struct nl_msg *ans_msg = NULL;
+
+	int ret_val = 0;
+
+	if ( (ret_val=prepare_request_message(state.handle, DIRECTOR_NPM_CACHE_SET, state.gnl_fid, &msg) ) != 0 ) {
+		goto done;
+  	}
+
+	ret_val = nla_put_string(msg, DIRECTOR_A_NAME, name);
+	if (ret_val != 0)
+    		goto done;
+
+  	ret_val = nla_put_u32(msg,
+			   DIRECTOR_A_UID,
+			   uid);
+	if (ret_val != 0)
+    		goto done;
+
+  	ret_val = nla_put_u32(msg,
+			   DIRECTOR_A_TASK_TYPE,
+			   is_guest ? 1 : 0);
+	if (ret_val != 0)
+    		goto done;
+
+  	ret_val = nla_put_u32(msg,
+			   DIRECTOR_A_CACHE_POLICY,
+			   policy);
+	if (ret_val != 0)
+    		goto done;
+
+  	ret_val = nla_put_u32(msg,
+			   DIRECTOR_A_TTL,
+			   ttl);
+	if (ret_val != 0)
+    		goto done;
+
+  	if ( (ret_val = send_request_message(state.handle, msg, 1) ) != 0 )
+    		goto done;
+
+	if ( (ret_val = read_message(state.handle, &ans_msg) ) != 0 ) {
+	      goto done;
+	}
+
+	while ( !is_ack_message(ans_msg) ) {
+	    // We can get different than ack messega here.. in this case we have to process it
+	    handle_incoming_message(ans_msg);
+	    
+	    if ( (ret_val = read_message(state.handle, &ans_msg) ) != 0 ) {
+		  goto done;
+	    }	  
+	}
+
+done:
+	nlmsg_free(ans_msg);
+	return ret_val;
+}
+
+/** Sends a single chunk of a migration batch, count must not exceed DIRECTOR_MIGRATION_BATCH_MAX */
+static int migrate_batch_chunk(int slot_type, struct director_migration* migrations, int count) {
+	struct nl_msg* msg = NULL;
+	struct nl_msg *ans_msg = NULL;
+
+	int ret_val = 0;
+
+	if ( (ret_val=prepare_request_message(state.handle, DIRECTOR_MIGRATE_BATCH, state.gnl_fid, &msg) ) != 0 ) {
+		goto done;
+  	}
+
+  	ret_val = nla_put_u32(msg,
+			   DIRECTOR_A_SLOT_TYPE,
+			   slot_type);
+	if (ret_val != 0)
+    		goto done;
+
+	ret_val = nla_put(msg, DIRECTOR_A_MIGRATIONS, count * sizeof(struct director_migration), migrations);
+	if (ret_val != 0)
+    		goto done;
+
+  	if ( (ret_val = send_request_message(state.handle, msg, 1) ) != 0 )
+    		goto done;
+
+	if ( (ret_val = read_message(state.handle, &ans_msg) ) != 0 ) {
+	      goto done;
+	}
+
+	while ( !is_ack_message(ans_msg) ) {
+	    // We can get different than ack messega here.. in this case we have to process it
+	    handle_incoming_message(ans_msg);
+	    
+	    if ( (ret_val = read_message(state.handle, &ans_msg) ) != 0 ) {
+		  goto done;
+	    }	  
+	}
+
+done:
+	nlmsg_free(ans_msg);
+	return ret_val;
+}
+
+/** Starts a batch of preemptive migrations, see director-api.h */
+int migrate_batch(int slot_type, struct director_migration* migrations, int count) {
+	int ret_val = 0;
+
+	while ( count > 0 ) {
+		int chunk = count > DIRECTOR_MIGRATION_BATCH_MAX ? DIRECTOR_MIGRATION_BATCH_MAX : count;
+
+		if ( (ret_val = migrate_batch_chunk(slot_type, migrations, chunk)) != 0 )
+			return ret_val;
+
+		migrations += chunk;
+		count -= chunk;
+	}
+
+	return ret_val;
+}
+
+/** Registers args and envs needed for npm decisions about a binary. */
+int npm_hint_set(const char* suffix, unsigned int arg_mask, char** env_keys) {
+	struct nl_msg* msg = NULL;
+	struct nl_msg *ans_msg = NULL;
+	struct nlattr *nest;
+	int i;
+
+	int ret_val = 0;
+
+	if ( (ret_val=prepare_request_message(state.handle, DIRECTOR_NPM_HINT_SET, state.gnl_fid, &msg) ) != 0 ) {
+		goto done;
+  	}
+
+	ret_val = nla_put_string(msg, DIRECTOR_A_NAME, suffix);
+	if (ret_val != 0)
+    		goto done;
+
+  	ret_val = nla_put_u32(msg,
+			   DIRECTOR_A_ARG_MASK,
+			   arg_mask);
+	if (ret_val != 0)
+    		goto done;
+
+	if ( env_keys ) {
+		nest = nla_nest_start(msg, DIRECTOR_A_ENVS);
+		if ( !nest ) {
+			ret_val = -EMSGSIZE;
+			goto done;
+		}
+
+		for ( i = 0; env_keys[i]; i++ ) {
+			ret_val = nla_put_string(msg, DIRECTOR_A_ENV, env_keys[i]);
+			if (ret_val != 0)
+				goto done;
+		}
+
+		nla_nest_end(msg, nest);
+	}
+
+  	if ( (ret_val = send_request_message(state.handle, msg, 1) ) != 0 )
+    		goto done;
+
+	if ( (ret_val = read_message(state.handle, &ans_msg) ) != 0 ) {
+	      goto done;
+	}
+
+	while ( !is_ack_message(ans_msg) ) {
+	    // We can get different than ack messega here.. in this case we have to process it
+	    handle_incoming_message(ans_msg);
+	    
+	    if ( (ret_val = read_message(state.handle, &ans_msg) ) != 0 ) {
+		  goto done;
+	    }	  
+	}
+
+done:
+	nlmsg_free(ans_msg);
+	return ret_val;
+}
+
 int initialize_director_api(void) {
 	printf("Initializing director\n");
 
@@ -362,6 +543,7 @@ int initialize_director_api(void) {
 	handlers[DIRECTOR_TASK_FORK] = handle_task_forked;
 	handlers[DIRECTOR_MIGRATED_HOME] = handle_migrated_home;
 	handlers[DIRECTOR_EMIGRATION_FAILED] = handle_emigration_failed;
+	handlers[DIRECTOR_TASK_MIGRATED] = handle_task_migrated;
 	handlers[DIRECTOR_GENERIC_USER_MESSAGE] = handle_generic_user_message;
 
 	printf("Comm channel initialized\n");
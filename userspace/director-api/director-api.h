@@ -41,9 +41,47 @@ void register_node_disconnected_callback(node_disconnected_callback_t callback);
 void register_immigration_request_callback(immigration_request_callback_t callback);
 /** Registers callback handler for task exit message */
 void register_task_exitted_callback(task_exitted_callback_t callback);
+/** Registers callback handler for task migrated message */
+void register_task_migrated_callback(task_migrated_callback_t callback);
 /** Registers callback handler for generic user message */
 void register_generic_user_message_callback(generic_user_message_callback_t callback);
 /** Sends a user message to remote node via associated kernel connection. */
 int send_user_message(int target_slot_type, int target_slot_index, int data_length, char* data);
+/**
+ * Installs a kernel side npm decision cache policy for a binary, so that its execs need not be checked with director.
+ *
+ * @param name Absolute path to the binary
+ * @param uid Effective user ID the policy applies to
+ * @param is_guest 1 if the policy applies to guest processes, 0 if to local processes
+ * @param policy Element of "npm_cache_policy" enum
+ * @param ttl Number of seconds the policy is valid for, 0 if it is valid until replaced. The kernel clamps it to a week
+ * @return 0 on success
+ */
+int npm_cache_set(const char* name, uid_t uid, int is_guest, int policy, unsigned int ttl);
+/**
+ * Registers args and envs that are needed for npm decisions about a binary. The first npm check of such a binary
+ * then already contains them and it is dispatched to the npm_check_full callback, with the args that are not selected
+ * replaced by empty strings and only the selected envs present. When the selected strings do not fit into a single
+ * request, the check is sent without them and dispatched to the npm_check callback.
+ *
+ * @param suffix Suffix of the path of binaries the hint applies to, the longest matching suffix wins
+ * @param arg_mask Bit i set if argv[i] is needed, 0xffffffff for all args
+ * @param env_keys NULL terminated array of keys of needed environment variables, or NULL
+ * @return 0 on success
+ */
+int npm_hint_set(const char* suffix, unsigned int arg_mask, char** env_keys);
+/** Digest of args and envs that were not passed to the npm_check_full callback being run because of a hint */
+unsigned int npm_check_digest(void);
+/**
+ * Starts a batch of preemptive migrations. The kernel executes them concurrently and does not wait for them,
+ * failed emigrations are reported via emigration failed callback. Batches larger than DIRECTOR_MIGRATION_BATCH_MAX
+ * are split.
+ *
+ * @param slot_type 1 if the core node manager shall migrate the tasks, 0 for the detached node manager
+ * @param migrations Migrations to be performed
+ * @param count Number of migrations
+ * @return 0 on success
+ */
+int migrate_batch(int slot_type, struct director_migration* migrations, int count);
 
 #endif
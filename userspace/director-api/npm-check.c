@@ -10,6 +10,15 @@ static npm_check_callback_t npm_callback = NULL;
 
 static npm_check_full_callback_t npm_full_callback = NULL;
 
+/** Digest of args and envs not passed in the npm check being handled */
+static unsigned int npm_digest = 0;
+
+unsigned int npm_check_digest(void) {
+	return npm_digest;
+}
+
+static char** parse_chars(struct nl_msg *req_msg, int type, int nested_type);
+
 void register_npm_check_callback(npm_check_callback_t callback) {
 	npm_callback = callback;
 }
@@ -31,6 +40,7 @@ int handle_npm_check(struct nl_msg *req_msg) {
 	pid_t pid;
 	uid_t uid;
 	struct rusage *rusage;
+	char** args = NULL, **envp = NULL;
 	// Out params
 	int decision = DO_NOT_MIGRATE;
 	int decision_value = -1;
@@ -70,8 +80,18 @@ int handle_npm_check(struct nl_msg *req_msg) {
 		rusage = nla_data(nla);
 	}
 
+	// A hint registered for the binary makes kernel pass selected args and envs right away
+	nla = nlmsg_find_attr(nlmsg_hdr(req_msg), sizeof(struct genlmsghdr), DIRECTOR_A_DIGEST);
+	if ( nla != NULL && npm_full_callback ) {
+		npm_digest = nla_get_u32(nla);
+		args = parse_chars(req_msg, DIRECTOR_A_ARGS, DIRECTOR_A_ARG);
+		envp = parse_chars(req_msg, DIRECTOR_A_ENVS, DIRECTOR_A_ENV);
+	}
+
 	//printf("NPM CALLED FOR NAME: %s\n", name);
-	if ( npm_callback )
+	if ( args && envp )
+		npm_full_callback(pid, uid, is_guest, name, args, envp, &decision, &decision_value);
+	else if ( npm_callback )
         	npm_callback(pid, uid, is_guest, name, rusage, &decision, &decision_value);
 
 	
@@ -99,6 +119,8 @@ int handle_npm_check(struct nl_msg *req_msg) {
 error_del_resp:
 	nlmsg_free(msg);
 done:	
+	free(args);
+	free(envp);
 	return ret;
 }
 
@@ -0,0 +1,74 @@
+#include "task-migrated.h"
+#include "director-api.h"
+#include "msg-common.h"
+#include "msgs.h"
+#include "internal.h"
+
+#include <errno.h>
+#include <stdint.h>
+
+static task_migrated_callback_t task_migrated_callback = NULL;
+
+void register_task_migrated_callback(task_migrated_callback_t callback) {
+	task_migrated_callback = callback;
+}
+
+int handle_task_migrated(struct nl_msg *req_msg) {
+	struct nl_msg *msg = NULL;
+	struct nlattr *nla;
+	int ret = 0;
+	int seq;
+	struct internal_state* state = get_current_state();
+
+	// In params
+	pid_t pid;
+	int restart;
+	int phase_count;
+	uint64_t *durations;
+	uint64_t *bytes;
+	
+	seq = nlmsg_hdr(req_msg)->nlmsg_seq;
+
+	nla = nlmsg_find_attr(nlmsg_hdr(req_msg), sizeof(struct genlmsghdr), DIRECTOR_A_PID);
+	if (nla == NULL)
+		return  -EBADMSG;
+	pid = nla_get_u32(nla);
+
+	nla = nlmsg_find_attr(nlmsg_hdr(req_msg), sizeof(struct genlmsghdr), DIRECTOR_A_RESTART);
+	if (nla == NULL)
+		return  -EBADMSG;
+	restart = nla_get_u32(nla);
+
+	nla = nlmsg_find_attr(nlmsg_hdr(req_msg), sizeof(struct genlmsghdr), DIRECTOR_A_LENGTH);
+	if (nla == NULL)
+		return  -EBADMSG;
+	phase_count = nla_get_u32(nla);
+
+	nla = nlmsg_find_attr(nlmsg_hdr(req_msg), sizeof(struct genlmsghdr), DIRECTOR_A_PHASE_TIMES);
+	if (nla == NULL || nla_len(nla) < phase_count * sizeof(uint64_t))
+		return  -EBADMSG;
+	durations = nla_data(nla);
+
+	nla = nlmsg_find_attr(nlmsg_hdr(req_msg), sizeof(struct genlmsghdr), DIRECTOR_A_PHASE_BYTES);
+	if (nla == NULL || nla_len(nla) < phase_count * sizeof(uint64_t))
+		return  -EBADMSG;
+	bytes = nla_data(nla);
+
+	if ( task_migrated_callback )
+        	task_migrated_callback(pid, restart, phase_count, durations, bytes);
+	
+	if ( (ret=prepare_response_message(state->handle, DIRECTOR_ACK, state->gnl_fid, seq, &msg) ) != 0 ) {
+		goto done;
+	}
+	
+	if (ret != 0)
+		goto error_del_resp;
+
+	ret = send_request_message(state->handle, msg, 0);
+	goto done;	
+
+error_del_resp:
+	nlmsg_free(msg);
+done:	
+	return ret;
+}
@@ -0,0 +1,8 @@
+#ifndef TASK_MIGRATED_H
+#define TASK_MIGRATED_H
+
+struct nl_msg;
+
+int handle_task_migrated(struct nl_msg *req_msg);
+
+#endif
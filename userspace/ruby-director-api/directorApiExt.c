@@ -13,6 +13,7 @@ static void ruby_task_exitted_callback(pid_t pid, int exit_code, struct rusage *
 static void ruby_task_forked_callback(pid_t pid, pid_t ppid);
 static void ruby_migrated_home_callback(pid_t pid);
 static void ruby_emigration_failed_callback(pid_t pid);
+static void ruby_task_migrated_callback(pid_t pid, int restart, int phase_count, uint64_t* durations, uint64_t* bytes);
 static void ruby_user_message_received_callback(int node_id, int slot_type, int slot_index, int user_data_size, char* user_data);
 
 static VALUE ruby_rusage(struct rusage *rusage)
@@ -67,6 +68,7 @@ static VALUE method_init(VALUE self)
 	register_task_forked_callback(ruby_task_forked_callback);
 	register_migrated_home_callback(ruby_migrated_home_callback);
 	register_emigration_failed_callback(ruby_emigration_failed_callback);
+	register_task_migrated_callback(ruby_task_migrated_callback);
 	register_generic_user_message_callback(ruby_user_message_received_callback);
 
 	rb_iv_set(self, "@npmCallbackTarget", Qnil);
@@ -89,6 +91,8 @@ static VALUE method_init(VALUE self)
 	rb_iv_set(self, "@migratedHomeCallbackFunction", Qnil);	
 	rb_iv_set(self, "@emigrationFailedCallbackTarget", Qnil);
 	rb_iv_set(self, "@emigrationFailedCallbackFunction", Qnil);	
+	rb_iv_set(self, "@taskMigratedCallbackTarget", Qnil);
+	rb_iv_set(self, "@taskMigratedCallbackFunction", Qnil);
 	rb_iv_set(self, "@userMessageReceivedCallbackTarget", Qnil);
 	rb_iv_set(self, "@userMessageReceivedCallbackFunction", Qnil);
 	return self;
@@ -288,6 +292,28 @@ static void ruby_emigration_failed_callback(pid_t pid) {
 	}
 }
 
+static void ruby_task_migrated_callback(pid_t pid, int restart, int phase_count, uint64_t* durations, uint64_t* bytes) {
+	VALUE self, selfClass, instanceMethod, callbackTarget, callbackMethod;
+	VALUE rb_durations, rb_bytes;
+	VALUE callResult = Qnil;
+	int i;
+	
+	selfClass = rb_const_get(rb_cObject, rb_intern("DirectorNetlinkApi"));
+	instanceMethod = rb_intern("instance");
+	self = rb_funcall(selfClass, instanceMethod, 0);
+	callbackMethod = rb_iv_get(self,"@taskMigratedCallbackFunction");
+	callbackTarget = rb_iv_get(self,"@taskMigratedCallbackTarget");
+	if ( callbackMethod != Qnil ) {
+		rb_durations = rb_ary_new2(phase_count);
+		rb_bytes = rb_ary_new2(phase_count);
+		for ( i = 0; i < phase_count; i++ ) {
+			rb_ary_push(rb_durations, ULL2NUM(durations[i]));
+			rb_ary_push(rb_bytes, ULL2NUM(bytes[i]));
+		}
+		callResult = rb_funcall(callbackTarget, rb_to_id(callbackMethod), 4, INT2FIX(pid), INT2FIX(restart), rb_durations, rb_bytes);
+	}
+}
+
 static void ruby_user_message_received_callback(int node_id, int slot_type, int slot_index, int user_data_size, char* user_data) {
 	VALUE self, selfClass, instanceMethod, callbackTarget, callbackMethod;
 	VALUE callResult = Qnil;
@@ -368,6 +394,11 @@ static VALUE method_registerEmigrationFailedCallback(VALUE self, VALUE callbackT
 	rb_iv_set(self, "@emigrationFailedCallbackFunction", callbackFunc);
 }
 
+static VALUE method_registerTaskMigratedCallback(VALUE self, VALUE callbackTarget, VALUE callbackFunc) {
+	rb_iv_set(self, "@taskMigratedCallbackTarget", callbackTarget);
+	rb_iv_set(self, "@taskMigratedCallbackFunction", callbackFunc);
+}
+
 static VALUE method_registerUserMessageReceivedCallback(VALUE self, VALUE callbackTarget, VALUE callbackFunc) {
 	rb_iv_set(self, "@userMessageReceivedCallbackTarget", callbackTarget);
 	rb_iv_set(self, "@userMessageReceivedCallbackFunction", callbackFunc);
@@ -386,6 +417,59 @@ static VALUE method_sendUserMessage(VALUE self, VALUE targetSlotType, VALUE targ
 	return INT2FIX(res);
 }
 
+static VALUE method_npmCacheSet(VALUE self, VALUE name, VALUE uid, VALUE isGuest, VALUE policy, VALUE ttl) {
+	int res;
+
+	res = npm_cache_set(StringValueCStr(name), FIX2INT(uid), FIX2INT(isGuest), FIX2INT(policy), FIX2INT(ttl));
+
+	return INT2FIX(res);
+}
+
+static VALUE method_npmHintSet(VALUE self, VALUE suffix, VALUE argMask, VALUE envKeys) {
+	struct RArray* keysArray;
+	char** env_keys;
+	int i, res;
+
+	Check_Type(envKeys, T_ARRAY);
+	keysArray = RARRAY(envKeys);
+	env_keys = ALLOCA_N(char*, keysArray->len + 1);
+	for ( i = 0; i < keysArray->len; i++ )
+		env_keys[i] = StringValueCStr(keysArray->ptr[i]);
+	env_keys[keysArray->len] = NULL;
+
+	res = npm_hint_set(StringValueCStr(suffix), NUM2UINT(argMask), env_keys);
+
+	return INT2FIX(res);
+}
+
+static VALUE method_migrateBatch(VALUE self, VALUE slotType, VALUE migrations) {
+	struct RArray* migrationsArray;
+	struct RArray* entry;
+	struct director_migration* batch;
+	int i, res;
+
+	Check_Type(migrations, T_ARRAY);
+	migrationsArray = RARRAY(migrations);
+	batch = ALLOC_N(struct director_migration, migrationsArray->len);
+	for ( i = 0; i < migrationsArray->len; i++ ) {
+		Check_Type(migrationsArray->ptr[i], T_ARRAY);
+		entry = RARRAY(migrationsArray->ptr[i]);
+		if ( entry->len != 3 ) {
+			xfree(batch);
+			rb_raise(rb_eArgError, "Migration has to be a [pid, slotIndex, mode] triple");
+		}
+		batch[i].pid = FIX2INT(entry->ptr[0]);
+		batch[i].slot_index = FIX2INT(entry->ptr[1]);
+		batch[i].mode = FIX2INT(entry->ptr[2]);
+		batch[i].reserved = 0;
+	}
+
+	res = migrate_batch(FIX2INT(slotType), batch, migrationsArray->len);
+	xfree(batch);
+
+	return INT2FIX(res);
+}
+
 static VALUE netlinkApi;
 
 static void define_npm_result_codes(void) {
@@ -395,6 +479,11 @@ static void define_npm_result_codes(void) {
 	rb_define_const(netlinkApi, "REQUIRE_ARGS", INT2FIX(REQUIRE_ARGS));
 	rb_define_const(netlinkApi, "REQUIRE_ENVP", INT2FIX(REQUIRE_ENVP));
 	rb_define_const(netlinkApi, "REQUIRE_ARGS_AND_ENVP", INT2FIX(REQUIRE_ARGS_AND_ENVP));
+	rb_define_const(netlinkApi, "NPM_CACHE_ASK", INT2FIX(NPM_CACHE_ASK));
+	rb_define_const(netlinkApi, "NPM_CACHE_LOCAL", INT2FIX(NPM_CACHE_LOCAL));
+	rb_define_const(netlinkApi, "MIGRATION_EMIGRATE_PPM_P", INT2FIX(DIRECTOR_MIGRATION_EMIGRATE_PPM_P));
+	rb_define_const(netlinkApi, "MIGRATION_HOME_PPM_P", INT2FIX(DIRECTOR_MIGRATION_HOME_PPM_P));
+	rb_define_const(netlinkApi, "MIGRATION_HOME_PPM_V", INT2FIX(DIRECTOR_MIGRATION_HOME_PPM_V));
 };
 
 
@@ -422,8 +511,12 @@ Init_directorApi()
 	rb_define_method(netlinkApi, "registerTaskForkedCallback", method_registerTaskForkedCallback, 2);
 	rb_define_method(netlinkApi, "registerEmigrationFailedCallback", method_registerEmigrationFailedCallback, 2);
 	rb_define_method(netlinkApi, "registerMigratedHomeCallback", method_registerMigratedHomeCallback, 2);
+	rb_define_method(netlinkApi, "registerTaskMigratedCallback", method_registerTaskMigratedCallback, 2);
 	rb_define_method(netlinkApi, "registerUserMessageReceivedCallback", method_registerUserMessageReceivedCallback, 2);
 	rb_define_method(netlinkApi, "sendUserMessage", method_sendUserMessage, 4);	
+	rb_define_method(netlinkApi, "npmCacheSet", method_npmCacheSet, 5);
+	rb_define_method(netlinkApi, "npmHintSet", method_npmHintSet, 3);
+	rb_define_method(netlinkApi, "migrateBatch", method_migrateBatch, 2);
 	rb_define_method(netlinkApi, "runProcessingLoop", method_runDirectorNetlinkProcessingLoop, 0);	
 }
 
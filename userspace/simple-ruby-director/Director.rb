@@ -132,6 +132,7 @@ class Director
                 @netlinkConnector.pushNpmHandlers(procTrace) if $useProcTrace
                 @netlinkConnector.pushNpmHandlers(ExecDumper.new())
                 @netlinkConnector.pushNpmHandlers(@loadBalancer)
+                @loadBalancer.npmHints.each { |suffix, argMask, envKeys| @netlinkConnector.registerNpmHint(suffix, argMask, envKeys) }
 
 		@netlinkConnector.pushExitHandler(@taskRepository)
 		@netlinkConnector.pushExitHandler(@immigratedTasksController)		
@@ -151,6 +152,7 @@ class Director
 		
 		@netlinkConnector.pushMigratedHomeHandler(@taskRepository)
 		@netlinkConnector.pushEmigrationFailedHandler(@taskRepository)
+		@netlinkConnector.pushTaskMigratedHandler(@loadBalancer)
 		@netlinkConnector.startProcessingThread                                
 		
 		@loadBalancer.registerMigrationListener(procTrace) if $useProcTrace
@@ -1,5 +1,12 @@
 # This class interacts with the kernel module via its exported pseudo-fs
 class FilesystemConnector
+	# Migration modes accepted by migrateBatch, they match director_migration_mode
+	MIGRATION_EMIGRATE_PPM_P = 0
+	MIGRATION_HOME_PPM_P = 1
+	MIGRATION_HOME_PPM_V = 2
+
+	# Max number of migrations the kernel accepts in a single write
+	MIGRATION_BATCH_MAX = 256
 
 	def initialize
 		@rootPath = "/clondike"
@@ -69,6 +76,21 @@ class FilesystemConnector
 	  `echo #{pid} #{index}  > #{root}/mig/emigrate-ppm-p`
 	end
 
+	# Starts a batch of migrations, each of them is a [pid, slotIndex, mode] triple.
+	# The kernel starts the migrations concurrently and does not wait for them, failures
+	# are reported via emigration failed callback
+	def migrateBatch(slotType, migrations)
+	  root = getRoot(slotType)
+	  migrations.each_slice(MIGRATION_BATCH_MAX) { |slice|
+	      data = slice.map { |pid, index, mode| [pid, index || 0, mode, 0].pack("l4") }.join
+	      # The kernel accepts a batch only at offset 0, so every slice gets its own open
+	      File.open("#{root}/mig/migrate-batch", "wb") { |aFile|
+	          # Each write has to carry whole batch, so no buffering here
+	          aFile.syswrite(data)
+	      }
+	  }
+	end
+
         # Returns id of node, specified by its address
         def findNodeIdByAddress(ipAddress)
             #For now, we can simply return address, since it is used as
@@ -44,13 +44,15 @@ private
 	$log.info("Preparing to request migrate home")
 	# Wait 10 seconds before migrating home just to give locally running remote tasks some chance to finish
 	sleep(10)
+	migrations = []
         @immigratedTasks.each_key { |pid|
 	    task = @taskRepository.getTask(pid)
 	    # Currently we send home only long-term tasks
 	    next if task && !task.hasClassification(MigrateableLongTermTaskClassification.new())
 	    $log.info("Requesting migrated home for #{pid}")
-	    @filesystemConnector.migrateHome(DETACHED_MANAGER_SLOT ,pid)
+	    migrations << [pid, 0, FilesystemConnector::MIGRATION_HOME_PPM_P]
 	}
+	@filesystemConnector.migrateBatch(DETACHED_MANAGER_SLOT, migrations) if !migrations.empty?
     end
 
 end
\ No newline at end of file
@@ -5,6 +5,10 @@ require 'ConfigurablePatternMatcher'
 #Preemptive are periodically evaluated (once per REBALANCING_INTERVAL seconds) and acted upon
 class LoadBalancer
     REBALANCING_INTERVAL = 1
+    # Weight of the latest sample in the migration cost averages
+    MIGRATION_COST_WEIGHT = 0.2
+    # Npm hint argument mask selecting all arguments
+    NPM_HINT_ALL_ARGS = 0xffffffff
     
     def initialize(balancingStrategy, taskRepository, filesystemConnector)
         loadPatterns("migrateable.patterns")
@@ -13,6 +17,8 @@ class LoadBalancer
         # Listeners on migration decisions
         @migrationListeners = []
 	@filesystemConnector = filesystemConnector
+	# Average checkpoint (false) and restart (true) costs, per phase [ns, bytes] pairs
+	@migrationCosts = {}
 	
 	ExceptionAwareThread.new() {
 	    rebalancingThread()
@@ -23,6 +29,33 @@ class LoadBalancer
        @migrationListeners << listener
     end
     
+    #Called when a task has been checkpointed or restarted, learns the real migration costs
+    def onTaskMigrated(pid, restart, durations, bytes)
+        samples = durations.zip(bytes)
+        costs = @migrationCosts[restart]
+        if costs
+            @migrationCosts[restart] = costs.zip(samples).map { |avg, sample|
+                [0, 1].map { |i| avg[i] + MIGRATION_COST_WEIGHT * (sample[i] - avg[i]) }
+            }
+        else
+            @migrationCosts[restart] = samples
+        end
+    end
+    
+    #Average duration of a checkpoint (restart=false) or restart in ns, nil if not known yet
+    def migrationCost(restart)
+        costs = @migrationCosts[restart]
+        costs ? costs.inject(0) { |sum, phase| sum + phase[0] } : nil
+    end
+    
+    #Hints for the kernel, which args and envs we need in the first npm check of migrateable binaries
+    #Returns array of [suffix, argMask, envKeys]. Only patterns that are plain suffixes (like "cc1$")
+    #can be expressed as kernel hints, other binaries still take two checks
+    def npmHints
+        suffixPatterns = @patterns.map { |pattern| pattern.source }.select { |source| source =~ /\A[\w\-\/]+\$\z/ }
+        suffixPatterns.map { |source| [source.chop, NPM_HINT_ALL_ARGS, ["EMIG"]] }
+    end
+    
     #Called when a new program is being "execv-ed"
     #Should return array with non-preemptive migration decisions and a target migman
     #in case a migration should be performed
@@ -102,10 +135,12 @@ private
 	  rebalancingPlan = @balancingStrategy.findRebalancing
 	  next if !rebalancingPlan
 	  
+	  migrations = []
 	  rebalancingPlan.each { |pid, nodeIndex|
 	      $log.info("LoadBalancer decided migrate preemptively #{pid} to #{nodeIndex}")
-	      @filesystemConnector.emigratePreemptively(nodeIndex, pid)
+	      migrations << [pid, nodeIndex, FilesystemConnector::MIGRATION_EMIGRATE_PPM_P]
 	  }
+	  @filesystemConnector.migrateBatch(CORE_MANAGER_SLOT, migrations) if !migrations.empty?
 	end    
     end    
 end
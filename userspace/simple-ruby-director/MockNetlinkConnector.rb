@@ -17,6 +17,10 @@ class MockNetlinkConnector
         @npmHandlers << handler;
     end
         
+    # Npm hints are meaningless without a kernel
+    def registerNpmHint(suffix, argMask, envKeys)
+    end
+        
     # Starts the processing thread, that listens on incoming messages from kernel
     def startProcessingThread
             @thread = Thread.new {
@@ -16,6 +16,7 @@ class NetlinkConnector
 		@immigrationConfirmedHandlers = []
 		@migrationFailedHandlers = []
 		@migratedHomeHandlers = []
+		@taskMigratedHandlers = []
 	end
 	
 	# Registers a netlink connector instance to native handler
@@ -31,6 +32,7 @@ class NetlinkConnector
 		    DirectorNetlinkApi.instance.registerImmigrationConfirmedCallback(instance, :connectorImmigrationConfirmedCallbackFunction)
 		    DirectorNetlinkApi.instance.registerEmigrationFailedCallback(instance, :connectorEmigrationFailedCallbackFunction)
 		    DirectorNetlinkApi.instance.registerMigratedHomeCallback(instance, :connectorMigratedHomeCallbackFunction)
+		    DirectorNetlinkApi.instance.registerTaskMigratedCallback(instance, :connectorTaskMigratedCallbackFunction)
 		    DirectorNetlinkApi.instance.registerUserMessageReceivedCallback(instance, :connectorUserMessageReceivedCallbackFunction)
                 rescue => err
 		    puts "#{err.backtrace.join("\n")}"		    
@@ -178,6 +180,27 @@ class NetlinkConnector
 	    end
 	end	
 
+        # Asks the kernel to pass selected args and envs already in the first npm check
+        # of binaries with the path suffix, so that no second check is needed
+        def registerNpmHint(suffix, argMask, envKeys)
+            res = DirectorNetlinkApi.instance.npmHintSet(suffix, argMask, envKeys)
+            $log.warn("Failed to register npm hint for #{suffix}: #{res}") if res != 0
+        end
+
+        def pushTaskMigratedHandler(handler)
+            @taskMigratedHandlers << handler;
+        end
+
+	# Durations (ns) and image bytes of the checkpoint/restart phases
+	# in order: header, files, mm, vmas, regs, signals, conv
+	def connectorTaskMigratedCallbackFunction(pid, restart, durations, bytes)
+	    $log.info("Task #{pid} #{restart == 1 ? "restarted" : "checkpointed"} in #{durations.inject(0) { |sum, d| sum + d } / 1000000} ms, #{bytes.inject(0) { |sum, b| sum + b }} bytes")
+	    
+	    @taskMigratedHandlers.each do |handler|
+		handler.onTaskMigrated(pid, restart == 1, durations, bytes)
+	    end
+	end
+
 	# Starts the processing thread, that listens on incoming messages from kernel
 	def startProcessingThread
 		@thread = ExceptionAwareThread.new {
@@ -0,0 +1,53 @@
+require 'test/unit'
+require 'Manager'
+require 'FilesystemConnector'
+
+# Mimics the migrate-batch file, it accepts a single write at offset 0 only
+class BatchFile
+  attr_reader :writes
+
+  def initialize
+      @writes = []
+  end
+
+  def syswrite(data)
+      raise Errno::EINVAL if !@writes.empty?
+      @writes << data
+      data.size
+  end
+end
+
+class FilesystemConnectorTest < Test::Unit::TestCase
+  def setup
+      $batchFiles = []
+      class << File
+          alias_method :originalOpen, :open
+          def open(path, *args, &block)
+              return originalOpen(path, *args, &block) if path !~ /migrate-batch$/
+              file = BatchFile.new
+              $batchFiles << file
+              block.call(file)
+          end
+      end
+  end
+
+  def teardown
+      class << File
+          alias_method :open, :originalOpen
+          remove_method :originalOpen
+      end
+  end
+
+  def testMigrateBatchOverSliceLimit
+      migrations = (1..600).map { |pid| [pid, pid % 3, FilesystemConnector::MIGRATION_EMIGRATE_PPM_P] }
+      FilesystemConnector.new.migrateBatch(CORE_MANAGER_SLOT, migrations)
+
+      assert_equal(3, $batchFiles.size)
+      $batchFiles.each { |file| assert_equal(1, file.writes.size) }
+      records = $batchFiles.map { |file| file.writes[0] }.join.unpack("l*").each_slice(4).to_a
+      assert_equal(600, records.size)
+      assert_equal([1, 1, 0, 0], records[0])
+      assert_equal([257, 2, 0, 0], records[256])
+      assert_equal([600, 0, 0, 0], records[599])
+  end
+end